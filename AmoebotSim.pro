@@ -8,73 +8,26 @@ QMAKE_INFO_PLIST = res/Info.plist
 
 win32:RC_FILE = res/AmoebotSim.rc
 
+include(AmoebotSimCore.pri)
+
 HEADERS += \
-    alg/demo/ballroomdemo.h \
-    alg/demo/discodemo.h \
-    alg/demo/metricsdemo.h \
-    alg/demo/tokendemo.h \
-    alg/compression.h \
-    alg/energyshape.h \
-    alg/energysharing.h \
-    alg/infobjcoating.h \
-    alg/shapeformation.h \
-    core/amoebotparticle.h \
-    core/amoebotsystem.h \
-    core/localparticle.h \
-    core/metric.h \
-    core/node.h \
-    core/object.h \
-    core/particle.h \
-    core/simulator.h \
-    core/system.h \
-    helper/randomnumbergenerator.h \
     main/application.h \
     script/scriptengine.h \
     script/scriptinterface.h \
-    ui/algorithm.h \
     ui/glitem.h \
     ui/parameterlistmodel.h \
     ui/view.h \
-    ui/visitem.h \
-    alg/leaderelection.h \
-	alg/leaderelection_erosion.h \
-    alg/leaderelection_stationary_deterministic.h \
-    alg/leaderelection_deterministic.h \
-	alg/leaderelection_scontraction.h
+    ui/visitem.h
 
 SOURCES += \
-    alg/demo/ballroomdemo.cpp \
-    alg/demo/discodemo.cpp \
-    alg/demo/metricsdemo.cpp \
-    alg/demo/tokendemo.cpp \
-    alg/compression.cpp \
-    alg/energyshape.cpp \
-    alg/energysharing.cpp \
-    alg/infobjcoating.cpp \
-    alg/shapeformation.cpp \
-    core/amoebotparticle.cpp \
-    core/amoebotsystem.cpp \
-    core/localparticle.cpp \
-    core/metric.cpp \
-    core/object.cpp \
-    core/particle.cpp \
-    core/simulator.cpp \
-    core/system.cpp \
-    helper/randomnumbergenerator.cpp \
     main/application.cpp \
     main/main.cpp\
     script/scriptengine.cpp \
     script/scriptinterface.cpp \
-    ui/algorithm.cpp \
     ui/glitem.cpp \
     ui/parameterlistmodel.cpp \
     ui/view.cpp \
-    ui/visitem.cpp \
-    alg/leaderelection.cpp \
-	alg/leaderelection_erosion.cpp \
-    alg/leaderelection_stationary_deterministic.cpp \
-    alg/leaderelection_deterministic.cpp \
-	alg/leaderelection_scontraction.cpp
+    ui/visitem.cpp
 
 RESOURCES += \
     res/qml.qrc \
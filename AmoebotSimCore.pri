@@ -0,0 +1,88 @@
+# The simulator core, the algorithms, and the algorithm registry. These depend
+# only on Qt Core and are shared by the GUI (AmoebotSim.pro) and the headless
+# command-line runner (cli/amoebotsim-cli.pro).
+
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/alg/demo/ballroomdemo.h \
+    $$PWD/alg/demo/discodemo.h \
+    $$PWD/alg/demo/metricsdemo.h \
+    $$PWD/alg/demo/tokendemo.h \
+    $$PWD/alg/compression.h \
+    $$PWD/alg/energyshape.h \
+    $$PWD/alg/energysharing.h \
+    $$PWD/alg/infobjcoating.h \
+    $$PWD/alg/shapeformation.h \
+    $$PWD/core/activationtally.h \
+    $$PWD/core/activationtrace.h \
+    $$PWD/core/amoebotparticle.h \
+    $$PWD/core/amoebotsystem.h \
+    $$PWD/core/asyncscheduler.h \
+    $$PWD/core/changeevent.h \
+    $$PWD/core/checkpoint.h \
+    $$PWD/core/configuration.h \
+    $$PWD/core/latticeindex.h \
+    $$PWD/core/localparticle.h \
+    $$PWD/core/metric.h \
+    $$PWD/core/metricsink.h \
+    $$PWD/core/node.h \
+    $$PWD/core/object.h \
+    $$PWD/core/particlearena.h \
+    $$PWD/core/particlesnapshot.h \
+    $$PWD/core/parallelroundscheduler.h \
+    $$PWD/core/particle.h \
+    $$PWD/core/permutationscheduler.h \
+    $$PWD/core/resultsink.h \
+    $$PWD/core/simulationthread.h \
+    $$PWD/core/simulator.h \
+    $$PWD/core/system.h \
+    $$PWD/core/tokenmailbox.h \
+    $$PWD/core/tokenpool.h \
+    $$PWD/helper/randomnumbergenerator.h \
+    $$PWD/ui/algorithm.h \
+    $$PWD/alg/leaderelection.h \
+	$$PWD/alg/leaderelection_erosion.h \
+    $$PWD/alg/leaderelection_stationary_deterministic.h \
+    $$PWD/alg/leaderelection_deterministic.h \
+	$$PWD/alg/leaderelection_scontraction.h
+
+SOURCES += \
+    $$PWD/alg/demo/ballroomdemo.cpp \
+    $$PWD/alg/demo/discodemo.cpp \
+    $$PWD/alg/demo/metricsdemo.cpp \
+    $$PWD/alg/demo/tokendemo.cpp \
+    $$PWD/alg/compression.cpp \
+    $$PWD/alg/energyshape.cpp \
+    $$PWD/alg/energysharing.cpp \
+    $$PWD/alg/infobjcoating.cpp \
+    $$PWD/alg/shapeformation.cpp \
+    $$PWD/core/activationtally.cpp \
+    $$PWD/core/activationtrace.cpp \
+    $$PWD/core/amoebotparticle.cpp \
+    $$PWD/core/amoebotsystem.cpp \
+    $$PWD/core/asyncscheduler.cpp \
+    $$PWD/core/checkpoint.cpp \
+    $$PWD/core/configuration.cpp \
+    $$PWD/core/latticeindex.cpp \
+    $$PWD/core/localparticle.cpp \
+    $$PWD/core/metric.cpp \
+    $$PWD/core/metricsink.cpp \
+    $$PWD/core/object.cpp \
+    $$PWD/core/particlearena.cpp \
+    $$PWD/core/parallelroundscheduler.cpp \
+    $$PWD/core/particle.cpp \
+    $$PWD/core/permutationscheduler.cpp \
+    $$PWD/core/resultsink.cpp \
+    $$PWD/core/simulationthread.cpp \
+    $$PWD/core/simulator.cpp \
+    $$PWD/core/system.cpp \
+    $$PWD/core/tokenmailbox.cpp \
+    $$PWD/core/tokenpool.cpp \
+    $$PWD/helper/randomnumbergenerator.cpp \
+    $$PWD/ui/algorithm.cpp \
+    $$PWD/alg/leaderelection.cpp \
+	$$PWD/alg/leaderelection_erosion.cpp \
+    $$PWD/alg/leaderelection_stationary_deterministic.cpp \
+    $$PWD/alg/leaderelection_deterministic.cpp \
+	$$PWD/alg/leaderelection_scontraction.cpp
@@ -5,6 +5,7 @@
 #include "alg/compression.h"
 
 #include <algorithm>  // For distance() and find().
+#include <cmath>
 #include <set>
 #include <vector>
 
@@ -82,6 +83,18 @@ QString CompressionParticle::inspectionText() const {
   return text;
 }
 
+void CompressionParticle::writeState(CheckpointWriter& out) const {
+  out.writeDouble(q);
+  out.writeInt(numNbrsBefore);
+  out.writeBool(flag);
+}
+
+void CompressionParticle::readState(CheckpointReader& in) {
+  q = in.readDouble();
+  numNbrsBefore = in.readInt();
+  flag = in.readBool();
+}
+
 CompressionParticle& CompressionParticle::nbrAtLabel(int label) const {
   return AmoebotParticle::nbrAtLabel<CompressionParticle>(label);
 }
@@ -200,7 +213,9 @@ bool CompressionParticle::checkProp2(std::vector<int> S) const {
 }
 
 
-CompressionSystem::CompressionSystem(int numParticles, double lambda) {
+CompressionSystem::CompressionSystem(int numParticles, double lambda,
+                                     const unsigned int seed)
+  : AmoebotSystem(seed) {
   Q_ASSERT(lambda > 1);
 
   // Initialize particle system.
@@ -248,11 +263,13 @@ CompressionSystem::CompressionSystem(int numParticles, double lambda) {
         }
       }
 
-      insert(new CompressionParticle(Node(x, y), -1, randDir(), *this, lambda));
+      emplaceParticle<CompressionParticle>(
+          Node(x, y), -1, randDir(), *this, lambda);
     }
   } else {  // In the unknown range or compression range, make a straight line.
     for (int i = 0; i < numParticles; ++i) {
-      insert(new CompressionParticle(Node(i, 0), -1, randDir(), *this, lambda));
+      emplaceParticle<CompressionParticle>(
+          Node(i, 0), -1, randDir(), *this, lambda);
     }
   }
 
@@ -262,7 +279,7 @@ CompressionSystem::CompressionSystem(int numParticles, double lambda) {
 
 bool CompressionSystem::hasTerminated() const {
   #ifdef QT_DEBUG
-    if (!isConnected(particles)) {
+    if (!isConnected(snapshot())) {
         return true;
     }
   #endif
@@ -270,6 +287,14 @@ bool CompressionSystem::hasTerminated() const {
   return false;
 }
 
+bool CompressionSystem::supportsParallelRounds() const {
+  return true;
+}
+
+bool CompressionSystem::supportsCheckpoints() const {
+  return true;
+}
+
 PerimeterMeasure::PerimeterMeasure(const QString name, const unsigned int freq,
                                    CompressionSystem& system)
     : Measure(name, freq),
@@ -36,6 +36,12 @@ class CompressionParticle : public AmoebotParticle {
   virtual QString inspectionText() const;
 
 protected:
+  // Functions for checkpoints (see AmoebotParticle::writeState). These write
+  // and read the particle memory below, except for lambda, which is fixed by
+  // the system's parameters.
+  void writeState(CheckpointWriter& out) const override;
+  void readState(CheckpointReader& in) override;
+
   // Particle memory.
   const double lambda;
   double q;
@@ -71,10 +77,19 @@ class CompressionSystem : public AmoebotSystem {
   // generated surface (with no tunnels). Takes an optionally specified size
   // (#particles) and a bias parameter. A bias above 2 + sqrt(2) will provably
   // yield compression; a bias below 2.17 will provably yield expansion.
-  CompressionSystem(int numParticles = 100, double lambda = 4.0);
+  CompressionSystem(int numParticles = 100, double lambda = 4.0,
+                    const unsigned int seed = 0);
 
   // Because this algorithm never terminates, this simply returns false.
   virtual bool hasTerminated() const;
+
+  // Activations only involve a particle and its neighbors, so this system can
+  // be run in parallel rounds.
+  bool supportsParallelRounds() const override;
+
+  // Particles hold no tokens and all their memory is checkpointed, so this
+  // system supports checkpoints.
+  bool supportsCheckpoints() const override;
 };
 
 class PerimeterMeasure : public Measure {
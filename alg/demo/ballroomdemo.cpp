@@ -4,6 +4,8 @@
 
 #include "alg/demo/ballroomdemo.h"
 
+#include <cmath>
+
 BallroomDemoParticle::BallroomDemoParticle(const Node head,
                                            const int globalTailDir,
                                            const int orientation,
@@ -123,7 +125,9 @@ BallroomDemoParticle::Color BallroomDemoParticle::getRandColor() const {
   return static_cast<Color>(randInt(0, 7));
 }
 
-BallroomDemoSystem::BallroomDemoSystem(unsigned int numParticles) {
+BallroomDemoSystem::BallroomDemoSystem(unsigned int numParticles,
+                                       const unsigned int seed)
+  : AmoebotSystem(seed) {
   // To enclose an area that's roughly 6x the # of particles using a rhombus,
   // the rhombus should have side length 2.6*sqrt(# particles).
   int sideLen = static_cast<int>(std::round(2.6 * std::sqrt(numParticles)));
@@ -153,17 +157,15 @@ BallroomDemoSystem::BallroomDemoSystem(unsigned int numParticles) {
     // by setting the Follower's partner label to face the Leader.
     if (occupied.find(leaderNode) == occupied.end()
         && occupied.find(followerNode) == occupied.end()) {
-      BallroomDemoParticle* leader =
-          new BallroomDemoParticle(leaderNode, -1, randDir(), *this,
-                                   BallroomDemoParticle::State::Leader);
-      insert(leader);
+      emplaceParticle<BallroomDemoParticle>(
+          leaderNode, -1, randDir(), *this,
+          BallroomDemoParticle::State::Leader);
       occupied.insert(leaderNode);
 
-      BallroomDemoParticle* follower =
-          new BallroomDemoParticle(followerNode, -1, randDir(), *this,
-                                   BallroomDemoParticle::State::Follower);
+      BallroomDemoParticle* follower = emplaceParticle<BallroomDemoParticle>(
+          followerNode, -1, randDir(), *this,
+          BallroomDemoParticle::State::Follower);
       follower->_partnerLbl = follower->globalToLocalDir((followerDir + 3) % 6);
-      insert(follower);
       occupied.insert(followerNode);
 
       numParticlesAdded += 2;
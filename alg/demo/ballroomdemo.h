@@ -79,7 +79,8 @@ class BallroomDemoSystem : public AmoebotSystem {
  public:
   // Constructs a system of the specified number of BallroomDemoParticles in
   // "dance partner" pairs enclosed by a rhombic ring of objects.
-  BallroomDemoSystem(unsigned int numParticles = 30);
+  BallroomDemoSystem(unsigned int numParticles = 30,
+                     const unsigned int seed = 0);
 };
 
 #endif  // AMOEBOTSIM_ALG_DEMO_BALLROOMDEMO_H_
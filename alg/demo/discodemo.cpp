@@ -4,6 +4,8 @@
 
 #include "alg/demo/discodemo.h"
 
+#include <cmath>
+
 DiscoDemoParticle::DiscoDemoParticle(const Node& head, const int globalTailDir,
                                      const int orientation,
                                      AmoebotSystem& system,
@@ -86,7 +88,9 @@ DiscoDemoParticle::State DiscoDemoParticle::getRandColor() const {
   return static_cast<State>(randInt(0, 7));
 }
 
-DiscoDemoSystem::DiscoDemoSystem(unsigned int numParticles, int counterMax) {
+DiscoDemoSystem::DiscoDemoSystem(unsigned int numParticles, int counterMax,
+                                 const unsigned int seed)
+  : AmoebotSystem(seed) {
   // In order to enclose an area that's roughly 3.7x the # of particles using a
   // regular hexagon, the hexagon should have side length 1.4*sqrt(# particles).
   int sideLen = static_cast<int>(std::round(1.4 * std::sqrt(numParticles)));
@@ -112,7 +116,8 @@ DiscoDemoSystem::DiscoDemoSystem(unsigned int numParticles, int counterMax) {
     // If the node satisfies (iii) and is unoccupied, place a particle there.
     if (0 < x + y && x + y < 2 * sideLen
         && occupied.find(node) == occupied.end()) {
-      insert(new DiscoDemoParticle(node, -1, randDir(), *this, counterMax));
+      emplaceParticle<DiscoDemoParticle>(
+          node, -1, randDir(), *this, counterMax);
       occupied.insert(node);
     }
   }
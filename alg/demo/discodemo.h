@@ -68,7 +68,8 @@ class DiscoDemoSystem : public AmoebotSystem {
  public:
   // Constructs a system of the specified number of DiscoDemoParticles enclosed
   // by a hexagonal ring of objects.
-  DiscoDemoSystem(unsigned int numParticles = 30, int counterMax = 5);
+  DiscoDemoSystem(unsigned int numParticles = 30, int counterMax = 5,
+                  const unsigned int seed = 0);
 };
 
 #endif  // AMOEBOTSIM_ALG_DEMO_DISCODEMO_H_
@@ -6,6 +6,7 @@
 
 #include <algorithm>  // for std::max
 #include <cmath>      // for std::sqrt, std::pow
+#include <vector>
 
 MetricsDemoParticle::MetricsDemoParticle(const Node& head,
                                          const int globalTailDir,
@@ -16,6 +17,7 @@ MetricsDemoParticle::MetricsDemoParticle(const Node& head,
       _counter(counterMax),
       _counterMax(counterMax) {
   _state = getRandColor();
+  setSnapshotState(static_cast<unsigned char>(_state));
 }
 
 void MetricsDemoParticle::activate() {
@@ -25,6 +27,7 @@ void MetricsDemoParticle::activate() {
   if (_counter == 0) {
     _counter = _counterMax;
     _state = getRandColor();
+    setSnapshotState(static_cast<unsigned char>(_state));
   }
 
   // Next, handle movement. If the particle is contracted, choose a random
@@ -92,7 +95,9 @@ MetricsDemoParticle::State MetricsDemoParticle::getRandColor() const {
   return static_cast<State>(randInt(0, 7));
 }
 
-MetricsDemoSystem::MetricsDemoSystem(unsigned int numParticles, int counterMax) {
+MetricsDemoSystem::MetricsDemoSystem(unsigned int numParticles,
+                                     int counterMax, const unsigned int seed)
+  : AmoebotSystem(seed) {
   // In order to enclose an area that's roughly 3.7x the # of particles using a
   // regular hexagon, the hexagon should have side length 1.4*sqrt(# particles).
   int sideLen = static_cast<int>(std::round(1.4 * std::sqrt(numParticles)));
@@ -118,7 +123,8 @@ MetricsDemoSystem::MetricsDemoSystem(unsigned int numParticles, int counterMax)
     // If the node satisfies (iii) and is unoccupied, place a particle there.
     if (0 < x + y && x + y < 2 * sideLen
         && occupied.find(node) == occupied.end()) {
-      insert(new MetricsDemoParticle(node, -1, randDir(), *this, counterMax));
+      emplaceParticle<MetricsDemoParticle>(
+          node, -1, randDir(), *this, counterMax);
       occupied.insert(node);
     }
   }
@@ -138,11 +144,12 @@ PercentRedMeasure::PercentRedMeasure(const QString name,
 double PercentRedMeasure::calculate() const {
   int numRed = 0;
 
-  // Loop through all particles of the system.
-  for (const auto& p : _system.particles) {
-    // Convert the pointer to a MetricsDemoParticle so its color can be checked.
-    auto metr_p = dynamic_cast<MetricsDemoParticle*>(p);
-    if (metr_p->_state == MetricsDemoParticle::State::Red) {
+  // Loop through the states of all particles of the system, which each
+  // MetricsDemoParticle publishes in the system's snapshot.
+  const auto red =
+      static_cast<unsigned char>(MetricsDemoParticle::State::Red);
+  for (const unsigned char state : _system.snapshot().state) {
+    if (state == red) {
       numRed++;
     }
   }
@@ -157,14 +164,21 @@ MaxDistanceMeasure::MaxDistanceMeasure(const QString name,
       _system(system) {}
 
 double MaxDistanceMeasure::calculate() const {
+  // Convert every head to Cartesian coordinates once, reading the positions
+  // from the system's snapshot.
+  const ParticleSnapshot& snapshot = _system.snapshot();
+  const unsigned int n = snapshot.size();
+  std::vector<double> x(n), y(n);
+  for (unsigned int i = 0; i < n; i++) {
+    x[i] = snapshot.headX[i] + snapshot.headY[i] / 2.0;
+    y[i] = std::sqrt(3.0) / 2 * snapshot.headY[i];
+  }
+
   double maxDist = 0.0;
-  for (const auto& p1 : _system.particles) {
-    double x1 = p1->head.x + p1->head.y / 2.0;
-    double y1 = std::sqrt(3.0) / 2 * p1->head.y;
-    for (const auto& p2 : _system.particles) {
-      double x2 = p2->head.x + p2->head.y / 2.0;
-      double y2 = std::sqrt(3.0) / 2 * p2->head.y;
-      maxDist = std::max(std::sqrt(std::pow(x2 - x1, 2) + std::pow(y2 - y1, 2)),
+  for (unsigned int i = 0; i < n; i++) {
+    for (unsigned int j = 0; j < n; j++) {
+      maxDist = std::max(std::sqrt(std::pow(x[j] - x[i], 2) +
+                                   std::pow(y[j] - y[i], 2)),
                          maxDist);
     }
   }
@@ -72,7 +72,8 @@ class MetricsDemoSystem : public AmoebotSystem {
  public:
   // Constructs a system of the specified number of MetricsDemoParticles
   // enclosed by a hexagonal ring of objects.
-  MetricsDemoSystem(unsigned int numParticles = 30, int counterMax = 5);
+  MetricsDemoSystem(unsigned int numParticles = 30, int counterMax = 5,
+                    const unsigned int seed = 0);
 };
 
 class PercentRedMeasure : public Measure {
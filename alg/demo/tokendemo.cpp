@@ -4,6 +4,8 @@
 
 #include "alg/demo/tokendemo.h"
 
+#include <cmath>
+
 TokenDemoParticle::TokenDemoParticle(const Node& head, const int globalTailDir,
                                      const int orientation,
                                      AmoebotSystem& system)
@@ -11,13 +13,13 @@ TokenDemoParticle::TokenDemoParticle(const Node& head, const int globalTailDir,
 
 void TokenDemoParticle::activate() {
   if (hasToken<DemoToken>()) {
-    std::shared_ptr<DemoToken> token = takeToken<DemoToken>();
+    TokenPtr<DemoToken> token = takeToken<DemoToken>();
 
     // Calculate the direction to pass this token.
     int passTo;
     if (token->_passedFrom == -1) {
       // This hasn't been passed yet; pass red and blue in opposite directions.
-      int sweepLen = (std::dynamic_pointer_cast<RedToken>(token)) ? 1 : 2;
+      int sweepLen = (dynamicTokenCast<RedToken>(token)) ? 1 : 2;
       for (int dir = 0; dir < 6; dir++) {
         if (hasNbrAtLabel(dir)) {
           sweepLen--;
@@ -84,7 +86,9 @@ TokenDemoParticle& TokenDemoParticle::nbrAtLabel(int label) const {
   return AmoebotParticle::nbrAtLabel<TokenDemoParticle>(label);
 }
 
-TokenDemoSystem::TokenDemoSystem(int numParticles, int lifetime) {
+TokenDemoSystem::TokenDemoSystem(int numParticles, int lifetime,
+                                 const unsigned int seed)
+  : AmoebotSystem(seed) {
   Q_ASSERT(numParticles >= 6);
 
   // Instantiate a hexagon of particles.
@@ -94,18 +98,18 @@ TokenDemoSystem::TokenDemoSystem(int numParticles, int lifetime) {
     for (int i = 0; i < sideLen; ++i) {
       // Give the first particle five tokens of each color.
       if (hexNode.x == 0 && hexNode.y == 0) {
-        auto firstP = new TokenDemoParticle(Node(0, 0), -1, randDir(), *this);
+        auto firstP = emplaceParticle<TokenDemoParticle>(Node(0, 0), -1,
+                                                         randDir(), *this);
         for (int j = 0; j < 5; ++j) {
-          auto redToken = std::make_shared<TokenDemoParticle::RedToken>();
+          auto redToken = makeToken<TokenDemoParticle::RedToken>();
           redToken->_lifetime = lifetime;
           firstP->putToken(redToken);
-          auto blueToken = std::make_shared<TokenDemoParticle::BlueToken>();
+          auto blueToken = makeToken<TokenDemoParticle::BlueToken>();
           blueToken->_lifetime = lifetime;
           firstP->putToken(blueToken);
         }
-        insert(firstP);
       } else {
-        insert(new TokenDemoParticle(hexNode, -1, randDir(), *this));
+        emplaceParticle<TokenDemoParticle>(hexNode, -1, randDir(), *this);
       }
 
       hexNode = hexNode.nodeInDir(dir);
@@ -114,12 +118,6 @@ TokenDemoSystem::TokenDemoSystem(int numParticles, int lifetime) {
 }
 
 bool TokenDemoSystem::hasTerminated() const {
-  for (auto p : particles) {
-    auto tdp = dynamic_cast<TokenDemoParticle*>(p);
-    if (tdp->hasToken<TokenDemoParticle::DemoToken>()) {
-      return false;
-    }
-  }
-
-  return true;
+  // Every token in this system is a DemoToken.
+  return numHeldTokens() == 0;
 }
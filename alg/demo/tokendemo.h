@@ -56,7 +56,8 @@ class TokenDemoSystem : public AmoebotSystem {
  public:
   // Constructs a system of TokenDemoParticles with an optionally specified size
   // (#particles) and token lifetime.
-  TokenDemoSystem(int numParticles = 48, int lifetime = 100);
+  TokenDemoSystem(int numParticles = 48, int lifetime = 100,
+                  const unsigned int seed = 0);
 
   // Returns true when the simulation has completed; i.e, when all tokens have
   // died out.
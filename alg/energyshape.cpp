@@ -1,6 +1,7 @@
 #include "alg/energyshape.h"
 
 #include <algorithm>
+#include <cmath>
 #include <set>
 
 EnergyShapeParticle::EnergyShapeParticle(const Node& head, int globalTailDir,
@@ -15,6 +16,7 @@ EnergyShapeParticle::EnergyShapeParticle(const Node& head, int globalTailDir,
       _capacity(capacity),
       _demand(demand),
       _transferRate(transferRate),
+      _actionsCount(system.countHandle("# Actions")),
       _battery(0),
       _stress(false),
       _inhibit(false),
@@ -29,6 +31,7 @@ EnergyShapeParticle::EnergyShapeParticle(const Node& head, int globalTailDir,
   if (_sState == ShapeState::Seed) {
     _constructionDir = 0;
   }
+  publishState();
 }
 
 void EnergyShapeParticle::activate() {
@@ -127,6 +130,16 @@ QString EnergyShapeParticle::inspectionText() const {
   return text;
 }
 
+void EnergyShapeParticle::setShapeState(ShapeState sState) {
+  _sState = sState;
+  publishState();
+}
+
+void EnergyShapeParticle::publishState() {
+  setSnapshotState(static_cast<unsigned char>(_sState) |
+                   (_stress ? kStressFlag : 0) | (_inhibit ? kInhibitFlag : 0));
+}
+
 EnergyShapeParticle& EnergyShapeParticle::nbrAtLabel(int label) const {
   return AmoebotParticle::nbrAtLabel<EnergyShapeParticle>(label);
 }
@@ -148,6 +161,7 @@ void EnergyShapeParticle::prune() {
   if (_eState != EnergyState::Root) {
     _eState = EnergyState::Idle;
   }
+  publishState();
 }
 
 void EnergyShapeParticle::communicate() {
@@ -168,6 +182,7 @@ void EnergyShapeParticle::communicate() {
   } else {
     _inhibit = _battery < _demand || hasStressChild;
   }
+  publishState();
 }
 
 void EnergyShapeParticle::shareEnergy() {
@@ -224,18 +239,18 @@ void EnergyShapeParticle::useEnergy() {
     } else {  // is contracted.
       if (_sState == ShapeState::Idle) {
         if (hasNbrInState({ShapeState::Seed, ShapeState::Finish})) {
-          _sState = ShapeState::Lead;
+          setShapeState(ShapeState::Lead);
           updateMoveDir();
           didAction = true;
         } else if (hasNbrInState({ShapeState::Lead, ShapeState::Follow})) {
-          _sState = ShapeState::Follow;
+          setShapeState(ShapeState::Follow);
           _followDir = labelOfFirstNbrInState({ShapeState::Lead,
                                                ShapeState::Follow});
           didAction = true;
         }
       } else if (_sState == ShapeState::Follow) {
         if (hasNbrInState({ShapeState::Seed, ShapeState::Finish})) {
-          _sState = ShapeState::Lead;
+          setShapeState(ShapeState::Lead);
           updateMoveDir();
           didAction = true;
         } else if (hasTailAtLabel(_followDir)) {
@@ -251,7 +266,7 @@ void EnergyShapeParticle::useEnergy() {
         }
       } else if (_sState == ShapeState::Lead) {
         if (canFinish()) {
-          _sState = ShapeState::Finish;
+          setShapeState(ShapeState::Finish);
           updateConstructionDir();
           didAction = true;
         } else {
@@ -275,7 +290,7 @@ void EnergyShapeParticle::useEnergy() {
 
     if (didAction) {
       _battery -= _demand;
-      system.getCount("# Actions").record();
+      system.count(_actionsCount).record();
     }
   }
 }
@@ -370,15 +385,17 @@ EnergyShapeSystem::EnergyShapeSystem(const int numParticles,
                                      const double holeProb,
                                      const double capacity,
                                      const double demand,
-                                     const double transferRate) {
-  _counts.push_back(new Count("# Actions"));
+                                     const double transferRate,
+                                     const unsigned int seed)
+  : AmoebotSystem(seed) {
+  addCount("# Actions");
 
   // Insert the energy distribution root/shape formation seed at (0,0).
   std::set<Node> occupied;
-  insert(new EnergyShapeParticle(Node(0, 0), -1, randDir(), *this, capacity,
-                                 demand, transferRate,
-                                 EnergyShapeParticle::EnergyState::Idle,
-                                 EnergyShapeParticle::ShapeState::Seed));
+  emplaceParticle<EnergyShapeParticle>(
+      Node(0, 0), -1, randDir(), *this, capacity, demand, transferRate,
+      EnergyShapeParticle::EnergyState::Idle,
+      EnergyShapeParticle::ShapeState::Seed);
   occupied.insert(Node(0, 0));
 
   std::set<Node> candidates;
@@ -404,10 +421,10 @@ EnergyShapeSystem::EnergyShapeSystem(const int numParticles,
 
     // With probability 1 - holeProb, add a new particle at the candidate node.
     if (randBool(1.0 - holeProb)) {
-      insert(new EnergyShapeParticle(randCand, -1, randDir(), *this, capacity,
-                                     demand, transferRate,
-                                     EnergyShapeParticle::EnergyState::Idle,
-                                     EnergyShapeParticle::ShapeState::Idle));
+      emplaceParticle<EnergyShapeParticle>(
+          randCand, -1, randDir(), *this, capacity, demand, transferRate,
+          EnergyShapeParticle::EnergyState::Idle,
+          EnergyShapeParticle::ShapeState::Idle);
       occupied.insert(randCand);
       particlesAdded++;
 
@@ -437,14 +454,10 @@ EnergyShapeSystem::EnergyShapeSystem(const int numParticles,
 }
 
 bool EnergyShapeSystem::hasTerminated() const {
-  for (auto p : particles) {
-    auto esp = dynamic_cast<EnergyShapeParticle*>(p);
-    if (esp->_stress || esp->_inhibit ||
-        (esp->_sState != EnergyShapeParticle::ShapeState::Seed
-         && esp->_sState != EnergyShapeParticle::ShapeState::Finish)) {
-      return false;
-    }
-  }
-
-  return true;
+  // A particle that is neither stressed nor inhibited publishes its shape state
+  // as its snapshot state, so this counts exactly the particles that are done.
+  using ShapeState = EnergyShapeParticle::ShapeState;
+  return numParticlesInState(static_cast<unsigned char>(ShapeState::Seed)) +
+         numParticlesInState(static_cast<unsigned char>(ShapeState::Finish)) ==
+         size();
 }
@@ -110,12 +110,18 @@ class EnergyShapeParticle : public AmoebotParticle {
   // following its tail.
   bool hasTailFollower() const;
 
+  // Sets this particle's shape state and publishes its snapshot state.
+  void setShapeState(ShapeState sState);
+
  protected:
   // Energy Distribution parameters.
   const double _capacity;
   const double _demand;
   const double _transferRate;
 
+  // Handle to the system's "# Actions" count, resolved once on construction.
+  const CountHandle _actionsCount;
+
   // Energy Distribution variables.
   double _battery;
   bool _stress;
@@ -133,6 +139,15 @@ class EnergyShapeParticle : public AmoebotParticle {
 
  private:
   friend class EnergyShapeSystem;
+
+  // The snapshot state of a particle is its shape state, with these flags set
+  // while it is stressed or inhibited; see EnergyShapeSystem::hasTerminated.
+  static constexpr unsigned char kStressFlag = 0x10;
+  static constexpr unsigned char kInhibitFlag = 0x20;
+
+  // Publishes the shape state and the above flags as the snapshot state; called
+  // whenever any of them changes.
+  void publishState();
 };
 
 class EnergyShapeSystem : public AmoebotSystem {
@@ -143,7 +158,8 @@ class EnergyShapeSystem : public AmoebotSystem {
   // energy capacity, energy demand per action, and energy transfer rate.
   EnergyShapeSystem(const int numParticles, const int numEnergyRoots,
                     const double holeProb, const double capacity,
-                    const double demand, const double transferRate);
+                    const double demand, const double transferRate,
+                    const unsigned int seed = 0);
 
   // Checks whether the system has completed forming the desired shape (i.e.,
   // all particles are in shape state Finish).
@@ -1,6 +1,7 @@
 #include "alg/energysharing.h"
 
 #include <algorithm>  // for std::min, std::max.
+#include <cmath>
 
 EnergySharingParticle::EnergySharingParticle(const Node& head,
                                              int globalTailDir,
@@ -16,6 +17,7 @@ EnergySharingParticle::EnergySharingParticle(const Node& head,
       _demand(demand),
       _transferRate(transferRate),
       _usage(usage),
+      _actionsCount(system.countHandle("# Actions")),
       _battery(0),
       _stress(false),
       _inhibit(false),
@@ -150,7 +152,7 @@ void EnergySharingParticle::useEnergy() {
   if (!_inhibit && _battery >= _demand) {
     if (_usage == Usage::Uniform) {
       _battery -= _demand;
-      system.getCount("# Actions").record();
+      system.count(_actionsCount).record();
     } else if (_usage == Usage::Reproduce) {
       int reproduceDir = -1;
       for (int dir = 0; dir < 6; dir++) {
@@ -162,11 +164,11 @@ void EnergySharingParticle::useEnergy() {
 
       if (reproduceDir != -1) {
         _battery -= _demand;
-        system.getCount("# Actions").record();
-        system.insert(new EnergySharingParticle(
+        system.count(_actionsCount).record();
+        system.emplaceParticle<EnergySharingParticle>(
                         head.nodeInDir(localToGlobalDir(reproduceDir)), -1,
                         randDir(), system, _capacity, _demand, _transferRate,
-                        _usage, State::Idle));
+                        _usage, State::Idle);
       }
     } else {
       Q_ASSERT(false);  // An invalid usage type was used.
@@ -199,8 +201,10 @@ EnergySharingSystem::EnergySharingSystem(int numParticles,
                                          const int usage,
                                          const double capacity,
                                          const double demand,
-                                         const double transferRate) {
-  _counts.push_back(new Count("# Actions"));
+                                         const double transferRate,
+                                         const unsigned int seed)
+  : AmoebotSystem(seed) {
+  addCount("# Actions");
 
   // Add a hexagon of idle particles to the system.
   int x, y;
@@ -246,10 +250,10 @@ EnergySharingSystem::EnergySharingSystem(int numParticles,
       }
     }
 
-    insert(new EnergySharingParticle(Node(x, y), -1, randDir(), *this,
-                                     capacity, demand, transferRate,
-                                     static_cast<EnergySharingParticle::Usage>(usage),
-                                     EnergySharingParticle::State::Idle));
+    emplaceParticle<EnergySharingParticle>(
+        Node(x, y), -1, randDir(), *this, capacity, demand, transferRate,
+        static_cast<EnergySharingParticle::Usage>(usage),
+        EnergySharingParticle::State::Idle);
   }
 
   // Choose particles at random to make energy ditribution roots.
@@ -77,6 +77,9 @@ class EnergySharingParticle : public AmoebotParticle {
   const double _transferRate;
   const Usage _usage;
 
+  // Handle to the system's "# Actions" count, resolved once on construction.
+  const CountHandle _actionsCount;
+
   // Local variables.
   double _battery;
   bool _stress;
@@ -98,7 +101,8 @@ class EnergySharingSystem : public AmoebotSystem {
   // action, and energy transfer rate.
   EnergySharingSystem(int numParticles, const int numEnergyRoots,
                       const int usage, const double capacity,
-                      const double demand, const double transferRate);
+                      const double demand, const double transferRate,
+                      const unsigned int seed = 0);
 };
 
 #endif  // ALG_ENERGYSHARING_H_
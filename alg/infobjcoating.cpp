@@ -4,6 +4,7 @@
 
 #include "alg/infobjcoating.h"
 
+#include <cmath>
 #include <set>
 
 InfObjCoatingParticle::InfObjCoatingParticle(const Node head,
@@ -12,7 +13,14 @@ InfObjCoatingParticle::InfObjCoatingParticle(const Node head,
                                              AmoebotSystem &system, State state)
   : AmoebotParticle(head, globalTailDir, orientation, system),
     state(state),
-    moveDir(-1) {}
+    moveDir(-1) {
+  setSnapshotState(static_cast<unsigned char>(state));
+}
+
+void InfObjCoatingParticle::setState(State state) {
+  this->state = state;
+  setSnapshotState(static_cast<unsigned char>(state));
+}
 
 void InfObjCoatingParticle::activate() {
   if (isExpanded()) {
@@ -36,11 +44,11 @@ void InfObjCoatingParticle::activate() {
     if (state == State::Inactive) {
       // Inactive particles need to first join the spanning tree.
       if (hasObjectNbr()) {
-        state = State::Leader;
+        setState(State::Leader);
         moveDir = nextSurfaceDir();
         return;
       } else if (hasNbrInState({State::Leader, State::Follower})) {
-        state = State::Follower;
+        setState(State::Follower);
         moveDir = labelOfFirstNbrInState({State::Leader, State::Follower});
         return;
       }
@@ -48,7 +56,7 @@ void InfObjCoatingParticle::activate() {
       if (hasObjectNbr()) {
         // If a follower has followed its spanning tree to the surface, become a
         // leader, removing follow direction and calculating move direction.
-        state = State::Leader;
+        setState(State::Leader);
         moveDir = nextSurfaceDir();
         return;
       } else if (hasTailAtLabel(moveDir)) {
@@ -63,7 +71,7 @@ void InfObjCoatingParticle::activate() {
     } else if (state == State::Leader) {
       // If has a follower child, generate a complaint token if not holding one.
       if (hasFollowerChild() && !hasToken<ComplaintToken>()) {
-        putToken(std::make_shared<ComplaintToken>());
+        putToken(makeToken<ComplaintToken>());
       }
 
       // Only act if holding a complaint token.
@@ -182,7 +190,9 @@ bool InfObjCoatingParticle::hasFollowerChild() const {
   return labelOfFirstNbrWithProperty<InfObjCoatingParticle>(prop) != -1;
 }
 
-InfObjCoatingSystem::InfObjCoatingSystem(uint numParticles, double holeProb) {
+InfObjCoatingSystem::InfObjCoatingSystem(uint numParticles, double holeProb,
+                                         const unsigned int seed)
+  : AmoebotSystem(seed) {
   Q_ASSERT(numParticles > 0);
   Q_ASSERT(0 <= holeProb && holeProb <= 1);
 
@@ -226,8 +236,9 @@ InfObjCoatingSystem::InfObjCoatingSystem(uint numParticles, double holeProb) {
     for (auto candPos : candidates) {
       // Place a particle at the candidate position with probability 1 - hole.
       if (particleNodes.size() < numParticles && randBool(1 - holeProb)) {
-        insert(new InfObjCoatingParticle(candPos, -1, randDir(), *this,
-                                       InfObjCoatingParticle::State::Inactive));
+        emplaceParticle<InfObjCoatingParticle>(
+            candPos, -1, randDir(), *this,
+            InfObjCoatingParticle::State::Inactive);
         particleNodes.insert(candPos);
         lastAdded.insert(candPos);
       }
@@ -254,14 +265,8 @@ InfObjCoatingSystem::InfObjCoatingSystem(uint numParticles, double holeProb) {
 
 bool InfObjCoatingSystem::hasTerminated() const {
   // Algorithm is terminated if all particles are on the surface (leaders) and
-  // have contracted.
-  for (auto p : particles) {
-    auto iocp = dynamic_cast<InfObjCoatingParticle*>(p);
-    if ((iocp->state != InfObjCoatingParticle::State::Leader) ||
-        iocp->hasToken<InfObjCoatingParticle::ComplaintToken>()) {
-      return false;
-    }
-  }
-
-  return true;
+  // no complaint tokens remain, the only tokens this algorithm uses.
+  using State = InfObjCoatingParticle::State;
+  return numParticlesInState(static_cast<unsigned char>(State::Leader)) ==
+         size() && numHeldTokens() == 0;
 }
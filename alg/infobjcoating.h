@@ -75,6 +75,10 @@ class InfObjCoatingParticle : public AmoebotParticle {
   // object's surface forever.
   struct ComplaintToken : public Token {};
 
+  // Sets this particle's state and publishes it as its snapshot state, so
+  // that the system can count the particles in each state.
+  void setState(State state);
+
   // Particle memory.
   State state;
   int moveDir;
@@ -90,7 +94,8 @@ class InfObjCoatingSystem : public AmoebotSystem {
   // (#particles) and a hole probability. holeProb in [0,1] controls how "spread
   // out" the system is; closer to 0 is more compressed, closer to 1 is more
   // expanded.
-  InfObjCoatingSystem(uint numParticles = 100, double holeProb = 0.2);
+  InfObjCoatingSystem(uint numParticles = 100, double holeProb = 0.2,
+                      const unsigned int seed = 0);
 
   // Checks whether or not the system has completed infinite object coating (all
   // particles contracted and on the object.
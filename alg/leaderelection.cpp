@@ -8,6 +8,8 @@
 
 #include <QtGlobal>
 
+#include "core/resultsink.h"
+
 //----------------------------BEGIN PARTICLE CODE----------------------------
 
 LeaderElectionParticle::LeaderElectionParticle(const Node head,
@@ -18,10 +20,16 @@ LeaderElectionParticle::LeaderElectionParticle(const Node head,
   : AmoebotParticle(head, globalTailDir, orientation, system),
     state(state),
     currentAgent(0) {
+  setSnapshotState(static_cast<unsigned char>(state));
   borderColorLabels.fill(-1);
   borderPointColorLabels.fill(-1);
 }
 
+void LeaderElectionParticle::setState(State state) {
+  this->state = state;
+  setSnapshotState(static_cast<unsigned char>(state));
+}
+
 void LeaderElectionParticle::activate() {
   if (state == State::Idle) {
     // Determine the number of neighbors of the current particle.
@@ -31,16 +39,17 @@ void LeaderElectionParticle::activate() {
     // leader election.
     // Otherwise, the particle may participate in leader election and must
     // generate agents to do so.
-    int numNbrs = getNumberOfNbrs();
+    const Neighborhood nbhd = neighborhood();
+    int numNbrs = nbhd.numNbrs();
     if (numNbrs == 0) {
-      state = State::Leader;
+      setState(State::Leader);
       return;
     } else if (numNbrs == 6) {
-      state = State::Finished;
+      setState(State::Finished);
     } else {
       int agentId = 0;
       for (int dir = 0; dir < 6; dir++) {
-        if (!hasNbrAtLabel(dir) && hasNbrAtLabel((dir + 1) % 6)) {
+        if (!nbhd.hasNbrAtLabel(dir) && nbhd.hasNbrAtLabel((dir + 1) % 6)) {
           Q_ASSERT(agentId < 3);
 
           LeaderElectionAgent* agent = new LeaderElectionAgent();
@@ -60,7 +69,7 @@ void LeaderElectionParticle::activate() {
           agentId++;
         }
       }
-      state = State::Candidate;
+      setState(State::Candidate);
       return;
     }
   } else if (state == State::Candidate) {
@@ -77,14 +86,17 @@ void LeaderElectionParticle::activate() {
         allFinished = false;
       }
       if (agent->agentState == State::Leader) {
-        state = State::Leader;
+        setState(State::Leader);
         return;
       }
     }
 
     if (allFinished) {
-      state = State::Finished;
+      setState(State::Finished);
     }
+  } else {
+    // Finished particles and the leader never act again.
+    sleep();
   }
 
   return;
@@ -180,10 +192,11 @@ LeaderElectionParticle& LeaderElectionParticle::nbrAtLabel(int label) const {
 }
 
 int LeaderElectionParticle::getNextAgentDir(const int agentDir) const {
-  Q_ASSERT(!hasNbrAtLabel(agentDir));
+  const Neighborhood nbhd = neighborhood();
+  Q_ASSERT(!nbhd.hasNbrAtLabel(agentDir));
 
   for (int dir = 1; dir < 6; dir++) {
-    if (hasNbrAtLabel((agentDir - dir + 6) % 6)) {
+    if (nbhd.hasNbrAtLabel((agentDir - dir + 6) % 6)) {
       return (agentDir - dir + 6) % 6;
     }
   }
@@ -193,10 +206,11 @@ int LeaderElectionParticle::getNextAgentDir(const int agentDir) const {
 }
 
 int LeaderElectionParticle::getPrevAgentDir(const int agentDir) const {
-  Q_ASSERT(!hasNbrAtLabel(agentDir));
+  const Neighborhood nbhd = neighborhood();
+  Q_ASSERT(!nbhd.hasNbrAtLabel(agentDir));
 
   for (int dir = 1; dir < 6; dir++) {
-    if (hasNbrAtLabel((agentDir + dir) % 6)) {
+    if (nbhd.hasNbrAtLabel((agentDir + dir) % 6)) {
       return (agentDir + dir) % 6;
     }
   }
@@ -206,13 +220,10 @@ int LeaderElectionParticle::getPrevAgentDir(const int agentDir) const {
 }
 
 int LeaderElectionParticle::getNumberOfNbrs() const {
-  int count = 0;
-  for (int dir = 0; dir < 6; dir++) {
-    if (hasNbrAtLabel(dir)) {
-      count++;
-    }
-  }
-  return count;
+  // Only labels 0-5 are counted, also when this particle is expanded.
+  Neighborhood nbhd = neighborhood();
+  nbhd.particles &= 0x3f;
+  return nbhd.numNbrs();
 }
 
 //----------------------------END PARTICLE CODE----------------------------
@@ -228,7 +239,7 @@ LeaderElectionParticle::LeaderElectionAgent::LeaderElectionAgent() :
   candidateParticle(nullptr) {}
 
 void LeaderElectionParticle::LeaderElectionAgent::activate() {
-  passTokensDir = randInt(0, 2);
+  passTokensDir = candidateParticle->randInt(0, 2);
   if (agentState == State::Candidate) {
     // Segment Comparison
     if (hasAgentToken<ActiveSegmentCleanToken>(nextAgentDir)) {
@@ -247,7 +258,7 @@ void LeaderElectionParticle::LeaderElectionAgent::activate() {
         takeAgentToken<SegmentLeadToken>(prevAgentDir);
         passAgentToken<PassiveSegmentToken>
             (prevAgentDir,
-             std::make_shared<PassiveSegmentToken>(-1, true));
+             makeToken<PassiveSegmentToken>(-1, true));
         paintBackSegment(0x696969);
       }
     }
@@ -261,16 +272,16 @@ void LeaderElectionParticle::LeaderElectionAgent::activate() {
           takeAgentToken<ActiveSegmentToken>(nextAgentDir);
           passAgentToken<FinalSegmentCleanToken>
               (nextAgentDir,
-               std::make_shared<FinalSegmentCleanToken>(-1, true));
+               makeToken<FinalSegmentCleanToken>(-1, true));
         } else if (next != nullptr &&
                    !next->hasAgentToken<PassiveSegmentCleanToken>
                    (next->prevAgentDir)) {
           passAgentToken<PassiveSegmentCleanToken>
-              (nextAgentDir, std::make_shared<PassiveSegmentCleanToken>());
+              (nextAgentDir, makeToken<PassiveSegmentCleanToken>());
           passiveClean(true);
           generatedCleanToken = true;
           candidateParticle->putToken
-              (std::make_shared<ActiveSegmentCleanToken>(nextAgentDir));
+              (makeToken<ActiveSegmentCleanToken>(nextAgentDir));
           activeClean(true);
           absorbedActiveToken = true;
           isCoveredCandidate = true;
@@ -281,7 +292,7 @@ void LeaderElectionParticle::LeaderElectionAgent::activate() {
       } else {
         Q_ASSERT(false);
         passAgentToken<ActiveSegmentToken>
-            (prevAgentDir, std::make_shared<ActiveSegmentToken>());
+            (prevAgentDir, makeToken<ActiveSegmentToken>());
       }
     }
 
@@ -290,7 +301,7 @@ void LeaderElectionParticle::LeaderElectionAgent::activate() {
         passTokensDir == 1) {
       takeAgentToken<CandidacyAnnounceToken>(prevAgentDir);
       passAgentToken<CandidacyAckToken>
-          (prevAgentDir, std::make_shared<CandidacyAckToken>());
+          (prevAgentDir, makeToken<CandidacyAckToken>());
       paintBackSegment(0x696969);
       if (waitingForTransferAck) {
         gotAnnounceBeforeAck = true;
@@ -341,7 +352,7 @@ void LeaderElectionParticle::LeaderElectionAgent::activate() {
               takeAgentToken<PassiveSegmentToken>(nextAgentDir)->isFinal;
           passAgentToken<ActiveSegmentToken>
               (prevAgentDir,
-               std::make_shared<ActiveSegmentToken>(-1, isFinalCheck));
+               makeToken<ActiveSegmentToken>(-1, isFinalCheck));
           if (isFinalCheck) {
             paintFrontSegment(0x696969);
           }
@@ -363,7 +374,7 @@ void LeaderElectionParticle::LeaderElectionAgent::activate() {
         return;
       } else if (!comparingSegment && passTokensDir == 0) {
         passAgentToken<SegmentLeadToken>
-            (nextAgentDir, std::make_shared<SegmentLeadToken>());
+            (nextAgentDir, makeToken<SegmentLeadToken>());
         paintFrontSegment(0xff0000);
         comparingSegment = true;
       }
@@ -380,18 +391,19 @@ void LeaderElectionParticle::LeaderElectionAgent::activate() {
         waitingForTransferAck = false;
         gotAnnounceBeforeAck = false;
         return;
-      } else if (!waitingForTransferAck && passTokensDir == 0 && randBool()) {
+      } else if (!waitingForTransferAck && passTokensDir == 0 &&
+                 candidateParticle->randBool()) {
         passAgentToken<CandidacyAnnounceToken>
-            (nextAgentDir, std::make_shared<CandidacyAnnounceToken>());
+            (nextAgentDir, makeToken<CandidacyAnnounceToken>());
         paintFrontSegment(0xffa500);
         waitingForTransferAck = true;
       }
     } else if (subPhase == SubPhase::SolitudeVerification) {
       if (!createdLead && passTokensDir == 0) {
         passAgentToken<SolitudeActiveToken>
-            (nextAgentDir, std::make_shared<SolitudeActiveToken>());
+            (nextAgentDir, makeToken<SolitudeActiveToken>());
         candidateParticle->putToken
-            (std::make_shared<SolitudePositiveXToken>(nextAgentDir, true));
+            (makeToken<SolitudePositiveXToken>(nextAgentDir, true));
         paintFrontSegment(0x00bfff);
         createdLead = true;
         hasGeneratedTokens = true;
@@ -459,7 +471,7 @@ void LeaderElectionParticle::LeaderElectionAgent::activate() {
       passAgentToken<SegmentLeadToken>
           (nextAgentDir, takeAgentToken<SegmentLeadToken>(prevAgentDir));
       candidateParticle->putToken(
-            std::make_shared<PassiveSegmentToken>(nextAgentDir, false));
+            makeToken<PassiveSegmentToken>(nextAgentDir, false));
       paintBackSegment(0xff0000);
       paintFrontSegment(0xff0000);
     }
@@ -477,7 +489,7 @@ void LeaderElectionParticle::LeaderElectionAgent::activate() {
       if (passTokensDir == 0 && !absorbedActiveToken) {
         if (takeAgentToken<ActiveSegmentToken>(nextAgentDir)->isFinal) {
           passAgentToken<FinalSegmentCleanToken>
-              (nextAgentDir, std::make_shared<FinalSegmentCleanToken>(-1, isCoveredCandidate));
+              (nextAgentDir, makeToken<FinalSegmentCleanToken>(-1, isCoveredCandidate));
           isCoveredCandidate = false;
         } else {
           absorbedActiveToken = true;
@@ -528,7 +540,7 @@ void LeaderElectionParticle::LeaderElectionAgent::activate() {
         next != nullptr &&
         !next->hasAgentToken<PassiveSegmentCleanToken>(next->prevAgentDir) &&
         !hasGeneratedTokens) {
-      std::shared_ptr<SolitudeActiveToken> token =
+      TokenPtr<SolitudeActiveToken> token =
           takeAgentToken<SolitudeActiveToken>(prevAgentDir);
       std::pair<int, int> generatedPair = augmentDirVector(token->vector);
       generateSolitudeVectorTokens(generatedPair);
@@ -550,7 +562,7 @@ void LeaderElectionParticle::LeaderElectionAgent::activate() {
             (prevAgentDir, takeAgentToken<SolitudeActiveToken>(nextAgentDir));
         cleanSolitudeVerificationTokens();
       } else if (checkX == 0 || checkY == 0) {
-        std::shared_ptr<SolitudeActiveToken> token =
+        TokenPtr<SolitudeActiveToken> token =
             takeAgentToken<SolitudeActiveToken>(nextAgentDir);
         token->isSoleCandidate = false;
         passAgentToken<SolitudeActiveToken>(prevAgentDir, token);
@@ -627,7 +639,7 @@ void LeaderElectionParticle::LeaderElectionAgent::activate() {
     }
 
     if (passTokensDir == 0 && hasAgentToken<BorderTestToken>(prevAgentDir)) {
-      std::shared_ptr<BorderTestToken> token =
+      TokenPtr<BorderTestToken> token =
           takeAgentToken<BorderTestToken>(prevAgentDir);
       token->borderSum = addNextBorder(token->borderSum);
       passAgentToken<BorderTestToken>(nextAgentDir, token);
@@ -639,8 +651,8 @@ void LeaderElectionParticle::LeaderElectionAgent::activate() {
 
   } else if (agentState == State::SoleCandidate) {
     if (!testingBorder) {
-      std::shared_ptr<BorderTestToken> token =
-          std::make_shared<BorderTestToken>(prevAgentDir, addNextBorder(0));
+      TokenPtr<BorderTestToken> token =
+          makeToken<BorderTestToken>(prevAgentDir, addNextBorder(0));
       passAgentToken(nextAgentDir, token);
       paintFrontSegment(-1);
       testingBorder = true;
@@ -755,13 +767,13 @@ generateSolitudeVectorTokens(std::pair<int, int> vector) {
   switch(vector.first) {
     case -1:
       candidateParticle->putToken
-          (std::make_shared<SolitudeNegativeXToken>(nextAgentDir, false));
+          (makeToken<SolitudeNegativeXToken>(nextAgentDir, false));
       break;
     case 0:
       break;
     case 1:
       candidateParticle->putToken
-          (std::make_shared<SolitudePositiveXToken>(nextAgentDir, false));
+          (makeToken<SolitudePositiveXToken>(nextAgentDir, false));
       break;
     default:
       Q_ASSERT(false);
@@ -770,13 +782,13 @@ generateSolitudeVectorTokens(std::pair<int, int> vector) {
   switch(vector.second) {
     case -1:
       candidateParticle->putToken
-          (std::make_shared<SolitudeNegativeYToken>(nextAgentDir, false));
+          (makeToken<SolitudeNegativeYToken>(nextAgentDir, false));
       break;
     case 0:
       break;
     case 1:
       candidateParticle->putToken
-          (std::make_shared<SolitudePositiveYToken>(nextAgentDir, false));
+          (makeToken<SolitudePositiveYToken>(nextAgentDir, false));
       break;
     default:
       Q_ASSERT(false);
@@ -871,34 +883,40 @@ addNextBorder(int currentSum) const {
 template <class TokenType>
 bool LeaderElectionParticle::LeaderElectionAgent::
 hasAgentToken(int agentDir) const{
-    auto prop = [agentDir](const std::shared_ptr<TokenType> token) {
+    auto prop = [agentDir](const TokenPtr<TokenType> token) {
       return token->origin == agentDir;
     };
     return candidateParticle->hasToken<TokenType>(prop);
 }
 
 template <class TokenType>
-std::shared_ptr<TokenType>
+TokenPtr<TokenType>
 LeaderElectionParticle::LeaderElectionAgent::
 peekAgentToken(int agentDir) const {
-  auto prop = [agentDir](const std::shared_ptr<TokenType> token) {
+  auto prop = [agentDir](const TokenPtr<TokenType> token) {
     return token->origin == agentDir;
   };
   return candidateParticle->peekAtToken<TokenType>(prop);
 }
 
 template <class TokenType>
-std::shared_ptr<TokenType>
+TokenPtr<TokenType>
 LeaderElectionParticle::LeaderElectionAgent::takeAgentToken(int agentDir) {
-  auto prop = [agentDir](const std::shared_ptr<TokenType> token) {
+  auto prop = [agentDir](const TokenPtr<TokenType> token) {
     return token->origin == agentDir;
   };
   return candidateParticle->takeToken<TokenType>(prop);
 }
 
+template <class TokenType, class... Args>
+TokenPtr<TokenType>
+LeaderElectionParticle::LeaderElectionAgent::makeToken(Args&&... args) const {
+  return candidateParticle->makeToken<TokenType>(std::forward<Args>(args)...);
+}
+
 template <class TokenType>
 void LeaderElectionParticle::LeaderElectionAgent::
-passAgentToken(int agentDir, std::shared_ptr<TokenType> token) {
+passAgentToken(int agentDir, TokenPtr<TokenType> token) {
   LeaderElectionParticle* nbr = &candidateParticle->nbrAtLabel(agentDir);
   int origin = -1;
   for (int i = 0; i < 6; i++) {
@@ -1027,51 +1045,32 @@ void LeaderElectionParticle::LeaderElectionAgent::paintBackSegment(
 //----------------------------BEGIN SYSTEM CODE----------------------------
 
 #include <string>
-#include <fstream>
-#include <sstream>
 #include <QTextStream>
 
 using namespace std;
 
-LeaderElectionSystem::LeaderElectionSystem(int numParticles, double holeProb, QString fileName) {
+LeaderElectionSystem::LeaderElectionSystem(int numParticles, double holeProb, QString fileName, const unsigned int seed)
+  : AmoebotSystem(seed) {
   Q_ASSERT(numParticles > 0 || fileName.size() > 0);
   Q_ASSERT((0 <= holeProb && holeProb <= 1) || fileName.size() > 0);
 
   randomPermutationScheduler = true;
 
-  string filePath = "../AmoebotSim/data/input/" + fileName.toStdString() + ".txt";
   if (fileName != "") {
     QTextStream out(stdout);
     out << "File name: " << fileName << endl;
-    ifstream file(filePath);
-    if (!file) {
-      out << "Cannot open file." << endl;
+    std::vector<ConfigurationRecord> records;
+    QString error;
+    if (!readConfiguration(inputConfigurationPath(fileName), records, error)) {
+      out << error << endl;
       return;
     }
     out << "File opened." << endl;
-    
-    string str;
-    while (getline(file, str)) {
-      std::vector<int> vect;
-      std::stringstream ss(str);
-
-      while (ss.good()) {
-        string substr;
-        getline(ss, substr, ',');
-        vect.push_back(std::stoi(substr));
-      }
-
-      int x = vect[0];
-      int y = vect[1];
-
-      insert(new LeaderElectionParticle(
-      Node(x, y), -1, randDir(), *this,
-      LeaderElectionParticle::State::Idle));
-    }
 
-    file.close();
+    emplaceParticles<LeaderElectionParticle>(
+        records, LeaderElectionParticle::State::Idle);
 
-    outputPath = "../AmoebotSim/data/output/" + fileName.toStdString() + ".txt";
+    inputName = fileName;
 
     out << "Particle system initialized from file." << endl;
     
@@ -1079,8 +1078,8 @@ LeaderElectionSystem::LeaderElectionSystem(int numParticles, double holeProb, QS
   }
 
   // Insert the seed at (0,0).
-  insert(new LeaderElectionParticle(Node(0, 0), -1, randDir(), *this,
-                                    LeaderElectionParticle::State::Idle));
+  emplaceParticle<LeaderElectionParticle>(
+      Node(0, 0), -1, randDir(), *this, LeaderElectionParticle::State::Idle);
   std::set<Node> occupied;
   occupied.insert(Node(0, 0));
 
@@ -1109,8 +1108,9 @@ LeaderElectionSystem::LeaderElectionSystem(int numParticles, double holeProb, QS
 
     // Add this candidate as a particle if not a hole.
     if (randBool(1.0 - holeProb)) {
-      insert(new LeaderElectionParticle(randomCandidate, -1, randDir(), *this,
-                                        LeaderElectionParticle::State::Idle));
+      emplaceParticle<LeaderElectionParticle>(
+          randomCandidate, -1, randDir(), *this,
+          LeaderElectionParticle::State::Idle);
       ++numNonStaticParticles;
 
       // Add new candidates.
@@ -1126,39 +1126,38 @@ LeaderElectionSystem::LeaderElectionSystem(int numParticles, double holeProb, QS
 
 bool LeaderElectionSystem::hasTerminated() const {
   #ifdef QT_DEBUG
-    if (!isConnected(particles)) {
+    if (!isConnected(snapshot())) {
       return true;
     }
   #endif
 
-  for (auto p : particles) {
-    auto hp = dynamic_cast<LeaderElectionParticle*>(p);
-    if (hp->state != LeaderElectionParticle::State::Leader &&
-        hp->state != LeaderElectionParticle::State::Finished) {
-      return false;
-    }
+  using State = LeaderElectionParticle::State;
+  if (numParticlesInState(static_cast<unsigned char>(State::Leader)) +
+      numParticlesInState(static_cast<unsigned char>(State::Finished)) !=
+      size()) {
+    return false;
   }
 
-  for (auto p : particles) {
-    auto hp = dynamic_cast<LeaderElectionParticle*>(p);
-    if (hp->state == LeaderElectionParticle::State::Leader) {
-      if (outputPath != "") {
-        ofstream file;
-        file.open(outputPath);
-        file << std::to_string(hp->head.x) << "," << std::to_string(hp->head.y);
+  return true;
+}
 
-        file << "\n" << std::to_string(getCount("# Rounds")._value);
-        file << "\n" << std::to_string(getCount("# Activations")._value);
-        file << "\n" << std::to_string(getCount("# Moves")._value);
+bool LeaderElectionSystem::supportsParallelRounds() const {
+  return true;
+}
 
-        file.close();
+bool LeaderElectionSystem::reportsResults() const {
+  return true;
+}
 
-        QTextStream out(stdout);
-        out << "Output written to: " << QString::fromStdString(outputPath) << endl;
-      }
-      break;
+void LeaderElectionSystem::writeResult(ResultRow& row) const {
+  row.input = inputName;
+  for (auto p : particles) {
+    auto hp = dynamic_cast<LeaderElectionParticle*>(p);
+    if (hp->state == LeaderElectionParticle::State::Leader) {
+      row.hasLeader = true;
+      row.leaderX = hp->head.x;
+      row.leaderY = hp->head.y;
+      return;
     }
   }
-
-  return true;
 }
@@ -338,11 +338,13 @@ class LeaderElectionParticle : public AmoebotParticle {
     template <class TokenType>
     bool hasAgentToken(int agentDir) const;
     template <class TokenType>
-    std::shared_ptr<TokenType> peekAgentToken(int agentDir) const;
+    TokenPtr<TokenType> peekAgentToken(int agentDir) const;
     template <class TokenType>
-    std::shared_ptr<TokenType> takeAgentToken(int agentDir);
+    TokenPtr<TokenType> takeAgentToken(int agentDir);
     template <class TokenType>
-    void passAgentToken(int agentDir, std::shared_ptr<TokenType> token);
+    void passAgentToken(int agentDir, TokenPtr<TokenType> token);
+    template <class TokenType, class... Args>
+    TokenPtr<TokenType> makeToken(Args&&... args) const;
     LeaderElectionAgent* nextAgent() const;
     LeaderElectionAgent* prevAgent() const;
 
@@ -369,6 +371,10 @@ class LeaderElectionParticle : public AmoebotParticle {
   };
 
   protected:
+   // Sets this particle's state and publishes it as its snapshot state, so
+   // that the system can count the particles in each state.
+   void setState(State state);
+
    State state;
    unsigned int currentAgent;
    std::vector<LeaderElectionAgent*> agents;
@@ -382,13 +388,28 @@ class LeaderElectionSystem : public AmoebotSystem {
   // size (#particles), and hole probability. holeProb in [0,1] controls how
   // "spread out" the system is; closer to 0 is more compressed, closer to 1 is
   // more expanded.
-  LeaderElectionSystem(int numParticles = 100, double holeProb = 0.2, QString fileName = "");
-
-  string outputPath = "";
+  LeaderElectionSystem(int numParticles = 100, double holeProb = 0.2, QString fileName = "", const unsigned int seed = 0);
 
   // Checks whether or not the system's run of the Leader Election algorithm has
   // terminated (all particles in state Finished or Leader).
   bool hasTerminated() const override;
+
+  // Activations only involve a particle and its neighbors, so this system can
+  // be run in parallel rounds.
+  bool supportsParallelRounds() const override;
+
+  // Results report the elected leader, so they are kept from GUI runs too.
+  bool reportsResults() const override;
+
+ protected:
+  // Reports the input configuration the system was loaded from and the
+  // position of the elected leader.
+  void writeResult(ResultRow& row) const override;
+
+ private:
+  // The name of the input configuration the system was loaded from, or
+  // empty.
+  QString inputName;
 };
 
 #endif  // AMOEBOTSIM_ALG_LEADERELECTION_H_
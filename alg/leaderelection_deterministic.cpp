@@ -15,6 +15,8 @@
 
 #include <QDebug>
 
+#include "core/resultsink.h"
+
 using namespace std;
 
 //----------------------------BEGIN PARTICLE CODE----------------------------
@@ -22,14 +24,21 @@ using namespace std;
 LeaderElectionDeterministicParticle::LeaderElectionDeterministicParticle(
     const Node head, const int globalTailDir, const int orientation,
     AmoebotSystem &system, State state)
-    : AmoebotParticle(head, globalTailDir, orientation, system), state(state) {}
+    : AmoebotParticle(head, globalTailDir, orientation, system), state(state) {
+  setSnapshotState(static_cast<unsigned char>(state));
+}
+
+void LeaderElectionDeterministicParticle::setState(State state) {
+  this->state = state;
+  setSnapshotState(static_cast<unsigned char>(state));
+}
 
 void LeaderElectionDeterministicParticle::activate() {
   if (state == State::Initlialization) {
     if (!isBoundaryParticle()) {
       // Particles not on a boundary change to phase 2 and wait
       onOuterBoundary = false;
-      state = State::ForestFormation;
+      setState(State::ForestFormation);
       return;
     }
     else {
@@ -92,38 +101,38 @@ void LeaderElectionDeterministicParticle::activate() {
           // Head (and possibly also tail) of segment
 
           if (hasToken<TerminationToken>()) {
-            std::shared_ptr<TerminationToken> token = peekAtToken<TerminationToken>();
+            TokenPtr<TerminationToken> token = peekAtToken<TerminationToken>();
             if (globalToLocalDir(token->origin) == nextNbr) {
               takeToken<TerminationToken>();
               if (token->traversed + 1 < token->ttl) {
                 LeaderElectionDeterministicParticle &nbr = nbrAtLabel(prevNbr);
-                nbr.putToken(std::make_shared<TerminationToken>(localToGlobalDir((prevNbr+3)%6), token->ttl, token->traversed+1));
+                nbr.putToken(makeToken<TerminationToken>(localToGlobalDir((prevNbr+3)%6), token->ttl, token->traversed+1));
               }
               numCandidates = token->ttl;
-              state = State::ForestFormationCandidate;
+              setState(State::ForestFormationCandidate);
               return;
             }
           }
 
           // receive and process count request tokens
           if (hasToken<CountRequestToken>()) {
-            std::shared_ptr<CountRequestToken> token = peekAtToken<CountRequestToken>();
+            TokenPtr<CountRequestToken> token = peekAtToken<CountRequestToken>();
             if (globalToLocalDir(token->origin) == prevNbr) {
               qDebug() << "Sending count: " << QString::number(count);
               takeToken<CountRequestToken>();
               LeaderElectionDeterministicParticle &nbr = nbrAtLabel(prevNbr);
-              nbr.putToken(std::make_shared<CountToken>(localToGlobalDir((prevNbr+3)%6), count));
+              nbr.putToken(makeToken<CountToken>(localToGlobalDir((prevNbr+3)%6), count));
             }
           }
 
           // receive and process termination detection tokens
           if (hasToken<TerminationDetectionToken>()) {
-            std::shared_ptr<TerminationDetectionToken> token = peekAtToken<TerminationDetectionToken>();
+            TokenPtr<TerminationDetectionToken> token = peekAtToken<TerminationDetectionToken>();
             if (globalToLocalDir(token->origin) == nextNbr) {
               if (token->count != count || mergeRequested) {
                 takeToken<TerminationDetectionToken>();
                 LeaderElectionDeterministicParticle &nbr = nbrAtLabel(nextNbr);
-                nbr.putToken(std::make_shared<TerminationDetectionReturnToken>(localToGlobalDir((nextNbr+3)%6), token->count, token->traversed+1, 1, false));
+                nbr.putToken(makeToken<TerminationDetectionReturnToken>(localToGlobalDir((nextNbr+3)%6), token->count, token->traversed+1, 1, false));
               }
               else {
                 // counts equal -> await lexicographic comparison
@@ -137,7 +146,7 @@ void LeaderElectionDeterministicParticle::activate() {
             }
           }
           if (hasToken<TerminationDetectionReturnToken>()) {
-            std::shared_ptr<TerminationDetectionReturnToken> token = peekAtToken<TerminationDetectionReturnToken>();
+            TokenPtr<TerminationDetectionReturnToken> token = peekAtToken<TerminationDetectionReturnToken>();
             if (globalToLocalDir(token->origin) == prevNbr) {
               takeToken<TerminationDetectionReturnToken>();
               if (token->traversed + 1 == token->ttl) {
@@ -145,42 +154,42 @@ void LeaderElectionDeterministicParticle::activate() {
                 terminationDetections[i] = false;
                 if (token->termination) {
                   LeaderElectionDeterministicParticle &nbr = nbrAtLabel(prevNbr);
-                  nbr.putToken(std::make_shared<TerminationToken>(localToGlobalDir((prevNbr+3)%6), 6/count+1, 1));
+                  nbr.putToken(makeToken<TerminationToken>(localToGlobalDir((prevNbr+3)%6), 6/count+1, 1));
                   numCandidates = 6/count;
                   return;
                 }
               }
               else if (token->count == count) {
                 LeaderElectionDeterministicParticle &nbr = nbrAtLabel(nextNbr);
-                nbr.putToken(std::make_shared<TerminationDetectionReturnToken>(localToGlobalDir((nextNbr+3)%6), token->count, token->ttl, token->traversed+1, token->termination));
+                nbr.putToken(makeToken<TerminationDetectionReturnToken>(localToGlobalDir((nextNbr+3)%6), token->count, token->ttl, token->traversed+1, token->termination));
               }
               else {
                 LeaderElectionDeterministicParticle &nbr = nbrAtLabel(nextNbr);
-                nbr.putToken(std::make_shared<TerminationDetectionReturnToken>(localToGlobalDir((nextNbr+3)%6), token->count, token->ttl, token->traversed+1, false));
+                nbr.putToken(makeToken<TerminationDetectionReturnToken>(localToGlobalDir((nextNbr+3)%6), token->count, token->ttl, token->traversed+1, false));
               }
             }
           }
 
           // receive and process merge request tokens
           if (hasToken<MergeRequestCountToken>()) {
-            std::shared_ptr<MergeRequestCountToken> token = peekAtToken<MergeRequestCountToken>();
+            TokenPtr<MergeRequestCountToken> token = peekAtToken<MergeRequestCountToken>();
             if (globalToLocalDir(token->origin) == prevNbr) {
               takeToken<MergeRequestCountToken>();
               qDebug() << "Received merge request...";
               LeaderElectionDeterministicParticle &nbr = nbrAtLabel(prevNbr);
               if (mergeRequested || !(token->count > count && token->count + count <= 6 && token->count > 0)) {
-                nbr.putToken(std::make_shared<MergeNackToken>(localToGlobalDir((prevNbr+3)%6)));
+                nbr.putToken(makeToken<MergeNackToken>(localToGlobalDir((prevNbr+3)%6)));
                 qDebug() << "Merge declined";
               }
               else {
                 qDebug() << "Acknowledging merge...";
-                nbr.putToken(std::make_shared<MergeAckToken>(localToGlobalDir((prevNbr+3)%6), count));
+                nbr.putToken(makeToken<MergeAckToken>(localToGlobalDir((prevNbr+3)%6), count));
                 predecessors[i] = prevNbr;
                 segHeads[i] = false;
                 // interrupt lexicographic comparison with next segment if applicable
                 if (lexicoGraphicComparison) {
                   LeaderElectionDeterministicParticle &nbr = nbrAtLabel(nextNbr);
-                  nbr.putToken(std::make_shared<LexCompInterruptNextToken>(localToGlobalDir((nextNbr+3)%6)));
+                  nbr.putToken(makeToken<LexCompInterruptNextToken>(localToGlobalDir((nextNbr+3)%6)));
                   cleanup(i);
                 }
                 continue;
@@ -188,24 +197,24 @@ void LeaderElectionDeterministicParticle::activate() {
             }
           }
           if (hasToken<LexCompMergeRequestToken>()) {
-            std::shared_ptr<LexCompMergeRequestToken> token = peekAtToken<LexCompMergeRequestToken>();
+            TokenPtr<LexCompMergeRequestToken> token = peekAtToken<LexCompMergeRequestToken>();
             if (globalToLocalDir(token->origin) == prevNbr) {
               takeToken<LexCompMergeRequestToken>();
               qDebug() << "Received lexicographic comparison merge request...";
               LeaderElectionDeterministicParticle &nbr = nbrAtLabel(prevNbr);
               if (mergeRequested || !(token->count == count && token->count + count <= 6 && token->count > 0)) {
-                nbr.putToken(std::make_shared<MergeNackToken>(localToGlobalDir((prevNbr+3)%6)));
+                nbr.putToken(makeToken<MergeNackToken>(localToGlobalDir((prevNbr+3)%6)));
                 qDebug() << "Merge declined";
               }
               else {
                 qDebug() << "Acknowledging merge...";
-                nbr.putToken(std::make_shared<MergeAckToken>(localToGlobalDir((prevNbr+3)%6), count));
+                nbr.putToken(makeToken<MergeAckToken>(localToGlobalDir((prevNbr+3)%6), count));
                 predecessors[i] = prevNbr;
                 segHeads[i] = false;
                 // interrupt lexicographic comparison with next segment if applicable
                 if (lexicoGraphicComparison) {
                   LeaderElectionDeterministicParticle &nbr = nbrAtLabel(nextNbr);
-                  nbr.putToken(std::make_shared<LexCompInterruptNextToken>(localToGlobalDir((nextNbr+3)%6)));
+                  nbr.putToken(makeToken<LexCompInterruptNextToken>(localToGlobalDir((nextNbr+3)%6)));
                   cleanup(i);
                 }
                 continue;
@@ -215,7 +224,7 @@ void LeaderElectionDeterministicParticle::activate() {
 
           // receive and process interrupt tokens
           if (hasToken<LexCompInterruptNextToken>()) {
-            std::shared_ptr<LexCompInterruptNextToken> token = peekAtToken<LexCompInterruptNextToken>();
+            TokenPtr<LexCompInterruptNextToken> token = peekAtToken<LexCompInterruptNextToken>();
             if (globalToLocalDir(token->origin) == prevNbr) {
               takeToken<LexCompInterruptNextToken>();
               cleanupForNbr(i);
@@ -223,7 +232,7 @@ void LeaderElectionDeterministicParticle::activate() {
             }
           }
           if (hasToken<LexCompInterruptPrevToken>()) {
-            std::shared_ptr<LexCompInterruptPrevToken> token = peekAtToken<LexCompInterruptPrevToken>();
+            TokenPtr<LexCompInterruptPrevToken> token = peekAtToken<LexCompInterruptPrevToken>();
             if (globalToLocalDir(token->origin) == nextNbr) {
               takeToken<LexCompInterruptPrevToken>();
               cleanup(i);
@@ -233,24 +242,24 @@ void LeaderElectionDeterministicParticle::activate() {
 
           // receive label requests from previous segment
           if (hasToken<LexCompRequestNbrLabelToken>()) {
-            std::shared_ptr<LexCompRequestNbrLabelToken> token = peekAtToken<LexCompRequestNbrLabelToken>();
+            TokenPtr<LexCompRequestNbrLabelToken> token = peekAtToken<LexCompRequestNbrLabelToken>();
             if (globalToLocalDir(token->origin) == prevNbr) {
               takeToken<LexCompRequestNbrLabelToken>();
               if (!sentNbrLabel) {
                 qDebug() << "Sending label to neighbor: " << QString::number(label);
                 LeaderElectionDeterministicParticle &nbr = nbrAtLabel(prevNbr);
-                nbr.putToken(std::make_shared<LexCompReturnNbrLabelToken>(localToGlobalDir((prevNbr+3)%6), label));
+                nbr.putToken(makeToken<LexCompReturnNbrLabelToken>(localToGlobalDir((prevNbr+3)%6), label));
                 sentNbrLabels[i] = true;
                 sentNbrLabel = true;
               }
               else if (successor == -1) {
                 LeaderElectionDeterministicParticle &nbr = nbrAtLabel(prevNbr);
-                nbr.putToken(std::make_shared<LexCompReturnNbrEndOfSegmentToken>(localToGlobalDir((prevNbr+3)%6)));
+                nbr.putToken(makeToken<LexCompReturnNbrEndOfSegmentToken>(localToGlobalDir((prevNbr+3)%6)));
                 cleanupForNbr(i);
               }
               else {
                 LeaderElectionDeterministicParticle &nbr = nbrAtLabel(nextNbr);
-                nbr.putToken(std::make_shared<LexCompReqLabelForNbrToken>(localToGlobalDir((nextNbr+3)%6)));
+                nbr.putToken(makeToken<LexCompReqLabelForNbrToken>(localToGlobalDir((nextNbr+3)%6)));
                 reqLabelsForNbr[i] = true;
                 reqLabelForNbr = true;
               }
@@ -260,22 +269,22 @@ void LeaderElectionDeterministicParticle::activate() {
           if (reqLabelForNbr) {
             // receive labels for previous segment and send them
             if (hasToken<LexCompReturnLabelForNbrToken>()) {
-              std::shared_ptr<LexCompReturnLabelForNbrToken> token = peekAtToken<LexCompReturnLabelForNbrToken>();
+              TokenPtr<LexCompReturnLabelForNbrToken> token = peekAtToken<LexCompReturnLabelForNbrToken>();
               if (globalToLocalDir(token->origin) == nextNbr) {
                 takeToken<LexCompReturnLabelForNbrToken>();
                 LeaderElectionDeterministicParticle &nbr = nbrAtLabel(prevNbr);
-                nbr.putToken(std::make_shared<LexCompReturnNbrLabelToken>(localToGlobalDir((prevNbr+3)%6), token->label));
+                nbr.putToken(makeToken<LexCompReturnNbrLabelToken>(localToGlobalDir((prevNbr+3)%6), token->label));
                 reqLabelForNbr = false;
                 reqLabelsForNbr[i] = false;
               }
             }
             if (hasToken<LexCompEndOfSegmentForNbrToken>()) {
               // receive end of segment tokens and send them to previous segment
-              std::shared_ptr<LexCompEndOfSegmentForNbrToken> token = peekAtToken<LexCompEndOfSegmentForNbrToken>();
+              TokenPtr<LexCompEndOfSegmentForNbrToken> token = peekAtToken<LexCompEndOfSegmentForNbrToken>();
               if (globalToLocalDir(token->origin) == nextNbr) {
                 takeToken<LexCompEndOfSegmentForNbrToken>();
                 LeaderElectionDeterministicParticle &nbr = nbrAtLabel(prevNbr);
-                nbr.putToken(std::make_shared<LexCompReturnNbrEndOfSegmentToken>(localToGlobalDir((prevNbr+3)%6)));
+                nbr.putToken(makeToken<LexCompReturnNbrEndOfSegmentToken>(localToGlobalDir((prevNbr+3)%6)));
                 reqLabelForNbr = false;
                 reqLabelsForNbr[i] = false;
                 cleanupForNbr(i);
@@ -305,7 +314,7 @@ void LeaderElectionDeterministicParticle::activate() {
               else {
                 qDebug() << "Requesting internal label...";
                 LeaderElectionDeterministicParticle &nbr = nbrAtLabel(nextNbr);
-                nbr.putToken(std::make_shared<LexCompReqLabelToken>(localToGlobalDir((nextNbr+3)%6)));
+                nbr.putToken(makeToken<LexCompReqLabelToken>(localToGlobalDir((nextNbr+3)%6)));
                 reqLabels[i] = true;
                 reqLabel = true;
               }
@@ -313,7 +322,7 @@ void LeaderElectionDeterministicParticle::activate() {
             if (reqLabel && !receivedLabel) {
               // receive internal labels
               if (hasToken<LexCompReturnLabelToken>()) {
-                std::shared_ptr<LexCompReturnLabelToken> token = peekAtToken<LexCompReturnLabelToken>();
+                TokenPtr<LexCompReturnLabelToken> token = peekAtToken<LexCompReturnLabelToken>();
                 if (globalToLocalDir(token->origin) == nextNbr) {
                   qDebug() << "Receiving internal label: " << QString::number(token->label);
                   takeToken<LexCompReturnLabelToken>();
@@ -327,7 +336,7 @@ void LeaderElectionDeterministicParticle::activate() {
               }
               // receive end of segment tokens
               if (hasToken<LexCompEndOfSegmentToken>()) {
-                std::shared_ptr<LexCompEndOfSegmentToken> token = peekAtToken<LexCompEndOfSegmentToken>();
+                TokenPtr<LexCompEndOfSegmentToken> token = peekAtToken<LexCompEndOfSegmentToken>();
                 if (globalToLocalDir(token->origin) == nextNbr) {
                   qDebug() << "Receiving internal end of segment token...";
                   takeToken<LexCompEndOfSegmentToken>();
@@ -344,13 +353,13 @@ void LeaderElectionDeterministicParticle::activate() {
               // request labels from next segment
               qDebug() << "Requesting label from next segment...";
               LeaderElectionDeterministicParticle &nbr = nbrAtLabel(nextNbr);
-              nbr.putToken(std::make_shared<LexCompRequestNbrLabelToken>(localToGlobalDir((nextNbr+3)%6)));
+              nbr.putToken(makeToken<LexCompRequestNbrLabelToken>(localToGlobalDir((nextNbr+3)%6)));
               reqNbrLabels[i] = true;
               reqNbrLabel = true;
             }
             if (hasToken<LexCompReturnNbrLabelToken>() && reqNbrLabel && !receivedNbrLabel) {
               // receive labels from next segment
-              std::shared_ptr<LexCompReturnNbrLabelToken> token = peekAtToken<LexCompReturnNbrLabelToken>();
+              TokenPtr<LexCompReturnNbrLabelToken> token = peekAtToken<LexCompReturnNbrLabelToken>();
               if (globalToLocalDir(token->origin) == nextNbr) {
                 qDebug() << "Receiving label from next segment: " << QString::number(token->label);
                 takeToken<LexCompReturnNbrLabelToken>();
@@ -364,7 +373,7 @@ void LeaderElectionDeterministicParticle::activate() {
             }
             if (hasToken<LexCompReturnNbrEndOfSegmentToken>() && reqNbrLabel && !receivedNbrLabel) {
               // receive end of segment tokens from next segment
-              std::shared_ptr<LexCompReturnNbrEndOfSegmentToken> token = peekAtToken<LexCompReturnNbrEndOfSegmentToken>();
+              TokenPtr<LexCompReturnNbrEndOfSegmentToken> token = peekAtToken<LexCompReturnNbrEndOfSegmentToken>();
               if (globalToLocalDir(token->origin) == nextNbr) {
                 qDebug() << "Receiving end of segment token from next segment...";
                 takeToken<LexCompReturnNbrEndOfSegmentToken>();
@@ -392,11 +401,11 @@ void LeaderElectionDeterministicParticle::activate() {
               if (firstLargerLabel != 0) {
                 // if not lexicographically equal, send back any termination detection tokens
                 if (hasToken<TerminationDetectionToken>()) {
-                  std::shared_ptr<TerminationDetectionToken> token = peekAtToken<TerminationDetectionToken>();
+                  TokenPtr<TerminationDetectionToken> token = peekAtToken<TerminationDetectionToken>();
                   if (globalToLocalDir(token->origin) == nextNbr) {
                     takeToken<TerminationDetectionToken>();
                     LeaderElectionDeterministicParticle &nbr = nbrAtLabel(nextNbr);
-                    nbr.putToken(std::make_shared<TerminationDetectionReturnToken>(localToGlobalDir((nextNbr+3)%6), token->count, token->traversed+1, 1, false));
+                    nbr.putToken(makeToken<TerminationDetectionReturnToken>(localToGlobalDir((nextNbr+3)%6), token->count, token->traversed+1, 1, false));
                   }
                 }
               }
@@ -411,7 +420,7 @@ void LeaderElectionDeterministicParticle::activate() {
                 // finish comparison (loss), interrupt next segment, cleanup
                 qDebug() << "Lexicographically smaller";
                 LeaderElectionDeterministicParticle &nbr = nbrAtLabel(nextNbr);
-                nbr.putToken(std::make_shared<LexCompInterruptNextToken>(localToGlobalDir((nextNbr+3)%6)));
+                nbr.putToken(makeToken<LexCompInterruptNextToken>(localToGlobalDir((nextNbr+3)%6)));
                 cleanup(i);
                 continue;
               }
@@ -419,14 +428,14 @@ void LeaderElectionDeterministicParticle::activate() {
                 // finish comparison (win), request merge, cleanup
                 qDebug() << "Lexicographically larger";
                 LeaderElectionDeterministicParticle &nbr = nbrAtLabel(nextNbr);
-                nbr.putToken(std::make_shared<LexCompMergeRequestToken>(localToGlobalDir((nextNbr+3)%6), count));
+                nbr.putToken(makeToken<LexCompMergeRequestToken>(localToGlobalDir((nextNbr+3)%6), count));
                 mergeRequested = true;
                 mergesRequested[i] = true;
                 cleanup(i);
                 // interrupt lexicographic comparison with previous segment if applicable
                 if (sentNbrLabel) {
                   LeaderElectionDeterministicParticle &nbr = nbrAtLabel(prevNbr);
-                  nbr.putToken(std::make_shared<LexCompInterruptPrevToken>(localToGlobalDir((prevNbr+3)%6)));
+                  nbr.putToken(makeToken<LexCompInterruptPrevToken>(localToGlobalDir((prevNbr+3)%6)));
                   cleanupForNbr(i);
                 }
                 continue;
@@ -437,14 +446,14 @@ void LeaderElectionDeterministicParticle::activate() {
                   // win, request merge, cleanup
                   qDebug() << "Lexicographically larger";
                   LeaderElectionDeterministicParticle &nbr = nbrAtLabel(nextNbr);
-                  nbr.putToken(std::make_shared<LexCompMergeRequestToken>(localToGlobalDir((nextNbr+3)%6), count));
+                  nbr.putToken(makeToken<LexCompMergeRequestToken>(localToGlobalDir((nextNbr+3)%6), count));
                   mergeRequested = true;
                   mergesRequested[i] = true;
                   cleanup(i);
                   // interrupt lexicographic comparison with previous segment if applicable
                   if (sentNbrLabel) {
                     LeaderElectionDeterministicParticle &nbr = nbrAtLabel(prevNbr);
-                    nbr.putToken(std::make_shared<LexCompInterruptPrevToken>(localToGlobalDir((prevNbr+3)%6)));
+                    nbr.putToken(makeToken<LexCompInterruptPrevToken>(localToGlobalDir((prevNbr+3)%6)));
                     cleanupForNbr(i);
                   }
                   continue;
@@ -461,27 +470,27 @@ void LeaderElectionDeterministicParticle::activate() {
                   qDebug() << "Lexicographically equal: termination detection... Count: " << QString::number(count);
                   if ((count == 1 || count == 2 || count == 3) && !terminationDetection) {
                     LeaderElectionDeterministicParticle &nbr = nbrAtLabel(prevNbr);
-                    nbr.putToken(std::make_shared<TerminationDetectionToken>(localToGlobalDir((prevNbr+3)%6), count, 6/count+1, 1));
+                    nbr.putToken(makeToken<TerminationDetectionToken>(localToGlobalDir((prevNbr+3)%6), count, 6/count+1, 1));
                     terminationDetection = true;
                     terminationDetections[i] = true;
                   }
                   else if (count == 6) {
                     qDebug() << "Lexicographically equal with count 6 -> terminating...";
-                    state = State::Leader;
+                    setState(State::Leader);
                     return;
                   }
 
                   if (hasToken<TerminationDetectionToken>()) {
-                    std::shared_ptr<TerminationDetectionToken> token = peekAtToken<TerminationDetectionToken>();
+                    TokenPtr<TerminationDetectionToken> token = peekAtToken<TerminationDetectionToken>();
                     if (globalToLocalDir(token->origin) == nextNbr) {
                       takeToken<TerminationDetectionToken>();
                       if (token->traversed + 1 == token->ttl) {
                         LeaderElectionDeterministicParticle &nbr = nbrAtLabel(nextNbr);
-                        nbr.putToken(std::make_shared<TerminationDetectionReturnToken>(localToGlobalDir((nextNbr+3)%6), count, 6/count+1, 1, true));
+                        nbr.putToken(makeToken<TerminationDetectionReturnToken>(localToGlobalDir((nextNbr+3)%6), count, 6/count+1, 1, true));
                       }
                       else {
                         LeaderElectionDeterministicParticle &nbr = nbrAtLabel(prevNbr);
-                        nbr.putToken(std::make_shared<TerminationDetectionToken>(localToGlobalDir((prevNbr+3)%6), count, token->ttl, token->traversed+1));
+                        nbr.putToken(makeToken<TerminationDetectionToken>(localToGlobalDir((prevNbr+3)%6), count, token->ttl, token->traversed+1));
                       }
                     }
                   }
@@ -496,25 +505,25 @@ void LeaderElectionDeterministicParticle::activate() {
               // Request count of next segment to determine if they should merge
               qDebug() << "Requesting count... Count: " << QString::number(count);
               LeaderElectionDeterministicParticle &nbr = nbrAtLabel(nextNbr);
-              nbr.putToken(std::make_shared<CountRequestToken>(localToGlobalDir((nextNbr+3)%6)));
+              nbr.putToken(makeToken<CountRequestToken>(localToGlobalDir((nextNbr+3)%6)));
               countsRequested[i] = true;
             }
             else if (!mergeRequested) {
               if (hasToken<CountToken>()) {
-                std::shared_ptr<CountToken> token = peekAtToken<CountToken>();
+                TokenPtr<CountToken> token = peekAtToken<CountToken>();
                 if (globalToLocalDir(token->origin) == nextNbr) {
                   takeToken<CountToken>();
                   countsRequested[i] = false;
                   if (count > token->count && count + token->count <= 6) {
                     // Merge
                     LeaderElectionDeterministicParticle &nbr = nbrAtLabel(nextNbr);
-                    nbr.putToken(std::make_shared<MergeRequestCountToken>(localToGlobalDir((nextNbr+3)%6), count));
+                    nbr.putToken(makeToken<MergeRequestCountToken>(localToGlobalDir((nextNbr+3)%6), count));
                     mergesRequested[i] = true;
                     mergeRequested = true;
                     // interrupt lexicographic comparison with previous segment if applicable
                     if (sentNbrLabel) {
                       LeaderElectionDeterministicParticle &nbr = nbrAtLabel(prevNbr);
-                      nbr.putToken(std::make_shared<LexCompInterruptPrevToken>(localToGlobalDir((prevNbr+3)%6)));
+                      nbr.putToken(makeToken<LexCompInterruptPrevToken>(localToGlobalDir((prevNbr+3)%6)));
                       cleanupForNbr(i);
                     }
                   }
@@ -532,7 +541,7 @@ void LeaderElectionDeterministicParticle::activate() {
             }
             else {
               if (hasToken<MergeAckToken>()) {
-                std::shared_ptr<MergeAckToken> token = peekAtToken<MergeAckToken>();
+                TokenPtr<MergeAckToken> token = peekAtToken<MergeAckToken>();
                 if (globalToLocalDir(token->origin) == nextNbr) {
                   takeToken<MergeAckToken>();
                   count += token->count;
@@ -546,7 +555,7 @@ void LeaderElectionDeterministicParticle::activate() {
                 }
               }
               if (hasToken<MergeNackToken>()) {
-                std::shared_ptr<MergeNackToken> token = peekAtToken<MergeNackToken>();
+                TokenPtr<MergeNackToken> token = peekAtToken<MergeNackToken>();
                 if (globalToLocalDir(token->origin) == nextNbr) {
                   takeToken<MergeNackToken>();
                   mergesRequested[i] = false;
@@ -559,54 +568,54 @@ void LeaderElectionDeterministicParticle::activate() {
         else {
           // Tail or internal node of segment consisting of multiple particles
           if (hasToken<TerminationToken>()) {
-            std::shared_ptr<TerminationToken> token = peekAtToken<TerminationToken>();
+            TokenPtr<TerminationToken> token = peekAtToken<TerminationToken>();
             if (globalToLocalDir(token->origin) == nextNbr) {
               takeToken<TerminationToken>();
               LeaderElectionDeterministicParticle &nbr = nbrAtLabel(prevNbr);
-              nbr.putToken(std::make_shared<TerminationToken>(localToGlobalDir((prevNbr+3)%6), token->ttl, token->traversed));
-              state = State::ForestFormation;
+              nbr.putToken(makeToken<TerminationToken>(localToGlobalDir((prevNbr+3)%6), token->ttl, token->traversed));
+              setState(State::ForestFormation);
               return;
             }
           }
 
           if (hasToken<CountRequestToken>()) {
-            std::shared_ptr<CountRequestToken> token = peekAtToken<CountRequestToken>();
+            TokenPtr<CountRequestToken> token = peekAtToken<CountRequestToken>();
             if (globalToLocalDir(token->origin) == prevNbr) {
               takeToken<CountRequestToken>();
               LeaderElectionDeterministicParticle &nbr = nbrAtLabel(nextNbr);
-              nbr.putToken(std::make_shared<CountRequestToken>(localToGlobalDir((nextNbr+3)%6)));
+              nbr.putToken(makeToken<CountRequestToken>(localToGlobalDir((nextNbr+3)%6)));
             }
           }
           if (hasToken<CountToken>()) {
-            std::shared_ptr<CountToken> token = peekAtToken<CountToken>();
+            TokenPtr<CountToken> token = peekAtToken<CountToken>();
             if (globalToLocalDir(token->origin) == nextNbr) {
               takeToken<CountToken>();
               LeaderElectionDeterministicParticle &nbr = nbrAtLabel(prevNbr);
-              nbr.putToken(std::make_shared<CountToken>(localToGlobalDir((prevNbr+3)%6), token->count));
+              nbr.putToken(makeToken<CountToken>(localToGlobalDir((prevNbr+3)%6), token->count));
             }
           }
           if (hasToken<MergeRequestCountToken>()) {
-            std::shared_ptr<MergeRequestCountToken> token = peekAtToken<MergeRequestCountToken>();
+            TokenPtr<MergeRequestCountToken> token = peekAtToken<MergeRequestCountToken>();
             if (globalToLocalDir(token->origin) == prevNbr) {
               takeToken<MergeRequestCountToken>();
               LeaderElectionDeterministicParticle &nbr = nbrAtLabel(nextNbr);
-              nbr.putToken(std::make_shared<MergeRequestCountToken>(localToGlobalDir((nextNbr+3)%6), token->count));
+              nbr.putToken(makeToken<MergeRequestCountToken>(localToGlobalDir((nextNbr+3)%6), token->count));
               if (hasToken<TerminationDetectionToken>()) {
-                std::shared_ptr<TerminationDetectionToken> token = peekAtToken<TerminationDetectionToken>();
+                TokenPtr<TerminationDetectionToken> token = peekAtToken<TerminationDetectionToken>();
                 if (globalToLocalDir(token->origin) == nextNbr) {
                   takeToken<TerminationDetectionToken>();
                   LeaderElectionDeterministicParticle &nbr = nbrAtLabel(nextNbr);
-                  nbr.putToken(std::make_shared<TerminationDetectionReturnToken>(localToGlobalDir((nextNbr+3)%6), token->count, token->traversed, 0, false));
+                  nbr.putToken(makeToken<TerminationDetectionReturnToken>(localToGlobalDir((nextNbr+3)%6), token->count, token->traversed, 0, false));
                 }
               }
             }
           }
           if (hasToken<MergeAckToken>()) {
-            std::shared_ptr<MergeAckToken> token = peekAtToken<MergeAckToken>();
+            TokenPtr<MergeAckToken> token = peekAtToken<MergeAckToken>();
             if (globalToLocalDir(token->origin) == nextNbr) {
               takeToken<MergeAckToken>();
               LeaderElectionDeterministicParticle &nbr = nbrAtLabel(prevNbr);
-              nbr.putToken(std::make_shared<MergeAckToken>(localToGlobalDir((prevNbr+3)%6), token->count));
+              nbr.putToken(makeToken<MergeAckToken>(localToGlobalDir((prevNbr+3)%6), token->count));
               if (successor == -1) {
                 successors[i] = nextNbr;
                 successor = nextNbr;
@@ -614,18 +623,18 @@ void LeaderElectionDeterministicParticle::activate() {
             }
           }
           if (hasToken<MergeNackToken>()) {
-            std::shared_ptr<MergeNackToken> token = peekAtToken<MergeNackToken>();
+            TokenPtr<MergeNackToken> token = peekAtToken<MergeNackToken>();
             if (globalToLocalDir(token->origin) == nextNbr) {
               takeToken<MergeNackToken>();
               LeaderElectionDeterministicParticle &nbr = nbrAtLabel(prevNbr);
-              nbr.putToken(std::make_shared<MergeNackToken>(localToGlobalDir((prevNbr+3)%6)));
+              nbr.putToken(makeToken<MergeNackToken>(localToGlobalDir((prevNbr+3)%6)));
             }
           }
 
           // process and/or pass lexicographic comparison tokens
           bool interruptedNext = false;
           if (hasToken<LexCompCleanupToken>()) {
-            std::shared_ptr<LexCompCleanupToken> token = peekAtToken<LexCompCleanupToken>();
+            TokenPtr<LexCompCleanupToken> token = peekAtToken<LexCompCleanupToken>();
             if (globalToLocalDir(token->origin) == prevNbr) {
               takeToken<LexCompCleanupToken>();
               cleanup(i);
@@ -633,7 +642,7 @@ void LeaderElectionDeterministicParticle::activate() {
             }
           }
           if (hasToken<LexCompCleanupForNbrToken>()) {
-            std::shared_ptr<LexCompCleanupForNbrToken> token = peekAtToken<LexCompCleanupForNbrToken>();
+            TokenPtr<LexCompCleanupForNbrToken> token = peekAtToken<LexCompCleanupForNbrToken>();
             if (globalToLocalDir(token->origin) == prevNbr) {
               takeToken<LexCompCleanupForNbrToken>();
               cleanupForNbr(i);
@@ -641,156 +650,156 @@ void LeaderElectionDeterministicParticle::activate() {
             }
           }
           if (hasToken<LexCompInterruptNextToken>()) {
-            std::shared_ptr<LexCompInterruptNextToken> token = peekAtToken<LexCompInterruptNextToken>();
+            TokenPtr<LexCompInterruptNextToken> token = peekAtToken<LexCompInterruptNextToken>();
             if (globalToLocalDir(token->origin) == prevNbr) {
               takeToken<LexCompInterruptNextToken>();
               LeaderElectionDeterministicParticle &nbr = nbrAtLabel(nextNbr);
-              nbr.putToken(std::make_shared<LexCompInterruptNextToken>(localToGlobalDir((nextNbr+3)%6)));
+              nbr.putToken(makeToken<LexCompInterruptNextToken>(localToGlobalDir((nextNbr+3)%6)));
             }
           }
           if (hasToken<LexCompInterruptPrevToken>()) {
-            std::shared_ptr<LexCompInterruptPrevToken> token = peekAtToken<LexCompInterruptPrevToken>();
+            TokenPtr<LexCompInterruptPrevToken> token = peekAtToken<LexCompInterruptPrevToken>();
             if (globalToLocalDir(token->origin) == nextNbr) {
               takeToken<LexCompInterruptPrevToken>();
               LeaderElectionDeterministicParticle &nbr = nbrAtLabel(prevNbr);
-              nbr.putToken(std::make_shared<LexCompInterruptPrevToken>(localToGlobalDir((prevNbr+3)%6)));
+              nbr.putToken(makeToken<LexCompInterruptPrevToken>(localToGlobalDir((prevNbr+3)%6)));
               interruptedNext = true;
             }
           }
           if (hasToken<LexCompRequestNbrLabelToken>()) {
-            std::shared_ptr<LexCompRequestNbrLabelToken> token = peekAtToken<LexCompRequestNbrLabelToken>();
+            TokenPtr<LexCompRequestNbrLabelToken> token = peekAtToken<LexCompRequestNbrLabelToken>();
             if (globalToLocalDir(token->origin) == prevNbr) {
               takeToken<LexCompRequestNbrLabelToken>();
               if (!interruptedNext) {
                 LeaderElectionDeterministicParticle &nbr = nbrAtLabel(nextNbr);
-                nbr.putToken(std::make_shared<LexCompRequestNbrLabelToken>(localToGlobalDir((nextNbr+3)%6)));
+                nbr.putToken(makeToken<LexCompRequestNbrLabelToken>(localToGlobalDir((nextNbr+3)%6)));
               }
             }
           }
           if (hasToken<LexCompReturnNbrLabelToken>()) {
-            std::shared_ptr<LexCompReturnNbrLabelToken> token = peekAtToken<LexCompReturnNbrLabelToken>();
+            TokenPtr<LexCompReturnNbrLabelToken> token = peekAtToken<LexCompReturnNbrLabelToken>();
             if (globalToLocalDir(token->origin) == nextNbr) {
               takeToken<LexCompReturnNbrLabelToken>();
               if (!interruptedNext) {
                 LeaderElectionDeterministicParticle &nbr = nbrAtLabel(prevNbr);
-                nbr.putToken(std::make_shared<LexCompReturnNbrLabelToken>(localToGlobalDir((prevNbr+3)%6), token->label));
+                nbr.putToken(makeToken<LexCompReturnNbrLabelToken>(localToGlobalDir((prevNbr+3)%6), token->label));
               }
             }
           }
           if (hasToken<LexCompReturnNbrEndOfSegmentToken>()) {
-            std::shared_ptr<LexCompReturnNbrEndOfSegmentToken> token = peekAtToken<LexCompReturnNbrEndOfSegmentToken>();
+            TokenPtr<LexCompReturnNbrEndOfSegmentToken> token = peekAtToken<LexCompReturnNbrEndOfSegmentToken>();
             if (globalToLocalDir(token->origin) == nextNbr) {
               takeToken<LexCompReturnNbrEndOfSegmentToken>();
               if (!interruptedNext) {
                 LeaderElectionDeterministicParticle &nbr = nbrAtLabel(prevNbr);
-                nbr.putToken(std::make_shared<LexCompReturnNbrEndOfSegmentToken>(localToGlobalDir((prevNbr+3)%6)));
+                nbr.putToken(makeToken<LexCompReturnNbrEndOfSegmentToken>(localToGlobalDir((prevNbr+3)%6)));
               }
             }
           }
           if (hasToken<LexCompReqLabelToken>()) {
-            std::shared_ptr<LexCompReqLabelToken> token = peekAtToken<LexCompReqLabelToken>();
+            TokenPtr<LexCompReqLabelToken> token = peekAtToken<LexCompReqLabelToken>();
             if (globalToLocalDir(token->origin) == prevNbr) {
               takeToken<LexCompReqLabelToken>();
               if (!interruptedNext) {
                 if (!sentLabel) {
                   qDebug() << "Sending internal label: " << QString::number(label);
                   LeaderElectionDeterministicParticle &nbr = nbrAtLabel(prevNbr);
-                  nbr.putToken(std::make_shared<LexCompReturnLabelToken>(localToGlobalDir((prevNbr+3)%6), label));
+                  nbr.putToken(makeToken<LexCompReturnLabelToken>(localToGlobalDir((prevNbr+3)%6), label));
                   sentLabels[i] = true;
                   sentLabel = true;
                 }
                 else if (successor != -1) {
                   LeaderElectionDeterministicParticle &nbr = nbrAtLabel(nextNbr);
-                  nbr.putToken(std::make_shared<LexCompReqLabelToken>(localToGlobalDir((nextNbr+3)%6)));
+                  nbr.putToken(makeToken<LexCompReqLabelToken>(localToGlobalDir((nextNbr+3)%6)));
                 }
                 else {
                   LeaderElectionDeterministicParticle &nbr = nbrAtLabel(prevNbr);
-                  nbr.putToken(std::make_shared<LexCompEndOfSegmentToken>(localToGlobalDir((prevNbr+3)%6)));
+                  nbr.putToken(makeToken<LexCompEndOfSegmentToken>(localToGlobalDir((prevNbr+3)%6)));
                 }
               }
             }
           }
           if (hasToken<LexCompReqLabelForNbrToken>()) {
-            std::shared_ptr<LexCompReqLabelForNbrToken> token = peekAtToken<LexCompReqLabelForNbrToken>();
+            TokenPtr<LexCompReqLabelForNbrToken> token = peekAtToken<LexCompReqLabelForNbrToken>();
             if (globalToLocalDir(token->origin) == prevNbr) {
               takeToken<LexCompReqLabelForNbrToken>();
               if (!sentNbrLabel) {
                 qDebug() << "Sending label to neighbor: " << QString::number(label);
                 LeaderElectionDeterministicParticle &nbr = nbrAtLabel(prevNbr);
-                nbr.putToken(std::make_shared<LexCompReturnLabelForNbrToken>(localToGlobalDir((prevNbr+3)%6), label));
+                nbr.putToken(makeToken<LexCompReturnLabelForNbrToken>(localToGlobalDir((prevNbr+3)%6), label));
                 sentNbrLabels[i] = true;
                 sentNbrLabel = true;
               }
               else if (successor != -1) {
                 LeaderElectionDeterministicParticle &nbr = nbrAtLabel(nextNbr);
-                nbr.putToken(std::make_shared<LexCompReqLabelForNbrToken>(localToGlobalDir((nextNbr+3)%6)));
+                nbr.putToken(makeToken<LexCompReqLabelForNbrToken>(localToGlobalDir((nextNbr+3)%6)));
               }
               else {
                 LeaderElectionDeterministicParticle &nbr = nbrAtLabel(prevNbr);
-                nbr.putToken(std::make_shared<LexCompEndOfSegmentForNbrToken>(localToGlobalDir((prevNbr+3)%6)));
+                nbr.putToken(makeToken<LexCompEndOfSegmentForNbrToken>(localToGlobalDir((prevNbr+3)%6)));
               }
             }
           }
           if (hasToken<LexCompReturnLabelToken>()) {
-            std::shared_ptr<LexCompReturnLabelToken> token = peekAtToken<LexCompReturnLabelToken>();
+            TokenPtr<LexCompReturnLabelToken> token = peekAtToken<LexCompReturnLabelToken>();
             if (globalToLocalDir(token->origin) == nextNbr) {
               takeToken<LexCompReturnLabelToken>();
               if (!interruptedNext) {
                 LeaderElectionDeterministicParticle &nbr = nbrAtLabel(prevNbr);
-                nbr.putToken(std::make_shared<LexCompReturnLabelToken>(localToGlobalDir((prevNbr+3)%6), token->label));
+                nbr.putToken(makeToken<LexCompReturnLabelToken>(localToGlobalDir((prevNbr+3)%6), token->label));
               }
             }
           }
           if (hasToken<LexCompEndOfSegmentToken>()) {
-            std::shared_ptr<LexCompEndOfSegmentToken> token = peekAtToken<LexCompEndOfSegmentToken>();
+            TokenPtr<LexCompEndOfSegmentToken> token = peekAtToken<LexCompEndOfSegmentToken>();
             if (globalToLocalDir(token->origin) == nextNbr) {
               takeToken<LexCompEndOfSegmentToken>();
               if (!interruptedNext) {
                 LeaderElectionDeterministicParticle &nbr = nbrAtLabel(prevNbr);
-                nbr.putToken(std::make_shared<LexCompEndOfSegmentToken>(localToGlobalDir((prevNbr+3)%6)));
+                nbr.putToken(makeToken<LexCompEndOfSegmentToken>(localToGlobalDir((prevNbr+3)%6)));
               }
             }
           }
           if (hasToken<LexCompReturnLabelForNbrToken>()) {
-            std::shared_ptr<LexCompReturnLabelForNbrToken> token = peekAtToken<LexCompReturnLabelForNbrToken>();
+            TokenPtr<LexCompReturnLabelForNbrToken> token = peekAtToken<LexCompReturnLabelForNbrToken>();
             if (globalToLocalDir(token->origin) == nextNbr) {
               takeToken<LexCompReturnLabelForNbrToken>();
               LeaderElectionDeterministicParticle &nbr = nbrAtLabel(prevNbr);
-              nbr.putToken(std::make_shared<LexCompReturnLabelForNbrToken>(localToGlobalDir((prevNbr+3)%6), token->label));
+              nbr.putToken(makeToken<LexCompReturnLabelForNbrToken>(localToGlobalDir((prevNbr+3)%6), token->label));
             }
           }
           if (hasToken<LexCompEndOfSegmentForNbrToken>()) {
-            std::shared_ptr<LexCompEndOfSegmentForNbrToken> token = peekAtToken<LexCompEndOfSegmentForNbrToken>();
+            TokenPtr<LexCompEndOfSegmentForNbrToken> token = peekAtToken<LexCompEndOfSegmentForNbrToken>();
             if (globalToLocalDir(token->origin) == nextNbr) {
               takeToken<LexCompEndOfSegmentForNbrToken>();
               LeaderElectionDeterministicParticle &nbr = nbrAtLabel(prevNbr);
-              nbr.putToken(std::make_shared<LexCompEndOfSegmentForNbrToken>(localToGlobalDir((prevNbr+3)%6)));
+              nbr.putToken(makeToken<LexCompEndOfSegmentForNbrToken>(localToGlobalDir((prevNbr+3)%6)));
             }
           }
           if (hasToken<LexCompMergeRequestToken>()) {
-            std::shared_ptr<LexCompMergeRequestToken> token = peekAtToken<LexCompMergeRequestToken>();
+            TokenPtr<LexCompMergeRequestToken> token = peekAtToken<LexCompMergeRequestToken>();
             if (globalToLocalDir(token->origin) == prevNbr) {
               takeToken<LexCompMergeRequestToken>();
               LeaderElectionDeterministicParticle &nbr = nbrAtLabel(nextNbr);
-              nbr.putToken(std::make_shared<LexCompMergeRequestToken>(localToGlobalDir((nextNbr+3)%6), token->count));
+              nbr.putToken(makeToken<LexCompMergeRequestToken>(localToGlobalDir((nextNbr+3)%6), token->count));
             }
           }
 
           // pass termination detection tokens
           if (hasToken<TerminationDetectionToken>()) {
-            std::shared_ptr<TerminationDetectionToken> token = peekAtToken<TerminationDetectionToken>();
+            TokenPtr<TerminationDetectionToken> token = peekAtToken<TerminationDetectionToken>();
             if (globalToLocalDir(token->origin) == nextNbr) {
               takeToken<TerminationDetectionToken>();
               LeaderElectionDeterministicParticle &nbr = nbrAtLabel(prevNbr);
-              nbr.putToken(std::make_shared<TerminationDetectionToken>(localToGlobalDir((prevNbr+3)%6), token->count, token->ttl, token->traversed));
+              nbr.putToken(makeToken<TerminationDetectionToken>(localToGlobalDir((prevNbr+3)%6), token->count, token->ttl, token->traversed));
             }
           }
           if (hasToken<TerminationDetectionReturnToken>()) {
-            std::shared_ptr<TerminationDetectionReturnToken> token = peekAtToken<TerminationDetectionReturnToken>();
+            TokenPtr<TerminationDetectionReturnToken> token = peekAtToken<TerminationDetectionReturnToken>();
             if (globalToLocalDir(token->origin) == prevNbr) {
               takeToken<TerminationDetectionReturnToken>();
               LeaderElectionDeterministicParticle &nbr = nbrAtLabel(nextNbr);
-              nbr.putToken(std::make_shared<TerminationDetectionReturnToken>(localToGlobalDir((nextNbr+3)%6), token->count, token->ttl, token->traversed, token->termination));
+              nbr.putToken(makeToken<TerminationDetectionReturnToken>(localToGlobalDir((nextNbr+3)%6), token->count, token->ttl, token->traversed, token->termination));
             }
           }
         }
@@ -800,10 +809,10 @@ void LeaderElectionDeterministicParticle::activate() {
   else if (state == State::ForestFormationCandidate) {
     if (!inTree) {
       while (hasToken<TreeJoinRequestToken>()) {
-        std::shared_ptr<TreeJoinRequestToken> token = takeToken<TreeJoinRequestToken>();
+        TokenPtr<TreeJoinRequestToken> token = takeToken<TreeJoinRequestToken>();
         int reqDir = globalToLocalDir(token->origin);
         LeaderElectionDeterministicParticle &nbr = nbrAtLabel(reqDir);
-        nbr.putToken(std::make_shared<JoinTreeNackToken>(localToGlobalDir((reqDir+3)%6)));
+        nbr.putToken(makeToken<JoinTreeNackToken>(localToGlobalDir((reqDir+3)%6)));
         requestedTreeJoin.insert(reqDir);
       }
       inTree = true;
@@ -811,19 +820,19 @@ void LeaderElectionDeterministicParticle::activate() {
         if (hasNbrAtLabel(dir)) {
           if (requestedTreeJoin.find(dir) == requestedTreeJoin.end()) {
             LeaderElectionDeterministicParticle &nbr = nbrAtLabel(dir);
-            nbr.putToken(std::make_shared<TreeJoinRequestToken>(localToGlobalDir((dir+3)%6)));
+            nbr.putToken(makeToken<TreeJoinRequestToken>(localToGlobalDir((dir+3)%6)));
           }
         }
       }
     }
     else if (!treeDone) {
       while (hasToken<JoinTreeAckToken>()) {
-        std::shared_ptr<JoinTreeAckToken> token = takeToken<JoinTreeAckToken>();
+        TokenPtr<JoinTreeAckToken> token = takeToken<JoinTreeAckToken>();
         int childDir = globalToLocalDir(token->origin);
         children.insert(childDir);
       }
       while (hasToken<JoinTreeNackToken>()) {
-        std::shared_ptr<JoinTreeNackToken> token = takeToken<JoinTreeNackToken>();
+        TokenPtr<JoinTreeNackToken> token = takeToken<JoinTreeNackToken>();
         int nackDir = globalToLocalDir(token->origin);
         nackReceived.insert(nackDir);
       }
@@ -841,27 +850,27 @@ void LeaderElectionDeterministicParticle::activate() {
       if (done) {
         int dir = nextDir(0);
         LeaderElectionDeterministicParticle &nbr = nbrAtLabel(dir);
-        nbr.putToken(std::make_shared<CandidateTreeDoneToken>(localToGlobalDir((dir+3)%6), numCandidates+1, 1));
+        nbr.putToken(makeToken<CandidateTreeDoneToken>(localToGlobalDir((dir+3)%6), numCandidates+1, 1));
         treeDone = true;
       }
     }
     else if (candidateTreesDone < numCandidates) {
       while (hasToken<CandidateTreeDoneToken>()) {
-        std::shared_ptr<CandidateTreeDoneToken> token = takeToken<CandidateTreeDoneToken>();
+        TokenPtr<CandidateTreeDoneToken> token = takeToken<CandidateTreeDoneToken>();
         candidateTreesDone += 1;
         if (token->traversed + 1 < token->ttl) {
           int dir = nextDir(0);
           LeaderElectionDeterministicParticle &nbr = nbrAtLabel(dir);
-          nbr.putToken(std::make_shared<CandidateTreeDoneToken>(localToGlobalDir((dir+3)%6), token->ttl, token->traversed+1));
+          nbr.putToken(makeToken<CandidateTreeDoneToken>(localToGlobalDir((dir+3)%6), token->ttl, token->traversed+1));
         }
       }
     }
     else {
       for (int dir : children) {
         LeaderElectionDeterministicParticle &nbr = nbrAtLabel(dir);
-        nbr.putToken(std::make_shared<ForestDoneToken>(localToGlobalDir((dir+3)%6)));
+        nbr.putToken(makeToken<ForestDoneToken>(localToGlobalDir((dir+3)%6)));
       }
-      state = State::ConvexificationCandidate;
+      setState(State::ConvexificationCandidate);
     }
   }
   else if (state == State::ForestFormation) {
@@ -869,15 +878,15 @@ void LeaderElectionDeterministicParticle::activate() {
       takeToken<ConvexificationStartToken>();
       for (int childDir : children) {
         LeaderElectionDeterministicParticle &child = nbrAtLabel(childDir);
-        child.putToken(std::make_shared<ConvexificationStartToken>(localToGlobalDir((childDir+3)%6)));
+        child.putToken(makeToken<ConvexificationStartToken>(localToGlobalDir((childDir+3)%6)));
       }
-      state = State::Convexification;
+      setState(State::Convexification);
       return;
     }
     if (numBoundaries() == 0) {
       if (!inTree) {
         while (hasToken<TreeJoinRequestToken>()) {
-          std::shared_ptr<TreeJoinRequestToken> token = takeToken<TreeJoinRequestToken>();
+          TokenPtr<TreeJoinRequestToken> token = takeToken<TreeJoinRequestToken>();
           int reqDir = globalToLocalDir(token->origin);
           requestedTreeJoin.insert(reqDir);
         }
@@ -886,7 +895,7 @@ void LeaderElectionDeterministicParticle::activate() {
             if (hasNbrAtLabel(dir)) {
               if (requestedTreeJoin.find(dir) == requestedTreeJoin.end()) {
                 LeaderElectionDeterministicParticle &nbr = nbrAtLabel(dir);
-                nbr.putToken(std::make_shared<TreeJoinRequestToken>(localToGlobalDir((dir+3)%6)));
+                nbr.putToken(makeToken<TreeJoinRequestToken>(localToGlobalDir((dir+3)%6)));
               }
             }
           }
@@ -895,12 +904,12 @@ void LeaderElectionDeterministicParticle::activate() {
       }
       else if (!treeDone) {
         while (hasToken<JoinTreeAckToken>()) {
-          std::shared_ptr<JoinTreeAckToken> token = takeToken<JoinTreeAckToken>();
+          TokenPtr<JoinTreeAckToken> token = takeToken<JoinTreeAckToken>();
           int childDir = globalToLocalDir(token->origin);
           children.insert(childDir);
         }
         while (hasToken<JoinTreeNackToken>()) {
-          std::shared_ptr<JoinTreeNackToken> token = takeToken<JoinTreeNackToken>();
+          TokenPtr<JoinTreeNackToken> token = takeToken<JoinTreeNackToken>();
           int nackDir = globalToLocalDir(token->origin);
           nackReceived.insert(nackDir);
         }
@@ -921,10 +930,10 @@ void LeaderElectionDeterministicParticle::activate() {
               LeaderElectionDeterministicParticle &nbr = nbrAtLabel(dir);
               if (parent == -1) {
                 parent = dir;
-                nbr.putToken(std::make_shared<JoinTreeAckToken>(localToGlobalDir((dir+3)%6)));
+                nbr.putToken(makeToken<JoinTreeAckToken>(localToGlobalDir((dir+3)%6)));
               }
               else {
-                nbr.putToken(std::make_shared<JoinTreeNackToken>(localToGlobalDir((dir+3)%6)));
+                nbr.putToken(makeToken<JoinTreeNackToken>(localToGlobalDir((dir+3)%6)));
               }
             }
           }
@@ -935,18 +944,18 @@ void LeaderElectionDeterministicParticle::activate() {
         takeToken<ForestDoneToken>();
         for (int dir : children) {
           LeaderElectionDeterministicParticle &nbr = nbrAtLabel(dir);
-          nbr.putToken(std::make_shared<ForestDoneToken>(localToGlobalDir((dir+3)%6)));
+          nbr.putToken(makeToken<ForestDoneToken>(localToGlobalDir((dir+3)%6)));
         }
       }
     }
     else {
       if (!inTree) {
         while (hasToken<TreeJoinRequestToken>()) {
-          std::shared_ptr<TreeJoinRequestToken> token = takeToken<TreeJoinRequestToken>();
+          TokenPtr<TreeJoinRequestToken> token = takeToken<TreeJoinRequestToken>();
           int reqDir = globalToLocalDir(token->origin);
           LeaderElectionDeterministicParticle &nbr = nbrAtLabel(reqDir);
           if (reqDir != prevDir(0)) {
-            nbr.putToken(std::make_shared<JoinTreeNackToken>(localToGlobalDir((reqDir+3)%6)));
+            nbr.putToken(makeToken<JoinTreeNackToken>(localToGlobalDir((reqDir+3)%6)));
           }
           requestedTreeJoin.insert(reqDir);
         }
@@ -956,7 +965,7 @@ void LeaderElectionDeterministicParticle::activate() {
             if (requestedTreeJoin.find(dir) == requestedTreeJoin.end()) {
               if (dir != prevDir(0)) {
                 LeaderElectionDeterministicParticle &nbr = nbrAtLabel(dir);
-                nbr.putToken(std::make_shared<TreeJoinRequestToken>(localToGlobalDir((dir+3)%6)));
+                nbr.putToken(makeToken<TreeJoinRequestToken>(localToGlobalDir((dir+3)%6)));
               }
             }
           }
@@ -967,12 +976,12 @@ void LeaderElectionDeterministicParticle::activate() {
           takeToken<TreeJoinRequestToken>();
         }
         while (hasToken<JoinTreeAckToken>()) {
-          std::shared_ptr<JoinTreeAckToken> token = takeToken<JoinTreeAckToken>();
+          TokenPtr<JoinTreeAckToken> token = takeToken<JoinTreeAckToken>();
           int childDir = globalToLocalDir(token->origin);
           children.insert(childDir);
         }
         while (hasToken<JoinTreeNackToken>()) {
-          std::shared_ptr<JoinTreeNackToken> token = takeToken<JoinTreeNackToken>();
+          TokenPtr<JoinTreeNackToken> token = takeToken<JoinTreeNackToken>();
           int nackDir = globalToLocalDir(token->origin);
           nackReceived.insert(nackDir);
         }
@@ -991,7 +1000,7 @@ void LeaderElectionDeterministicParticle::activate() {
           treeDone = true;
           parent = prevDir(0);
           LeaderElectionDeterministicParticle &nbr = nbrAtLabel(parent);
-          nbr.putToken(std::make_shared<JoinTreeAckToken>(localToGlobalDir((parent+3)%6)));
+          nbr.putToken(makeToken<JoinTreeAckToken>(localToGlobalDir((parent+3)%6)));
         }
       }
       else {
@@ -999,7 +1008,7 @@ void LeaderElectionDeterministicParticle::activate() {
           takeToken<TreeJoinRequestToken>();
         }
         while (hasToken<CandidateTreeDoneToken>()) {
-          std::shared_ptr<CandidateTreeDoneToken> token = takeToken<CandidateTreeDoneToken>();
+          TokenPtr<CandidateTreeDoneToken> token = takeToken<CandidateTreeDoneToken>();
           int dir = (globalToLocalDir(token->origin) + 5) % 6;
           while (hasNbrAtLabel(dir)) {
             dir = (dir + 5) % 6;
@@ -1008,13 +1017,13 @@ void LeaderElectionDeterministicParticle::activate() {
             dir = (dir + 5) % 6;
           }
           LeaderElectionDeterministicParticle &nbr = nbrAtLabel(dir);
-          nbr.putToken(std::make_shared<CandidateTreeDoneToken>(localToGlobalDir((dir+3)%6), token->ttl, token->traversed));
+          nbr.putToken(makeToken<CandidateTreeDoneToken>(localToGlobalDir((dir+3)%6), token->ttl, token->traversed));
         }
         if (hasToken<ForestDoneToken>()) {
           takeToken<ForestDoneToken>();
           for (int dir : children) {
             LeaderElectionDeterministicParticle &nbr = nbrAtLabel(dir);
-            nbr.putToken(std::make_shared<ForestDoneToken>(localToGlobalDir((dir+3)%6)));
+            nbr.putToken(makeToken<ForestDoneToken>(localToGlobalDir((dir+3)%6)));
           }
         }
       }
@@ -1025,7 +1034,7 @@ void LeaderElectionDeterministicParticle::activate() {
     if (state == State::ConvexificationCandidate && !convexificationStarted) {
       for (int childDir : children) {
         LeaderElectionDeterministicParticle &child = nbrAtLabel(childDir);
-        child.putToken(std::make_shared<ConvexificationStartToken>(localToGlobalDir((childDir+3)%6)));
+        child.putToken(makeToken<ConvexificationStartToken>(localToGlobalDir((childDir+3)%6)));
       }
       convexificationStarted = true;
     }
@@ -1039,7 +1048,7 @@ void LeaderElectionDeterministicParticle::activate() {
     }
 
     if (hasToken<ChildDirToken>()) {
-      std::shared_ptr<ChildDirToken> token = takeToken<ChildDirToken>();
+      TokenPtr<ChildDirToken> token = takeToken<ChildDirToken>();
       children.insert(globalToLocalDir(token->origin));
       for (int childDir : children) {
         if (hasNbrAtLabel(childDir)) {
@@ -1055,7 +1064,7 @@ void LeaderElectionDeterministicParticle::activate() {
     // TODO: acknowledgement messages
     if (isContracted()) {
       if (hasToken<ParentDirToken>()) {
-        std::shared_ptr<ParentDirToken> token = takeToken<ParentDirToken>();
+        TokenPtr<ParentDirToken> token = takeToken<ParentDirToken>();
         qDebug() << "Received parent dir update: " + QString::number(parent) + " -> " + QString::number(globalToLocalDir(token->origin));
         parent = globalToLocalDir(token->origin);
       }
@@ -1104,14 +1113,14 @@ void LeaderElectionDeterministicParticle::activate() {
           }
           if (canPull(childLabel)) {
             LeaderElectionDeterministicParticle &nbr = nbrAtLabel(parentLabel);
-            nbr.putToken(std::make_shared<ChildDirToken>(localToGlobalDir((parent+3)%6)));
+            nbr.putToken(makeToken<ChildDirToken>(localToGlobalDir((parent+3)%6)));
             LeaderElectionDeterministicParticle &child = nbrAtLabel(childLabel);
-            child.putToken(std::make_shared<ChildHandOffToken>(localToGlobalDir((dir+3)%6), oldChildrenGlobal, localToGlobalDir((tailDir() + 3) % 6)));
+            child.putToken(makeToken<ChildHandOffToken>(localToGlobalDir((dir+3)%6), oldChildrenGlobal, localToGlobalDir((tailDir() + 3) % 6)));
             pull(childLabel);
             for (int d : newChildren) {
               if (d != tailDir()) {
                 LeaderElectionDeterministicParticle &child = nbrAtLabel(d);
-                child.putToken(std::make_shared<ParentDirToken>(localToGlobalDir((d+3)%6)));
+                child.putToken(makeToken<ParentDirToken>(localToGlobalDir((d+3)%6)));
               }
             }
           }
@@ -1122,13 +1131,13 @@ void LeaderElectionDeterministicParticle::activate() {
         }
         if (!isContracted()) {
           LeaderElectionDeterministicParticle &nbr = nbrAtLabel(parentLabel);
-          nbr.putToken(std::make_shared<ChildDirToken>(localToGlobalDir((parent+3)%6)));
+          nbr.putToken(makeToken<ChildDirToken>(localToGlobalDir((parent+3)%6)));
           int tDir = tailDir();
           contractTail();
           for (int d : newChildren) {
             if (d != tDir) {
               LeaderElectionDeterministicParticle &child = nbrAtLabel(d);
-              child.putToken(std::make_shared<ParentDirToken>(localToGlobalDir((d+3)%6)));
+              child.putToken(makeToken<ParentDirToken>(localToGlobalDir((d+3)%6)));
             }
           }
         }
@@ -1136,11 +1145,11 @@ void LeaderElectionDeterministicParticle::activate() {
       }
       else {
         LeaderElectionDeterministicParticle &nbr = nbrAtLabel(parentLabel);
-        nbr.putToken(std::make_shared<ChildDirToken>(localToGlobalDir((parent+3)%6)));
+        nbr.putToken(makeToken<ChildDirToken>(localToGlobalDir((parent+3)%6)));
         contractTail();
       }
       if (hasToken<ChildHandOffToken>()) {
-        std::shared_ptr<ChildHandOffToken> token = takeToken<ChildHandOffToken>();
+        TokenPtr<ChildHandOffToken> token = takeToken<ChildHandOffToken>();
         for (int childDir : token->childDirs) {
           childDir = globalToLocalDir(childDir);
           children.insert(childDir);
@@ -1277,8 +1286,9 @@ QString LeaderElectionDeterministicParticle::inspectionText() const {
 }
 
 bool LeaderElectionDeterministicParticle::isBoundaryParticle() const {
+  const Neighborhood nbhd = neighborhood();
   for (int dir = 0; dir < 6; dir++) {
-    if (!hasNbrAtLabel(dir)) {
+    if (!nbhd.hasNbrAtLabel(dir)) {
       return true;
     }
   }
@@ -1286,10 +1296,11 @@ bool LeaderElectionDeterministicParticle::isBoundaryParticle() const {
 }
 
 int LeaderElectionDeterministicParticle::numBoundaries() const {
+  const Neighborhood nbhd = neighborhood();
   int num = 0;
   for (int dir = 0; dir < 6; dir++) {
     int prevDir = (dir + 5) % 6;
-    if (hasNbrAtLabel(prevDir) && !hasNbrAtLabel(dir)) {
+    if (nbhd.hasNbrAtLabel(prevDir) && !nbhd.hasNbrAtLabel(dir)) {
       num += 1;
     }
   }
@@ -1297,13 +1308,10 @@ int LeaderElectionDeterministicParticle::numBoundaries() const {
 }
 
 int LeaderElectionDeterministicParticle::numNbrs() const {
-  int num = 0;
-  for (int dir = 0; dir < 6; dir++) {
-    if (hasNbrAtLabel(dir)) {
-      num += 1;
-    }
-  }
-  return num;
+  // Only labels 0-5 are counted, also when this particle is expanded.
+  Neighborhood nbhd = neighborhood();
+  nbhd.particles &= 0x3f;
+  return nbhd.numNbrs();
 }
 
 bool LeaderElectionDeterministicParticle::isBridgeParticle() const {
@@ -1326,12 +1334,13 @@ bool LeaderElectionDeterministicParticle::isSemiBridgeParticle() const {
 }
 
 bool LeaderElectionDeterministicParticle::isConcave() const {
+  const Neighborhood nbhd = neighborhood();
   for (int dir = 0; dir < 6; dir++) {
     int prevDir = (dir + 5) % 6;
-    if (hasNbrAtLabel(prevDir) && !hasNbrAtLabel(dir)) {
+    if (nbhd.hasNbrAtLabel(prevDir) && !nbhd.hasNbrAtLabel(dir)) {
       int nextDir = dir;
       int unoccupied = 0;
-      while (!hasNbrAtLabel(nextDir)) {
+      while (!nbhd.hasNbrAtLabel(nextDir)) {
         unoccupied += 1;
         nextDir = (nextDir + 1) % 6;
       }
@@ -1344,9 +1353,10 @@ bool LeaderElectionDeterministicParticle::isConcave() const {
 }
 
 int LeaderElectionDeterministicParticle::concaveDir() const {
+  const Neighborhood nbhd = neighborhood();
   for (int dir = 0; dir < 6; dir++) {
     int prevDir = (dir + 5) % 6;
-    if (hasNbrAtLabel(prevDir) && !hasNbrAtLabel(dir)) {
+    if (nbhd.hasNbrAtLabel(prevDir) && !nbhd.hasNbrAtLabel(dir)) {
       return dir;
     }
   }
@@ -1354,11 +1364,12 @@ int LeaderElectionDeterministicParticle::concaveDir() const {
 }
 
 void LeaderElectionDeterministicParticle::setLabels() {
+  const Neighborhood nbhd = neighborhood();
   for (int dir = 0; dir < 6; dir++) {
     int prevDir = (dir + 5) % 6;
-    if (hasNbrAtLabel(prevDir) && !hasNbrAtLabel(dir)) {
+    if (nbhd.hasNbrAtLabel(prevDir) && !nbhd.hasNbrAtLabel(dir)) {
       int nextDir = (dir + 1) % 6;
-      while (!hasNbrAtLabel(nextDir)) {
+      while (!nbhd.hasNbrAtLabel(nextDir)) {
         nextDir = (nextDir + 1) % 6;
       }
       if (nextDir == (dir + 1) % 6) {
@@ -1384,10 +1395,11 @@ void LeaderElectionDeterministicParticle::setLabels() {
 }
 
 int LeaderElectionDeterministicParticle::nextDir(int boundary) {
+  const Neighborhood nbhd = neighborhood();
   int num = 0;
   for (int dir = 0; dir < 6; dir++) {
     int next = (dir + 5) % 6;
-    if (hasNbrAtLabel(next) && !hasNbrAtLabel(dir)) {
+    if (nbhd.hasNbrAtLabel(next) && !nbhd.hasNbrAtLabel(dir)) {
       if (num == boundary) {
         return next;
       }
@@ -1397,13 +1409,14 @@ int LeaderElectionDeterministicParticle::nextDir(int boundary) {
 }
 
 int LeaderElectionDeterministicParticle::prevDir(int boundary) {
+  const Neighborhood nbhd = neighborhood();
   int num = 0;
   for (int dir = 0; dir < 6; dir++) {
     int next = (dir + 5) % 6;
-    if (hasNbrAtLabel(next) && !hasNbrAtLabel(dir)) {
+    if (nbhd.hasNbrAtLabel(next) && !nbhd.hasNbrAtLabel(dir)) {
       if (num == boundary) {
         int prev = (dir + 1) % 6;
-        while (!hasNbrAtLabel(prev)) {
+        while (!nbhd.hasNbrAtLabel(prev)) {
           prev = (prev + 1) % 6;
         }
         return prev;
@@ -1432,11 +1445,11 @@ void LeaderElectionDeterministicParticle::cleanup(int boundary) {
   // pass cleanup token throughout segment
   if (successors[boundary] != -1) {
     LeaderElectionDeterministicParticle &nbr = nbrAtLabel(nextNbr);
-    nbr.putToken(std::make_shared<LexCompCleanupToken>(localToGlobalDir((nextNbr+3)%6)));
+    nbr.putToken(makeToken<LexCompCleanupToken>(localToGlobalDir((nextNbr+3)%6)));
   }
 
   while (hasToken<LexCompReturnNbrLabelToken>()){
-    std::shared_ptr<LexCompReturnNbrLabelToken> token = peekAtToken<LexCompReturnNbrLabelToken>();
+    TokenPtr<LexCompReturnNbrLabelToken> token = peekAtToken<LexCompReturnNbrLabelToken>();
     if (globalToLocalDir(token->origin) == nextNbr) {
       takeToken<LexCompReturnNbrLabelToken>();
     }
@@ -1445,7 +1458,7 @@ void LeaderElectionDeterministicParticle::cleanup(int boundary) {
     }
   }
   while (hasToken<LexCompReturnNbrEndOfSegmentToken>()){
-    std::shared_ptr<LexCompReturnNbrEndOfSegmentToken> token = peekAtToken<LexCompReturnNbrEndOfSegmentToken>();
+    TokenPtr<LexCompReturnNbrEndOfSegmentToken> token = peekAtToken<LexCompReturnNbrEndOfSegmentToken>();
     if (globalToLocalDir(token->origin) == nextNbr) {
       takeToken<LexCompReturnNbrEndOfSegmentToken>();
     }
@@ -1454,7 +1467,7 @@ void LeaderElectionDeterministicParticle::cleanup(int boundary) {
     }
   }
   while (hasToken<LexCompReturnLabelToken>()){
-    std::shared_ptr<LexCompReturnLabelToken> token = peekAtToken<LexCompReturnLabelToken>();
+    TokenPtr<LexCompReturnLabelToken> token = peekAtToken<LexCompReturnLabelToken>();
     if (globalToLocalDir(token->origin) == nextNbr) {
       takeToken<LexCompReturnLabelToken>();
     }
@@ -1463,7 +1476,7 @@ void LeaderElectionDeterministicParticle::cleanup(int boundary) {
     }
   }
   while (hasToken<LexCompEndOfSegmentToken>()){
-    std::shared_ptr<LexCompEndOfSegmentToken> token = peekAtToken<LexCompEndOfSegmentToken>();
+    TokenPtr<LexCompEndOfSegmentToken> token = peekAtToken<LexCompEndOfSegmentToken>();
     if (globalToLocalDir(token->origin) == nextNbr) {
       takeToken<LexCompEndOfSegmentToken>();
     }
@@ -1472,7 +1485,7 @@ void LeaderElectionDeterministicParticle::cleanup(int boundary) {
     }
   }
   while (hasToken<LexCompInterruptPrevToken>()){
-    std::shared_ptr<LexCompInterruptPrevToken> token = peekAtToken<LexCompInterruptPrevToken>();
+    TokenPtr<LexCompInterruptPrevToken> token = peekAtToken<LexCompInterruptPrevToken>();
     if (globalToLocalDir(token->origin) == nextNbr) {
       takeToken<LexCompInterruptPrevToken>();
     }
@@ -1493,11 +1506,11 @@ void LeaderElectionDeterministicParticle::cleanupForNbr(int boundary) {
   // pass cleanup token throughout segment
   if (successors[boundary] != -1) {
     LeaderElectionDeterministicParticle &nbr = nbrAtLabel(nextNbr);
-    nbr.putToken(std::make_shared<LexCompCleanupForNbrToken>(localToGlobalDir((nextNbr+3)%6)));
+    nbr.putToken(makeToken<LexCompCleanupForNbrToken>(localToGlobalDir((nextNbr+3)%6)));
   }
 
   while (hasToken<LexCompRequestNbrLabelToken>()){
-    std::shared_ptr<LexCompRequestNbrLabelToken> token = peekAtToken<LexCompRequestNbrLabelToken>();
+    TokenPtr<LexCompRequestNbrLabelToken> token = peekAtToken<LexCompRequestNbrLabelToken>();
     if (globalToLocalDir(token->origin) == prevNbr && segHeads[boundary]) {
       takeToken<LexCompRequestNbrLabelToken>();
     }
@@ -1506,7 +1519,7 @@ void LeaderElectionDeterministicParticle::cleanupForNbr(int boundary) {
     }
   }
   while (hasToken<LexCompReturnLabelForNbrToken>()){
-    std::shared_ptr<LexCompReturnLabelForNbrToken> token = peekAtToken<LexCompReturnLabelForNbrToken>();
+    TokenPtr<LexCompReturnLabelForNbrToken> token = peekAtToken<LexCompReturnLabelForNbrToken>();
     if (globalToLocalDir(token->origin) == nextNbr) {
       takeToken<LexCompReturnLabelForNbrToken>();
     }
@@ -1515,7 +1528,7 @@ void LeaderElectionDeterministicParticle::cleanupForNbr(int boundary) {
     }
   }
   while (hasToken<LexCompEndOfSegmentForNbrToken>()){
-    std::shared_ptr<LexCompEndOfSegmentForNbrToken> token = peekAtToken<LexCompEndOfSegmentForNbrToken>();
+    TokenPtr<LexCompEndOfSegmentForNbrToken> token = peekAtToken<LexCompEndOfSegmentForNbrToken>();
     if (globalToLocalDir(token->origin) == nextNbr) {
       takeToken<LexCompEndOfSegmentForNbrToken>();
     }
@@ -1524,7 +1537,7 @@ void LeaderElectionDeterministicParticle::cleanupForNbr(int boundary) {
     }
   }
   while (hasToken<LexCompInterruptNextToken>()){
-    std::shared_ptr<LexCompInterruptNextToken> token = peekAtToken<LexCompInterruptNextToken>();
+    TokenPtr<LexCompInterruptNextToken> token = peekAtToken<LexCompInterruptNextToken>();
     if (globalToLocalDir(token->origin) == prevNbr) {
       takeToken<LexCompInterruptNextToken>();
     }
@@ -1539,50 +1552,31 @@ void LeaderElectionDeterministicParticle::cleanupForNbr(int boundary) {
 //----------------------------BEGIN SYSTEM CODE----------------------------
 
 #include <string>
-#include <fstream>
-#include <sstream>
 #include <QTextStream>
 
 using namespace std;
 
-LeaderElectionDeterministicSystem::LeaderElectionDeterministicSystem(int numParticles, QString fileName) {
+LeaderElectionDeterministicSystem::LeaderElectionDeterministicSystem(int numParticles, QString fileName, const unsigned int seed)
+  : AmoebotSystem(seed) {
   Q_ASSERT(numParticles > 0 || fileName.size() > 0);
 
   randomPermutationScheduler = true;
 
-  string filePath = "../AmoebotSim/data/input/" + fileName.toStdString() + ".txt";
   if (fileName != "") {
     QTextStream out(stdout);
     out << "File name: " << fileName << endl;
-    ifstream file(filePath);
-    if (!file) {
-      out << "Cannot open file." << endl;
+    std::vector<ConfigurationRecord> records;
+    QString error;
+    if (!readConfiguration(inputConfigurationPath(fileName), records, error)) {
+      out << error << endl;
       return;
     }
     out << "File opened." << endl;
-    
-    string str;
-    while (getline(file, str)) {
-      std::vector<int> vect;
-      std::stringstream ss(str);
-
-      while (ss.good()) {
-        string substr;
-        getline(ss, substr, ',');
-        vect.push_back(std::stoi(substr));
-      }
-
-      int x = vect[0];
-      int y = vect[1];
-
-      insert(new LeaderElectionDeterministicParticle(
-      Node(x, y), -1, randDir(), *this,
-      LeaderElectionDeterministicParticle::State::Initlialization));
-    }
 
-    file.close();
+    emplaceParticles<LeaderElectionDeterministicParticle>(
+        records, LeaderElectionDeterministicParticle::State::Initlialization);
 
-    outputPath = "../AmoebotSim/data/output/" + fileName.toStdString() + ".txt";
+    inputName = fileName;
 
     out << "Particle system initialized from file." << endl;
     
@@ -1590,9 +1584,9 @@ LeaderElectionDeterministicSystem::LeaderElectionDeterministicSystem(int numPart
   }
 
   // Insert the seed at (0,0).
-  insert(new LeaderElectionDeterministicParticle(
+  emplaceParticle<LeaderElectionDeterministicParticle>(
       Node(0, 0), -1, randDir(), *this,
-      LeaderElectionDeterministicParticle::State::Initlialization));
+      LeaderElectionDeterministicParticle::State::Initlialization);
   std::set<Node> occupied;
   occupied.insert(Node(0, 0));
 
@@ -1622,9 +1616,9 @@ LeaderElectionDeterministicSystem::LeaderElectionDeterministicSystem(int numPart
         }
         if (switches <= 2) {
           occupied.insert(nbr);
-          insert(new LeaderElectionDeterministicParticle(
+          emplaceParticle<LeaderElectionDeterministicParticle>(
               nbr, -1, randDir(), *this,
-              LeaderElectionDeterministicParticle::State::Initlialization));
+              LeaderElectionDeterministicParticle::State::Initlialization);
           ++added;
           if (added == numParticles) {
             break;
@@ -1637,31 +1631,36 @@ LeaderElectionDeterministicSystem::LeaderElectionDeterministicSystem(int numPart
 
 bool LeaderElectionDeterministicSystem::hasTerminated() const {
 #ifdef QT_DEBUG
-  if (!isConnected(particles)) {
+  if (!isConnected(snapshot())) {
     return true;
   }
 #endif
 
-  for (auto p : particles) {
-    auto hp = dynamic_cast<LeaderElectionDeterministicParticle *>(p);
-    if (hp->state == LeaderElectionDeterministicParticle::State::Leader) {
-      if (outputPath != "") {
-        ofstream file;
-        file.open(outputPath);
-        file << std::to_string(hp->head.x) << "," << std::to_string(hp->head.y);
+  if (numParticlesInState(
+          static_cast<unsigned char>(LeaderElectionDeterministicParticle::State::Leader)) == 0) {
+    return false;
+  }
 
-        file << "\n" << std::to_string(getCount("# Rounds")._value);
-        file << "\n" << std::to_string(getCount("# Activations")._value);
-        file << "\n" << std::to_string(getCount("# Moves")._value);
+  return true;
+}
 
-        file.close();
+bool LeaderElectionDeterministicSystem::supportsParallelRounds() const {
+  return true;
+}
 
-        QTextStream out(stdout);
-        out << "Output written to: " << QString::fromStdString(outputPath) << endl;
-      }
-      return true;
+bool LeaderElectionDeterministicSystem::reportsResults() const {
+  return true;
+}
+
+void LeaderElectionDeterministicSystem::writeResult(ResultRow& row) const {
+  row.input = inputName;
+  for (auto p : particles) {
+    auto hp = dynamic_cast<LeaderElectionDeterministicParticle*>(p);
+    if (hp->state == LeaderElectionDeterministicParticle::State::Leader) {
+      row.hasLeader = true;
+      row.leaderX = hp->head.x;
+      row.leaderY = hp->head.y;
+      return;
     }
   }
-
-  return false;
-}
\ No newline at end of file
+}
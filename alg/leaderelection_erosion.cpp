@@ -15,6 +15,8 @@
 
 #include <QDebug>
 
+#include "core/resultsink.h"
+
 using namespace std;
 
 //----------------------------BEGIN PARTICLE CODE----------------------------
@@ -22,7 +24,14 @@ using namespace std;
 LeaderElectionErosionParticle::LeaderElectionErosionParticle(
     const Node head, const int globalTailDir, const int orientation,
     AmoebotSystem &system, State state)
-    : AmoebotParticle(head, globalTailDir, orientation, system), state(state) {}
+    : AmoebotParticle(head, globalTailDir, orientation, system), state(state) {
+  setSnapshotState(static_cast<unsigned char>(state));
+}
+
+void LeaderElectionErosionParticle::setState(State state) {
+  this->state = state;
+  setSnapshotState(static_cast<unsigned char>(state));
+}
 
 void LeaderElectionErosionParticle::activate() {
   // 1. Lattice consumption phase.
@@ -33,7 +42,7 @@ void LeaderElectionErosionParticle::activate() {
      * Otherwise, the particle will participate in leader election. */
     int numNbrs = getNumberOfNbrs();
     if (numNbrs == 0) {
-      state = State::Leader;
+      setState(State::Leader);
       stateStable = false;
       return;
     } else {
@@ -82,7 +91,7 @@ void LeaderElectionErosionParticle::activate() {
         return;
       } else if (cornerType == 0) {
         // One 0-corner particle remaining.
-        state = State::Candidate;
+        setState(State::Candidate);
         stateStable = false;
         return;
       } else if (cornerType == 1) {
@@ -93,11 +102,11 @@ void LeaderElectionErosionParticle::activate() {
               // If unique elible neighbor is 1-corner -> candidate
               // Otherwise erode.
               if (nbr.cornerType == 1) {
-                state = State::Candidate;
+                setState(State::Candidate);
                 stateStable = false;
                 return;
               } else {
-                state = State::Eroded;
+                setState(State::Eroded);
                 stateStable = false;
                 return;
               }
@@ -112,19 +121,19 @@ void LeaderElectionErosionParticle::activate() {
             LeaderElectionErosionParticle &nbr = nbrAtLabel(dir);
             if (nbr.state != State::Eroded) {
               if (nbr.cornerType != 2) {
-                state = State::Eroded;
+                setState(State::Eroded);
                 stateStable = false;
                 return;
               }
             }
           }
         }
-        state = State::Candidate;
+        setState(State::Candidate);
         stateStable = false;
         return;
       } else {
         // 3-corner particle -> erode.
-        state = State::Eroded;
+        setState(State::Eroded);
         stateStable = false;
         return;
       }
@@ -144,7 +153,7 @@ void LeaderElectionErosionParticle::activate() {
 
     if (cornerType == 0) {
       // If unique 0-corner candidate -> become leader.
-      state = State::Leader;
+      setState(State::Leader);
       stateStable = false;
       return;
     } // Else: move to phase 2: spanning forest construction phase.
@@ -159,7 +168,7 @@ void LeaderElectionErosionParticle::activate() {
           }
         }
       }
-      state = State::Root;
+      setState(State::Root);
       parent = -1;
       stateStable = false;
       return;
@@ -197,7 +206,7 @@ void LeaderElectionErosionParticle::activate() {
           return;
         }
 
-        state = State::RootElection;
+        setState(State::RootElection);
         stateStable = false;
         return;
       }
@@ -249,19 +258,19 @@ void LeaderElectionErosionParticle::activate() {
             if ((dir - dir_u + 6) % 6 == 1) {
               // Have u choose.
               int globalizedDirU = localToGlobalDir(dir_u);
-              u.putToken(std::make_shared<YouChooseToken>(globalizedDirU));
+              u.putToken(makeToken<YouChooseToken>(globalizedDirU));
 
               int globalizedDirV = localToGlobalDir(dir_v);
-              v.putToken(std::make_shared<YouDoNotChooseToken>(globalizedDirV));
+              v.putToken(makeToken<YouDoNotChooseToken>(globalizedDirV));
 
               chooseTokenSent = true;
             } else {
               // Have v choose.
               int globalizedDirV = localToGlobalDir(dir_v);
-              v.putToken(std::make_shared<YouChooseToken>(globalizedDirV));
+              v.putToken(makeToken<YouChooseToken>(globalizedDirV));
 
               int globalizedDirU = localToGlobalDir(dir_u);
-              u.putToken(std::make_shared<YouDoNotChooseToken>(globalizedDirU));
+              u.putToken(makeToken<YouDoNotChooseToken>(globalizedDirU));
 
               chooseTokenSent = true;
             }
@@ -278,7 +287,7 @@ void LeaderElectionErosionParticle::activate() {
 
             qDebug() << "Agreed on handedness.";
 
-            state = State::RootElection;
+            setState(State::RootElection);
             stateStable = false;
             return;
           }
@@ -290,7 +299,7 @@ void LeaderElectionErosionParticle::activate() {
             LeaderElectionErosionParticle &u = nbrAtLabel(dir_u);
             if (!chooseTokenSent) {
               int globalizedDir = localToGlobalDir(dir_u);
-              u.putToken(std::make_shared<YouChooseToken>(globalizedDir));
+              u.putToken(makeToken<YouChooseToken>(globalizedDir));
               chooseTokenSent = true;
             } else {
               if (hasToken<ChosenToken>()) {
@@ -304,7 +313,7 @@ void LeaderElectionErosionParticle::activate() {
                   int localChosenDir = globalToLocalDir(globalChosenDir);
                   int localNbrDir = (localChosenDir + 3) % 6;
                   if (localNbrDir == dir_u) {
-                    state = State::Leader;
+                    setState(State::Leader);
                     stateStable = false;
                     return;
                   }
@@ -314,10 +323,10 @@ void LeaderElectionErosionParticle::activate() {
                 int localChosenDir = globalToLocalDir(globalChosenDir);
                 int localNbrDir = (localChosenDir + 3) % 6;
                 if (localNbrDir == dir_u) {
-                  state = State::Tree;
+                  setState(State::Tree);
                   parent = dir;
                   int globalizedDir = localToGlobalDir(parent);
-                  q.putToken(std::make_shared<ParentToken>(globalizedDir));
+                  q.putToken(makeToken<ParentToken>(globalizedDir));
                   stateStable = false;
                   return;
                 }
@@ -327,7 +336,7 @@ void LeaderElectionErosionParticle::activate() {
             LeaderElectionErosionParticle &v = nbrAtLabel(dir_v);
             if (!chooseTokenSent) {
               int globalizedDir = localToGlobalDir(dir_v);
-              v.putToken(std::make_shared<YouChooseToken>(globalizedDir));
+              v.putToken(makeToken<YouChooseToken>(globalizedDir));
               chooseTokenSent = true;
             } else {
               if (hasToken<ChosenToken>()) {
@@ -341,7 +350,7 @@ void LeaderElectionErosionParticle::activate() {
                   int localChosenDir = globalToLocalDir(globalChosenDir);
                   int localNbrDir = (localChosenDir + 3) % 6;
                   if (localNbrDir == dir_v) {
-                    state = State::Leader;
+                    setState(State::Leader);
                     stateStable = false;
                     return;
                   }
@@ -351,10 +360,10 @@ void LeaderElectionErosionParticle::activate() {
                 int localChosenDir = globalToLocalDir(globalChosenDir);
                 int localNbrDir = (localChosenDir + 3) % 6;
                 if (localNbrDir == dir_v) {
-                  state = State::Tree;
+                  setState(State::Tree);
                   parent = dir;
                   int globalizedDir = localToGlobalDir(parent);
-                  q.putToken(std::make_shared<ParentToken>(globalizedDir));
+                  q.putToken(makeToken<ParentToken>(globalizedDir));
                   stateStable = false;
                   return;
                 }
@@ -371,10 +380,10 @@ void LeaderElectionErosionParticle::activate() {
               } else if (hasToken<YouAreEliminatedToken>()) {
                 takeToken<YouAreEliminatedToken>();
                 int globalizedDir = localToGlobalDir(dir);
-                q.putToken(std::make_shared<IAmEliminatedToken>(globalizedDir));
-                state = State::Tree;
+                q.putToken(makeToken<IAmEliminatedToken>(globalizedDir));
+                setState(State::Tree);
                 parent = dir;
-                q.putToken(std::make_shared<ParentToken>(globalizedDir));
+                q.putToken(makeToken<ParentToken>(globalizedDir));
                 stateStable = false;
                 return;
               } else {
@@ -394,12 +403,12 @@ void LeaderElectionErosionParticle::activate() {
                 // Same handedness
                 sameHandedness = true;
                 q.putToken(
-                    std::make_shared<SameHandednessToken>(globalizedDir));
+                    makeToken<SameHandednessToken>(globalizedDir));
                 stateStable = true;
                 return;
               } else {
                 q.putToken(
-                    std::make_shared<YouAreEliminatedToken>(globalizedDir));
+                    makeToken<YouAreEliminatedToken>(globalizedDir));
                 stateStable = true;
                 return;
               }
@@ -409,7 +418,7 @@ void LeaderElectionErosionParticle::activate() {
                 takeToken<ParentToken>();
                 children.insert(dir);
                 contractHead();
-                state = State::Leader;
+                setState(State::Leader);
                 stateStable = false;
                 return;
               }
@@ -426,7 +435,7 @@ void LeaderElectionErosionParticle::activate() {
 
               qDebug() << "Agreed on handedness.";
 
-              state = State::RootElection;
+              setState(State::RootElection);
               stateStable = false;
               return;
             }
@@ -438,10 +447,10 @@ void LeaderElectionErosionParticle::activate() {
               } else if (hasToken<YouAreEliminatedToken>()) {
                 takeToken<YouAreEliminatedToken>();
                 int globalizedDir = localToGlobalDir(dir);
-                q.putToken(std::make_shared<IAmEliminatedToken>(globalizedDir));
-                state = State::Tree;
+                q.putToken(makeToken<IAmEliminatedToken>(globalizedDir));
+                setState(State::Tree);
                 parent = dir;
-                q.putToken(std::make_shared<ParentToken>(globalizedDir));
+                q.putToken(makeToken<ParentToken>(globalizedDir));
                 stateStable = false;
                 return;
               } else {
@@ -461,12 +470,12 @@ void LeaderElectionErosionParticle::activate() {
                 // Same handedness
                 sameHandedness = true;
                 q.putToken(
-                    std::make_shared<SameHandednessToken>(globalizedDir));
+                    makeToken<SameHandednessToken>(globalizedDir));
                 stateStable = true;
                 return;
               } else {
                 q.putToken(
-                    std::make_shared<YouAreEliminatedToken>(globalizedDir));
+                    makeToken<YouAreEliminatedToken>(globalizedDir));
                 stateStable = true;
                 return;
               }
@@ -476,7 +485,7 @@ void LeaderElectionErosionParticle::activate() {
                 takeToken<ParentToken>();
                 children.insert(dir);
                 contractHead();
-                state = State::Leader;
+                setState(State::Leader);
                 stateStable = false;
                 return;
               }
@@ -493,7 +502,7 @@ void LeaderElectionErosionParticle::activate() {
 
               qDebug() << "Agreed on handedness.";
 
-              state = State::RootElection;
+              setState(State::RootElection);
               stateStable = false;
               return;
             }
@@ -530,13 +539,13 @@ void LeaderElectionErosionParticle::activate() {
         if (!chooseTokenSent) {
           // choose q
           if (dir_r == (dir_q + 1) % 6) {
-            q.putToken(std::make_shared<ChosenToken>(globalizedDirQ));
-            r.putToken(std::make_shared<NotChosenToken>(globalizedDirR));
+            q.putToken(makeToken<ChosenToken>(globalizedDirQ));
+            r.putToken(makeToken<NotChosenToken>(globalizedDirR));
             chooseTokenSent = true;
           } // choose r
           else {
-            q.putToken(std::make_shared<NotChosenToken>(globalizedDirQ));
-            r.putToken(std::make_shared<ChosenToken>(globalizedDirR));
+            q.putToken(makeToken<NotChosenToken>(globalizedDirQ));
+            r.putToken(makeToken<ChosenToken>(globalizedDirR));
             chooseTokenSent = true;
           }
         }
@@ -545,12 +554,12 @@ void LeaderElectionErosionParticle::activate() {
         if (countTokens<ChosenToken>() == 2) {
           takeToken<ChosenToken>();
           takeToken<ChosenToken>();
-          q.putToken(std::make_shared<YouAreEliminatedToken>(globalizedDirQ));
-          r.putToken(std::make_shared<YouAreEliminatedToken>(globalizedDirR));
+          q.putToken(makeToken<YouAreEliminatedToken>(globalizedDirQ));
+          r.putToken(makeToken<YouAreEliminatedToken>(globalizedDirR));
 
           sameHandedness = true;
 
-          state = State::Leader;
+          setState(State::Leader);
           stateStable = false;
           return;
         }
@@ -559,8 +568,8 @@ void LeaderElectionErosionParticle::activate() {
                  countTokens<NotChosenToken>() == 1) {
           takeToken<ChosenToken>();
           takeToken<NotChosenToken>();
-          q.putToken(std::make_shared<IAmEliminatedToken>(globalizedDirQ));
-          r.putToken(std::make_shared<IAmEliminatedToken>(globalizedDirR));
+          q.putToken(makeToken<IAmEliminatedToken>(globalizedDirQ));
+          r.putToken(makeToken<IAmEliminatedToken>(globalizedDirR));
           notChosen = true;
         }
 
@@ -570,11 +579,11 @@ void LeaderElectionErosionParticle::activate() {
           int localLeaderDir = globalToLocalDir(globalLeaderDir);
           int localNbrDir = (localLeaderDir + 3) % 6;
 
-          state = State::Tree;
+          setState(State::Tree);
           parent = localNbrDir;
           int globalizedDir = localToGlobalDir(parent);
           LeaderElectionErosionParticle &l = nbrAtLabel(parent);
-          l.putToken(std::make_shared<ParentToken>(globalizedDir));
+          l.putToken(makeToken<ParentToken>(globalizedDir));
           stateStable = false;
           return;
         }
@@ -591,7 +600,7 @@ void LeaderElectionErosionParticle::activate() {
 
           qDebug() << "Agreed on handedness.";
 
-          state = State::RootElection;
+          setState(State::RootElection);
           stateStable = false;
           return;
         }
@@ -609,23 +618,25 @@ void LeaderElectionErosionParticle::activate() {
       if (hasNbrAtLabel(dir)) {
         LeaderElectionErosionParticle &nbr = nbrAtLabel(dir);
         if (nbr.state == State::Root) {
-          state = State::Tree;
+          setState(State::Tree);
           parent = dir;
           int globalizedDir = localToGlobalDir(parent);
-          nbr.putToken(std::make_shared<ParentToken>(globalizedDir));
+          nbr.putToken(makeToken<ParentToken>(globalizedDir));
           stateStable = false;
           return;
         } else if (nbr.state == State::Tree) {
-          state = State::Tree;
+          setState(State::Tree);
           parent = dir;
           int globalizedDir = localToGlobalDir(parent);
-          nbr.putToken(std::make_shared<ParentToken>(globalizedDir));
+          nbr.putToken(makeToken<ParentToken>(globalizedDir));
           stateStable = false;
           return;
         }
       }
     }
+    // Nothing changes until a neighbor joins a tree, which wakes this particle.
     stateStable = true;
+    sleep();
     return;
   } else if (state == State::Tree) {
     // 2. Spanning forest construction phase.
@@ -661,15 +672,15 @@ void LeaderElectionErosionParticle::activate() {
         for (int dir = 0; dir < 6; dir++) {
           if (dir == dir_p) {
             int globalizedDirP = localToGlobalDir(dir_p);
-            p.putToken(std::make_shared<ChosenToken>(globalizedDirP));
+            p.putToken(makeToken<ChosenToken>(globalizedDirP));
             int globalizedDirQ = localToGlobalDir(dir_q);
-            q.putToken(std::make_shared<NotChosenToken>(globalizedDirQ));
+            q.putToken(makeToken<NotChosenToken>(globalizedDirQ));
             break;
           } else if (dir == dir_q) {
             int globalizedDirQ = localToGlobalDir(dir_q);
-            q.putToken(std::make_shared<ChosenToken>(globalizedDirQ));
+            q.putToken(makeToken<ChosenToken>(globalizedDirQ));
             int globalizedDirP = localToGlobalDir(dir_p);
-            p.putToken(std::make_shared<NotChosenToken>(globalizedDirP));
+            p.putToken(makeToken<NotChosenToken>(globalizedDirP));
             break;
           }
         }
@@ -687,10 +698,10 @@ void LeaderElectionErosionParticle::activate() {
         LeaderElectionErosionParticle &q = nbrAtLabel(dir_q);
 
         int globalizedDirP = localToGlobalDir(dir_p);
-        p.putToken(std::make_shared<SameHandednessToken>(globalizedDirP));
+        p.putToken(makeToken<SameHandednessToken>(globalizedDirP));
 
         int globalizedDirQ = localToGlobalDir(dir_q);
-        q.putToken(std::make_shared<SameHandednessToken>(globalizedDirQ));
+        q.putToken(makeToken<SameHandednessToken>(globalizedDirQ));
       }
 
       // 4. Leader election phase
@@ -741,7 +752,7 @@ void LeaderElectionErosionParticle::activate() {
               int globalizedDir = localToGlobalDir(childDir);
 
               nbr.putToken(
-                  std::make_shared<RequestEncodingToken>(globalizedDir));
+                  makeToken<RequestEncodingToken>(globalizedDir));
               sentEncodingRequest = true;
 
               stateStable = true;
@@ -753,7 +764,7 @@ void LeaderElectionErosionParticle::activate() {
             // If encoding received
             if (hasToken<EncodingToken>()) {
               // Take token and forward encoding
-              std::shared_ptr<EncodingToken> token =
+              TokenPtr<EncodingToken> token =
                   peekAtToken<EncodingToken>();
               string encoding = token->encoding;
               takeToken<EncodingToken>();
@@ -809,7 +820,7 @@ void LeaderElectionErosionParticle::activate() {
     if (sentEncodingRequest) {
       if (hasToken<EncodingToken>()) {
         // Receive encoding token, set encoding and send it
-        std::shared_ptr<EncodingToken> token = peekAtToken<EncodingToken>();
+        TokenPtr<EncodingToken> token = peekAtToken<EncodingToken>();
         int globalDir = token->origin;
         string encoding = token->encoding;
         takeToken<EncodingToken>();
@@ -848,23 +859,23 @@ void LeaderElectionErosionParticle::activate() {
       }
 
       if (numCandidates == 1) {
-        std::shared_ptr<EncodingTokenCandidate> token =
+        TokenPtr<EncodingTokenCandidate> token =
             takeToken<EncodingTokenCandidate>();
         int globalDir = token->origin;
         string encoding = token->encoding;
 
         if (currentEncoding < encoding) {
           // Lexicographically smaller -> become leader
-          state = State::Leader;
+          setState(State::Leader);
           stateStable = false;
           return;
         } else if (currentEncoding > encoding) {
           // Lexicographically larger -> revoke candidacy
-          state = State::Tree;
+          setState(State::Tree);
           parent = (globalToLocalDir(globalDir) + 3) % 6;
           int globalizedDir = localToGlobalDir(parent);
           LeaderElectionErosionParticle &nbr = nbrAtLabel(parent);
-          nbr.putToken(std::make_shared<ParentToken>(globalizedDir));
+          nbr.putToken(makeToken<ParentToken>(globalizedDir));
           stateStable = false;
           return;
         } else {
@@ -874,13 +885,13 @@ void LeaderElectionErosionParticle::activate() {
           return;
         }
       } else if (numCandidates == 2) {
-        std::shared_ptr<EncodingTokenCandidate> tokenA =
+        TokenPtr<EncodingTokenCandidate> tokenA =
             peekAtToken<EncodingTokenCandidate>();
         int globalDirA = tokenA->origin;
         string encodingA = tokenA->encoding;
         takeToken<EncodingTokenCandidate>();
 
-        std::shared_ptr<EncodingTokenCandidate> tokenB =
+        TokenPtr<EncodingTokenCandidate> tokenB =
             peekAtToken<EncodingTokenCandidate>();
         int globalDirB = tokenB->origin;
         string encodingB = tokenB->encoding;
@@ -888,25 +899,25 @@ void LeaderElectionErosionParticle::activate() {
 
         if (currentEncoding < encodingA && currentEncoding < encodingB) {
           // Lexicographically smallest -> become leader
-          state = State::Leader;
+          setState(State::Leader);
           stateStable = false;
           return;
         } else if (encodingA < currentEncoding && encodingA < encodingB) {
           // encoding A is smallest -> A becomes the leader
-          state = State::Tree;
+          setState(State::Tree);
           parent = (globalToLocalDir(globalDirA) + 3) % 6;
           int globalizedDir = localToGlobalDir(parent);
           LeaderElectionErosionParticle &nbr = nbrAtLabel(parent);
-          nbr.putToken(std::make_shared<ParentToken>(globalizedDir));
+          nbr.putToken(makeToken<ParentToken>(globalizedDir));
           stateStable = false;
           return;
         } else if (encodingB < currentEncoding && encodingB < encodingA) {
           // encoding B is smallest -> B becomes the leader
-          state = State::Tree;
+          setState(State::Tree);
           parent = (globalToLocalDir(globalDirB) + 3) % 6;
           int globalizedDir = localToGlobalDir(parent);
           LeaderElectionErosionParticle &nbr = nbrAtLabel(parent);
-          nbr.putToken(std::make_shared<ParentToken>(globalizedDir));
+          nbr.putToken(makeToken<ParentToken>(globalizedDir));
           stateStable = false;
           return;
         }
@@ -914,25 +925,25 @@ void LeaderElectionErosionParticle::activate() {
         // Check if there is a unique lexicographically largest encoding...
         else if (currentEncoding > encodingA && currentEncoding > encodingB) {
           // Lexicographically largest -> become leader
-          state = State::Leader;
+          setState(State::Leader);
           stateStable = false;
           return;
         } else if (encodingA > currentEncoding && encodingA > encodingB) {
           // encoding A is largest -> A becomes leader
-          state = State::Tree;
+          setState(State::Tree);
           parent = (globalToLocalDir(globalDirA) + 3) % 6;
           int globalizedDir = localToGlobalDir(parent);
           LeaderElectionErosionParticle &nbr = nbrAtLabel(parent);
-          nbr.putToken(std::make_shared<ParentToken>(globalizedDir));
+          nbr.putToken(makeToken<ParentToken>(globalizedDir));
           stateStable = false;
           return;
         } else if (encodingB > currentEncoding && encodingB > encodingA) {
           // encoding B is largest -> B becomes leader
-          state = State::Tree;
+          setState(State::Tree);
           parent = (globalToLocalDir(globalDirB) + 3) % 6;
           int globalizedDir = localToGlobalDir(parent);
           LeaderElectionErosionParticle &nbr = nbrAtLabel(parent);
-          nbr.putToken(std::make_shared<ParentToken>(globalizedDir));
+          nbr.putToken(makeToken<ParentToken>(globalizedDir));
           stateStable = false;
           return;
         } else {
@@ -974,14 +985,14 @@ void LeaderElectionErosionParticle::activate() {
     if (childDir == candidateDir) {
       // Tree exhausted -> unbreakable symmetry by theorem 6
       // Become leader (1 of multiple leaders, algorithm fails)
-      state = State::Leader;
+      setState(State::Leader);
       stateStable = false;
       return;
     } else {
       // Request encoding from child
       LeaderElectionErosionParticle &nbr = nbrAtLabel(childDir);
       int globalizedDir = localToGlobalDir(childDir);
-      nbr.putToken(std::make_shared<RequestEncodingToken>(globalizedDir));
+      nbr.putToken(makeToken<RequestEncodingToken>(globalizedDir));
       sentEncodingRequest = true;
       stateStable = true;
       return;
@@ -995,13 +1006,13 @@ void LeaderElectionErosionParticle::activate() {
 void LeaderElectionErosionParticle::sendExhaustedToken(int dir) {
   LeaderElectionErosionParticle &nbr = nbrAtLabel(dir);
   int globalizedDir = localToGlobalDir(dir);
-  nbr.putToken(std::make_shared<SubTreeExhaustedToken>(globalizedDir));
+  nbr.putToken(makeToken<SubTreeExhaustedToken>(globalizedDir));
 }
 
 void LeaderElectionErosionParticle::sendEncodingParent(string encoding) {
   LeaderElectionErosionParticle &nbr = nbrAtLabel(parent);
   int globalizedDir = localToGlobalDir(parent);
-  nbr.putToken(std::make_shared<EncodingToken>(globalizedDir, encoding));
+  nbr.putToken(makeToken<EncodingToken>(globalizedDir, encoding));
 }
 
 void LeaderElectionErosionParticle::sendEncodingCandidates(string encoding) {
@@ -1009,7 +1020,7 @@ void LeaderElectionErosionParticle::sendEncodingCandidates(string encoding) {
     LeaderElectionErosionParticle &nbr = nbrAtLabel(dir);
     int globalizedDir = localToGlobalDir(dir);
     nbr.putToken(
-        std::make_shared<EncodingTokenCandidate>(globalizedDir, encoding));
+        makeToken<EncodingTokenCandidate>(globalizedDir, encoding));
   }
 }
 
@@ -1249,13 +1260,10 @@ int LeaderElectionErosionParticle::getCornerType() const {
 }
 
 int LeaderElectionErosionParticle::getNumberOfNbrs() const {
-  int count = 0;
-  for (int dir = 0; dir < 6; dir++) {
-    if (hasNbrAtLabel(dir)) {
-      count++;
-    }
-  }
-  return count;
+  // Only labels 0-5 are counted, also when this particle is expanded.
+  Neighborhood nbhd = neighborhood();
+  nbhd.particles &= 0x3f;
+  return nbhd.numNbrs();
 }
 
 QString LeaderElectionErosionParticle::inspectionText() const {
@@ -1313,50 +1321,31 @@ QString LeaderElectionErosionParticle::inspectionText() const {
 //----------------------------BEGIN SYSTEM CODE----------------------------
 
 #include <string>
-#include <fstream>
-#include <sstream>
 #include <QTextStream>
 
 using namespace std;
 
-LeaderElectionErosionSystem::LeaderElectionErosionSystem(int numParticles, QString fileName) {
+LeaderElectionErosionSystem::LeaderElectionErosionSystem(int numParticles, QString fileName, const unsigned int seed)
+  : AmoebotSystem(seed) {
   Q_ASSERT(numParticles > 0 || fileName.size() > 0);
 
   randomPermutationScheduler = true;
 
-  string filePath = "../AmoebotSim/data/input/" + fileName.toStdString() + ".txt";
   if (fileName != "") {
     QTextStream out(stdout);
     out << "File name: " << fileName << endl;
-    ifstream file(filePath);
-    if (!file) {
-      out << "Cannot open file." << endl;
+    std::vector<ConfigurationRecord> records;
+    QString error;
+    if (!readConfiguration(inputConfigurationPath(fileName), records, error)) {
+      out << error << endl;
       return;
     }
     out << "File opened." << endl;
-    
-    string str;
-    while (getline(file, str)) {
-      std::vector<int> vect;
-      std::stringstream ss(str);
-
-      while (ss.good()) {
-        string substr;
-        getline(ss, substr, ',');
-        vect.push_back(std::stoi(substr));
-      }
 
-      int x = vect[0];
-      int y = vect[1];
-
-      insert(new LeaderElectionErosionParticle(
-      Node(x, y), -1, randDir(), *this,
-      LeaderElectionErosionParticle::State::Eligible));
-    }
+    emplaceParticles<LeaderElectionErosionParticle>(
+        records, LeaderElectionErosionParticle::State::Eligible);
 
-    file.close();
-
-    outputPath = "../AmoebotSim/data/output/" + fileName.toStdString() + ".txt";
+    inputName = fileName;
 
     out << "Particle system initialized from file." << endl;
     
@@ -1364,9 +1353,9 @@ LeaderElectionErosionSystem::LeaderElectionErosionSystem(int numParticles, QStri
   }
 
   // Insert the seed at (0,0).
-  insert(new LeaderElectionErosionParticle(
+  emplaceParticle<LeaderElectionErosionParticle>(
       Node(0, 0), -1, randDir(), *this,
-      LeaderElectionErosionParticle::State::Eligible));
+      LeaderElectionErosionParticle::State::Eligible);
   std::set<Node> occupied;
   occupied.insert(Node(0, 0));
 
@@ -1396,9 +1385,9 @@ LeaderElectionErosionSystem::LeaderElectionErosionSystem(int numParticles, QStri
         }
         if (switches <= 2) {
           occupied.insert(nbr);
-          insert(new LeaderElectionErosionParticle(
+          emplaceParticle<LeaderElectionErosionParticle>(
               nbr, -1, randDir(), *this,
-              LeaderElectionErosionParticle::State::Eligible));
+              LeaderElectionErosionParticle::State::Eligible);
           ++added;
           if (added == numParticles) {
             break;
@@ -1411,31 +1400,36 @@ LeaderElectionErosionSystem::LeaderElectionErosionSystem(int numParticles, QStri
 
 bool LeaderElectionErosionSystem::hasTerminated() const {
 #ifdef QT_DEBUG
-  if (!isConnected(particles)) {
+  if (!isConnected(snapshot())) {
     return true;
   }
 #endif
 
-  for (auto p : particles) {
-    auto hp = dynamic_cast<LeaderElectionErosionParticle *>(p);
-    if (hp->state == LeaderElectionErosionParticle::State::Leader) {
-      if (outputPath != "") {
-        ofstream file;
-        file.open(outputPath);
-        file << std::to_string(hp->head.x) << "," << std::to_string(hp->head.y);
+  if (numParticlesInState(
+          static_cast<unsigned char>(LeaderElectionErosionParticle::State::Leader)) == 0) {
+    return false;
+  }
 
-        file << "\n" << std::to_string(getCount("# Rounds")._value);
-        file << "\n" << std::to_string(getCount("# Activations")._value);
-        file << "\n" << std::to_string(getCount("# Moves")._value);
+  return true;
+}
 
-        file.close();
+bool LeaderElectionErosionSystem::supportsParallelRounds() const {
+  return true;
+}
 
-        QTextStream out(stdout);
-        out << "Output written to: " << QString::fromStdString(outputPath) << endl;
-      }
-      return true;
+bool LeaderElectionErosionSystem::reportsResults() const {
+  return true;
+}
+
+void LeaderElectionErosionSystem::writeResult(ResultRow& row) const {
+  row.input = inputName;
+  for (auto p : particles) {
+    auto hp = dynamic_cast<LeaderElectionErosionParticle*>(p);
+    if (hp->state == LeaderElectionErosionParticle::State::Leader) {
+      row.hasLeader = true;
+      row.leaderX = hp->head.x;
+      row.leaderY = hp->head.y;
+      return;
     }
   }
-
-  return false;
-}
\ No newline at end of file
+}
@@ -35,6 +35,10 @@ public:
 
   State state;
 
+  // Sets this particle's state and publishes it as its snapshot state, so
+  // that the system can count the particles in each state.
+  void setState(State state);
+
   // Denotes the local direction to the parent particle.
   int parent;
 
@@ -246,12 +250,27 @@ public:
   // specified size (#particles), and hole probability. holeProb in [0,1]
   // controls how "spread out" the system is; closer to 0 is more compressed,
   // closer to 1 is more expanded.
-  LeaderElectionErosionSystem(int numParticles = 100, QString fileName = "");
-
-  string outputPath = "";
+  LeaderElectionErosionSystem(int numParticles = 100, QString fileName = "", const unsigned int seed = 0);
 
   // Checks whether or not the system's run of the Leader Election algorithm has
   // terminated (all particles in state Finished or Leader).
   bool hasTerminated() const override;
+
+  // Activations only involve a particle and its neighbors, so this system can
+  // be run in parallel rounds.
+  bool supportsParallelRounds() const override;
+
+  // Results report the elected leader, so they are kept from GUI runs too.
+  bool reportsResults() const override;
+
+ protected:
+  // Reports the input configuration the system was loaded from and the
+  // position of the elected leader.
+  void writeResult(ResultRow& row) const override;
+
+ private:
+  // The name of the input configuration the system was loaded from, or
+  // empty.
+  QString inputName;
 };
 #endif // AMOEBOTSIM_ALG_LEADERELECTION_EROSION_H_
\ No newline at end of file
@@ -16,6 +16,8 @@
 
 #include <QDebug>
 
+#include "core/resultsink.h"
+
 using namespace std;
 
 //----------------------------BEGIN PARTICLE CODE----------------------------
@@ -23,18 +25,28 @@ using namespace std;
 LeaderElectionSContractionParticle::LeaderElectionSContractionParticle(
     const Node head, const int globalTailDir, const int orientation,
     AmoebotSystem &system, State state)
-    : AmoebotParticle(head, globalTailDir, orientation, system), state(state) {}
+    : AmoebotParticle(head, globalTailDir, orientation, system), state(state) {
+  setSnapshotState(static_cast<unsigned char>(state));
+}
+
+void LeaderElectionSContractionParticle::setState(State state) {
+  this->state = state;
+  setSnapshotState(static_cast<unsigned char>(state));
+}
 
 void LeaderElectionSContractionParticle::activate() {
   if (state == State::Candidate) {
     if (isSContractible()) {
       if (!hasCandidateNbr()) {
-        state = State::Leader;
+        setState(State::Leader);
       }
       else {
-        state = State::NotElected;
+        setState(State::NotElected);
       }
     }
+  } else {
+    // Eliminated particles and the leader never act again.
+    sleep();
   }
 }
 
@@ -93,61 +105,42 @@ bool LeaderElectionSContractionParticle::isSContractible() {
 }
 
 bool LeaderElectionSContractionParticle::candidatesConnected() {
+  const unsigned int candidates = candidateNbrMask();
+  auto isCandidate = [candidates](int dir) {
+    return ((candidates >> dir) & 1u) != 0;
+  };
+
   for (int dir = 0; dir < 6; dir++) {
-    bool nonCandidate = false;
-    if (hasNbrAtLabel(dir)) {
-      LeaderElectionSContractionParticle &nbr = nbrAtLabel(dir);
-      if (nbr.state != State::Candidate) {
-        nonCandidate = true;
-      }
-    }
-    else {
-      nonCandidate = true;
+    if (isCandidate(dir)) {
+      continue;
     }
 
-    if (nonCandidate) {
-      for (int dir_2 = dir+1; dir_2 < 6; dir_2++) {
-        nonCandidate = false;
-        if (hasNbrAtLabel(dir_2)) {
-          LeaderElectionSContractionParticle &nbr_2 = nbrAtLabel(dir_2);
-          if (nbr_2.state != State::Candidate) {
-            nonCandidate = true;
-          }
+    for (int dir_2 = dir+1; dir_2 < 6; dir_2++) {
+      if (isCandidate(dir_2)) {
+        continue;
+      }
+
+      bool candidateLeft = false;
+      int i = (dir + 1) % 6;
+      while (i != dir_2) {
+        if (isCandidate(i)) {
+          candidateLeft = true;
+          break;
         }
-        else {
-          nonCandidate = true;
+        i = (i + 1) % 6;
+      }
+      bool candidateRight = false;
+      i = (dir + 5) % 6;
+      while (i != dir_2) {
+        if (isCandidate(i)) {
+          candidateRight = true;
+          break;
         }
+        i = (i + 5) % 6;
+      }
 
-        if (nonCandidate) {
-          bool candidateLeft = false;
-          int i = (dir + 1) % 6;
-          while (i != dir_2) {
-            if (hasNbrAtLabel(i)) {
-              LeaderElectionSContractionParticle &p = nbrAtLabel(i);
-              if (p.state == State::Candidate) {
-                candidateLeft = true;
-                break;
-              }
-            }
-            i = (i + 1) % 6;
-          }
-          bool candidateRight = false;
-          i = (dir + 5) % 6;
-          while (i != dir_2) {
-            if (hasNbrAtLabel(i)) {
-              LeaderElectionSContractionParticle &p = nbrAtLabel(i);
-              if (p.state == State::Candidate) {
-                candidateRight = true;
-                break;
-              }
-            }
-            i = (i + 5) % 6;
-          }
-
-          if (candidateLeft && candidateRight) {
-            return false;
-          }
-        }
+      if (candidateLeft && candidateRight) {
+        return false;
       }
     }
   }
@@ -155,30 +148,22 @@ bool LeaderElectionSContractionParticle::candidatesConnected() {
 }
 
 bool LeaderElectionSContractionParticle::nonCandidateAdjacent() {
-  for (int dir = 0; dir < 6; dir++) {
-    if (hasNbrAtLabel(dir)) {
-      LeaderElectionSContractionParticle &nbr = nbrAtLabel(dir);
-      if (nbr.state != State::Candidate) {
-        return true;
-      }
-    }
-    else {
-      return true;
-    }
-  }
-  return false;
+  return candidateNbrMask() != 0x3f;
 }
 
 bool LeaderElectionSContractionParticle::hasCandidateNbr() {
+  return candidateNbrMask() != 0;
+}
+
+unsigned int LeaderElectionSContractionParticle::candidateNbrMask() const {
+  const Neighborhood nbhd = neighborhood();
+  unsigned int mask = 0;
   for (int dir = 0; dir < 6; dir++) {
-    if (hasNbrAtLabel(dir)) {
-      LeaderElectionSContractionParticle &nbr = nbrAtLabel(dir);
-      if (nbr.state == State::Candidate) {
-        return true;
-      }
+    if (nbhd.hasNbrAtLabel(dir) && nbrAtLabel(dir).state == State::Candidate) {
+      mask |= 1u << dir;
     }
   }
-  return false;
+  return mask;
 }
 
 //----------------------------END PARTICLE CODE----------------------------
@@ -186,50 +171,31 @@ bool LeaderElectionSContractionParticle::hasCandidateNbr() {
 //----------------------------BEGIN SYSTEM CODE----------------------------
 
 #include <string>
-#include <fstream>
-#include <sstream>
 #include <QTextStream>
 
 using namespace std;
 
-LeaderElectionSContractionSystem::LeaderElectionSContractionSystem(int numParticles, QString fileName) {
+LeaderElectionSContractionSystem::LeaderElectionSContractionSystem(int numParticles, QString fileName, const unsigned int seed)
+  : AmoebotSystem(seed) {
   Q_ASSERT(numParticles > 0 || fileName.size() > 0);
 
   randomPermutationScheduler = true;
 
-  string filePath = "../AmoebotSim/data/input/" + fileName.toStdString() + ".txt";
   if (fileName != "") {
     QTextStream out(stdout);
     out << "File name: " << fileName << endl;
-    ifstream file(filePath);
-    if (!file) {
-      out << "Cannot open file." << endl;
+    std::vector<ConfigurationRecord> records;
+    QString error;
+    if (!readConfiguration(inputConfigurationPath(fileName), records, error)) {
+      out << error << endl;
       return;
     }
     out << "File opened." << endl;
-    
-    string str;
-    while (getline(file, str)) {
-      std::vector<int> vect;
-      std::stringstream ss(str);
-
-      while (ss.good()) {
-        string substr;
-        getline(ss, substr, ',');
-        vect.push_back(std::stoi(substr));
-      }
-
-      int x = vect[0];
-      int y = vect[1];
-
-      insert(new LeaderElectionSContractionParticle(
-      Node(x, y), -1, randDir(), *this,
-      LeaderElectionSContractionParticle::State::Candidate));
-    }
 
-    file.close();
+    emplaceParticles<LeaderElectionSContractionParticle>(
+        records, LeaderElectionSContractionParticle::State::Candidate);
 
-    outputPath = "../AmoebotSim/data/output/" + fileName.toStdString() + ".txt";
+    inputName = fileName;
 
     out << "Particle system initialized from file." << endl;
     
@@ -237,9 +203,9 @@ LeaderElectionSContractionSystem::LeaderElectionSContractionSystem(int numPartic
   }
 
   // Insert the seed at (0,0).
-  insert(new LeaderElectionSContractionParticle(
+  emplaceParticle<LeaderElectionSContractionParticle>(
       Node(0, 0), -1, randDir(), *this,
-      LeaderElectionSContractionParticle::State::Candidate));
+      LeaderElectionSContractionParticle::State::Candidate);
   std::set<Node> occupied;
   occupied.insert(Node(0, 0));
 
@@ -269,9 +235,9 @@ LeaderElectionSContractionSystem::LeaderElectionSContractionSystem(int numPartic
         }
         if (switches <= 2) {
           occupied.insert(nbr);
-          insert(new LeaderElectionSContractionParticle(
+          emplaceParticle<LeaderElectionSContractionParticle>(
               nbr, -1, randDir(), *this,
-              LeaderElectionSContractionParticle::State::Candidate));
+              LeaderElectionSContractionParticle::State::Candidate);
           ++added;
           if (added == numParticles) {
             break;
@@ -284,31 +250,36 @@ LeaderElectionSContractionSystem::LeaderElectionSContractionSystem(int numPartic
 
 bool LeaderElectionSContractionSystem::hasTerminated() const {
 #ifdef QT_DEBUG
-  if (!isConnected(particles)) {
+  if (!isConnected(snapshot())) {
     return true;
   }
 #endif
 
-  for (auto p : particles) {
-    auto hp = dynamic_cast<LeaderElectionSContractionParticle *>(p);
-    if (hp->state == LeaderElectionSContractionParticle::State::Leader) {
-      if (outputPath != "") {
-        ofstream file;
-        file.open(outputPath);
-        file << std::to_string(hp->head.x) << "," << std::to_string(hp->head.y);
+  if (numParticlesInState(
+          static_cast<unsigned char>(LeaderElectionSContractionParticle::State::Leader)) == 0) {
+    return false;
+  }
+
+  return true;
+}
 
-        file << "\n" << std::to_string(getCount("# Rounds")._value);
-        file << "\n" << std::to_string(getCount("# Activations")._value);
-        file << "\n" << std::to_string(getCount("# Moves")._value);
+bool LeaderElectionSContractionSystem::supportsParallelRounds() const {
+  return true;
+}
 
-        file.close();
+bool LeaderElectionSContractionSystem::reportsResults() const {
+  return true;
+}
 
-        QTextStream out(stdout);
-        out << "Output written to: " << QString::fromStdString(outputPath) << endl;
-      }
-      return true;
+void LeaderElectionSContractionSystem::writeResult(ResultRow& row) const {
+  row.input = inputName;
+  for (auto p : particles) {
+    auto hp = dynamic_cast<LeaderElectionSContractionParticle*>(p);
+    if (hp->state == LeaderElectionSContractionParticle::State::Leader) {
+      row.hasLeader = true;
+      row.leaderX = hp->head.x;
+      row.leaderY = hp->head.y;
+      return;
     }
   }
-
-  return false;
-}
\ No newline at end of file
+}
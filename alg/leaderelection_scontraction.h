@@ -31,6 +31,10 @@ public:
 
   State state;
 
+  // Sets this particle's state and publishes it as its snapshot state, so
+  // that the system can count the particles in each state.
+  void setState(State state);
+
   // Constructs a new particle with a node position for its head, a global
   // compass direction from its head to its tail (-1 if contracted), an offset
   // for its local compass, and a system which it belongs to.
@@ -75,6 +79,11 @@ public:
   // Returns true iff this particle has a candidate neighbor
   bool hasCandidateNbr();
 
+  // Returns a bitmask whose bit i is set iff label i leads to a neighbor in the
+  // Candidate state. The helpers above are all computed from this mask, so
+  // each inspects the neighborhood only once.
+  unsigned int candidateNbrMask() const;
+
 protected:
   // The LeaderElectionToken struct provides a general framework of any token
   // under the General Leader Election algorithm.
@@ -89,12 +98,27 @@ class LeaderElectionSContractionSystem : public AmoebotSystem {
 public:
   // Constructs a system of LeaderElectionDeterministicParticles with an optionally
   // specified size (#particles).
-  LeaderElectionSContractionSystem(int numParticles = 100, QString fileName = "");
-
-  string outputPath = "";
+  LeaderElectionSContractionSystem(int numParticles = 100, QString fileName = "", const unsigned int seed = 0);
 
   // Checks whether or not the system's run of the Leader Election algorithm has
   // terminated (all particles in state Finished or Leader).
   bool hasTerminated() const override;
+
+  // Activations only involve a particle and its neighbors, so this system can
+  // be run in parallel rounds.
+  bool supportsParallelRounds() const override;
+
+  // Results report the elected leader, so they are kept from GUI runs too.
+  bool reportsResults() const override;
+
+ protected:
+  // Reports the input configuration the system was loaded from and the
+  // position of the elected leader.
+  void writeResult(ResultRow& row) const override;
+
+ private:
+  // The name of the input configuration the system was loaded from, or
+  // empty.
+  QString inputName;
 };
 #endif // AMOEBOTSIM_ALG_LEADERELECTION_S_CONTRACTION_H_
\ No newline at end of file
@@ -16,20 +16,121 @@
 
 #include <qDebug>
 
+#include "core/resultsink.h"
+
 using namespace std;
 
+namespace {
+
+// Visitors applying a checkpoint writer (respectively, reader) to the fields of
+// a token; see visitTokenFields.
+struct FieldWriter {
+  CheckpointWriter& out;
+  void operator()(const int& value) { out.writeInt(value); }
+  void operator()(const bool& value) { out.writeBool(value); }
+  void operator()(const string& value) { out.writeString(value); }
+};
+
+struct FieldReader {
+  CheckpointReader& in;
+  void operator()(int& value) { value = in.readInt(); }
+  void operator()(bool& value) { value = in.readBool(); }
+  void operator()(string& value) { value = in.readString(); }
+};
+
+// Besides an origin and a destination, each token type has some of the fields
+// below. Each pair of overloads visits its field if the token type has it and
+// does nothing otherwise; the int argument prefers the first overload.
+template <class Visitor, class TokenType>
+auto visitValue(Visitor& visit, TokenType& token, int)
+    -> decltype(visit(token.value)) {
+  visit(token.value);
+}
+template <class Visitor, class TokenType>
+void visitValue(Visitor&, TokenType&, long) {}
+
+template <class Visitor, class TokenType>
+auto visitCounter(Visitor& visit, TokenType& token, int)
+    -> decltype(visit(token.counter)) {
+  visit(token.counter);
+}
+template <class Visitor, class TokenType>
+void visitCounter(Visitor&, TokenType&, long) {}
+
+template <class Visitor, class TokenType>
+auto visitTtl(Visitor& visit, TokenType& token, int)
+    -> decltype(visit(token.ttl)) {
+  visit(token.ttl);
+}
+template <class Visitor, class TokenType>
+void visitTtl(Visitor&, TokenType&, long) {}
+
+template <class Visitor, class TokenType>
+auto visitTraversed(Visitor& visit, TokenType& token, int)
+    -> decltype(visit(token.traversed)) {
+  visit(token.traversed);
+}
+template <class Visitor, class TokenType>
+void visitTraversed(Visitor&, TokenType&, long) {}
+
+template <class Visitor, class TokenType>
+auto visitResult(Visitor& visit, TokenType& token, int)
+    -> decltype(visit(token.result)) {
+  visit(token.result);
+}
+template <class Visitor, class TokenType>
+void visitResult(Visitor&, TokenType&, long) {}
+
+template <class Visitor, class TokenType>
+auto visitTermination(Visitor& visit, TokenType& token, int)
+    -> decltype(visit(token.termination)) {
+  visit(token.termination);
+}
+template <class Visitor, class TokenType>
+void visitTermination(Visitor&, TokenType&, long) {}
+
+template <class Visitor, class TokenType>
+auto visitEncoding(Visitor& visit, TokenType& token, int)
+    -> decltype(visit(token.encoding)) {
+  visit(token.encoding);
+}
+template <class Visitor, class TokenType>
+void visitEncoding(Visitor&, TokenType&, long) {}
+
+// Visits all fields of the given token in a fixed order.
+template <class Visitor, class TokenType>
+void visitTokenFields(Visitor& visit, TokenType& token) {
+  visit(token.origin);
+  visit(token.destination);
+  visitValue(visit, token, 0);
+  visitCounter(visit, token, 0);
+  visitTtl(visit, token, 0);
+  visitTraversed(visit, token, 0);
+  visitResult(visit, token, 0);
+  visitTermination(visit, token, 0);
+  visitEncoding(visit, token, 0);
+}
+
+}  // namespace
+
 //----------------------------BEGIN PARTICLE CODE----------------------------
 
 LeaderElectionStationaryDeterministicParticle::LeaderElectionStationaryDeterministicParticle(
     const Node head, const int globalTailDir, const int orientation,
     AmoebotSystem &system, State state)
     : AmoebotParticle(head, globalTailDir, orientation, system), state(state) {
+  setSnapshotState(static_cast<unsigned char>(state));
   borderColorLabels.fill(-1);
   borderPointColorLabels.fill(-1);
   borderPointBetweenEdgeColorLabels.fill(-1);
   borderHalfPointBetweenEdgeColorLabels.fill(-1);
 }
 
+void LeaderElectionStationaryDeterministicParticle::setState(State state) {
+  this->state = state;
+  setSnapshotState(static_cast<unsigned char>(state));
+}
+
 void LeaderElectionStationaryDeterministicParticle::activate() {
   if (state == State::IdentificationLabeling) {
     // Determine the number of neighbors of the current particle.
@@ -41,11 +142,11 @@ void LeaderElectionStationaryDeterministicParticle::activate() {
     // generate nodes to do so.
     int numNbrs = getNumberOfNbrs();
     if (numNbrs == 0) {
-      state = State::Leader;
+      setState(State::Leader);
       return;
     }
     else if (numNbrs == 6) {
-      state = State::Demoted;
+      setState(State::Demoted);
     }
     else {
       // Initialize 6 nodes
@@ -83,18 +184,18 @@ void LeaderElectionStationaryDeterministicParticle::activate() {
         }
       }
       if (nodes.size() > 0) {
-        state = State::StretchExpansion;
+        setState(State::StretchExpansion);
         return;
       }
       else {
-        state = State::Demoted;
+        setState(State::Demoted);
         return;
       }
     }
   }
   else if (state == State::StretchExpansion) {
     if (nodes.size() == 0) {
-      state = State::Demoted;
+      setState(State::Demoted);
       return;
     }
     // Wait for all neighbors to reach stretch expansion state.
@@ -110,13 +211,13 @@ void LeaderElectionStationaryDeterministicParticle::activate() {
             if (node->predecessor == nullptr) {
               // If this particle has a node that is the head of a stretch
               // Then become a candidate
-              state = State::Candidate;
+              setState(State::Candidate);
               tree = true;
               headCount = node->count;
               return;
             }
           }
-          state = State::TreeFormation;
+          setState(State::TreeFormation);
           return;
         }
       }
@@ -245,10 +346,10 @@ void LeaderElectionStationaryDeterministicParticle::activate() {
         LeaderElectionStationaryDeterministicParticle &nbr = nbrAtLabel(dir);
         // If tree formation phase is starting, change state
         if (nbr.state == State::Candidate || (nbr.state == State::TreeFormation && nbr.tree)) {
-          state = State::TreeFormation;
+          setState(State::TreeFormation);
           tree = true;
           parent = dir;
-          nbr.putToken(std::make_shared<ParentToken>(localToGlobalDir(parent)));
+          nbr.putToken(makeToken<ParentToken>(localToGlobalDir(parent)));
           return;
         }
       }
@@ -269,21 +370,21 @@ void LeaderElectionStationaryDeterministicParticle::activate() {
       childrenExhaustedLeft = {};
       for (int childDir : children) {
         LeaderElectionStationaryDeterministicParticle &child = nbrAtLabel(childDir);
-        child.putToken(std::make_shared<CleanUpToken>(localToGlobalDir(childDir)));
+        child.putToken(makeToken<CleanUpToken>(localToGlobalDir(childDir)));
       }
       return;
     }
     // pass comparison result tokens
     while (hasToken<ComparisonResultToken>()) {
-      std::shared_ptr<ComparisonResultToken> token = takeToken<ComparisonResultToken>();
+      TokenPtr<ComparisonResultToken> token = takeToken<ComparisonResultToken>();
       int nextDir = getNextDir((globalToLocalDir(token->origin) + 3) % 6);
       LeaderElectionStationaryDeterministicParticle &nbr = nbrAtLabel(nextDir);
-      nbr.putToken(std::make_shared<ComparisonResultToken>(localToGlobalDir(nextDir), token->ttl, token->traversed, token->result));
+      nbr.putToken(makeToken<ComparisonResultToken>(localToGlobalDir(nextDir), token->ttl, token->traversed, token->result));
     }
     // receive parent tokens -> add to children
     while (hasToken<ParentToken>()) {
       // qDebug() << "Processing parent token...";
-      std::shared_ptr<ParentToken> token = takeToken<ParentToken>();
+      TokenPtr<ParentToken> token = takeToken<ParentToken>();
       int globalParentDir = token->origin;
       int localParentDir = globalToLocalDir(globalParentDir);
       int localChildDir = (localParentDir + 3) % 6;
@@ -297,12 +398,12 @@ void LeaderElectionStationaryDeterministicParticle::activate() {
       // with the head of the stretch as root
       if (hasToken<ChildToken>()) {
         // qDebug() << "Processing child token...";
-        std::shared_ptr<ChildToken> token = takeToken<ChildToken>();
+        TokenPtr<ChildToken> token = takeToken<ChildToken>();
         int globalParentDir = token->origin;
         int localParentDir = globalToLocalDir(globalParentDir);
         parent = (localParentDir + 3) % 6;
         LeaderElectionStationaryDeterministicParticle &p = nbrAtLabel(parent);
-        p.putToken(std::make_shared<ParentToken>(localToGlobalDir(parent)));
+        p.putToken(makeToken<ParentToken>(localToGlobalDir(parent)));
         tree = true;
 
         // Forward childToken to remainder of stretch if applicable
@@ -314,7 +415,7 @@ void LeaderElectionStationaryDeterministicParticle::activate() {
             LeaderElectionStationaryDeterministicParticle &nbr = nbrAtLabel(node->nextNodeDir);
             if (!nbr.tree) {
               // qDebug() << "Forwarding child token...";
-              nbr.putToken(std::make_shared<ChildToken>(localToGlobalDir(node->nextNodeDir)));
+              nbr.putToken(makeToken<ChildToken>(localToGlobalDir(node->nextNodeDir)));
             }
             break;
           }
@@ -328,7 +429,7 @@ void LeaderElectionStationaryDeterministicParticle::activate() {
             LeaderElectionStationaryDeterministicParticle &nbr = nbrAtLabel(dir);
             if (nbr.tree) {
               parent = dir;
-              nbr.putToken(std::make_shared<ParentToken>(localToGlobalDir(parent)));
+              nbr.putToken(makeToken<ParentToken>(localToGlobalDir(parent)));
               tree = true;
               break;
             }
@@ -349,7 +450,7 @@ void LeaderElectionStationaryDeterministicParticle::activate() {
         }
         parent = dir;
         LeaderElectionStationaryDeterministicParticle &nbr = nbrAtLabel(dir);
-        nbr.putToken(std::make_shared<ParentToken>(localToGlobalDir(parent)));
+        nbr.putToken(makeToken<ParentToken>(localToGlobalDir(parent)));
         tree = true;
       }
       */
@@ -383,19 +484,19 @@ void LeaderElectionStationaryDeterministicParticle::activate() {
     if (hasToken<TreeComparisonStartToken>()) {
       // qDebug() << "Processing tree comparison start token...";
       takeToken<TreeComparisonStartToken>();
-      state = State::TreeComparison;
+      setState(State::TreeComparison);
       for(int childDir : children) {
         LeaderElectionStationaryDeterministicParticle &child = nbrAtLabel(childDir);
-        child.putToken(std::make_shared<TreeComparisonStartToken>(localToGlobalDir(childDir)));
+        child.putToken(makeToken<TreeComparisonStartToken>(localToGlobalDir(childDir)));
       }
     }
     else if (parent >= 0 && treeDone) {
       if ((nbrAtLabel(parent).treeFormationDone || nbrAtLabel(parent).state == State::TreeComparison)) {
         // qDebug() << "Changing state to TreeComparison...";
-        state = State::TreeComparison;
+        setState(State::TreeComparison);
         for(int childDir : children) {
           LeaderElectionStationaryDeterministicParticle &child = nbrAtLabel(childDir);
-          child.putToken(std::make_shared<TreeComparisonStartToken>(localToGlobalDir(childDir)));
+          child.putToken(makeToken<TreeComparisonStartToken>(localToGlobalDir(childDir)));
         }
         return;
       }
@@ -405,10 +506,10 @@ void LeaderElectionStationaryDeterministicParticle::activate() {
             LeaderElectionStationaryDeterministicParticle &nbr = nbrAtLabel(dir);
             if (nbr.state == State::TreeComparison || nbr.treeFormationDone) {
               // qDebug() << "Changing state to TreeComparison...";
-              state = State::TreeComparison;
+              setState(State::TreeComparison);
               for(int childDir : children) {
                 LeaderElectionStationaryDeterministicParticle &child = nbrAtLabel(childDir);
-                child.putToken(std::make_shared<TreeComparisonStartToken>(localToGlobalDir(childDir)));
+                child.putToken(makeToken<TreeComparisonStartToken>(localToGlobalDir(childDir)));
               }
               return;
             }
@@ -419,10 +520,10 @@ void LeaderElectionStationaryDeterministicParticle::activate() {
     // receive and pass TreeFormationFinishedTokens
     while (hasToken<TreeFormationFinishedToken>()) {
       // qDebug() << "Processing tree formation finished token...";
-      std::shared_ptr<TreeFormationFinishedToken> token = takeToken<TreeFormationFinishedToken>();
+      TokenPtr<TreeFormationFinishedToken> token = takeToken<TreeFormationFinishedToken>();
       int nextDir = getNextDir((globalToLocalDir(token->origin) + 3) % 6);
       LeaderElectionStationaryDeterministicParticle &nbr = nbrAtLabel(nextDir);
-      nbr.putToken(std::make_shared<TreeFormationFinishedToken>(localToGlobalDir(nextDir), token->ttl, token->traversed));
+      nbr.putToken(makeToken<TreeFormationFinishedToken>(localToGlobalDir(nextDir), token->ttl, token->traversed));
     }
   }
   else if (state == State::Candidate) {
@@ -434,7 +535,7 @@ void LeaderElectionStationaryDeterministicParticle::activate() {
     // receive parent tokens -> add to children
     while (hasToken<ParentToken>()) {
       // qDebug() << "Processing parent token...";
-      std::shared_ptr<ParentToken> token = takeToken<ParentToken>();
+      TokenPtr<ParentToken> token = takeToken<ParentToken>();
       int globalParentDir = token->origin;
       int localParentDir = globalToLocalDir(globalParentDir);
       int localChildDir = (localParentDir + 3) % 6;
@@ -453,7 +554,7 @@ void LeaderElectionStationaryDeterministicParticle::activate() {
           LeaderElectionStationaryDeterministicParticle &nbr = nbrAtLabel(node->nextNodeDir);
           nextDirCandidate = node->nextNodeDir;
           if (!nbr.tree) {
-            nbr.putToken(std::make_shared<ChildToken>(localToGlobalDir(node->nextNodeDir)));
+            nbr.putToken(makeToken<ChildToken>(localToGlobalDir(node->nextNodeDir)));
           }
           break;
         }
@@ -465,7 +566,7 @@ void LeaderElectionStationaryDeterministicParticle::activate() {
       if (comparisonDone && !comparisonSent) {
         // qDebug() << "Sending comparison result...";
         LeaderElectionStationaryDeterministicParticle &nbr = nbrAtLabel(nextDirCandidate);
-        nbr.putToken(std::make_shared<ComparisonResultToken>(localToGlobalDir(nextDirCandidate), numCandidates, 1, comparisonResult));
+        nbr.putToken(makeToken<ComparisonResultToken>(localToGlobalDir(nextDirCandidate), numCandidates, 1, comparisonResult));
         comparisonSent = true;
         std::vector<int> newVector(numCandidates, comparisonResult);
         comparisonResults = newVector;
@@ -475,14 +576,14 @@ void LeaderElectionStationaryDeterministicParticle::activate() {
       if (comparisonDone && comparisonsReceived < numCandidates) {
         while (hasToken<ComparisonResultToken>()) {
           // qDebug() << "Processing comparison result token...";
-          std::shared_ptr<ComparisonResultToken> token = takeToken<ComparisonResultToken>();
+          TokenPtr<ComparisonResultToken> token = takeToken<ComparisonResultToken>();
           int index = 1 + (token->ttl - (token->traversed + 1));
           comparisonResults[index] = token->result;
           comparisonsReceived += 1;
           // pass the token on if necessary
           if (token->traversed + 1 < token->ttl) {
             LeaderElectionStationaryDeterministicParticle &nbr = nbrAtLabel(nextDirCandidate);
-            nbr.putToken(std::make_shared<ComparisonResultToken>(localToGlobalDir(nextDirCandidate), token->ttl, token->traversed+1, token->result));
+            nbr.putToken(makeToken<ComparisonResultToken>(localToGlobalDir(nextDirCandidate), token->ttl, token->traversed+1, token->result));
           }
         }
       }
@@ -500,24 +601,24 @@ void LeaderElectionStationaryDeterministicParticle::activate() {
           }
           // If all candidates are equal, there is unbreakable symmetry
           if (seq.size() == numCandidates + 1) {
-            state = State::Finished;
+            setState(State::Finished);
             return;
           }
           int candidate = seq[0]; // candidate to be eliminated
           // If this candidate is eliminated, revoke candidacy, join tree
           // of candidate to the left
           if (candidate == 0) {
-            state = State::TreeFormation;
+            setState(State::TreeFormation);
             tree = true;
             parent = (nextDirCandidate + 1) % 6;
             while (!hasNbrAtLabel(parent)) {
               parent = (parent + 1) % 6;
             }
             LeaderElectionStationaryDeterministicParticle &nbr = nbrAtLabel(parent);
-            nbr.putToken(std::make_shared<ParentToken>(localToGlobalDir(parent)));
+            nbr.putToken(makeToken<ParentToken>(localToGlobalDir(parent)));
             for (int childDir : children) {
               LeaderElectionStationaryDeterministicParticle &child = nbrAtLabel(childDir);
-              child.putToken(std::make_shared<CleanUpToken>(localToGlobalDir(childDir)));
+              child.putToken(makeToken<CleanUpToken>(localToGlobalDir(childDir)));
             }
             treeDone = false;
             treeFormationDone = false;
@@ -537,7 +638,7 @@ void LeaderElectionStationaryDeterministicParticle::activate() {
             numCandidates -= 1;
             // If this candidate is now the last remaining candidate, become the leader
             if (numCandidates == 1) {
-              state = State::Leader;
+              setState(State::Leader);
               return;
             }
           }
@@ -565,18 +666,18 @@ void LeaderElectionStationaryDeterministicParticle::activate() {
         nbrTreeExhausted = false;
         for (int childDir : children) {
           LeaderElectionStationaryDeterministicParticle &child = nbrAtLabel(childDir);
-          child.putToken(std::make_shared<CleanUpToken>(localToGlobalDir(childDir)));
+          child.putToken(makeToken<CleanUpToken>(localToGlobalDir(childDir)));
         }
         return;
       }
       // receive encoding request tokens from other candidates
       while (hasToken<RequestCandidateEncodingToken>()) {
         // qDebug() << "Processing candidate encoding request token...";
-        std::shared_ptr<RequestCandidateEncodingToken> token = takeToken<RequestCandidateEncodingToken>();
+        TokenPtr<RequestCandidateEncodingToken> token = takeToken<RequestCandidateEncodingToken>();
         // If token is intended for other candidate, pass it on
         if (token->traversed + 1 != token->ttl) {
           LeaderElectionStationaryDeterministicParticle &nbr = nbrAtLabel(nextDirCandidate);
-          nbr.putToken(std::make_shared<RequestCandidateEncodingToken>(localToGlobalDir(nextDirCandidate), token->ttl, token->traversed+1));
+          nbr.putToken(makeToken<RequestCandidateEncodingToken>(localToGlobalDir(nextDirCandidate), token->ttl, token->traversed+1));
         }
         else {
           nbrEncodingRequestReceived = true;
@@ -586,11 +687,11 @@ void LeaderElectionStationaryDeterministicParticle::activate() {
       // receive tree exhausted tokens from other candidates
       while (hasToken<CandidateTreeExhaustedToken>()) {
         // qDebug() << "Processing candidate tree exhausted token...";
-        std::shared_ptr<CandidateTreeExhaustedToken> token = takeToken<CandidateTreeExhaustedToken>();
+        TokenPtr<CandidateTreeExhaustedToken> token = takeToken<CandidateTreeExhaustedToken>();
         // if token is intended for other candidate, pass it on
         if (token->traversed + 1 != token->ttl) {
           LeaderElectionStationaryDeterministicParticle &nbr = nbrAtLabel(nextDirCandidate);
-          nbr.putToken(std::make_shared<CandidateTreeExhaustedToken>(localToGlobalDir(nextDirCandidate), token->ttl, token->traversed+1));
+          nbr.putToken(makeToken<CandidateTreeExhaustedToken>(localToGlobalDir(nextDirCandidate), token->ttl, token->traversed+1));
         }
         // If token is intended for this candidate, store it
         else {
@@ -602,11 +703,11 @@ void LeaderElectionStationaryDeterministicParticle::activate() {
       // Receive neighbourhood encodings from other candidates
       while (hasToken<CandidateEncodingToken>()) {
         // qDebug() << "Processing candidate encoding token...";
-        std::shared_ptr<CandidateEncodingToken> token = takeToken<CandidateEncodingToken>();
+        TokenPtr<CandidateEncodingToken> token = takeToken<CandidateEncodingToken>();
         // if token is intended for other candidate, pass it on
         if (token->traversed + 1 != token->ttl) {
           LeaderElectionStationaryDeterministicParticle &nbr = nbrAtLabel(nextDirCandidate);
-          nbr.putToken(std::make_shared<CandidateEncodingToken>(localToGlobalDir(nextDirCandidate), token->ttl, token->traversed+1, token->encoding));
+          nbr.putToken(makeToken<CandidateEncodingToken>(localToGlobalDir(nextDirCandidate), token->ttl, token->traversed+1, token->encoding));
         }
         // If token is intended for this candidate, store it
         else {
@@ -620,7 +721,7 @@ void LeaderElectionStationaryDeterministicParticle::activate() {
       if (!nbrEncodingRequested && !nbrEncodingReceived && !comparisonDone) {
         // qDebug() << "Requesting encoding from right stretch...";
         LeaderElectionStationaryDeterministicParticle &nbr = nbrAtLabel(nextDirCandidate);
-        nbr.putToken(std::make_shared<RequestCandidateEncodingToken>(localToGlobalDir(nextDirCandidate), 2, 1));
+        nbr.putToken(makeToken<RequestCandidateEncodingToken>(localToGlobalDir(nextDirCandidate), 2, 1));
         nbrEncodingRequested = true;
       }
       // request encodings from tree for comparison with right stretch
@@ -651,7 +752,7 @@ void LeaderElectionStationaryDeterministicParticle::activate() {
           }
           else {
             LeaderElectionStationaryDeterministicParticle &child = nbrAtLabel(childDir);
-            child.putToken(std::make_shared<RequestEncodingRightToken>(localToGlobalDir(childDir)));
+            child.putToken(makeToken<RequestEncodingRightToken>(localToGlobalDir(childDir)));
             encodingRequestedRight = true;
           }
         }
@@ -666,7 +767,7 @@ void LeaderElectionStationaryDeterministicParticle::activate() {
       if (encodingRequestedRight && !encodingReceivedRight) {
         if (hasToken<EncodingRightToken>()) {
           // qDebug() << "Processing right encoding token...";
-          std::shared_ptr<EncodingRightToken> token = takeToken<EncodingRightToken>();
+          TokenPtr<EncodingRightToken> token = takeToken<EncodingRightToken>();
           currentEncodingRight = token->encoding;
           encodingRequestedRight = false;
           encodingReceivedRight = true;
@@ -674,7 +775,7 @@ void LeaderElectionStationaryDeterministicParticle::activate() {
         // receive subtree exhausted tokens
         else if (hasToken<SubTreeExhaustedRightToken>()) {
           // qDebug() << "Processing right subtree exhausted token...";
-          std::shared_ptr<SubTreeExhaustedRightToken> token = takeToken<SubTreeExhaustedRightToken>();
+          TokenPtr<SubTreeExhaustedRightToken> token = takeToken<SubTreeExhaustedRightToken>();
           int dir = (globalToLocalDir(token->origin) + 3) % 6;
           childrenExhaustedRight.insert(dir);
           encodingRequestedRight = false;
@@ -752,7 +853,7 @@ void LeaderElectionStationaryDeterministicParticle::activate() {
           }
           else {
             LeaderElectionStationaryDeterministicParticle &child = nbrAtLabel(childDir);
-            child.putToken(std::make_shared<RequestEncodingLeftToken>(localToGlobalDir(childDir)));
+            child.putToken(makeToken<RequestEncodingLeftToken>(localToGlobalDir(childDir)));
             encodingRequestedLeft = true;
           }
         }
@@ -767,7 +868,7 @@ void LeaderElectionStationaryDeterministicParticle::activate() {
       if (nbrEncodingRequestReceived && encodingRequestedLeft && !encodingReceivedLeft) {
         if (hasToken<EncodingLeftToken>()) {
           // qDebug() << "Processing left encoding token...";
-          std::shared_ptr<EncodingLeftToken> token = takeToken<EncodingLeftToken>();
+          TokenPtr<EncodingLeftToken> token = takeToken<EncodingLeftToken>();
           currentEncodingLeft = token->encoding;
           encodingRequestedLeft = false;
           encodingReceivedLeft = true;
@@ -775,7 +876,7 @@ void LeaderElectionStationaryDeterministicParticle::activate() {
         // receive subtree exhausted tokens
         else if (hasToken<SubTreeExhaustedLeftToken>()) {
           // qDebug() << "Processing left subtree exhausted token...";
-          std::shared_ptr<SubTreeExhaustedLeftToken> token = takeToken<SubTreeExhaustedLeftToken>();
+          TokenPtr<SubTreeExhaustedLeftToken> token = takeToken<SubTreeExhaustedLeftToken>();
           int dir = (globalToLocalDir(token->origin) + 3) % 6;
           childrenExhaustedLeft.insert(dir);
           encodingRequestedLeft = false;
@@ -786,13 +887,13 @@ void LeaderElectionStationaryDeterministicParticle::activate() {
         // qDebug() << "Sending encoding to left stretch...";
         if (!treeExhaustedLeft) {
           LeaderElectionStationaryDeterministicParticle &nbr = nbrAtLabel(nextDirCandidate);
-          nbr.putToken(std::make_shared<CandidateEncodingToken>(localToGlobalDir(nextDirCandidate), numCandidates, 1, currentEncodingLeft));
+          nbr.putToken(makeToken<CandidateEncodingToken>(localToGlobalDir(nextDirCandidate), numCandidates, 1, currentEncodingLeft));
           nbrEncodingRequestReceived = false;
           encodingReceivedLeft = false;
         }
         else {
           LeaderElectionStationaryDeterministicParticle &nbr = nbrAtLabel(nextDirCandidate);
-          nbr.putToken(std::make_shared<CandidateTreeExhaustedToken>(localToGlobalDir(nextDirCandidate), numCandidates, 1));
+          nbr.putToken(makeToken<CandidateTreeExhaustedToken>(localToGlobalDir(nextDirCandidate), numCandidates, 1));
           nbrEncodingRequestReceived = false;
           encodingReceivedLeft = false;
         }
@@ -825,13 +926,13 @@ void LeaderElectionStationaryDeterministicParticle::activate() {
       // qDebug() << "Sending TreeComparisonStartTokens...";
       // send tokens to other candidates to communicate that tree formation is finished
       LeaderElectionStationaryDeterministicParticle &nbr = nbrAtLabel(nextDirCandidate);
-      nbr.putToken(std::make_shared<TreeFormationFinishedToken>(localToGlobalDir(nextDirCandidate), numCandidates, 1));
+      nbr.putToken(makeToken<TreeFormationFinishedToken>(localToGlobalDir(nextDirCandidate), numCandidates, 1));
       treeFormationFinishedTokensReceived = 1;
       // Send tokens to children to indicate that tree formation is done and comparison will start soon
       for (int childDir : children) {
         LeaderElectionStationaryDeterministicParticle &child = nbrAtLabel(childDir);
         if (child.state != State::TreeComparison) {
-          child.putToken(std::make_shared<TreeComparisonStartToken>(localToGlobalDir(childDir)));
+          child.putToken(makeToken<TreeComparisonStartToken>(localToGlobalDir(childDir)));
         }
       }
       treeFormationDone = true;
@@ -840,12 +941,12 @@ void LeaderElectionStationaryDeterministicParticle::activate() {
     // receive TreeFormationFinishedTokens and pass them on if applicable
     while (hasToken<TreeFormationFinishedToken>() && treeFormationDone && !treeComparisonReady) {
       // qDebug() << "Processing TreeFormationFinishedToken...";
-      std::shared_ptr<TreeFormationFinishedToken> token = takeToken<TreeFormationFinishedToken>();
+      TokenPtr<TreeFormationFinishedToken> token = takeToken<TreeFormationFinishedToken>();
       treeFormationFinishedTokensReceived += 1;
       // pass token if necessary
       if (token->traversed + 1 < token->ttl) {
         LeaderElectionStationaryDeterministicParticle &nbr = nbrAtLabel(nextDirCandidate);
-        nbr.putToken(std::make_shared<TreeFormationFinishedToken>(localToGlobalDir(nextDirCandidate), token->ttl, token->traversed+1));
+        nbr.putToken(makeToken<TreeFormationFinishedToken>(localToGlobalDir(nextDirCandidate), token->ttl, token->traversed+1));
       }
     }
     if (treeFormationFinishedTokensReceived >= numCandidates) {
@@ -857,13 +958,13 @@ void LeaderElectionStationaryDeterministicParticle::activate() {
   else if (state == State::TreeComparison) {
     // qDebug() << "TreeComparison particle running...";
     if (!treeDone) {
-      state = State::TreeFormation;
+      setState(State::TreeFormation);
     }
     // process and pass cleanup tokens
     if (hasToken<CleanUpToken>()) {
       takeToken<CleanUpToken>();
       treeDone = false;
-      state = State::TreeFormation;
+      setState(State::TreeFormation);
       nbrhdEncodingSentRight = false;
       nbrhdEncodingSentLeft = false;
       treeExhaustedRight = false;
@@ -872,48 +973,48 @@ void LeaderElectionStationaryDeterministicParticle::activate() {
       childrenExhaustedLeft = {};
       for (int childDir : children) {
         LeaderElectionStationaryDeterministicParticle &child = nbrAtLabel(childDir);
-        child.putToken(std::make_shared<CleanUpToken>(localToGlobalDir(childDir)));
+        child.putToken(makeToken<CleanUpToken>(localToGlobalDir(childDir)));
       }
       return;
     }
     // pass tree formation finished tokens
     while (hasToken<TreeFormationFinishedToken>()) {
-      std::shared_ptr<TreeFormationFinishedToken> token = takeToken<TreeFormationFinishedToken>();
+      TokenPtr<TreeFormationFinishedToken> token = takeToken<TreeFormationFinishedToken>();
       int nextDir = getNextDir((globalToLocalDir(token->origin) + 3) % 6);
       LeaderElectionStationaryDeterministicParticle &nbr = nbrAtLabel(nextDir);
-      nbr.putToken(std::make_shared<TreeFormationFinishedToken>(localToGlobalDir(nextDir), token->ttl, token->traversed));
+      nbr.putToken(makeToken<TreeFormationFinishedToken>(localToGlobalDir(nextDir), token->ttl, token->traversed));
     }
     // pass comparison result tokens
     while (hasToken<ComparisonResultToken>()) {
-      std::shared_ptr<ComparisonResultToken> token = takeToken<ComparisonResultToken>();
+      TokenPtr<ComparisonResultToken> token = takeToken<ComparisonResultToken>();
       int nextDir = getNextDir((globalToLocalDir(token->origin) + 3) % 6);
       LeaderElectionStationaryDeterministicParticle &nbr = nbrAtLabel(nextDir);
-      nbr.putToken(std::make_shared<ComparisonResultToken>(localToGlobalDir(nextDir), token->ttl, token->traversed, token->result));
+      nbr.putToken(makeToken<ComparisonResultToken>(localToGlobalDir(nextDir), token->ttl, token->traversed, token->result));
     }
     // pass candidate encoding requests
     while (hasToken<RequestCandidateEncodingToken>()) {
-      std::shared_ptr<RequestCandidateEncodingToken> token = takeToken<RequestCandidateEncodingToken>();
+      TokenPtr<RequestCandidateEncodingToken> token = takeToken<RequestCandidateEncodingToken>();
       int nextDir = getNextDir((globalToLocalDir(token->origin) + 3) % 6);
       LeaderElectionStationaryDeterministicParticle &nbr = nbrAtLabel(nextDir);
-      nbr.putToken(std::make_shared<RequestCandidateEncodingToken>(localToGlobalDir(nextDir), token->ttl, token->traversed));
+      nbr.putToken(makeToken<RequestCandidateEncodingToken>(localToGlobalDir(nextDir), token->ttl, token->traversed));
     }
     // pass candidate tree exhausted tokens
     while (hasToken<CandidateTreeExhaustedToken>()) {
-      std::shared_ptr<CandidateTreeExhaustedToken> token = takeToken<CandidateTreeExhaustedToken>();
+      TokenPtr<CandidateTreeExhaustedToken> token = takeToken<CandidateTreeExhaustedToken>();
       int nextDir = getNextDir((globalToLocalDir(token->origin) + 3) % 6);
       LeaderElectionStationaryDeterministicParticle &nbr = nbrAtLabel(nextDir);
-      nbr.putToken(std::make_shared<CandidateTreeExhaustedToken>(localToGlobalDir(nextDir), token->ttl, token->traversed));
+      nbr.putToken(makeToken<CandidateTreeExhaustedToken>(localToGlobalDir(nextDir), token->ttl, token->traversed));
     }
     // pass candidate encoding tokens
     while (hasToken<CandidateEncodingToken>()) {
-      std::shared_ptr<CandidateEncodingToken> token = takeToken<CandidateEncodingToken>();
+      TokenPtr<CandidateEncodingToken> token = takeToken<CandidateEncodingToken>();
       int nextDir = getNextDir((globalToLocalDir(token->origin) + 3) % 6);
       LeaderElectionStationaryDeterministicParticle &nbr = nbrAtLabel(nextDir);
-      nbr.putToken(std::make_shared<CandidateEncodingToken>(localToGlobalDir(nextDir), token->ttl, token->traversed, token->encoding));
+      nbr.putToken(makeToken<CandidateEncodingToken>(localToGlobalDir(nextDir), token->ttl, token->traversed, token->encoding));
     }
     // process and/or pass right encoding requests
     if (hasToken<RequestEncodingRightToken>()) {
-      std::shared_ptr<RequestEncodingRightToken> token = takeToken<RequestEncodingRightToken>();
+      TokenPtr<RequestEncodingRightToken> token = takeToken<RequestEncodingRightToken>();
       // first step: use own neighbourhood encoding
       if (!nbrhdEncodingSentRight) {
         currentEncodingRight = getNeighborhoodEncoding();
@@ -939,7 +1040,7 @@ void LeaderElectionStationaryDeterministicParticle::activate() {
         }
         else {
           LeaderElectionStationaryDeterministicParticle &child = nbrAtLabel(childDir);
-          child.putToken(std::make_shared<RequestEncodingRightToken>(localToGlobalDir(childDir)));
+          child.putToken(makeToken<RequestEncodingRightToken>(localToGlobalDir(childDir)));
           encodingRequestedRight = true;
         }
       }
@@ -952,14 +1053,14 @@ void LeaderElectionStationaryDeterministicParticle::activate() {
     // receive encodings from tree for comparison with right stretch
     if (encodingRequestedRight && !encodingReceivedRight) {
       if (hasToken<EncodingRightToken>()) {
-        std::shared_ptr<EncodingRightToken> token = takeToken<EncodingRightToken>();
+        TokenPtr<EncodingRightToken> token = takeToken<EncodingRightToken>();
         currentEncodingRight = token->encoding;
         encodingRequestedRight = false;
         encodingReceivedRight = true;
       }
       // receive subtree exhausted tokens
       else if (hasToken<SubTreeExhaustedRightToken>()) {
-        std::shared_ptr<SubTreeExhaustedRightToken> token = takeToken<SubTreeExhaustedRightToken>();
+        TokenPtr<SubTreeExhaustedRightToken> token = takeToken<SubTreeExhaustedRightToken>();
         int dir = (globalToLocalDir(token->origin) + 3) % 6;
         childrenExhaustedRight.insert(dir);
         encodingRequestedRight = false;
@@ -970,17 +1071,17 @@ void LeaderElectionStationaryDeterministicParticle::activate() {
       // if tree exhausted, send subtree exhausted token
       if (treeExhaustedRight) {
         LeaderElectionStationaryDeterministicParticle &p = nbrAtLabel(parent);
-        p.putToken(std::make_shared<SubTreeExhaustedRightToken>(localToGlobalDir(parent)));
+        p.putToken(makeToken<SubTreeExhaustedRightToken>(localToGlobalDir(parent)));
       }
       else {
         LeaderElectionStationaryDeterministicParticle &p = nbrAtLabel(parent);
-        p.putToken(std::make_shared<EncodingRightToken>(localToGlobalDir(parent), currentEncodingRight));
+        p.putToken(makeToken<EncodingRightToken>(localToGlobalDir(parent), currentEncodingRight));
       }
       encodingReceivedRight = false;
     }
     // process and/or pass left encoding requests
     if (hasToken<RequestEncodingLeftToken>()) {
-      std::shared_ptr<RequestEncodingLeftToken> token = takeToken<RequestEncodingLeftToken>();
+      TokenPtr<RequestEncodingLeftToken> token = takeToken<RequestEncodingLeftToken>();
       // first step: use own neighbourhood encoding
       if (!nbrhdEncodingSentLeft) {
         currentEncodingLeft = getNeighborhoodEncoding();
@@ -1006,7 +1107,7 @@ void LeaderElectionStationaryDeterministicParticle::activate() {
         }
         else {
           LeaderElectionStationaryDeterministicParticle &child = nbrAtLabel(childDir);
-          child.putToken(std::make_shared<RequestEncodingLeftToken>(localToGlobalDir(childDir)));
+          child.putToken(makeToken<RequestEncodingLeftToken>(localToGlobalDir(childDir)));
           encodingRequestedLeft = true;
         }
       }
@@ -1019,14 +1120,14 @@ void LeaderElectionStationaryDeterministicParticle::activate() {
     // receive encodings from tree for comparison with left stretch
     if (encodingRequestedLeft && !encodingReceivedLeft) {
       if (hasToken<EncodingLeftToken>()) {
-        std::shared_ptr<EncodingLeftToken> token = takeToken<EncodingLeftToken>();
+        TokenPtr<EncodingLeftToken> token = takeToken<EncodingLeftToken>();
         currentEncodingLeft = token->encoding;
         encodingRequestedLeft = false;
         encodingReceivedLeft = true;
       }
       // receive subtree exhausted tokens
       else if (hasToken<SubTreeExhaustedLeftToken>()) {
-        std::shared_ptr<SubTreeExhaustedLeftToken> token = takeToken<SubTreeExhaustedLeftToken>();
+        TokenPtr<SubTreeExhaustedLeftToken> token = takeToken<SubTreeExhaustedLeftToken>();
         int dir = (globalToLocalDir(token->origin) + 3) % 6;
         childrenExhaustedLeft.insert(dir);
         encodingRequestedLeft = false;
@@ -1037,11 +1138,11 @@ void LeaderElectionStationaryDeterministicParticle::activate() {
       // if tree exhausted, send subtree exhausted token
       if (treeExhaustedLeft) {
         LeaderElectionStationaryDeterministicParticle &p = nbrAtLabel(parent);
-        p.putToken(std::make_shared<SubTreeExhaustedLeftToken>(localToGlobalDir(parent)));
+        p.putToken(makeToken<SubTreeExhaustedLeftToken>(localToGlobalDir(parent)));
       }
       else {
         LeaderElectionStationaryDeterministicParticle &p = nbrAtLabel(parent);
-        p.putToken(std::make_shared<EncodingLeftToken>(localToGlobalDir(parent), currentEncodingLeft));
+        p.putToken(makeToken<EncodingLeftToken>(localToGlobalDir(parent), currentEncodingLeft));
       }
       encodingReceivedLeft = false;
     }
@@ -1220,13 +1321,10 @@ std::array<int, 12> LeaderElectionStationaryDeterministicParticle::borderHalfPoi
 }
 
 int LeaderElectionStationaryDeterministicParticle::getNumberOfNbrs() const {
-  int count = 0;
-  for (int dir = 0; dir < 6; dir++) {
-    if (hasNbrAtLabel(dir)) {
-      count++;
-    }
-  }
-  return count;
+  // Only labels 0-5 are counted, also when this particle is expanded.
+  Neighborhood nbhd = neighborhood();
+  nbhd.particles &= 0x3f;
+  return nbhd.numNbrs();
 }
 
 string LeaderElectionStationaryDeterministicParticle::getNeighborhoodEncoding() {
@@ -1288,6 +1386,309 @@ set<std::vector<int>> LeaderElectionStationaryDeterministicParticle::getMaxNonDe
   return results;
 }
 
+void LeaderElectionStationaryDeterministicParticle::writeState(
+    CheckpointWriter& out) const {
+  const auto writeSet = [&out](const set<int>& values) {
+    out.writeArray(std::vector<int>(values.begin(), values.end()),
+                   &CheckpointWriter::writeInt);
+  };
+
+  out.writeInt(static_cast<int>(state));
+  out.writeInt(nextDirCandidate);
+  out.writeInt(numCandidates);
+  out.writeInt(headCount);
+  out.writeBool(tree);
+  out.writeBool(treeDone);
+  out.writeInt(parent);
+  writeSet(children);
+  out.writeBool(childTokensSent);
+  out.writeBool(treeFormationDone);
+  out.writeInt(treeFormationFinishedTokensReceived);
+  out.writeBool(treeComparisonReady);
+  out.writeBool(nbrhdEncodingSentRight);
+  out.writeBool(nbrhdEncodingSentLeft);
+  out.writeString(currentEncodingRight);
+  out.writeString(currentEncodingLeft);
+  out.writeString(currentEncodingNbr);
+  out.writeBool(nbrEncodingRequestReceived);
+  out.writeBool(encodingRequestedRight);
+  out.writeBool(encodingRequestedLeft);
+  out.writeBool(nbrEncodingRequested);
+  out.writeBool(encodingReceivedRight);
+  out.writeBool(encodingReceivedLeft);
+  out.writeBool(nbrEncodingReceived);
+  out.writeBool(treeExhaustedRight);
+  out.writeBool(treeExhaustedLeft);
+  out.writeBool(nbrTreeExhausted);
+  writeSet(childrenExhaustedRight);
+  writeSet(childrenExhaustedLeft);
+  out.writeInt(comparisonsReceived);
+  out.writeBool(comparisonDone);
+  out.writeInt(comparisonResult);
+  out.writeBool(comparisonSent);
+  out.writeArray(comparisonResults, &CheckpointWriter::writeInt);
+
+  out.writeUInt(nodes.size());
+  for (const LeaderElectionNode* node : nodes) {
+    out.writeInt(node->nodeDir);
+    out.writeInt(node->nextNodeDir);
+    out.writeInt(node->prevNodeDir);
+    out.writeBool(node->nextNodeClone);
+    out.writeBool(node->prevNodeClone);
+    out.writeBool(node->cloneChange);
+    out.writeInt(static_cast<int>(node->nodeState));
+    out.writeInt(static_cast<int>(node->subPhase));
+    out.writeInt(node->unaryLabel);
+    out.writeInt(node->count);
+    out.writeBool(node->mergePending);
+    out.writeBool(node->mergeAck);
+    out.writeInt(node->mergeDir);
+    out.writeBool(node->countSent);
+    out.writeBool(node->lexCompInit);
+    out.writeBool(node->lexCompTryMerge);
+    out.writeBool(node->lexicographicComparisonLeft);
+    out.writeBool(node->lexicographicComparisonRight);
+    out.writeBool(node->requestedNbrLabel);
+    out.writeBool(node->receivedNbrLabel);
+    out.writeInt(node->NbrLabel);
+    out.writeBool(node->requestedLabel);
+    out.writeBool(node->receivedLabel);
+    out.writeBool(node->receivedLabelRequestFromNbr);
+    out.writeBool(node->requestedLabelForNbr);
+    out.writeBool(node->receivedLabelForNbr);
+    out.writeInt(node->internalLabel);
+    out.writeInt(node->internalLabelForNbr);
+    out.writeInt(node->firstLargerLabel);
+    out.writeBool(node->retrieved);
+    out.writeBool(node->retrievedForNbr);
+    out.writeBool(node->terminationDetectionInitiated);
+  }
+
+  for (const int color : borderColorLabels) {
+    out.writeInt(color);
+  }
+  for (const int color : borderPointColorLabels) {
+    out.writeInt(color);
+  }
+  for (const int color : borderPointBetweenEdgeColorLabels) {
+    out.writeInt(color);
+  }
+  for (const int color : borderHalfPointBetweenEdgeColorLabels) {
+    out.writeInt(color);
+  }
+}
+
+void LeaderElectionStationaryDeterministicParticle::readState(
+    CheckpointReader& in) {
+  const auto readSet = [&in]() {
+    const std::vector<int> values =
+        in.readArray<int>(&CheckpointReader::readInt, 6);
+    return set<int>(values.begin(), values.end());
+  };
+  const auto readState = [&in]() {
+    const int value = in.readInt();
+    if (value < static_cast<int>(State::IdentificationLabeling) ||
+        value > static_cast<int>(State::Finished)) {
+      in.fail();
+    }
+    return static_cast<State>(value);
+  };
+
+  // The snapshot state is restored by the system, so the state is set
+  // directly instead of through setState.
+  state = readState();
+  nextDirCandidate = in.readInt();
+  numCandidates = in.readInt();
+  headCount = in.readInt();
+  tree = in.readBool();
+  treeDone = in.readBool();
+  parent = in.readInt();
+  children = readSet();
+  childTokensSent = in.readBool();
+  treeFormationDone = in.readBool();
+  treeFormationFinishedTokensReceived = in.readInt();
+  treeComparisonReady = in.readBool();
+  nbrhdEncodingSentRight = in.readBool();
+  nbrhdEncodingSentLeft = in.readBool();
+  currentEncodingRight = in.readString();
+  currentEncodingLeft = in.readString();
+  currentEncodingNbr = in.readString();
+  nbrEncodingRequestReceived = in.readBool();
+  encodingRequestedRight = in.readBool();
+  encodingRequestedLeft = in.readBool();
+  nbrEncodingRequested = in.readBool();
+  encodingReceivedRight = in.readBool();
+  encodingReceivedLeft = in.readBool();
+  nbrEncodingReceived = in.readBool();
+  treeExhaustedRight = in.readBool();
+  treeExhaustedLeft = in.readBool();
+  nbrTreeExhausted = in.readBool();
+  childrenExhaustedRight = readSet();
+  childrenExhaustedLeft = readSet();
+  comparisonsReceived = in.readInt();
+  comparisonDone = in.readBool();
+  comparisonResult = in.readInt();
+  comparisonSent = in.readBool();
+  comparisonResults = in.readArray<int>(&CheckpointReader::readInt);
+
+  for (LeaderElectionNode* node : nodes) {
+    delete node;
+  }
+  nodes.clear();
+  const uint32_t numNodes = in.readUInt();
+  if (numNodes > 6) {
+    in.fail();
+  }
+  for (uint32_t i = 0; i < numNodes && !in.failed(); ++i) {
+    LeaderElectionNode* node = new LeaderElectionNode();
+    node->particle = this;
+    node->nodeDir = in.readInt();
+    node->nextNodeDir = in.readInt();
+    node->prevNodeDir = in.readInt();
+    node->nextNodeClone = in.readBool();
+    node->prevNodeClone = in.readBool();
+    node->cloneChange = in.readBool();
+    node->nodeState = readState();
+    node->subPhase = static_cast<LeaderElectionNode::SubPhase>(in.readInt());
+    node->unaryLabel = in.readInt();
+    node->count = in.readInt();
+    node->mergePending = in.readBool();
+    node->mergeAck = in.readBool();
+    node->mergeDir = in.readInt();
+    node->countSent = in.readBool();
+    node->lexCompInit = in.readBool();
+    node->lexCompTryMerge = in.readBool();
+    node->lexicographicComparisonLeft = in.readBool();
+    node->lexicographicComparisonRight = in.readBool();
+    node->requestedNbrLabel = in.readBool();
+    node->receivedNbrLabel = in.readBool();
+    node->NbrLabel = in.readInt();
+    node->requestedLabel = in.readBool();
+    node->receivedLabel = in.readBool();
+    node->receivedLabelRequestFromNbr = in.readBool();
+    node->requestedLabelForNbr = in.readBool();
+    node->receivedLabelForNbr = in.readBool();
+    node->internalLabel = in.readInt();
+    node->internalLabelForNbr = in.readInt();
+    node->firstLargerLabel = in.readInt();
+    node->retrieved = in.readBool();
+    node->retrievedForNbr = in.readBool();
+    node->terminationDetectionInitiated = in.readBool();
+    nodes.push_back(node);
+  }
+
+  for (int& color : borderColorLabels) {
+    color = in.readInt();
+  }
+  for (int& color : borderPointColorLabels) {
+    color = in.readInt();
+  }
+  for (int& color : borderPointBetweenEdgeColorLabels) {
+    color = in.readInt();
+  }
+  for (int& color : borderHalfPointBetweenEdgeColorLabels) {
+    color = in.readInt();
+  }
+}
+
+void LeaderElectionStationaryDeterministicParticle::writeToken(
+    CheckpointWriter& out, const Token& token) const {
+  const std::vector<TokenCodec>& codecs = tokenCodecs();
+  for (unsigned int tag = 0; tag < codecs.size(); ++tag) {
+    if (*codecs[tag].type == typeid(token)) {
+      out.writeUInt(tag);
+      codecs[tag].write(out, token);
+      return;
+    }
+  }
+  Q_ASSERT(false);  // Token type missing from tokenCodecs().
+}
+
+TokenPtr<AmoebotParticle::Token>
+LeaderElectionStationaryDeterministicParticle::readToken(CheckpointReader& in) {
+  const std::vector<TokenCodec>& codecs = tokenCodecs();
+  const uint32_t tag = in.readUInt();
+  if (in.failed() || tag >= codecs.size()) {
+    in.fail();
+    return nullptr;
+  }
+
+  return (this->*codecs[tag].read)(in);
+}
+
+template <class TokenType>
+void LeaderElectionStationaryDeterministicParticle::writeTokenOf(
+    CheckpointWriter& out, const Token& token) {
+  FieldWriter writer{out};
+  visitTokenFields(writer, static_cast<const TokenType&>(token));
+}
+
+template <class TokenType>
+TokenPtr<AmoebotParticle::Token>
+LeaderElectionStationaryDeterministicParticle::readTokenOf(
+    CheckpointReader& in) {
+  TokenPtr<TokenType> token = makeToken<TokenType>();
+  FieldReader reader{in};
+  visitTokenFields(reader, *token);
+  return token;
+}
+
+template <class TokenType>
+LeaderElectionStationaryDeterministicParticle::TokenCodec
+LeaderElectionStationaryDeterministicParticle::codecOf() {
+  return TokenCodec{&typeid(TokenType), &writeTokenOf<TokenType>,
+                    &LeaderElectionStationaryDeterministicParticle::
+                        readTokenOf<TokenType>};
+}
+
+const std::vector<LeaderElectionStationaryDeterministicParticle::TokenCodec>&
+LeaderElectionStationaryDeterministicParticle::tokenCodecs() {
+  static const std::vector<TokenCodec> codecs = {
+    codecOf<ParentToken>(),
+    codecOf<ChildToken>(),
+    codecOf<TreeComparisonStartToken>(),
+    codecOf<TreeFormationFinishedToken>(),
+    codecOf<ComparisonResultToken>(),
+    codecOf<RequestCandidateEncodingToken>(),
+    codecOf<CandidateEncodingToken>(),
+    codecOf<CandidateTreeExhaustedToken>(),
+    codecOf<RequestEncodingRightToken>(),
+    codecOf<RequestEncodingLeftToken>(),
+    codecOf<EncodingRightToken>(),
+    codecOf<EncodingLeftToken>(),
+    codecOf<SubTreeExhaustedRightToken>(),
+    codecOf<SubTreeExhaustedLeftToken>(),
+    codecOf<CleanUpToken>(),
+    codecOf<MergeRequestToken>(),
+    codecOf<MergeAckToken>(),
+    codecOf<MergeNackToken>(),
+    codecOf<CountToken>(),
+    codecOf<CountReturnToken>(),
+    codecOf<AttemptMergeToken>(),
+    codecOf<MergeCountToken>(),
+    codecOf<LexCompAttemptMergeToken>(),
+    codecOf<LexCompInitToken>(),
+    codecOf<LexCompAckToken>(),
+    codecOf<LexCompNackToken>(),
+    codecOf<LexCompReqStretchLabelToken>(),
+    codecOf<LexCompReturnStretchLabelToken>(),
+    codecOf<LexCompEndOfNbrStretchToken>(),
+    codecOf<LexCompRetrieveNextLabelToken>(),
+    codecOf<LexCompNextLabelToken>(),
+    codecOf<LexCompEndOfStretchToken>(),
+    codecOf<LexCompRetrieveNextLabelForNbrToken>(),
+    codecOf<LexCompNextLabelForNbrToken>(),
+    codecOf<LexCompEndOfStretchForNbrToken>(),
+    codecOf<LexCompInterruptRightToken>(),
+    codecOf<LexCompInterruptLeftToken>(),
+    codecOf<LexCompCleanUpToken>(),
+    codecOf<LexCompCleanUpForNbrToken>(),
+    codecOf<TerminationDetectionToken>(),
+    codecOf<TerminationDetectionReturnToken>()
+  };
+  return codecs;
+}
+
 //----------------------------END PARTICLE CODE----------------------------
 
 //----------------------------BEGIN AGENT CODE----------------------------
@@ -1296,6 +1697,7 @@ LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::LeaderElectio
   nodeDir(-1),
   nextNodeDir(-1),
   prevNodeDir(-1),
+  subPhase(SubPhase::Initial),
   particle(nullptr) {}
 
 void LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::activate() {
@@ -1306,20 +1708,20 @@ void LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::activate
       // Process termination detection tokens
       if (hasNodeToken<TerminationDetectionToken>(nextNode()->prevNodeDir)) {
         // qDebug() << "Head has termination detection token...";
-        std::shared_ptr<TerminationDetectionToken> token = peekNodeToken<TerminationDetectionToken>(nextNode()->prevNodeDir);
+        TokenPtr<TerminationDetectionToken> token = peekNodeToken<TerminationDetectionToken>(nextNode()->prevNodeDir);
         // qDebug() << "Peeked at the token...";
         if (token->counter != count) {
           // Different count -> send token back, no termination
           // qDebug() << "Different count -> no termination";
           takeNodeToken<TerminationDetectionToken>(nextNode()->prevNodeDir);
-          passNodeToken<TerminationDetectionReturnToken>(nextNodeDir, std::make_shared<TerminationDetectionReturnToken>(-1, token->counter, token->traversed, 0, false));
+          passNodeToken<TerminationDetectionReturnToken>(nextNodeDir, makeToken<TerminationDetectionReturnToken>(-1, token->counter, token->traversed, 0, false));
         }
         else {
           // Same count, initiate lexicographic comparison if not started yet
           // At the end, send back if different string, send to next stretch if equal
           if (!lexCompInit) {
             // Initiate lexicographic comparison
-            passNodeToken<LexCompInitToken>(nextNodeDir, std::make_shared<LexCompInitToken>(-1, count));
+            passNodeToken<LexCompInitToken>(nextNodeDir, makeToken<LexCompInitToken>(-1, count));
             lexCompInit = true;
             lexCompTryMerge = false;
           }
@@ -1329,7 +1731,7 @@ void LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::activate
       // Pass termination detection return tokens
       // If token intended for this stretch, process it
       if (hasNodeToken<TerminationDetectionReturnToken>(prevNode()->nextNodeDir)) {
-        std::shared_ptr<TerminationDetectionReturnToken> token = takeNodeToken<TerminationDetectionReturnToken>(prevNode()->nextNodeDir);
+        TokenPtr<TerminationDetectionReturnToken> token = takeNodeToken<TerminationDetectionReturnToken>(prevNode()->nextNodeDir);
         bool termination = token->termination;
         if (count != token->counter) {
           termination = false;
@@ -1342,7 +1744,7 @@ void LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::activate
                 // Single stretch with count 6 covering the outer border
                 // Head becomes leader
                 // qDebug() << "Terminating...";
-                particle->state = State::Leader;
+                particle->setState(State::Leader);
                 terminationDetectionInitiated = false;
                 return;
               }
@@ -1350,7 +1752,7 @@ void LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::activate
                 // Multiple lexicographically equal stretches covering the border
                 // Move to next state -> Trees to break symmetry
                 // qDebug() << "Trees to break symmetry";
-                particle->state = State::Candidate;
+                particle->setState(State::Candidate);
                 particle->tree = true;
                 particle->headCount = count;
                 terminationDetectionInitiated = false;
@@ -1365,7 +1767,7 @@ void LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::activate
         }
         else {
           // qDebug() << "Passing termination detection return token back";
-          passNodeToken<TerminationDetectionReturnToken>(nextNodeDir, std::make_shared<TerminationDetectionReturnToken>(-1, token->counter, token->ttl, token->traversed+1, termination));
+          passNodeToken<TerminationDetectionReturnToken>(nextNodeDir, makeToken<TerminationDetectionReturnToken>(-1, token->counter, token->ttl, token->traversed+1, termination));
         }
       }
 
@@ -1403,10 +1805,10 @@ void LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::activate
       }
       // If init token received, send ack or nack token
       if (hasNodeToken<LexCompInitToken>(prevNode()->nextNodeDir)) {
-        std::shared_ptr<LexCompInitToken> token = takeNodeToken<LexCompInitToken>(prevNode()->nextNodeDir);
+        TokenPtr<LexCompInitToken> token = takeNodeToken<LexCompInitToken>(prevNode()->nextNodeDir);
         int value = token->value;
         if (value == count && !lexicographicComparisonLeft) {
-          passNodeToken<LexCompAckToken>(prevNodeDir, std::make_shared<LexCompAckToken>());
+          passNodeToken<LexCompAckToken>(prevNodeDir, makeToken<LexCompAckToken>());
           lexCompCleanUpForNbr();
           lexicographicComparisonLeft = true;
           while (hasNodeToken<LexCompNextLabelForNbrToken>(nextNode()->prevNodeDir)) {
@@ -1415,7 +1817,7 @@ void LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::activate
           return;
         }
         else {
-          passNodeToken<LexCompNackToken>(prevNodeDir, std::make_shared<LexCompNackToken>());
+          passNodeToken<LexCompNackToken>(prevNodeDir, makeToken<LexCompNackToken>());
         }
       }
       
@@ -1423,13 +1825,13 @@ void LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::activate
       if (lexicographicComparisonRight) {
         // Request labels from the adjacent stretch
         if (!requestedNbrLabel) {
-          passNodeToken<LexCompReqStretchLabelToken>(nextNodeDir, std::make_shared<LexCompReqStretchLabelToken>());
+          passNodeToken<LexCompReqStretchLabelToken>(nextNodeDir, makeToken<LexCompReqStretchLabelToken>());
           requestedNbrLabel = true;
         }
         // Receive labels from the adjacent stretch after requesting them
         else if (!receivedNbrLabel) {
           if (hasNodeToken<LexCompReturnStretchLabelToken>(nextNode()->prevNodeDir)) {
-            std::shared_ptr<LexCompReturnStretchLabelToken> token = takeNodeToken<LexCompReturnStretchLabelToken>(nextNode()->prevNodeDir);
+            TokenPtr<LexCompReturnStretchLabelToken> token = takeNodeToken<LexCompReturnStretchLabelToken>(nextNode()->prevNodeDir);
             NbrLabel = token->value;
             receivedNbrLabel = true;
           }
@@ -1449,14 +1851,14 @@ void LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::activate
             retrieved = true;
           }
           else {
-            passNodeToken<LexCompRetrieveNextLabelToken>(nextNodeDir, std::make_shared<LexCompRetrieveNextLabelToken>());
+            passNodeToken<LexCompRetrieveNextLabelToken>(nextNodeDir, makeToken<LexCompRetrieveNextLabelToken>());
             requestedLabel = true;
           }
         }
         // Receive internal labels after requesting them
         else if (!receivedLabel) {
           if (hasNodeToken<LexCompNextLabelToken>(nextNode()->prevNodeDir)) {
-            std::shared_ptr<LexCompNextLabelToken> token = takeNodeToken<LexCompNextLabelToken>(nextNode()->prevNodeDir);
+            TokenPtr<LexCompNextLabelToken> token = takeNodeToken<LexCompNextLabelToken>(nextNode()->prevNodeDir);
             internalLabel = token->value;
             receivedLabel = true;
           }
@@ -1486,8 +1888,8 @@ void LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::activate
             // Send back termination detection token -> no termination
             if (hasNodeToken<TerminationDetectionToken>(nextNode()->prevNodeDir)) {
               // qDebug() << "Lexicographically inequal -> no termination";
-              std::shared_ptr<TerminationDetectionToken> token = takeNodeToken<TerminationDetectionToken>(nextNode()->prevNodeDir);
-              passNodeToken<TerminationDetectionReturnToken>(nextNodeDir, std::make_shared<TerminationDetectionReturnToken>(-1, token->counter, token->traversed, 0, false));
+              TokenPtr<TerminationDetectionToken> token = takeNodeToken<TerminationDetectionToken>(nextNode()->prevNodeDir);
+              passNodeToken<TerminationDetectionReturnToken>(nextNodeDir, makeToken<TerminationDetectionReturnToken>(-1, token->counter, token->traversed, 0, false));
             }
           }
           // If one of the labels is 0, then the stretch has exhausted all its labels
@@ -1495,7 +1897,7 @@ void LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::activate
           if (internalLabel == 0 && NbrLabel != 0) {
             // qDebug() << "Adjacent stretch is lexicographically larger";
             // Adjacent stretch is lexicographically larger -> no merge
-            passNodeToken<LexCompInterruptRightToken>(nextNodeDir, std::make_shared<LexCompInterruptRightToken>());
+            passNodeToken<LexCompInterruptRightToken>(nextNodeDir, makeToken<LexCompInterruptRightToken>());
             // qDebug() << "Sent interrupt token";
             lexCompCleanUp();
             // qDebug() << "Cleaned up";
@@ -1508,7 +1910,7 @@ void LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::activate
             // Merge
             if (lexCompTryMerge) {
               // qDebug() << "Attempting merge...";
-              passNodeToken<LexCompAttemptMergeToken>(nextNodeDir, std::make_shared<LexCompAttemptMergeToken>(-1, count));
+              passNodeToken<LexCompAttemptMergeToken>(nextNodeDir, makeToken<LexCompAttemptMergeToken>(-1, count));
               mergePending = true;
               mergeAck = false;
               mergeDir = 1;
@@ -1532,7 +1934,7 @@ void LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::activate
               // Merge
               if (lexCompTryMerge) {
                 // qDebug() << "Attempting merge...";
-                passNodeToken<LexCompAttemptMergeToken>(nextNodeDir, std::make_shared<LexCompAttemptMergeToken>(-1, count));
+                passNodeToken<LexCompAttemptMergeToken>(nextNodeDir, makeToken<LexCompAttemptMergeToken>(-1, count));
                 mergePending = true;
                 mergeAck = false;
                 mergeDir = 1;
@@ -1579,13 +1981,13 @@ void LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::activate
 
               if ((count == 1 || count == 2 || count == 3) && !terminationDetectionInitiated) {
                 // qDebug() << "Lexicographically equal -> starting termination detection...";
-                passNodeToken<TerminationDetectionToken>(prevNodeDir, std::make_shared<TerminationDetectionToken>(-1, count, 6/count, 0));
+                passNodeToken<TerminationDetectionToken>(prevNodeDir, makeToken<TerminationDetectionToken>(-1, count, 6/count, 0));
                 terminationDetectionInitiated = true;
               }
               else if (count == 6) {
                 // Border covered by 1 stretch of count 6
                 // qDebug() << "Lexicographically equal with count 6 -> terminating...";
-                particle->state = State::Leader;
+                particle->setState(State::Leader);
                 return;
               }
 
@@ -1593,14 +1995,14 @@ void LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::activate
               // or if last stretch, return to initiator with termination set to true
               if (hasNodeToken<TerminationDetectionToken>(nextNode()->prevNodeDir)) {
                 // qDebug() << "Head has termination detection token AND lexicographically equal";
-                std::shared_ptr<TerminationDetectionToken> token = takeNodeToken<TerminationDetectionToken>(nextNode()->prevNodeDir);
+                TokenPtr<TerminationDetectionToken> token = takeNodeToken<TerminationDetectionToken>(nextNode()->prevNodeDir);
                 if (token->traversed + 1 >= token->ttl) {
                   // qDebug() << "Sending termination token back";
-                  passNodeToken<TerminationDetectionReturnToken>(nextNodeDir, std::make_shared<TerminationDetectionReturnToken>(-1, token->counter, token->traversed+1, 0, true));
+                  passNodeToken<TerminationDetectionReturnToken>(nextNodeDir, makeToken<TerminationDetectionReturnToken>(-1, token->counter, token->traversed+1, 0, true));
                 }
                 else {
                   // qDebug() << "Passing termination detection token to next head";
-                  passNodeToken<TerminationDetectionToken>(prevNodeDir, std::make_shared<TerminationDetectionToken>(-1, token->counter, token->ttl, token->traversed+1));
+                  passNodeToken<TerminationDetectionToken>(prevNodeDir, makeToken<TerminationDetectionToken>(-1, token->counter, token->ttl, token->traversed+1));
                 }
               }
             }
@@ -1631,7 +2033,7 @@ void LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::activate
           }
           else {
             if (successor != nullptr) {
-              passNodeToken<LexCompRetrieveNextLabelForNbrToken>(nextNodeDir, std::make_shared<LexCompRetrieveNextLabelForNbrToken>());
+              passNodeToken<LexCompRetrieveNextLabelForNbrToken>(nextNodeDir, makeToken<LexCompRetrieveNextLabelForNbrToken>());
               requestedLabelForNbr = true;
             }
             else {
@@ -1645,7 +2047,7 @@ void LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::activate
         // Receive internal labels after requesting them
         else if (!receivedLabelForNbr) {
           if (hasNodeToken<LexCompNextLabelForNbrToken>(nextNode()->prevNodeDir)) {
-            std::shared_ptr<LexCompNextLabelForNbrToken> token = takeNodeToken<LexCompNextLabelForNbrToken>(nextNode()->prevNodeDir);
+            TokenPtr<LexCompNextLabelForNbrToken> token = takeNodeToken<LexCompNextLabelForNbrToken>(nextNode()->prevNodeDir);
             internalLabelForNbr = token->value;
             receivedLabelForNbr = true;
           }
@@ -1661,7 +2063,7 @@ void LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::activate
           // If there was an internal label, send it
           // qDebug() << "Sending label to neighbour: " + QString::number(internalLabelForNbr);
           if (internalLabelForNbr != 0) {
-            passNodeToken<LexCompReturnStretchLabelToken>(prevNodeDir, std::make_shared<LexCompReturnStretchLabelToken>(-1, internalLabelForNbr));
+            passNodeToken<LexCompReturnStretchLabelToken>(prevNodeDir, makeToken<LexCompReturnStretchLabelToken>(-1, internalLabelForNbr));
             receivedLabelRequestFromNbr = false;
             requestedLabelForNbr = false;
             receivedLabelForNbr = false;
@@ -1669,7 +2071,7 @@ void LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::activate
           }
           // Otherwise signal end of stretch
           else {
-            passNodeToken<LexCompEndOfNbrStretchToken>(prevNodeDir, std::make_shared<LexCompEndOfNbrStretchToken>());
+            passNodeToken<LexCompEndOfNbrStretchToken>(prevNodeDir, makeToken<LexCompEndOfNbrStretchToken>());
             lexCompCleanUpForNbr();
           }
         }
@@ -1685,24 +2087,24 @@ void LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::activate
         mergeAck = true;
         // Interrupt lexicographic comparison if applicable
         if (lexicographicComparisonLeft) {
-          passNodeToken<LexCompInterruptLeftToken>(prevNodeDir, std::make_shared<LexCompInterruptLeftToken>());
+          passNodeToken<LexCompInterruptLeftToken>(prevNodeDir, makeToken<LexCompInterruptLeftToken>());
           lexCompCleanUpForNbr();
         }
       }
       if (hasNodeToken<MergeRequestToken>(prevNode()->nextNodeDir)) {
         if (mergePending) {
           takeNodeToken<MergeRequestToken>(prevNode()->nextNodeDir);
-          passNodeToken<MergeNackToken>(prevNodeDir, std::make_shared<MergeNackToken>());
+          passNodeToken<MergeNackToken>(prevNodeDir, makeToken<MergeNackToken>());
         }
         else {
           takeNodeToken<MergeRequestToken>(prevNode()->nextNodeDir);
-          passNodeToken<MergeAckToken>(prevNodeDir, std::make_shared<MergeAckToken>());
+          passNodeToken<MergeAckToken>(prevNodeDir, makeToken<MergeAckToken>());
           mergePending = true;
           mergeAck = true;
           mergeDir = -1;
           // Interrupt lexicographic comparison if applicable
           if (lexCompInit) {
-            passNodeToken<LexCompInterruptRightToken>(nextNodeDir, std::make_shared<LexCompInterruptRightToken>());
+            passNodeToken<LexCompInterruptRightToken>(nextNodeDir, makeToken<LexCompInterruptRightToken>());
           }
           lexCompCleanUp();
         }
@@ -1714,13 +2116,13 @@ void LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::activate
           LeaderElectionNode* next = nextNode(true);
           if (unaryLabel > next->count && unaryLabel + next->count <= 6) {
             // Send a merge request
-            passNodeToken<MergeRequestToken>(nextNodeDir, std::make_shared<MergeRequestToken>());
+            passNodeToken<MergeRequestToken>(nextNodeDir, makeToken<MergeRequestToken>());
             mergePending = true;
             mergeAck = false;
             mergeDir = 1;
             // Interrupt lexicographic comparison if applicable
             if (lexicographicComparisonLeft) {
-              passNodeToken<LexCompInterruptLeftToken>(prevNodeDir, std::make_shared<LexCompInterruptLeftToken>());
+              passNodeToken<LexCompInterruptLeftToken>(prevNodeDir, makeToken<LexCompInterruptLeftToken>());
               lexCompCleanUpForNbr();
             }
           }
@@ -1743,16 +2145,16 @@ void LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::activate
           if (!mergePending) {
             takeNodeToken<MergeRequestToken>(prevNode()->nextNodeDir);
             predecessor = prevNode(true);
-            passNodeToken<MergeAckToken>(prevNodeDir, std::make_shared<MergeAckToken>());
+            passNodeToken<MergeAckToken>(prevNodeDir, makeToken<MergeAckToken>());
             // Interrupt lexicographic comparison if applicable
             if (lexCompInit) {
-              passNodeToken<LexCompInterruptRightToken>(nextNodeDir, std::make_shared<LexCompInterruptRightToken>());
+              passNodeToken<LexCompInterruptRightToken>(nextNodeDir, makeToken<LexCompInterruptRightToken>());
             }
             lexCompCleanUp();
           }
           else {
             takeNodeToken<MergeRequestToken>(prevNode()->nextNodeDir);
-            passNodeToken<MergeNackToken>(prevNodeDir, std::make_shared<MergeNackToken>());
+            passNodeToken<MergeNackToken>(prevNodeDir, makeToken<MergeNackToken>());
           }
         }
         if (mergePending && mergeAck && mergeDir == -1) {
@@ -1762,24 +2164,24 @@ void LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::activate
         }
         else if (!mergePending) {
           if (!countSent && count > 0 && !lexCompInit) {
-            passNodeToken<CountToken>(nextNodeDir, std::make_shared<CountToken>(-1, count));
+            passNodeToken<CountToken>(nextNodeDir, makeToken<CountToken>(-1, count));
             countSent = true;
           }
           else if (!lexCompInit) {
             if (hasNodeToken<CountReturnToken>(successor->prevNodeDir)) {
-              std::shared_ptr<CountReturnToken> token = takeNodeToken<CountReturnToken>(successor->prevNodeDir);
+              TokenPtr<CountReturnToken> token = takeNodeToken<CountReturnToken>(successor->prevNodeDir);
               int value = token->value;
               countSent = false;
               if (count > 0 && count > value && count + value <= 6) {
                 // Attempt to merge with the adjacent stretch
-                passNodeToken<AttemptMergeToken>(nextNodeDir, std::make_shared<AttemptMergeToken>(-1, count));
+                passNodeToken<AttemptMergeToken>(nextNodeDir, makeToken<AttemptMergeToken>(-1, count));
                 mergePending = true;
                 mergeDir = 1;
                 // Interrupt lexicographic comparison if applicable
                 if (lexicographicComparisonLeft) {
                   // Lexicographic comparison was initiated by the counter-clockwise adjacent stretch
                   // Send interrupt token in this direction
-                  passNodeToken<LexCompInterruptLeftToken>(prevNodeDir, std::make_shared<LexCompInterruptLeftToken>());
+                  passNodeToken<LexCompInterruptLeftToken>(prevNodeDir, makeToken<LexCompInterruptLeftToken>());
                   lexCompCleanUpForNbr();
                 }
               }
@@ -1809,7 +2211,7 @@ void LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::activate
                  * If all labels were equal -> trigger termination detection.
                  */
                 if (!lexCompInit) {
-                  passNodeToken<LexCompInitToken>(nextNodeDir, std::make_shared<LexCompInitToken>(-1, count));
+                  passNodeToken<LexCompInitToken>(nextNodeDir, makeToken<LexCompInitToken>(-1, count));
                   lexCompInit = true;
                   lexCompTryMerge = true;
                 }
@@ -1817,7 +2219,7 @@ void LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::activate
               else if ((count == 1 || count == 2 || count == 3 || count == 6) && count == value) {
                 // Initialize lexicographic comparison
                 // But do not merge, only start termination detection if strings are lexicographically equal
-                passNodeToken<LexCompInitToken>(nextNodeDir, std::make_shared<LexCompInitToken>(-1, count));
+                passNodeToken<LexCompInitToken>(nextNodeDir, makeToken<LexCompInitToken>(-1, count));
                 lexCompInit = true;
                 lexCompTryMerge = false;
               }
@@ -1830,7 +2232,7 @@ void LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::activate
             mergePending = false;
           }
           else if (hasNodeToken<MergeCountToken>(successor->prevNodeDir)) {
-            std::shared_ptr<MergeCountToken> token = takeNodeToken<MergeCountToken>(successor->prevNodeDir);
+            TokenPtr<MergeCountToken> token = takeNodeToken<MergeCountToken>(successor->prevNodeDir);
             int value = token->value;
             count += value;
             mergePending = false;
@@ -1843,7 +2245,7 @@ void LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::activate
       // Pass termination detection tokens
       if (hasNodeToken<TerminationDetectionToken>(nextNode()->prevNodeDir)) {
         // qDebug() << "Tail node has termination detection token";
-        std::shared_ptr<TerminationDetectionToken> token = takeNodeToken<TerminationDetectionToken>(nextNode()->prevNodeDir);
+        TokenPtr<TerminationDetectionToken> token = takeNodeToken<TerminationDetectionToken>(nextNode()->prevNodeDir);
         bool hasMergeToken = false;
         if (hasNodeToken<LexCompAttemptMergeToken>(predecessor->nextNodeDir)) {
           hasMergeToken = true;
@@ -1862,17 +2264,17 @@ void LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::activate
         }
         if (hasMergeToken) {
           if(token->traversed > 0) {
-            passNodeToken<TerminationDetectionReturnToken>(nextNodeDir, std::make_shared<TerminationDetectionReturnToken>(-1, token->counter, token->traversed+1, 0, false));
+            passNodeToken<TerminationDetectionReturnToken>(nextNodeDir, makeToken<TerminationDetectionReturnToken>(-1, token->counter, token->traversed+1, 0, false));
           }
         }
         else {
           // qDebug() << "Passing termination detection token...";
-          passNodeToken<TerminationDetectionToken>(prevNodeDir, std::make_shared<TerminationDetectionToken>(-1, token->counter, token->ttl, token->traversed));
+          passNodeToken<TerminationDetectionToken>(prevNodeDir, makeToken<TerminationDetectionToken>(-1, token->counter, token->ttl, token->traversed));
         }
       }
       if (hasNodeToken<TerminationDetectionReturnToken>(prevNode()->nextNodeDir)) {
-        std::shared_ptr<TerminationDetectionReturnToken> token = takeNodeToken<TerminationDetectionReturnToken>(prevNode()->nextNodeDir);
-        passNodeToken<TerminationDetectionReturnToken>(nextNodeDir, std::make_shared<TerminationDetectionReturnToken>(-1, token->counter, token->ttl, token->traversed, token->termination));
+        TokenPtr<TerminationDetectionReturnToken> token = takeNodeToken<TerminationDetectionReturnToken>(prevNode()->nextNodeDir);
+        passNodeToken<TerminationDetectionReturnToken>(nextNodeDir, makeToken<TerminationDetectionReturnToken>(-1, token->counter, token->ttl, token->traversed, token->termination));
       }
 
       // Pass lexicographic comparison tokens
@@ -1904,41 +2306,41 @@ void LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::activate
       }
       if (hasNodeToken<LexCompInitToken>(predecessor->nextNodeDir)) {
         // Pass init tokens towards clockwise adjacent stretch
-        std::shared_ptr<LexCompInitToken> token = takeNodeToken<LexCompInitToken>(predecessor->nextNodeDir);
+        TokenPtr<LexCompInitToken> token = takeNodeToken<LexCompInitToken>(predecessor->nextNodeDir);
         int value = token->value;
-        passNodeToken<LexCompInitToken>(nextNodeDir, std::make_shared<LexCompInitToken>(-1, value));
+        passNodeToken<LexCompInitToken>(nextNodeDir, makeToken<LexCompInitToken>(-1, value));
       }
       if (hasNodeToken<LexCompAckToken>(nextNode()->prevNodeDir)) {
         // Pass ack tokens towards head
         takeNodeToken<LexCompAckToken>(nextNode()->prevNodeDir);
-        passNodeToken<LexCompAckToken>(prevNodeDir, std::make_shared<LexCompAckToken>());
+        passNodeToken<LexCompAckToken>(prevNodeDir, makeToken<LexCompAckToken>());
       }
       if (hasNodeToken<LexCompNackToken>(nextNode()->prevNodeDir)) {
         // Pass nack tokens towards head
         takeNodeToken<LexCompNackToken>(nextNode()->prevNodeDir);
-        passNodeToken<LexCompNackToken>(prevNodeDir, std::make_shared<LexCompNackToken>());
+        passNodeToken<LexCompNackToken>(prevNodeDir, makeToken<LexCompNackToken>());
       }
       if (hasNodeToken<LexCompInterruptLeftToken>(nextNode()->prevNodeDir)) {
         // Pass interrupt tokens in counter-clockwise direction
         takeNodeToken<LexCompInterruptLeftToken>(nextNode()->prevNodeDir);
-        passNodeToken<LexCompInterruptLeftToken>(prevNodeDir, std::make_shared<LexCompInterruptLeftToken>());
+        passNodeToken<LexCompInterruptLeftToken>(prevNodeDir, makeToken<LexCompInterruptLeftToken>());
       }
       if (hasNodeToken<LexCompInterruptRightToken>(predecessor->nextNodeDir)) {
         // Pass interrupt tokens in clockwise direction
         takeNodeToken<LexCompInterruptRightToken>(predecessor->nextNodeDir);
-        passNodeToken<LexCompInterruptRightToken>(nextNodeDir, std::make_shared<LexCompInterruptRightToken>());
+        passNodeToken<LexCompInterruptRightToken>(nextNodeDir, makeToken<LexCompInterruptRightToken>());
       }
       if (hasNodeToken<LexCompRetrieveNextLabelToken>(predecessor->nextNodeDir)) {
         // Handle retrieve internal label tokens
         takeNodeToken<LexCompRetrieveNextLabelToken>(predecessor->nextNodeDir);
         // If this node's label hasn't been retrieved yet, send it
         if (!retrieved) {
-          passNodeToken<LexCompNextLabelToken>(prevNodeDir, std::make_shared<LexCompNextLabelToken>(-1, unaryLabel));
+          passNodeToken<LexCompNextLabelToken>(prevNodeDir, makeToken<LexCompNextLabelToken>(-1, unaryLabel));
           retrieved = true;
         }
         // Otherwise send end of stretch token
         else {
-          passNodeToken<LexCompEndOfStretchToken>(prevNodeDir, std::make_shared<LexCompEndOfStretchToken>());
+          passNodeToken<LexCompEndOfStretchToken>(prevNodeDir, makeToken<LexCompEndOfStretchToken>());
         }
       }
       if (hasNodeToken<LexCompRetrieveNextLabelForNbrToken>(predecessor->nextNodeDir)) {
@@ -1946,66 +2348,66 @@ void LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::activate
         takeNodeToken<LexCompRetrieveNextLabelForNbrToken>(predecessor->nextNodeDir);
         // If this node's label hasn't been retrieved yet, send it
         if (!retrievedForNbr) {
-          passNodeToken<LexCompNextLabelForNbrToken>(prevNodeDir, std::make_shared<LexCompNextLabelForNbrToken>(-1, unaryLabel));
+          passNodeToken<LexCompNextLabelForNbrToken>(prevNodeDir, makeToken<LexCompNextLabelForNbrToken>(-1, unaryLabel));
           retrievedForNbr = true;
         }
         // Otherwise send end of stretch token
         else {
-          passNodeToken<LexCompEndOfStretchForNbrToken>(prevNodeDir, std::make_shared<LexCompEndOfStretchForNbrToken>());
+          passNodeToken<LexCompEndOfStretchForNbrToken>(prevNodeDir, makeToken<LexCompEndOfStretchForNbrToken>());
         }
       }
       if (hasNodeToken<LexCompReqStretchLabelToken>(predecessor->nextNodeDir)) {
         // Pass label requests towards the adjacent stretch
         takeNodeToken<LexCompReqStretchLabelToken>(predecessor->nextNodeDir);
-        passNodeToken<LexCompReqStretchLabelToken>(nextNodeDir, std::make_shared<LexCompReqStretchLabelToken>());
+        passNodeToken<LexCompReqStretchLabelToken>(nextNodeDir, makeToken<LexCompReqStretchLabelToken>());
       }
       if (hasNodeToken<LexCompReturnStretchLabelToken>(nextNode()->prevNodeDir)) {
         // Pass labels back towards the head of the stretch
-        std::shared_ptr<LexCompReturnStretchLabelToken> token = takeNodeToken<LexCompReturnStretchLabelToken>(nextNode()->prevNodeDir);
+        TokenPtr<LexCompReturnStretchLabelToken> token = takeNodeToken<LexCompReturnStretchLabelToken>(nextNode()->prevNodeDir);
         int value = token->value;
-        passNodeToken<LexCompReturnStretchLabelToken>(prevNodeDir, std::make_shared<LexCompReturnStretchLabelToken>(-1, value));
+        passNodeToken<LexCompReturnStretchLabelToken>(prevNodeDir, makeToken<LexCompReturnStretchLabelToken>(-1, value));
       }
       if (hasNodeToken<LexCompEndOfNbrStretchToken>(nextNode()->prevNodeDir)) {
         // Pass the adjacent stretch's end of stretch token towards the head
         takeNodeToken<LexCompEndOfNbrStretchToken>(nextNode()->prevNodeDir);
-        passNodeToken<LexCompEndOfNbrStretchToken>(prevNodeDir, std::make_shared<LexCompEndOfNbrStretchToken>());
+        passNodeToken<LexCompEndOfNbrStretchToken>(prevNodeDir, makeToken<LexCompEndOfNbrStretchToken>());
       }
       if (hasNodeToken<LexCompAttemptMergeToken>(predecessor->nextNodeDir)) {
         // Receive attempt merge tokens and merge if requirements met
-        std::shared_ptr<LexCompAttemptMergeToken> token = takeNodeToken<LexCompAttemptMergeToken>(predecessor->nextNodeDir);
+        TokenPtr<LexCompAttemptMergeToken> token = takeNodeToken<LexCompAttemptMergeToken>(predecessor->nextNodeDir);
         count = token->value;
         LeaderElectionNode* headNbr = nextNode(true);
         if (count > 0 && count == headNbr->count && count + headNbr->count <= 6) {
-          passNodeToken<MergeRequestToken>(nextNodeDir, std::make_shared<MergeRequestToken>());
+          passNodeToken<MergeRequestToken>(nextNodeDir, makeToken<MergeRequestToken>());
           mergePending = true;
           mergeDir = 1;
         }
         else {
           // Counts have changed since communication, abort merge.
-          passNodeToken<MergeNackToken>(prevNodeDir, std::make_shared<MergeNackToken>());
+          passNodeToken<MergeNackToken>(prevNodeDir, makeToken<MergeNackToken>());
         }
       }
 
       if (hasNodeToken<CountToken>(predecessor->nextNodeDir)) {
-        std::shared_ptr<CountToken> token = takeNodeToken<CountToken>(predecessor->nextNodeDir);
+        TokenPtr<CountToken> token = takeNodeToken<CountToken>(predecessor->nextNodeDir);
         int value = token->value;
         count = value;
         LeaderElectionNode* headNbr = nextNode(true);
-        passNodeToken<CountReturnToken>(prevNodeDir, std::make_shared<CountReturnToken>(-1, headNbr->count));
+        passNodeToken<CountReturnToken>(prevNodeDir, makeToken<CountReturnToken>(-1, headNbr->count));
       }
       if (hasNodeToken<AttemptMergeToken>(predecessor->nextNodeDir)) {
-        std::shared_ptr<AttemptMergeToken> token = takeNodeToken<AttemptMergeToken>(predecessor->nextNodeDir);
+        TokenPtr<AttemptMergeToken> token = takeNodeToken<AttemptMergeToken>(predecessor->nextNodeDir);
         int value = token->value;
         count = value;
         LeaderElectionNode* headNbr = nextNode(true);
         if (count > 0 && count > headNbr->count && count + headNbr->count <= 6) {
-          passNodeToken<MergeRequestToken>(nextNodeDir, std::make_shared<MergeRequestToken>());
+          passNodeToken<MergeRequestToken>(nextNodeDir, makeToken<MergeRequestToken>());
           mergePending = true;
           mergeDir = 1;
         }
         else {
           // Counts have changed since communication, abort merge.
-          passNodeToken<MergeNackToken>(prevNodeDir, std::make_shared<MergeNackToken>());
+          passNodeToken<MergeNackToken>(prevNodeDir, makeToken<MergeNackToken>());
         }
       }
       if (mergePending) {
@@ -2013,12 +2415,12 @@ void LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::activate
           takeNodeToken<MergeAckToken>(nextNode()->prevNodeDir);
           successor = nextNode();
           mergePending = false;
-          passNodeToken<MergeCountToken>(prevNodeDir, std::make_shared<MergeCountToken>(-1, successor->count));
+          passNodeToken<MergeCountToken>(prevNodeDir, makeToken<MergeCountToken>(-1, successor->count));
         }
         else if (hasNodeToken<MergeNackToken>(nextNode()->prevNodeDir)) {
           takeNodeToken<MergeNackToken>(nextNode()->prevNodeDir);
           mergePending = false;
-          passNodeToken<MergeNackToken>(prevNodeDir, std::make_shared<MergeNackToken>());
+          passNodeToken<MergeNackToken>(prevNodeDir, makeToken<MergeNackToken>());
         }
       }
     }
@@ -2027,7 +2429,7 @@ void LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::activate
       // Pass termination detection tokens
       if (hasNodeToken<TerminationDetectionToken>(nextNode()->prevNodeDir)) {
         // qDebug() << "Internal node has termination detection token";
-        std::shared_ptr<TerminationDetectionToken> token = takeNodeToken<TerminationDetectionToken>(nextNode()->prevNodeDir);
+        TokenPtr<TerminationDetectionToken> token = takeNodeToken<TerminationDetectionToken>(nextNode()->prevNodeDir);
         bool hasMergeToken = false;
         if (hasNodeToken<LexCompAttemptMergeToken>(predecessor->nextNodeDir)) {
           hasMergeToken = true;
@@ -2046,17 +2448,17 @@ void LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::activate
         }
         if (hasMergeToken) {
           if(token->traversed > 0) {
-            passNodeToken<TerminationDetectionReturnToken>(nextNodeDir, std::make_shared<TerminationDetectionReturnToken>(-1, token->counter, token->traversed+1, 0, false));
+            passNodeToken<TerminationDetectionReturnToken>(nextNodeDir, makeToken<TerminationDetectionReturnToken>(-1, token->counter, token->traversed+1, 0, false));
           }
         }
         else {
           // qDebug() << "Passing termination detection token...";
-          passNodeToken<TerminationDetectionToken>(prevNodeDir, std::make_shared<TerminationDetectionToken>(-1, token->counter, token->ttl, token->traversed));
+          passNodeToken<TerminationDetectionToken>(prevNodeDir, makeToken<TerminationDetectionToken>(-1, token->counter, token->ttl, token->traversed));
         }
       }
       if (hasNodeToken<TerminationDetectionReturnToken>(prevNode()->nextNodeDir)) {
-        std::shared_ptr<TerminationDetectionReturnToken> token = takeNodeToken<TerminationDetectionReturnToken>(prevNode()->nextNodeDir);
-        passNodeToken<TerminationDetectionReturnToken>(nextNodeDir, std::make_shared<TerminationDetectionReturnToken>(-1, token->counter, token->ttl, token->traversed, token->termination));
+        TokenPtr<TerminationDetectionReturnToken> token = takeNodeToken<TerminationDetectionReturnToken>(prevNode()->nextNodeDir);
+        passNodeToken<TerminationDetectionReturnToken>(nextNodeDir, makeToken<TerminationDetectionReturnToken>(-1, token->counter, token->ttl, token->traversed, token->termination));
       }
 
       // Pass lexicographic comparison topkens
@@ -2064,7 +2466,7 @@ void LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::activate
         // Pass cleanup tokens towards tail
         takeNodeToken<LexCompCleanUpToken>(predecessor->nextNodeDir);
         retrieved = false;
-        passNodeToken<LexCompCleanUpToken>(nextNodeDir, std::make_shared<LexCompCleanUpToken>());
+        passNodeToken<LexCompCleanUpToken>(nextNodeDir, makeToken<LexCompCleanUpToken>());
         // intercept label tokens and remove them
         while (hasNodeToken<LexCompReturnStretchLabelToken>(successor->prevNodeDir)) {
           takeNodeToken<LexCompReturnStretchLabelToken>(successor->prevNodeDir);
@@ -2085,7 +2487,7 @@ void LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::activate
       if (hasNodeToken<LexCompCleanUpForNbrToken>(predecessor->nextNodeDir)) {
         takeNodeToken<LexCompCleanUpForNbrToken>(predecessor->nextNodeDir);
         retrievedForNbr = false;
-        passNodeToken<LexCompCleanUpForNbrToken>(nextNodeDir, std::make_shared<LexCompCleanUpForNbrToken>());
+        passNodeToken<LexCompCleanUpForNbrToken>(nextNodeDir, makeToken<LexCompCleanUpForNbrToken>());
         // intercept label tokens for nbr and remove them
         while (hasNodeToken<LexCompNextLabelForNbrToken>(successor->prevNodeDir)) {
           takeNodeToken<LexCompNextLabelForNbrToken>(successor->prevNodeDir);
@@ -2096,41 +2498,41 @@ void LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::activate
       }
       if (hasNodeToken<LexCompInitToken>(predecessor->nextNodeDir)) {
         // Pass init tokens towards clockwise adjacent stretch
-        std::shared_ptr<LexCompInitToken> token = takeNodeToken<LexCompInitToken>(predecessor->nextNodeDir);
+        TokenPtr<LexCompInitToken> token = takeNodeToken<LexCompInitToken>(predecessor->nextNodeDir);
         int value = token->value;
-        passNodeToken<LexCompInitToken>(nextNodeDir, std::make_shared<LexCompInitToken>(-1, value));
+        passNodeToken<LexCompInitToken>(nextNodeDir, makeToken<LexCompInitToken>(-1, value));
       }
       if (hasNodeToken<LexCompAckToken>(successor->prevNodeDir)) {
         // Pass ack tokens towards head
         takeNodeToken<LexCompAckToken>(successor->prevNodeDir);
-        passNodeToken<LexCompAckToken>(prevNodeDir, std::make_shared<LexCompAckToken>());
+        passNodeToken<LexCompAckToken>(prevNodeDir, makeToken<LexCompAckToken>());
       }
       if (hasNodeToken<LexCompNackToken>(successor->prevNodeDir)) {
         // Pass nack tokens towards head
         takeNodeToken<LexCompNackToken>(successor->prevNodeDir);
-        passNodeToken<LexCompNackToken>(prevNodeDir, std::make_shared<LexCompNackToken>());
+        passNodeToken<LexCompNackToken>(prevNodeDir, makeToken<LexCompNackToken>());
       }
       if (hasNodeToken<LexCompInterruptLeftToken>(successor->prevNodeDir)) {
         // Pass interrupt tokens in counter-clockwise direction
         takeNodeToken<LexCompInterruptLeftToken>(successor->prevNodeDir);
-        passNodeToken<LexCompInterruptLeftToken>(prevNodeDir, std::make_shared<LexCompInterruptLeftToken>());
+        passNodeToken<LexCompInterruptLeftToken>(prevNodeDir, makeToken<LexCompInterruptLeftToken>());
       }
       if (hasNodeToken<LexCompInterruptRightToken>(predecessor->nextNodeDir)) {
         // Pass interrupt tokens in clockwise direction
         takeNodeToken<LexCompInterruptRightToken>(predecessor->nextNodeDir);
-        passNodeToken<LexCompInterruptRightToken>(nextNodeDir, std::make_shared<LexCompInterruptRightToken>());
+        passNodeToken<LexCompInterruptRightToken>(nextNodeDir, makeToken<LexCompInterruptRightToken>());
       }
       if (hasNodeToken<LexCompRetrieveNextLabelToken>(predecessor->nextNodeDir)) {
         // Pass retrieve internal label tokens
         takeNodeToken<LexCompRetrieveNextLabelToken>(predecessor->nextNodeDir);
         // If this node's label hasn't been retrieved yet, send it
         if (!retrieved) {
-          passNodeToken<LexCompNextLabelToken>(prevNodeDir, std::make_shared<LexCompNextLabelToken>(-1, unaryLabel));
+          passNodeToken<LexCompNextLabelToken>(prevNodeDir, makeToken<LexCompNextLabelToken>(-1, unaryLabel));
           retrieved = true;
         }
         // Otherwise pass the token
         else {
-          passNodeToken<LexCompRetrieveNextLabelToken>(nextNodeDir, std::make_shared<LexCompRetrieveNextLabelToken>());
+          passNodeToken<LexCompRetrieveNextLabelToken>(nextNodeDir, makeToken<LexCompRetrieveNextLabelToken>());
         }
       }
       if (hasNodeToken<LexCompRetrieveNextLabelForNbrToken>(predecessor->nextNodeDir)) {
@@ -2138,88 +2540,88 @@ void LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::activate
         takeNodeToken<LexCompRetrieveNextLabelForNbrToken>(predecessor->nextNodeDir);
         // If this node's label hasn't been retrieved yet, send it
         if (!retrievedForNbr) {
-          passNodeToken<LexCompNextLabelForNbrToken>(prevNodeDir, std::make_shared<LexCompNextLabelForNbrToken>(-1, unaryLabel));
+          passNodeToken<LexCompNextLabelForNbrToken>(prevNodeDir, makeToken<LexCompNextLabelForNbrToken>(-1, unaryLabel));
           retrievedForNbr = true;
         }
         // Otherwise pass the token
         else {
-          passNodeToken<LexCompRetrieveNextLabelForNbrToken>(nextNodeDir, std::make_shared<LexCompRetrieveNextLabelForNbrToken>());
+          passNodeToken<LexCompRetrieveNextLabelForNbrToken>(nextNodeDir, makeToken<LexCompRetrieveNextLabelForNbrToken>());
         }
       }
       if (hasNodeToken<LexCompNextLabelToken>(successor->prevNodeDir)) {
         // Pass retrieved internal labels towards the head
-        std::shared_ptr<LexCompNextLabelToken> token = takeNodeToken<LexCompNextLabelToken>(successor->prevNodeDir);
+        TokenPtr<LexCompNextLabelToken> token = takeNodeToken<LexCompNextLabelToken>(successor->prevNodeDir);
         int value = token->value;
-        passNodeToken<LexCompNextLabelToken>(prevNodeDir, std::make_shared<LexCompNextLabelToken>(-1, value));
+        passNodeToken<LexCompNextLabelToken>(prevNodeDir, makeToken<LexCompNextLabelToken>(-1, value));
       }
       if (hasNodeToken<LexCompNextLabelForNbrToken>(successor->prevNodeDir)) {
         // Pass retrieved internal labels towards the head
-        std::shared_ptr<LexCompNextLabelForNbrToken> token = takeNodeToken<LexCompNextLabelForNbrToken>(successor->prevNodeDir);
+        TokenPtr<LexCompNextLabelForNbrToken> token = takeNodeToken<LexCompNextLabelForNbrToken>(successor->prevNodeDir);
         int value = token->value;
-        passNodeToken<LexCompNextLabelForNbrToken>(prevNodeDir, std::make_shared<LexCompNextLabelForNbrToken>(-1, value));
+        passNodeToken<LexCompNextLabelForNbrToken>(prevNodeDir, makeToken<LexCompNextLabelForNbrToken>(-1, value));
       }
       if (hasNodeToken<LexCompEndOfStretchToken>(successor->prevNodeDir)) {
         // Pass internal end of stretch tokens towards the head
         takeNodeToken<LexCompEndOfStretchToken>(successor->prevNodeDir);
-        passNodeToken<LexCompEndOfStretchToken>(prevNodeDir, std::make_shared<LexCompEndOfStretchToken>());
+        passNodeToken<LexCompEndOfStretchToken>(prevNodeDir, makeToken<LexCompEndOfStretchToken>());
       }
       if (hasNodeToken<LexCompEndOfStretchForNbrToken>(successor->prevNodeDir)) {
         // Pass internal end of stretch tokens towards the head
         takeNodeToken<LexCompEndOfStretchForNbrToken>(successor->prevNodeDir);
-        passNodeToken<LexCompEndOfStretchForNbrToken>(prevNodeDir, std::make_shared<LexCompEndOfStretchForNbrToken>());
+        passNodeToken<LexCompEndOfStretchForNbrToken>(prevNodeDir, makeToken<LexCompEndOfStretchForNbrToken>());
       }
       if (hasNodeToken<LexCompReqStretchLabelToken>(predecessor->nextNodeDir)) {
         // Pass label requests towards the adjacent stretch
         takeNodeToken<LexCompReqStretchLabelToken>(predecessor->nextNodeDir);
-        passNodeToken<LexCompReqStretchLabelToken>(nextNodeDir, std::make_shared<LexCompReqStretchLabelToken>());
+        passNodeToken<LexCompReqStretchLabelToken>(nextNodeDir, makeToken<LexCompReqStretchLabelToken>());
       }
       if (hasNodeToken<LexCompReturnStretchLabelToken>(successor->prevNodeDir)) {
         // Pass labels back towards the head of the stretch
-        std::shared_ptr<LexCompReturnStretchLabelToken> token = takeNodeToken<LexCompReturnStretchLabelToken>(successor->prevNodeDir);
+        TokenPtr<LexCompReturnStretchLabelToken> token = takeNodeToken<LexCompReturnStretchLabelToken>(successor->prevNodeDir);
         int value = token->value;
-        passNodeToken<LexCompReturnStretchLabelToken>(prevNodeDir, std::make_shared<LexCompReturnStretchLabelToken>(-1, value));
+        passNodeToken<LexCompReturnStretchLabelToken>(prevNodeDir, makeToken<LexCompReturnStretchLabelToken>(-1, value));
       }
       if (hasNodeToken<LexCompEndOfNbrStretchToken>(successor->prevNodeDir)) {
         // Pass the adjacent stretch's end of stretch token towards the head
         takeNodeToken<LexCompEndOfNbrStretchToken>(successor->prevNodeDir);
-        passNodeToken<LexCompEndOfNbrStretchToken>(prevNodeDir, std::make_shared<LexCompEndOfNbrStretchToken>());
+        passNodeToken<LexCompEndOfNbrStretchToken>(prevNodeDir, makeToken<LexCompEndOfNbrStretchToken>());
       }
       if (hasNodeToken<LexCompAttemptMergeToken>(predecessor->nextNodeDir)) {
         // Pass merge attempt tokens towards tail
-        std::shared_ptr<LexCompAttemptMergeToken> token = takeNodeToken<LexCompAttemptMergeToken>(predecessor->nextNodeDir);
+        TokenPtr<LexCompAttemptMergeToken> token = takeNodeToken<LexCompAttemptMergeToken>(predecessor->nextNodeDir);
         int value = token->value;
-        passNodeToken<LexCompAttemptMergeToken>(nextNodeDir, std::make_shared<LexCompAttemptMergeToken>(-1, value));
+        passNodeToken<LexCompAttemptMergeToken>(nextNodeDir, makeToken<LexCompAttemptMergeToken>(-1, value));
       }
 
       // Pass count and merge tokens
       if (hasNodeToken<CountToken>(predecessor->nextNodeDir)) {
         // Pass on count tokens towards the tail
-        std::shared_ptr<CountToken> token = takeNodeToken<CountToken>(predecessor->nextNodeDir);
+        TokenPtr<CountToken> token = takeNodeToken<CountToken>(predecessor->nextNodeDir);
         int value = token->value;
-        passNodeToken<CountToken>(nextNodeDir, std::make_shared<CountToken>(-1, value));
+        passNodeToken<CountToken>(nextNodeDir, makeToken<CountToken>(-1, value));
       }
       if (hasNodeToken<CountReturnToken>(successor->prevNodeDir)) {
         // Pass on count return tokens towards the head
-        std::shared_ptr<CountReturnToken> token = takeNodeToken<CountReturnToken>(successor->prevNodeDir);
+        TokenPtr<CountReturnToken> token = takeNodeToken<CountReturnToken>(successor->prevNodeDir);
         int value = token->value;
-        passNodeToken<CountReturnToken>(prevNodeDir, std::make_shared<CountReturnToken>(-1, value));
+        passNodeToken<CountReturnToken>(prevNodeDir, makeToken<CountReturnToken>(-1, value));
       }
       if (hasNodeToken<AttemptMergeToken>(predecessor->nextNodeDir)) {
         // Pass on merge attempt tokens towards the tail
-        std::shared_ptr<AttemptMergeToken> token = takeNodeToken<AttemptMergeToken>(predecessor->nextNodeDir);
+        TokenPtr<AttemptMergeToken> token = takeNodeToken<AttemptMergeToken>(predecessor->nextNodeDir);
         int value = token->value;
-        passNodeToken<AttemptMergeToken>(nextNodeDir, std::make_shared<AttemptMergeToken>(-1, value));
+        passNodeToken<AttemptMergeToken>(nextNodeDir, makeToken<AttemptMergeToken>(-1, value));
       }
       if (hasNodeToken<MergeNackToken>(successor->prevNodeDir)) {
         // Pass on merge nack tokens towards the head
         takeNodeToken<MergeNackToken>(successor->prevNodeDir);
-        passNodeToken<MergeNackToken>(prevNodeDir, std::make_shared<MergeNackToken>());
+        passNodeToken<MergeNackToken>(prevNodeDir, makeToken<MergeNackToken>());
       }
       if (hasNodeToken<MergeCountToken>(successor->prevNodeDir)) {
         // Pass on merge count tokens towards the head
-        std::shared_ptr<MergeCountToken> token = takeNodeToken<MergeCountToken>(successor->prevNodeDir);
+        TokenPtr<MergeCountToken> token = takeNodeToken<MergeCountToken>(successor->prevNodeDir);
         int value = token->value;
-        passNodeToken<MergeCountToken>(prevNodeDir, std::make_shared<MergeCountToken>(-1, value));
+        passNodeToken<MergeCountToken>(prevNodeDir, makeToken<MergeCountToken>(-1, value));
       }
     }
   }
@@ -2237,7 +2639,7 @@ void LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::lexCompC
   lexicographicComparisonRight = false;
   retrieved = false;
   if (successor != nullptr) {
-    passNodeToken<LexCompCleanUpToken>(nextNodeDir, std::make_shared<LexCompCleanUpToken>());
+    passNodeToken<LexCompCleanUpToken>(nextNodeDir, makeToken<LexCompCleanUpToken>());
   }
   countSent = false;
   while (hasNodeToken<LexCompReturnStretchLabelToken>(nextNode()->prevNodeDir)) {
@@ -2270,7 +2672,7 @@ void LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::lexCompC
   lexicographicComparisonLeft = false;
   retrievedForNbr = false;
   if (successor != nullptr) {
-    passNodeToken<LexCompCleanUpForNbrToken>(nextNodeDir, std::make_shared<LexCompCleanUpForNbrToken>());
+    passNodeToken<LexCompCleanUpForNbrToken>(nextNodeDir, makeToken<LexCompCleanUpForNbrToken>());
   }
   while (hasNodeToken<LexCompNextLabelForNbrToken>(nextNode()->prevNodeDir)) {
     takeNodeToken<LexCompNextLabelForNbrToken>(nextNode()->prevNodeDir);
@@ -2331,18 +2733,18 @@ hasNodeToken(int dir, bool checkClone) const{
       return true;
     }
   }
-  auto prop = [dir,this](const std::shared_ptr<TokenType> token) {
+  auto prop = [dir,this](const TokenPtr<TokenType> token) {
     return token->origin == dir && token->destination == nodeDir;
   };
   return particle->hasToken<TokenType>(prop);
 }
 
 template <class TokenType>
-std::shared_ptr<TokenType>
+TokenPtr<TokenType>
 LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::
 peekNodeToken(int dir, bool checkClone) const {
   if (hasNodeToken<TokenType>(dir, false)) {
-    auto prop = [dir,this](const std::shared_ptr<TokenType> token) {
+    auto prop = [dir,this](const TokenPtr<TokenType> token) {
       return token->origin == dir && token->destination == nodeDir;
     };
     return particle->peekAtToken<TokenType>(prop);
@@ -2377,11 +2779,11 @@ peekNodeToken(int dir, bool checkClone) const {
 }
 
 template <class TokenType>
-std::shared_ptr<TokenType>
+TokenPtr<TokenType>
 LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::
 takeNodeToken(int dir, bool checkClone) {
   if (hasNodeToken<TokenType>(dir, false)) {
-    auto prop = [dir,this](const std::shared_ptr<TokenType> token) {
+    auto prop = [dir,this](const TokenPtr<TokenType> token) {
       return token->origin == dir && token->destination == nodeDir;
     };
     return particle->takeToken<TokenType>(prop);
@@ -2415,9 +2817,16 @@ takeNodeToken(int dir, bool checkClone) {
   }
 }
 
+template <class TokenType, class... Args>
+TokenPtr<TokenType>
+LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::makeToken(
+    Args&&... args) const {
+  return particle->makeToken<TokenType>(std::forward<Args>(args)...);
+}
+
 template <class TokenType>
 void LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::
-passNodeToken(int dir, std::shared_ptr<TokenType> token, bool checkClone) {
+passNodeToken(int dir, TokenPtr<TokenType> token, bool checkClone) {
   int dest = dir;
   LeaderElectionStationaryDeterministicParticle* nbr;
   if (dir == nextNodeDir) {
@@ -2563,50 +2972,33 @@ LeaderElectionStationaryDeterministicParticle::LeaderElectionNode::prevNode(bool
 //----------------------------BEGIN SYSTEM CODE----------------------------
 
 #include <string>
-#include <fstream>
-#include <sstream>
+#include <map>
 #include <QTextStream>
 
 using namespace std;
 
-LeaderElectionStationaryDeterministicSystem::LeaderElectionStationaryDeterministicSystem(int numParticles, QString fileName) {
+LeaderElectionStationaryDeterministicSystem::LeaderElectionStationaryDeterministicSystem(int numParticles, QString fileName, const unsigned int seed)
+  : AmoebotSystem(seed) {
   Q_ASSERT(numParticles > 0 || fileName.size() > 0);
 
   randomPermutationScheduler = true;
 
-  string filePath = "../AmoebotSim/data/input/" + fileName.toStdString() + ".txt";
   if (fileName != "") {
     QTextStream out(stdout);
     out << "File name: " << fileName << endl;
-    ifstream file(filePath);
-    if (!file) {
-      out << "Cannot open file." << endl;
+    std::vector<ConfigurationRecord> records;
+    QString error;
+    if (!readConfiguration(inputConfigurationPath(fileName), records, error)) {
+      out << error << endl;
       return;
     }
     out << "File opened." << endl;
-    
-    string str;
-    while (getline(file, str)) {
-      std::vector<int> vect;
-      std::stringstream ss(str);
-
-      while (ss.good()) {
-        string substr;
-        getline(ss, substr, ',');
-        vect.push_back(std::stoi(substr));
-      }
-
-      int x = vect[0];
-      int y = vect[1];
-
-      insert(new LeaderElectionStationaryDeterministicParticle(
-      Node(x, y), -1, randDir(), *this,
-      LeaderElectionStationaryDeterministicParticle::State::IdentificationLabeling));
-    }
 
-    file.close();
+    emplaceParticles<LeaderElectionStationaryDeterministicParticle>(
+        records,
+        LeaderElectionStationaryDeterministicParticle::State::IdentificationLabeling);
 
-    outputPath = "../AmoebotSim/data/output/" + fileName.toStdString() + ".txt";
+    inputName = fileName;
 
     out << "Particle system initialized from file." << endl;
     
@@ -2614,9 +3006,9 @@ LeaderElectionStationaryDeterministicSystem::LeaderElectionStationaryDeterminist
   }
 
   // Insert the seed at (0,0).
-  insert(new LeaderElectionStationaryDeterministicParticle(
+  emplaceParticle<LeaderElectionStationaryDeterministicParticle>(
       Node(0, 0), -1, randDir(), *this,
-      LeaderElectionStationaryDeterministicParticle::State::IdentificationLabeling));
+      LeaderElectionStationaryDeterministicParticle::State::IdentificationLabeling);
   std::set<Node> occupied;
   occupied.insert(Node(0, 0));
 
@@ -2646,9 +3038,9 @@ LeaderElectionStationaryDeterministicSystem::LeaderElectionStationaryDeterminist
         }
         if (switches <= 2) {
           occupied.insert(nbr);
-          insert(new LeaderElectionStationaryDeterministicParticle(
+          emplaceParticle<LeaderElectionStationaryDeterministicParticle>(
               nbr, -1, randDir(), *this,
-              LeaderElectionStationaryDeterministicParticle::State::IdentificationLabeling));
+              LeaderElectionStationaryDeterministicParticle::State::IdentificationLabeling);
           ++added;
           if (added == numParticles) {
             break;
@@ -2661,36 +3053,103 @@ LeaderElectionStationaryDeterministicSystem::LeaderElectionStationaryDeterminist
 
 bool LeaderElectionStationaryDeterministicSystem::hasTerminated() const {
 #ifdef QT_DEBUG
-  if (!isConnected(particles)) {
+  if (!isConnected(snapshot())) {
     return true;
   }
 #endif
 
+  using State = LeaderElectionStationaryDeterministicParticle::State;
+  if (numParticlesInState(static_cast<unsigned char>(State::Leader)) +
+      numParticlesInState(static_cast<unsigned char>(State::Finished)) == 0) {
+    return false;
+  }
+
+  return true;
+}
+
+bool LeaderElectionStationaryDeterministicSystem::supportsParallelRounds() const {
+  return true;
+}
+
+bool LeaderElectionStationaryDeterministicSystem::reportsResults() const {
+  return true;
+}
+
+void LeaderElectionStationaryDeterministicSystem::writeResult(
+    ResultRow& row) const {
+  using State = LeaderElectionStationaryDeterministicParticle::State;
+  row.input = inputName;
   for (auto p : particles) {
-    auto hp = dynamic_cast<LeaderElectionStationaryDeterministicParticle *>(p);
-    if (hp->state == LeaderElectionStationaryDeterministicParticle::State::Leader || hp->state == LeaderElectionStationaryDeterministicParticle::State::Finished) {
-      if (outputPath != "") {
-        ofstream file;
-        file.open(outputPath);
-        if (hp->state == LeaderElectionStationaryDeterministicParticle::State::Leader) {
-          file << std::to_string(hp->head.x) << "," << std::to_string(hp->head.y);
-        }
-        else {
-           file << "N/A";
-        }
+    auto hp = dynamic_cast<LeaderElectionStationaryDeterministicParticle*>(p);
+    if (hp->state == State::Leader) {
+      row.hasLeader = true;
+      row.leaderX = hp->head.x;
+      row.leaderY = hp->head.y;
+      return;
+    }
+  }
+}
 
-        file << "\n" << std::to_string(getCount("# Rounds")._value);
-        file << "\n" << std::to_string(getCount("# Activations")._value);
-        file << "\n" << std::to_string(getCount("# Moves")._value);
+bool LeaderElectionStationaryDeterministicSystem::supportsCheckpoints() const {
+  return true;
+}
 
-        file.close();
+void LeaderElectionStationaryDeterministicSystem::writeAlgorithmState(
+    CheckpointWriter& out) const {
+  using LENode = LeaderElectionStationaryDeterministicParticle::LeaderElectionNode;
+  map<const LENode*, pair<int, int>> refs;
+  for (unsigned int i = 0; i < particles.size(); ++i) {
+    auto hp = dynamic_cast<LeaderElectionStationaryDeterministicParticle *>(
+        particles[i]);
+    for (unsigned int j = 0; j < hp->nodes.size(); ++j) {
+      refs[hp->nodes[j]] = make_pair(i, j);
+    }
+  }
 
-        QTextStream out(stdout);
-        out << "Output written to: " << QString::fromStdString(outputPath) << endl;
-      }
-      return true;
+  const auto writeRef = [&out, &refs](const LENode* node) {
+    pair<int, int> ref(-1, -1);
+    if (node != nullptr) {
+      Q_ASSERT(refs.count(node) == 1);
+      ref = refs.at(node);
+    }
+    out.writeInt(ref.first);
+    out.writeInt(ref.second);
+  };
+  for (auto p : particles) {
+    auto hp = dynamic_cast<LeaderElectionStationaryDeterministicParticle *>(p);
+    for (const LENode* node : hp->nodes) {
+      writeRef(node->predecessor);
+      writeRef(node->successor);
     }
   }
+}
 
-  return false;
-}
\ No newline at end of file
+void LeaderElectionStationaryDeterministicSystem::readAlgorithmState(
+    CheckpointReader& in) {
+  using LENode = LeaderElectionStationaryDeterministicParticle::LeaderElectionNode;
+  const auto readRef = [this, &in]() -> LENode* {
+    const int i = in.readInt();
+    const int j = in.readInt();
+    if (i == -1 && j == -1) {
+      return nullptr;
+    }
+    if (i < 0 || i >= static_cast<int>(particles.size()) || j < 0) {
+      in.fail();
+      return nullptr;
+    }
+    auto hp = dynamic_cast<LeaderElectionStationaryDeterministicParticle *>(
+        particles[i]);
+    if (j >= static_cast<int>(hp->nodes.size())) {
+      in.fail();
+      return nullptr;
+    }
+    return hp->nodes[j];
+  };
+  for (auto p : particles) {
+    auto hp = dynamic_cast<LeaderElectionStationaryDeterministicParticle *>(p);
+    for (LENode* node : hp->nodes) {
+      node->predecessor = readRef();
+      node->successor = readRef();
+    }
+  }
+}
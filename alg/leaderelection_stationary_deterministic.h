@@ -12,6 +12,7 @@
 #define AMOEBOTSIM_ALG_LEADERELECTION_STATIONARY_DETERMINISTIC_H_
 
 #include <array>
+#include <typeinfo>
 #include <vector>
 
 #include <QString>
@@ -36,6 +37,10 @@ public:
 
   State state;
 
+  // Sets this particle's state and publishes it as its snapshot state, so
+  // that the system can count the particles in each state.
+  void setState(State state);
+
   // Variables for "trees to break symmetry" phase
 
   // Stores the direction to the next particle of the stretch
@@ -167,6 +172,16 @@ public:
   set<std::vector<int>> getMaxNonDescSubSeq(std::vector<int> input);
 
 protected:
+  // Functions for checkpoints (see AmoebotParticle::writeState). writeState and
+  // readState cover the particle memory above and its nodes, except for the
+  // nodes' predecessors and successors, which may be nodes of other particles
+  // and are restored by the system once all nodes exist. Tokens are written as
+  // their type's index in tokenCodecs() followed by their fields.
+  void writeState(CheckpointWriter& out) const override;
+  void readState(CheckpointReader& in) override;
+  void writeToken(CheckpointWriter& out, const Token& token) const override;
+  TokenPtr<Token> readToken(CheckpointReader& in) override;
+
   // The LeaderElectionToken struct provides a general framework of any token
   // under the General Leader Election algorithm.
   struct LeaderElectionToken : public Token {
@@ -501,6 +516,7 @@ protected:
     };
 
     LeaderElectionNode();
+    virtual ~LeaderElectionNode() = default;
 
     /* General variables in node memory:
      * From the particle's perspective, this node is on the border with the 
@@ -617,15 +633,34 @@ protected:
     template <class TokenType>
     bool hasNodeToken(int dir, bool checkClone=true) const;
     template <class TokenType>
-    std::shared_ptr<TokenType> peekNodeToken(int dir, bool checkClone=true) const;
+    TokenPtr<TokenType> peekNodeToken(int dir, bool checkClone=true) const;
     template <class TokenType>
-    std::shared_ptr<TokenType> takeNodeToken(int dir, bool checkClone=true);
+    TokenPtr<TokenType> takeNodeToken(int dir, bool checkClone=true);
     template <class TokenType>
-    void passNodeToken(int dir, std::shared_ptr<TokenType> token, bool checkClone=true);
+    void passNodeToken(int dir, TokenPtr<TokenType> token, bool checkClone=true);
+    template <class TokenType, class... Args>
+    TokenPtr<TokenType> makeToken(Args&&... args) const;
     LeaderElectionNode* nextNode(bool recursion=false) const;
     LeaderElectionNode* prevNode(bool recursion=false) const;
   };
 
+  // Writes and reads the tokens of one type in checkpoints. tokenCodecs lists
+  // one codec per token type of this algorithm; a type's index in this list is
+  // its tag in checkpoints, so new types must be appended.
+  struct TokenCodec {
+    const std::type_info* type;
+    void (*write)(CheckpointWriter& out, const Token& token);
+    TokenPtr<Token> (LeaderElectionStationaryDeterministicParticle::*read)(
+        CheckpointReader& in);
+  };
+  static const std::vector<TokenCodec>& tokenCodecs();
+  template <class TokenType>
+  static TokenCodec codecOf();
+  template <class TokenType>
+  static void writeTokenOf(CheckpointWriter& out, const Token& token);
+  template <class TokenType>
+  TokenPtr<Token> readTokenOf(CheckpointReader& in);
+
   protected:
    std::vector<LeaderElectionNode*> nodes = {};
    std::array<int, 18> borderColorLabels;
@@ -640,12 +675,37 @@ public:
   // specified size (#particles), and hole probability. holeProb in [0,1]
   // controls how "spread out" the system is; closer to 0 is more compressed,
   // closer to 1 is more expanded.
-  LeaderElectionStationaryDeterministicSystem(int numParticles = 100, QString fileName = "");
-
-  string outputPath = "";
+  LeaderElectionStationaryDeterministicSystem(int numParticles = 100, QString fileName = "", const unsigned int seed = 0);
 
   // Checks whether or not the system's run of the Leader Election algorithm has
   // terminated (all particles in state Finished or Leader).
   bool hasTerminated() const override;
+
+  // Activations only involve a particle and its neighbors, so this system can
+  // be run in parallel rounds.
+  bool supportsParallelRounds() const override;
+
+  // Results report the elected leader, so they are kept from GUI runs too.
+  bool reportsResults() const override;
+
+  // Particles checkpoint their memory, nodes, and tokens, so this system
+  // supports checkpoints.
+  bool supportsCheckpoints() const override;
+
+ protected:
+  // Writes (respectively, reads) the predecessors and successors of all
+  // particles' nodes, each as the index of its particle in particles and its
+  // index in that particle's nodes.
+  void writeAlgorithmState(CheckpointWriter& out) const override;
+  void readAlgorithmState(CheckpointReader& in) override;
+
+  // Reports the input configuration the system was loaded from and the
+  // position of the elected leader, if any.
+  void writeResult(ResultRow& row) const override;
+
+ private:
+  // The name of the input configuration the system was loaded from, or
+  // empty.
+  QString inputName;
 };
 #endif // AMOEBOTSIM_ALG_LEADERELECTION_STATIONARY_DETERMINISTIC_H_
\ No newline at end of file
@@ -17,11 +17,17 @@ ShapeFormationParticle::ShapeFormationParticle(const Node head,
     constructionDir(-1),
     moveDir(-1),
     followDir(-1) {
+  setSnapshotState(static_cast<unsigned char>(state));
   if (state == State::Seed) {
     constructionDir = 0;
   }
 }
 
+void ShapeFormationParticle::setState(State state) {
+  this->state = state;
+  setSnapshotState(static_cast<unsigned char>(state));
+}
+
 void ShapeFormationParticle::activate() {
   if (isExpanded()) {
     if (state == State::Follow) {
@@ -39,21 +45,26 @@ void ShapeFormationParticle::activate() {
       Q_ASSERT(false);
     }
   } else {
-    if (state == State::Seed) {
+    if (state == State::Seed || state == State::Finish) {
+      // The seed and finished particles never act again.
+      sleep();
       return;
     } else if (state == State::Idle) {
       if (hasNbrInState({State::Seed, State::Finish})) {
-        state = State::Lead;
+        setState(State::Lead);
         updateMoveDir();
         return;
       } else if (hasNbrInState({State::Lead, State::Follow})) {
-        state = State::Follow;
+        setState(State::Follow);
         followDir = labelOfFirstNbrInState({State::Lead, State::Follow});
         return;
       }
+      // Nothing changes until a neighbor arrives or changes its state, either
+      // of which wakes this particle.
+      sleep();
     } else if (state == State::Follow) {
       if (hasNbrInState({State::Seed, State::Finish})) {
-        state = State::Lead;
+        setState(State::Lead);
         updateMoveDir();
         return;
       } else if (hasTailAtLabel(followDir)) {
@@ -65,7 +76,7 @@ void ShapeFormationParticle::activate() {
       }
     } else if (state == State::Lead) {
       if (canFinish()) {
-        state = State::Finish;
+        setState(State::Finish);
         updateConstructionDir();
         return;
       } else {
@@ -301,7 +312,9 @@ bool ShapeFormationParticle::hasTailFollower() const {
 }
 
 ShapeFormationSystem::ShapeFormationSystem(int numParticles, double holeProb,
-                                           QString mode) {
+                                           QString mode,
+                                           const unsigned int seed)
+  : AmoebotSystem(seed) {
   Q_ASSERT(mode == "h" || mode == "s" || mode == "t1" || mode == "t2" ||
            mode == "l");
   Q_ASSERT(numParticles > 0);
@@ -309,8 +322,9 @@ ShapeFormationSystem::ShapeFormationSystem(int numParticles, double holeProb,
 
   // Insert the seed at (0,0).
   std::set<Node> occupied;
-  insert(new ShapeFormationParticle(Node(0, 0), -1, randDir(), *this,
-                                    ShapeFormationParticle::State::Seed, mode));
+  emplaceParticle<ShapeFormationParticle>(
+      Node(0, 0), -1, randDir(), *this, ShapeFormationParticle::State::Seed,
+      mode);
   occupied.insert(Node(0, 0));
 
   std::set<Node> candidates;
@@ -336,9 +350,9 @@ ShapeFormationSystem::ShapeFormationSystem(int numParticles, double holeProb,
 
     // With probability 1 - holeProb, add a new particle at the candidate node.
     if (randBool(1.0 - holeProb)) {
-      insert(new ShapeFormationParticle(randCand, -1, randDir(), *this,
-                                        ShapeFormationParticle::State::Idle,
-                                        mode));
+      emplaceParticle<ShapeFormationParticle>(
+          randCand, -1, randDir(), *this, ShapeFormationParticle::State::Idle,
+          mode);
       occupied.insert(randCand);
       particlesAdded++;
 
@@ -354,20 +368,15 @@ ShapeFormationSystem::ShapeFormationSystem(int numParticles, double holeProb,
 
 bool ShapeFormationSystem::hasTerminated() const {
   #ifdef QT_DEBUG
-    if (!isConnected(particles)) {
+    if (!isConnected(snapshot())) {
       return true;
     }
   #endif
 
-  for (auto p : particles) {
-    auto hp = dynamic_cast<ShapeFormationParticle*>(p);
-    if (hp->state != ShapeFormationParticle::State::Seed &&
-        hp->state != ShapeFormationParticle::State::Finish) {
-      return false;
-    }
-  }
-
-  return true;
+  using State = ShapeFormationParticle::State;
+  return numParticlesInState(static_cast<unsigned char>(State::Seed)) +
+         numParticlesInState(static_cast<unsigned char>(State::Finish)) ==
+         size();
 }
 
 std::set<QString> ShapeFormationSystem::getAcceptedModes() {
@@ -92,6 +92,10 @@ class ShapeFormationParticle : public AmoebotParticle {
   bool hasTailFollower() const;
 
  protected:
+  // Sets this particle's state and publishes it as its snapshot state, so
+  // that the system can count the particles in each state.
+  void setState(State state);
+
   State state;
   QString mode;
   int turnSignal;
@@ -115,7 +119,7 @@ class ShapeFormationSystem : public AmoebotSystem  {
   //   "t2" --> center triangle
   //   "l"  --> line
   ShapeFormationSystem(int numParticles = 200, double holeProb = 0.2,
-                       QString mode = "h");
+                       QString mode = "h", const unsigned int seed = 0);
 
   // Checks whether or not the system's run of the ShapeFormation formation
   // algorithm has terminated (all particles in state Finish).
@@ -0,0 +1,16 @@
+QT       = core
+CONFIG  += c++11 console
+CONFIG  -= app_bundle
+TARGET    = amoebotsim-cli
+TEMPLATE  = app
+
+include(../AmoebotSimCore.pri)
+
+HEADERS += \
+    clirunner.h \
+    replicarunner.h
+
+SOURCES += \
+    clirunner.cpp \
+    main.cpp \
+    replicarunner.cpp
@@ -0,0 +1,230 @@
+/* Copyright (C) 2020 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+#include "cli/clirunner.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <QElapsedTimer>
+#include <QMetaMethod>
+#include <QVariant>
+
+#include "core/activationtrace.h"
+#include "core/asyncscheduler.h"
+#include "core/parallelroundscheduler.h"
+
+const AlgorithmList& CliRunner::getAlgorithmList() const {
+  return algorithms;
+}
+
+std::shared_ptr<System> CliRunner::instantiate(const QString signature,
+                                               const QStringList params,
+                                               QString& error) const {
+  Algorithm* alg = algorithms.getAlgBySignature(signature);
+  if (alg == nullptr) {
+    error = "unknown algorithm signature: " + signature;
+    return nullptr;
+  }
+
+  const QStringList defaults = alg->getParameterDefaults();
+  if (params.size() > defaults.size()) {
+    error = signature + " takes at most " + QString::number(defaults.size()) +
+            " parameters";
+    return nullptr;
+  }
+
+  // moc registers one instantiate() overload per number of defaulted
+  // parameters; use the one taking every parameter.
+  const QMetaObject* meta = alg->metaObject();
+  QMetaMethod method;
+  for (int i = meta->methodOffset(); i < meta->methodCount(); ++i) {
+    const QMetaMethod candidate = meta->method(i);
+    if (candidate.name() == "instantiate" &&
+        candidate.parameterCount() == defaults.size()) {
+      method = candidate;
+      break;
+    }
+  }
+  if (!method.isValid() || defaults.size() > 10) {
+    error = signature + " cannot be instantiated from the command line";
+    return nullptr;
+  }
+
+  // Convert the parameter strings to the types instantiate() expects.
+  std::vector<QVariant> values;
+  for (int i = 0; i < defaults.size(); ++i) {
+    const QString value = (i < params.size()) ? params[i] : defaults[i];
+    QVariant variant(value);
+    if (!variant.convert(method.parameterType(i))) {
+      error = "invalid value for " + alg->getParameterNames()[i] + ": " + value;
+      return nullptr;
+    }
+    values.push_back(variant);
+  }
+  QGenericArgument args[10];
+  for (unsigned int i = 0; i < values.size(); ++i) {
+    args[i] = QGenericArgument(values[i].typeName(), values[i].constData());
+  }
+
+  // The algorithm reports the new system (or a parameter error) by signal.
+  std::shared_ptr<System> system;
+  auto onSystem = QObject::connect(alg, &Algorithm::setSystem,
+                                   [&system](std::shared_ptr<System> s) {
+                                     system = s;
+                                   });
+  auto onLog = QObject::connect(alg, &Algorithm::log,
+                                [&error](const QString msg, bool isError) {
+                                  if (isError) {
+                                    error = msg;
+                                  }
+                                });
+  method.invoke(alg, Qt::DirectConnection, args[0], args[1], args[2], args[3],
+                args[4], args[5], args[6], args[7], args[8], args[9]);
+  QObject::disconnect(onSystem);
+  QObject::disconnect(onLog);
+
+  if (system == nullptr && error.isEmpty()) {
+    error = signature + " did not create a system";
+  }
+
+  return system;
+}
+
+CliRunner::RunResult CliRunner::run(System& system, const long long budget) {
+  RunResult result;
+  QElapsedTimer timer;
+  timer.start();
+
+  // Dormant particles are skipped, so activations are read off the system's
+  // count rather than the number of calls to activate.
+  const Count& activations = system.getCount("# Activations");
+  while (budget <= 0 || result.activations < budget) {
+    if (system.hasTerminated()) {
+      system.reportResult();
+      result.terminated = true;
+      break;
+    }
+    const unsigned int before = activations._value;
+    system.activate();
+    if (activations._value == before) {
+      result.dormant = true;
+      break;
+    }
+    result.activations++;
+  }
+
+  result.elapsedMs = timer.nsecsElapsed() / 1e6;
+
+  return result;
+}
+
+CliRunner::RunResult CliRunner::runParallelRounds(AmoebotSystem& system,
+                                                 const long long budget,
+                                                 const unsigned int numThreads) {
+  RunResult result;
+  QElapsedTimer timer;
+  timer.start();
+
+  // Dormant particles are skipped, so a round's activations are read off the
+  // system's count rather than its size.
+  const Count& activations = system.getCount("# Activations");
+  ParallelRoundScheduler scheduler(system, numThreads);
+  while (budget <= 0 || result.activations < budget) {
+    if (system.hasTerminated()) {
+      system.reportResult();
+      result.terminated = true;
+      break;
+    }
+    const unsigned int before = activations._value;
+    scheduler.runRound();
+    const unsigned int numActivations = activations._value - before;
+    if (numActivations == 0) {
+      result.dormant = true;
+      break;
+    }
+    result.activations += numActivations;
+  }
+
+  result.elapsedMs = timer.nsecsElapsed() / 1e6;
+
+  return result;
+}
+
+CliRunner::RunResult CliRunner::runAsync(AmoebotSystem& system,
+                                        const long long budget,
+                                        const unsigned int numThreads) {
+  RunResult result;
+  QElapsedTimer timer;
+  timer.start();
+
+  const Count& activations = system.getCount("# Activations");
+  AsyncScheduler scheduler(system, numThreads);
+  while (budget <= 0 || result.activations < budget) {
+    if (system.hasTerminated()) {
+      system.reportResult();
+      result.terminated = true;
+      break;
+    }
+    long long numActivations = std::max(system.size(), 1u);
+    if (budget > 0) {
+      numActivations = std::min(numActivations, budget - result.activations);
+    }
+    const unsigned int before = activations._value;
+    scheduler.run(numActivations);
+    if (activations._value == before) {
+      result.dormant = true;
+      break;
+    }
+    result.activations += activations._value - before;
+  }
+
+  result.elapsedMs = timer.nsecsElapsed() / 1e6;
+
+  return result;
+}
+
+bool CliRunner::replay(AmoebotSystem& system, const QString filePath,
+                       const long long budget, RunResult& result,
+                       QString& error) {
+  QElapsedTimer timer;
+  timer.start();
+
+  ActivationReplayer replayer;
+  if (!replayer.open(filePath, error)) {
+    return false;
+  }
+  const uint64_t numActivations =
+      (budget > 0) ? std::min<uint64_t>(budget, replayer.numActivations())
+                   : replayer.numActivations();
+  if (!replayer.seek(system, numActivations, error)) {
+    error = filePath + ": " + error;
+    return false;
+  }
+  result.activations = numActivations;
+  result.terminated = system.hasTerminated();
+  if (result.terminated) {
+    system.reportResult();
+  }
+  result.elapsedMs = timer.nsecsElapsed() / 1e6;
+
+  return true;
+}
+
+QString CliRunner::usage() const {
+  QString text;
+  for (const QString& name : algorithms.getAlgNames()) {
+    Algorithm* alg = algorithms.getAlg(name);
+    const QStringList names = alg->getParameterNames();
+    const QStringList defaults = alg->getParameterDefaults();
+
+    text += "  " + alg->getSignature() + " (" + name + "):";
+    for (int i = 0; i < names.size(); ++i) {
+      text += " [" + names[i] + " = \"" + defaults[i] + "\"]";
+    }
+    text += "\n";
+  }
+
+  return text;
+}
@@ -0,0 +1,85 @@
+/* Copyright (C) 2020 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+// Defines the headless runner behind amoebotsim-cli. It instantiates an
+// algorithm from the AlgorithmList by its signature and a list of parameter
+// strings, runs the resulting system without any GUI, and reports its metrics.
+
+#ifndef AMOEBOTSIM_CLI_CLIRUNNER_H_
+#define AMOEBOTSIM_CLI_CLIRUNNER_H_
+
+#include <memory>
+
+#include <QString>
+#include <QStringList>
+
+#include "core/amoebotsystem.h"
+#include "core/system.h"
+#include "ui/algorithm.h"
+
+class CliRunner {
+ public:
+  // The outcome of running a system: the number of activations executed,
+  // whether the system terminated (as opposed to exhausting its budget),
+  // whether it stopped because all its particles are dormant, in which case it
+  // will not change anymore, and the wall-clock time taken in milliseconds.
+  struct RunResult {
+    long long activations = 0;
+    bool terminated = false;
+    bool dormant = false;
+    double elapsedMs = 0;
+  };
+
+  // Returns the registry of algorithms the runner can instantiate.
+  const AlgorithmList& getAlgorithmList() const;
+
+  // Instantiates the algorithm with the given signature. The given parameters
+  // are matched, in order, to the parameters of the algorithm's instantiate()
+  // slot and converted to their types; missing trailing parameters take their
+  // default values. Returns nullptr and sets error on failure.
+  std::shared_ptr<System> instantiate(const QString signature,
+                                      const QStringList params,
+                                      QString& error) const;
+
+  // Activates the given system until it terminates, until all its particles
+  // are dormant, or, if budget > 0, until budget activations have been
+  // executed. Dormant particles are not counted as activated.
+  static RunResult run(System& system, const long long budget = 0);
+
+  // Runs the given system, which must support parallel rounds, in rounds on
+  // numThreads threads (0 uses one per core; see
+  // core/parallelroundscheduler.h) until it terminates, until all its
+  // particles are dormant, or, if budget > 0, until at least budget
+  // activations have been executed. Dormant particles are not counted as
+  // activated.
+  static RunResult runParallelRounds(AmoebotSystem& system,
+                                     const long long budget = 0,
+                                     const unsigned int numThreads = 0);
+
+  // Runs the given system, which must support parallel rounds, with concurrent
+  // asynchronous activations on numThreads threads (0 uses one per core; see
+  // core/asyncscheduler.h) until it terminates, until all its particles are
+  // dormant, or, if budget > 0, until budget activations have been executed.
+  // Termination is checked once per size() activations, and dormant particles
+  // are not counted as activated.
+  static RunResult runAsync(AmoebotSystem& system, const long long budget = 0,
+                            const unsigned int numThreads = 0);
+
+  // Replays the first budget activations (all of them if budget is 0) of the
+  // activation trace in the given file on the given system, which must have
+  // been instantiated with the same parameters as the recorded one (see
+  // core/activationtrace.h). Returns false and sets error on failure.
+  static bool replay(AmoebotSystem& system, const QString filePath,
+                     const long long budget, RunResult& result,
+                     QString& error);
+
+  // Lists every algorithm with its signature and its parameters' names and
+  // default values, one algorithm per line.
+  QString usage() const;
+
+ private:
+  AlgorithmList algorithms;
+};
+
+#endif  // AMOEBOTSIM_CLI_CLIRUNNER_H_
@@ -0,0 +1,646 @@
+/* AmoebotSim: a visual simulator for the amoebot model of programmable matter.
+ * Copyright (C) 2020 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * Please direct all questions and communications to sopslab@asu.edu.
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * AmoebotSim is developed using Open Source Qt. */
+
+// amoebotsim-cli: runs a single algorithm without the GUI, e.g.,
+//   amoebotsim-cli --budget 100000 --output metrics.json compression 100 4.0 42
+// instantiates Compression with 100 particles, lambda 4.0, and seed 42, runs it
+// until it terminates or has executed 100000 activations, and writes its
+// metrics JSON to metrics.json. A run summary is printed to stderr. With
+// --replicas N, N replicas with consecutive seeds run concurrently instead and
+// the statistics of their final counts are written (see replicarunner.h). With
+// --parallel-rounds, a single run executes in rounds whose non-interfering
+// activations run concurrently (see core/parallelroundscheduler.h); with
+// --async, its random activations run concurrently, each locking its
+// particle's neighborhood (see core/asyncscheduler.h). With --checkpoint, a
+// single run writes a binary checkpoint of its system when it ends and, with
+// --checkpoint-every, periodically while it runs; --restore continues the run
+// saved in a checkpoint, given the same signature and parameters. With
+// --record, a single sequential run writes the trace of its activations (see
+// core/activationtrace.h); --replay re-executes a prefix of such a trace
+// instead of running, e.g., to write a checkpoint of the system at a given
+// activation. With --metrics-stream, a single run also writes its counts and
+// measures round by round while it runs (see core/metricsink.h); --history
+// bounds the memory their histories take (see HistoryPolicy in core/metric.h).
+// With --results, every run that terminates appends a row with its counts and,
+// for leader election, its leader to a results table shared across runs (see
+// core/resultsink.h).
+
+#include <fstream>
+#include <functional>
+#include <memory>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
+
+#include "cli/clirunner.h"
+#include "cli/replicarunner.h"
+#include "core/activationtrace.h"
+#include "core/checkpoint.h"
+#include "core/metric.h"
+#include "core/metricsink.h"
+#include "core/resultsink.h"
+namespace {
+
+// The command line of amoebotsim-cli, parsed and checked for valid values.
+// Paths are empty for options that were not given.
+struct Options {
+  QString signature;
+  QStringList params;
+  long long budget = 0;
+  QString outputPath;
+  bool quiet = false;
+  int numReplicas = 1;
+  int numThreads = 0;
+  bool parallelRounds = false;
+  bool async = false;
+  QString checkpointPath;
+  long long checkpointEvery = 0;
+  QString restorePath;
+  QString recordPath;
+  long long keyframeEvery = 0;
+  QString replayPath;
+  QString metricsStreamPath;
+  QString metricsFormat;
+  unsigned int metricsFlushEvery = 0;
+  bool hasHistoryPolicy = false;
+  HistoryPolicy historyPolicy = HistoryPolicy::Full;
+  unsigned int historyCapacity = 0;
+  QString resultsPath;
+  QString resultsFormat;
+  unsigned int resultsBatch = 0;
+};
+
+// Parses the given history policy (see --history) into policy and capacity.
+// Returns false if it is not a valid policy.
+bool parseHistoryPolicy(const QString value, HistoryPolicy& policy,
+                        unsigned int& capacity) {
+  const QStringList spec = value.split(':');
+  policy = HistoryPolicy::Full;
+  capacity = 0;
+  if (spec[0] == "recent" || spec[0] == "decimated") {
+    policy = (spec[0] == "recent") ? HistoryPolicy::Recent
+                                   : HistoryPolicy::Decimated;
+    bool ok = (spec.size() == 2);
+    if (ok) {
+      capacity = spec[1].toUInt(&ok);
+    }
+    return ok && capacity >= 2;
+  } else if (spec[0] == "compressed") {
+    policy = HistoryPolicy::Compressed;
+  } else if (spec[0] != "full") {
+    return false;
+  }
+  return spec.size() == 1;
+}
+
+// Parses the command line into options. Returns false if amoebotsim-cli should
+// exit right away: with exit code 0 after listing the algorithms, or with
+// error describing an option with an invalid value.
+bool parseOptions(const QCoreApplication& app, const CliRunner& runner,
+                  Options& options, QString& error) {
+  QCommandLineParser parser;
+  parser.setApplicationDescription(
+      "Runs an AmoebotSim algorithm headlessly and writes its metrics as JSON."
+      "\n\nAlgorithms:\n" + runner.usage());
+  parser.addHelpOption();
+  QCommandLineOption listOption(
+      {"l", "list"}, "List the available algorithms and their parameters.");
+  QCommandLineOption budgetOption(
+      {"b", "budget"},
+      "Stop after <activations> activations (default: run until termination).",
+      "activations", "0");
+  QCommandLineOption outputOption(
+      {"o", "output"}, "Write the metrics to <file> instead of stdout.",
+      "file");
+  QCommandLineOption quietOption(
+      {"q", "quiet"}, "Do not print a run summary to stderr.");
+  QCommandLineOption replicasOption(
+      {"r", "replicas"},
+      "Run <n> replicas with consecutive seeds and write the statistics of "
+      "their counts instead of the metrics of a single run.",
+      "n", "1");
+  QCommandLineOption threadsOption(
+      {"j", "threads"},
+      "Run replicas, parallel rounds, or asynchronous activations on <n> "
+      "threads (default: one per core).",
+      "n", "0");
+  QCommandLineOption parallelOption(
+      {"p", "parallel-rounds"},
+      "Activate particles in rounds, running non-interfering activations in "
+      "parallel (only for algorithms that support it).");
+  QCommandLineOption asyncOption(
+      {"a", "async"},
+      "Activate random particles concurrently, locking each activated "
+      "particle's neighborhood (only for algorithms that support parallel "
+      "rounds).");
+  QCommandLineOption checkpointOption(
+      {"c", "checkpoint"},
+      "Write a checkpoint of the system to <file> when the run ends (only for "
+      "algorithms that support it).",
+      "file");
+  QCommandLineOption checkpointEveryOption(
+      "checkpoint-every",
+      "Also write the checkpoint every <activations> activations.",
+      "activations", "0");
+  QCommandLineOption restoreOption(
+      "restore",
+      "Continue the run saved in the checkpoint <file>, which must have been "
+      "written by the same algorithm with the same parameters.",
+      "file");
+  QCommandLineOption recordOption(
+      "record",
+      "Record the activations of the run to the trace <file> (only for single "
+      "sequential runs).",
+      "file");
+  QCommandLineOption keyframeEveryOption(
+      "keyframe-every",
+      "Store a keyframe of the system in the trace every <activations> "
+      "activations (only for algorithms that support checkpoints).",
+      "activations", "0");
+  QCommandLineOption replayOption(
+      "replay",
+      "Instead of running, replay the first <budget> activations (all of them "
+      "without a budget) of the trace <file>, which must have been recorded "
+      "with the same algorithm and parameters.",
+      "file");
+  QCommandLineOption metricsStreamOption(
+      "metrics-stream",
+      "Also write the counts and measures of every round to <file> while "
+      "running (only for single runs).",
+      "file");
+  QCommandLineOption metricsFormatOption(
+      "metrics-format",
+      "Write the metrics stream as <format>: jsonl, csv, or bin.",
+      "format", "jsonl");
+  QCommandLineOption metricsFlushEveryOption(
+      "metrics-flush-every",
+      "Write the metrics stream to its file every <rounds> rounds.",
+      "rounds", "1000");
+  QCommandLineOption historyOption(
+      "history",
+      "Store the history of every count and measure as <policy>: full (the "
+      "default), recent:<k> (only the last k values), decimated:<k> (at most "
+      "k values spread over the run), or compressed.",
+      "policy", "full");
+  QCommandLineOption resultsOption(
+      "results",
+      "Append the result of every run that terminates to the table <file>.",
+      "file");
+  QCommandLineOption resultsFormatOption(
+      "results-format",
+      "Write the results table as <format>: csv or bin.",
+      "format", "csv");
+  QCommandLineOption resultsBatchOption(
+      "results-batch",
+      "Append results to their table in batches of <rows> rows.",
+      "rows", "64");
+  parser.addOptions({listOption, budgetOption, outputOption, quietOption,
+                     replicasOption, threadsOption, parallelOption,
+                     asyncOption, checkpointOption, checkpointEveryOption,
+                     restoreOption, recordOption, keyframeEveryOption,
+                     replayOption, metricsStreamOption, metricsFormatOption,
+                     metricsFlushEveryOption, historyOption, resultsOption,
+                     resultsFormatOption, resultsBatchOption});
+  parser.addPositionalArgument("signature", "The algorithm to run.");
+  parser.addPositionalArgument("parameters",
+                               "The algorithm's parameters, in order.",
+                               "[parameters...]");
+  parser.process(app);
+
+  if (parser.isSet(listOption)) {
+    QTextStream(stdout) << runner.usage();
+    return false;
+  }
+
+  options.params = parser.positionalArguments();
+  if (options.params.isEmpty()) {
+    parser.showHelp(1);
+  }
+  options.signature = options.params.takeFirst();
+  options.outputPath = parser.value(outputOption);
+  options.quiet = parser.isSet(quietOption);
+  options.parallelRounds = parser.isSet(parallelOption);
+  options.async = parser.isSet(asyncOption);
+  options.checkpointPath = parser.value(checkpointOption);
+  options.restorePath = parser.value(restoreOption);
+  options.recordPath = parser.value(recordOption);
+  options.replayPath = parser.value(replayOption);
+  options.metricsStreamPath = parser.value(metricsStreamOption);
+  options.metricsFormat = parser.value(metricsFormatOption);
+  options.hasHistoryPolicy = parser.isSet(historyOption);
+  options.resultsPath = parser.value(resultsOption);
+  options.resultsFormat = parser.value(resultsFormatOption);
+
+  bool ok = false;
+  options.budget = parser.value(budgetOption).toLongLong(&ok);
+  if (!ok || options.budget < 0) {
+    error = "budget must be a nonnegative integer";
+    return false;
+  }
+
+  options.checkpointEvery =
+      parser.value(checkpointEveryOption).toLongLong(&ok);
+  if (!ok || options.checkpointEvery < 0) {
+    error = "checkpoint interval must be a nonnegative integer";
+    return false;
+  }
+
+  options.keyframeEvery = parser.value(keyframeEveryOption).toLongLong(&ok);
+  if (!ok || options.keyframeEvery < 0) {
+    error = "keyframe interval must be a nonnegative integer";
+    return false;
+  }
+
+  options.metricsFlushEvery =
+      parser.value(metricsFlushEveryOption).toUInt(&ok);
+  if (!ok || options.metricsFlushEvery == 0) {
+    error = "metrics flush interval must be a positive integer";
+    return false;
+  } else if (options.metricsFormat != "jsonl" &&
+             options.metricsFormat != "csv" &&
+             options.metricsFormat != "bin") {
+    error = "unknown metrics format " + options.metricsFormat;
+    return false;
+  }
+
+  options.resultsBatch = parser.value(resultsBatchOption).toUInt(&ok);
+  if (!ok || options.resultsBatch == 0) {
+    error = "results batch size must be a positive integer";
+    return false;
+  } else if (options.resultsFormat != "csv" &&
+             options.resultsFormat != "bin") {
+    error = "unknown results format " + options.resultsFormat;
+    return false;
+  }
+
+  if (!parseHistoryPolicy(parser.value(historyOption), options.historyPolicy,
+                          options.historyCapacity)) {
+    error = "history policy must be full, recent:<k> or decimated:<k> with "
+            "k >= 2, or compressed";
+    return false;
+  }
+
+  options.numReplicas = parser.value(replicasOption).toInt(&ok);
+  if (!ok || options.numReplicas <= 0) {
+    error = "# replicas must be > 0";
+    return false;
+  }
+  options.numThreads = parser.value(threadsOption).toInt(&ok);
+  if (!ok || options.numThreads < 0) {
+    error = "# threads must be >= 0";
+    return false;
+  }
+
+  return true;
+}
+
+// Checks that the given options can be combined. Returns false and describes
+// the conflict in error otherwise.
+bool checkCombinations(const Options& options, QString& error) {
+  const bool replicas = options.numReplicas > 1;
+  const bool traces =
+      !options.recordPath.isEmpty() || !options.replayPath.isEmpty();
+  if (options.checkpointEvery > 0 && options.checkpointPath.isEmpty()) {
+    error = "--checkpoint-every requires --checkpoint";
+  } else if (options.keyframeEvery > 0 && options.recordPath.isEmpty()) {
+    error = "--keyframe-every requires --record";
+  } else if (options.parallelRounds && options.async) {
+    error = "parallel rounds cannot be combined with async";
+  } else if ((options.parallelRounds || options.async) && replicas) {
+    error = "parallel rounds and async cannot be combined with replicas";
+  } else if ((!options.checkpointPath.isEmpty() ||
+              !options.restorePath.isEmpty()) && replicas) {
+    error = "checkpoints cannot be combined with replicas";
+  } else if (!options.metricsStreamPath.isEmpty() && replicas) {
+    error = "metrics streams cannot be combined with replicas";
+  } else if (options.hasHistoryPolicy && replicas) {
+    error = "history policies cannot be combined with replicas";
+  } else if (traces &&
+             (replicas || options.parallelRounds || options.async)) {
+    error = "traces cannot be combined with replicas, parallel rounds, or "
+            "async";
+  } else if (!options.replayPath.isEmpty() &&
+             (!options.recordPath.isEmpty() ||
+              !options.restorePath.isEmpty())) {
+    error = "--replay cannot be combined with --record or --restore";
+  } else {
+    return true;
+  }
+  return false;
+}
+
+// Instantiates the system of a single run and checks that it supports the
+// requested features. Then restores it from its checkpoint, sets its history
+// policy, and attaches it to the given result sink as the options request.
+// Returns nullptr and sets error on failure.
+std::shared_ptr<System> prepareSystem(const CliRunner& runner,
+                                      const Options& options,
+                                      ResultSink* resultSink,
+                                      QString& error) {
+  std::shared_ptr<System> system =
+      runner.instantiate(options.signature, options.params, error);
+  if (system == nullptr) {
+    return nullptr;
+  }
+
+  auto amoebotSystem = std::dynamic_pointer_cast<AmoebotSystem>(system);
+  const bool traces =
+      !options.recordPath.isEmpty() || !options.replayPath.isEmpty();
+  const bool checkpoints =
+      !options.checkpointPath.isEmpty() || !options.restorePath.isEmpty();
+  if (traces && amoebotSystem == nullptr) {
+    error = options.signature + " does not support traces";
+  } else if (!options.metricsStreamPath.isEmpty() &&
+             amoebotSystem == nullptr) {
+    error = options.signature + " does not support metrics streams";
+  } else if (options.hasHistoryPolicy && amoebotSystem == nullptr) {
+    error = options.signature + " does not support history policies";
+  } else if (checkpoints && (amoebotSystem == nullptr ||
+                             !amoebotSystem->supportsCheckpoints())) {
+    error = options.signature + " does not support checkpoints";
+  } else if ((options.parallelRounds || options.async) &&
+             (amoebotSystem == nullptr ||
+              !amoebotSystem->supportsParallelRounds())) {
+    error = options.signature + " does not support parallel rounds";
+  }
+  if (!error.isEmpty()) {
+    return nullptr;
+  }
+
+  if (resultSink != nullptr && amoebotSystem != nullptr) {
+    const QString label =
+        (options.signature + " " + options.params.join(" ")).trimmed();
+    amoebotSystem->setResultSink(resultSink, label);
+  }
+  if (options.hasHistoryPolicy) {
+    amoebotSystem->setHistoryPolicy(options.historyPolicy,
+                                    options.historyCapacity);
+  }
+  if (!options.restorePath.isEmpty() &&
+      !loadCheckpoint(*amoebotSystem, options.restorePath, error)) {
+    return nullptr;
+  }
+
+  return system;
+}
+
+// Replays the trace given in the options on the given system and writes its
+// checkpoint, if requested. Returns false and sets error on failure.
+bool replayTrace(AmoebotSystem& system, const Options& options,
+                 CliRunner::RunResult& result, QString& error) {
+  if (!CliRunner::replay(system, options.replayPath, options.budget, result,
+                         error)) {
+    return false;
+  }
+  return options.checkpointPath.isEmpty() ||
+         saveCheckpoint(system, options.checkpointPath, error);
+}
+
+// Runs the given system until it terminates or exhausts the budget, recording
+// its trace and writing its checkpoint as the options request. Returns false
+// and sets error on failure.
+bool runSystem(System& system, const Options& options,
+               CliRunner::RunResult& result, QString& error) {
+  auto amoebotSystem = dynamic_cast<AmoebotSystem*>(&system);
+
+  std::ofstream traceFile;
+  std::unique_ptr<ActivationRecorder> recorder;
+  if (!options.recordPath.isEmpty()) {
+    traceFile.open(options.recordPath.toStdString(),
+                   std::ios::binary | std::ios::trunc);
+    if (!traceFile) {
+      error = "cannot open " + options.recordPath + " for writing";
+      return false;
+    }
+    recorder.reset(new ActivationRecorder(*amoebotSystem, traceFile,
+                                          options.keyframeEvery));
+  }
+
+  // Run in slices of checkpointEvery activations, writing a checkpoint after
+  // each, or in a single slice. The budget counts the activations of this
+  // invocation, also when continuing a restored run.
+  const long long budget = options.budget;
+  do {
+    long long sliceBudget = (budget > 0) ? budget - result.activations : 0;
+    if (options.checkpointEvery > 0 &&
+        (sliceBudget == 0 || options.checkpointEvery < sliceBudget)) {
+      sliceBudget = options.checkpointEvery;
+    }
+
+    CliRunner::RunResult slice;
+    if (options.parallelRounds) {
+      slice = CliRunner::runParallelRounds(*amoebotSystem, sliceBudget,
+                                           options.numThreads);
+    } else if (options.async) {
+      slice = CliRunner::runAsync(*amoebotSystem, sliceBudget,
+                                  options.numThreads);
+    } else {
+      slice = CliRunner::run(system, sliceBudget);
+    }
+    result.activations += slice.activations;
+    result.terminated = slice.terminated;
+    result.dormant = slice.dormant;
+    result.elapsedMs += slice.elapsedMs;
+
+    if (!options.checkpointPath.isEmpty() &&
+        !saveCheckpoint(*amoebotSystem, options.checkpointPath, error)) {
+      return false;
+    }
+  } while (!result.terminated && !result.dormant &&
+           (budget <= 0 || result.activations < budget));
+
+  if (recorder != nullptr) {
+    recorder->finish();
+    if (recorder->failed()) {
+      error = "cannot write " + options.recordPath;
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// Writes the JSON output of a run to the given stream.
+using JSONWriter = std::function<void(QTextStream&)>;
+
+// Executes a single run as the options request, reporting its result to the
+// given sink (if any), and sets writeJSON to write its metrics and summary to a
+// summary of the run. Returns false and sets error on failure.
+bool runSingle(const CliRunner& runner, const Options& options,
+               ResultSink* resultSink, const QElapsedTimer& startup,
+               JSONWriter& writeJSON, QString& summary, QString& error) {
+  std::shared_ptr<System> system =
+      prepareSystem(runner, options, resultSink, error);
+  if (system == nullptr) {
+    return false;
+  }
+  auto amoebotSystem = std::dynamic_pointer_cast<AmoebotSystem>(system);
+  const double startupMs = startup.nsecsElapsed() / 1e6;
+
+  std::ofstream metricsFile;
+  std::unique_ptr<MetricSink> metricSink;
+  if (!options.metricsStreamPath.isEmpty()) {
+    metricsFile.open(options.metricsStreamPath.toStdString(),
+                     std::ios::binary | std::ios::trunc);
+    if (!metricsFile) {
+      error = "cannot open " + options.metricsStreamPath + " for writing";
+      return false;
+    }
+    metricSink = makeMetricSink(options.metricsFormat, metricsFile,
+                                options.metricsFlushEvery);
+    amoebotSystem->addMetricSink(metricSink.get());
+  }
+
+  CliRunner::RunResult result;
+  if (!options.replayPath.isEmpty()) {
+    if (!replayTrace(*amoebotSystem, options, result, error)) {
+      return false;
+    }
+    summary = QString("replayed %1 activations in %2 ms (startup %3 ms)")
+                  .arg(result.activations)
+                  .arg(result.elapsedMs)
+                  .arg(startupMs);
+  } else {
+    if (!runSystem(*system, options, result, error)) {
+      return false;
+    }
+    const QString outcome = result.terminated ? "terminated"
+                            : result.dormant  ? "all particles dormant"
+                                              : "stopped at budget";
+    summary = QString("%1 after %2 activations in %3 ms (startup %4 ms)")
+                  .arg(outcome)
+                  .arg(result.activations)
+                  .arg(result.elapsedMs)
+                  .arg(startupMs);
+  }
+  // The metrics are streamed into the output rather than built as a string
+  // first, since their histories may be long.
+  writeJSON = [system](QTextStream& out) { system->writeMetricsJSON(out); };
+
+  if (metricSink != nullptr) {
+    amoebotSystem->removeMetricSink(metricSink.get());
+    metricSink->flush();
+    if (metricSink->failed()) {
+      error = "cannot write " + options.metricsStreamPath;
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// Executes the replicas the options request, reporting their results to the
+// given sink (if any), and sets writeJSON to write their statistics and
+// summary to a summary of the runs. Returns false and sets error on failure.
+bool runReplicas(const Options& options, ResultSink* resultSink,
+                 JSONWriter& writeJSON, QString& summary, QString& error) {
+  ReplicaRunner::Result result;
+  if (!ReplicaRunner::run(options.signature, options.params,
+                          options.numReplicas, options.numThreads,
+                          options.budget, result, error, resultSink)) {
+    return false;
+  }
+  const QString json = ReplicaRunner::resultAsJSON(options.signature, result);
+  writeJSON = [json](QTextStream& out) { out << json; };
+  summary = QString("%1 of %2 replicas terminated in %3 ms")
+                .arg(result.numTerminated)
+                .arg(options.numReplicas)
+                .arg(result.elapsedMs);
+  return true;
+}
+
+// Writes JSON with the given writer to the output file of the options, or to
+// stdout if there is none. Returns false and sets error on failure.
+bool writeOutput(const Options& options, const JSONWriter& writeJSON,
+                 QString& error) {
+  if (options.outputPath.isEmpty()) {
+    QTextStream out(stdout);
+    writeJSON(out);
+    out << endl;
+    return true;
+  }
+
+  QFile outFile(options.outputPath);
+  if (!outFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
+    error = "cannot open " + outFile.fileName() + " for writing";
+    return false;
+  }
+  QTextStream outStream(&outFile);
+  writeJSON(outStream);
+  outStream.flush();
+  outFile.close();
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  QElapsedTimer startup;
+  startup.start();
+
+  QCoreApplication app(argc, argv);
+  QCoreApplication::setApplicationName("amoebotsim-cli");
+  QTextStream err(stderr);
+
+  CliRunner runner;
+  Options options;
+  QString error;
+  if (!parseOptions(app, runner, options, error) ||
+      !checkCombinations(options, error)) {
+    if (error.isEmpty()) {
+      return 0;
+    }
+    err << error << endl;
+    return 1;
+  }
+
+  std::unique_ptr<ResultSink> resultSink;
+  if (!options.resultsPath.isEmpty()) {
+    resultSink = makeResultSink(options.resultsFormat, options.resultsPath,
+                                options.resultsBatch);
+  }
+
+  JSONWriter writeJSON;
+  QString summary;
+  bool ok = (options.numReplicas == 1)
+                ? runSingle(runner, options, resultSink.get(), startup,
+                            writeJSON, summary, error)
+                : runReplicas(options, resultSink.get(), writeJSON, summary,
+                              error);
+  if (ok && resultSink != nullptr) {
+    resultSink->flush();
+    if (resultSink->failed()) {
+      error = "cannot write " + options.resultsPath;
+      ok = false;
+    }
+  }
+  if (!ok || !writeOutput(options, writeJSON, error)) {
+    err << error << endl;
+    return 1;
+  }
+
+  if (!options.quiet) {
+    err << options.signature << ": " << summary << endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,227 @@
+/* Copyright (C) 2020 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+#include "cli/replicarunner.h"
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <thread>
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+
+#include "core/metric.h"
+#include "helper/randomnumbergenerator.h"
+
+bool ReplicaRunner::run(const QString signature, const QStringList params,
+                        const int numReplicas, const int numThreads,
+                        const long long budget, Result& result,
+                        QString& error, ResultSink* resultSink) {
+  CliRunner runner;
+  Algorithm* alg = runner.getAlgorithmList().getAlgBySignature(signature);
+  if (alg == nullptr) {
+    error = "unknown algorithm signature: " + signature;
+    return false;
+  } else if (numReplicas <= 0) {
+    error = "# replicas must be > 0";
+    return false;
+  }
+
+  // Fill in the default parameters, so that the seed can be replaced.
+  const QStringList names = alg->getParameterNames();
+  const QStringList defaults = alg->getParameterDefaults();
+  const int seedIndex = names.indexOf("Seed");
+  if (seedIndex == -1) {
+    error = signature + " does not take a seed";
+    return false;
+  } else if (params.size() > names.size()) {
+    error = signature + " takes at most " + QString::number(names.size()) +
+            " parameters";
+    return false;
+  }
+  QStringList replicaParams = params;
+  while (replicaParams.size() < names.size()) {
+    replicaParams.append(defaults[replicaParams.size()]);
+  }
+
+  bool seedOk = false;
+  long long baseSeed = replicaParams[seedIndex].toLongLong(&seedOk);
+  if (!seedOk || baseSeed < 0) {
+    error = "seed must be >= 0";
+    return false;
+  } else if (baseSeed == 0) {
+    baseSeed = RandomEngine().getSeed() % 1000000000 + 1;
+  }
+  if (baseSeed > INT_MAX - numReplicas) {
+    error = "seed too large for " + QString::number(numReplicas) + " replicas";
+    return false;
+  }
+
+  result = Result();
+  for (int i = 0; i < numReplicas; ++i) {
+    result.seeds.push_back(static_cast<int>(baseSeed + i));
+  }
+  result.runs.resize(numReplicas);
+  std::vector<std::vector<double>> countValues(numReplicas);
+  std::vector<QStringList> countNames(numReplicas);
+
+  // Algorithms report their systems by signal, so instantiation goes through
+  // the one runner under a lock; the systems themselves share no state.
+  QMutex mutex;
+  std::atomic<int> nextReplica(0);
+  auto work = [&]() {
+    for (int i = nextReplica++; i < numReplicas; i = nextReplica++) {
+      QStringList p = replicaParams;
+      p[seedIndex] = QString::number(result.seeds[i]);
+
+      std::shared_ptr<System> system;
+      {
+        QMutexLocker locker(&mutex);
+        if (!error.isEmpty()) {
+          return;
+        }
+        QString instantiateError;
+        system = runner.instantiate(signature, p, instantiateError);
+        if (system == nullptr) {
+          error = instantiateError;
+          return;
+        }
+      }
+
+      auto amoebotSystem = std::dynamic_pointer_cast<AmoebotSystem>(system);
+      if (resultSink != nullptr && amoebotSystem != nullptr) {
+        amoebotSystem->setResultSink(resultSink,
+                                     signature + " " + p.join(" "));
+      }
+
+      result.runs[i] = CliRunner::run(*system, budget);
+      for (const Count* count : system->getCounts()) {
+        countNames[i].append(count->_name);
+        countValues[i].push_back(count->_value);
+      }
+    }
+  };
+
+  int threads = numThreads;
+  if (threads <= 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  threads = std::min(threads, numReplicas);
+
+  QElapsedTimer timer;
+  timer.start();
+  std::vector<std::thread> workers;
+  for (int t = 1; t < threads; ++t) {
+    workers.emplace_back(work);
+  }
+  work();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  result.elapsedMs = timer.nsecsElapsed() / 1e6;
+
+  if (!error.isEmpty()) {
+    return false;
+  }
+
+  // Every replica runs the same algorithm and thus has the same counts.
+  for (int c = 0; c < countNames[0].size(); ++c) {
+    std::vector<double> values;
+    for (int i = 0; i < numReplicas; ++i) {
+      values.push_back(countValues[i][c]);
+    }
+    result.statistics.push_back(summarize(countNames[0][c], values));
+  }
+  std::vector<double> runtimes;
+  for (const auto& run : result.runs) {
+    runtimes.push_back(run.elapsedMs);
+    result.numTerminated += run.terminated ? 1 : 0;
+  }
+  result.statistics.push_back(summarize("Runtime (ms)", runtimes));
+
+  return true;
+}
+
+ReplicaRunner::Statistic ReplicaRunner::summarize(const QString name,
+                                                  std::vector<double> values) {
+  Statistic stat;
+  stat.name = name;
+  stat.values = values;
+  if (values.empty()) {
+    return stat;
+  }
+
+  const int n = values.size();
+  double sum = 0;
+  for (double value : values) {
+    sum += value;
+  }
+  stat.mean = sum / n;
+  if (n > 1) {
+    double squares = 0;
+    for (double value : values) {
+      squares += (value - stat.mean) * (value - stat.mean);
+    }
+    stat.variance = squares / (n - 1);
+  }
+
+  std::sort(values.begin(), values.end());
+  auto quantile = [&values, n](const double p) {
+    const double pos = p * (n - 1);
+    const int lower = static_cast<int>(pos);
+    if (lower + 1 >= n) {
+      return values[n - 1];
+    }
+    return values[lower] + (pos - lower) * (values[lower + 1] - values[lower]);
+  };
+  stat.min = values.front();
+  stat.q25 = quantile(0.25);
+  stat.median = quantile(0.5);
+  stat.q75 = quantile(0.75);
+  stat.max = values.back();
+
+  return stat;
+}
+
+QString ReplicaRunner::resultAsJSON(const QString signature,
+                                    const Result& result) {
+  QString json = "{\"title\" : \"AmoebotSim Replica Statistics JSON\", ";
+  json += "\"algorithm\" : \"" + signature + "\", ";
+  json += "\"replicas\" : " + QString::number(result.seeds.size()) + ", ";
+  json += "\"terminated\" : " + QString::number(result.numTerminated) + ", ";
+  json += "\"seeds\" : [";
+  for (int seed : result.seeds) {
+    json += QString::number(seed) + ", ";
+  }
+  if (!result.seeds.empty()) {
+    json.chop(2);  // Remove the last ", ".
+  }
+  json += "], \"statistics\" : [";
+  for (const auto& stat : result.statistics) {
+    json += "{\"name\" : \"" + stat.name + "\", ";
+    json += "\"mean\" : " + QString::number(stat.mean, 'g', 15) + ", ";
+    json += "\"variance\" : " + QString::number(stat.variance, 'g', 15) + ", ";
+    json += "\"min\" : " + QString::number(stat.min, 'g', 15) + ", ";
+    json += "\"q25\" : " + QString::number(stat.q25, 'g', 15) + ", ";
+    json += "\"median\" : " + QString::number(stat.median, 'g', 15) + ", ";
+    json += "\"q75\" : " + QString::number(stat.q75, 'g', 15) + ", ";
+    json += "\"max\" : " + QString::number(stat.max, 'g', 15) + ", ";
+    json += "\"values\" : [";
+    for (double value : stat.values) {
+      json += QString::number(value, 'g', 15) + ", ";
+    }
+    if (!stat.values.empty()) {
+      json.chop(2);  // Remove the last ", ".
+    }
+    json += "]}, ";
+  }
+  if (!result.statistics.empty()) {
+    json.chop(2);  // Remove the last ", ".
+  }
+  json += "]}";
+
+  return json;
+}
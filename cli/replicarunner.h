@@ -0,0 +1,69 @@
+/* Copyright (C) 2020 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+// Defines a runner for many independent replicas of the same algorithm, e.g.,
+// a few hundred seeds of Leader Election at a fixed size and hole probability.
+// Replicas differ only in their seed and run concurrently on a pool of threads;
+// since every system owns its random number generator, the results do not
+// depend on how replicas are scheduled onto threads. The final value of every
+// count is then summarized over all replicas.
+
+#ifndef AMOEBOTSIM_CLI_REPLICARUNNER_H_
+#define AMOEBOTSIM_CLI_REPLICARUNNER_H_
+
+#include <vector>
+
+#include <QString>
+#include <QStringList>
+
+#include "cli/clirunner.h"
+
+class ResultSink;
+
+class ReplicaRunner {
+ public:
+  // Summary statistics of one quantity over all replicas. Variance is the
+  // sample variance; quantiles interpolate linearly between order statistics.
+  struct Statistic {
+    QString name;
+    std::vector<double> values;  // One per replica, in replica order.
+    double mean = 0;
+    double variance = 0;
+    double min = 0;
+    double q25 = 0;
+    double median = 0;
+    double q75 = 0;
+    double max = 0;
+  };
+
+  struct Result {
+    std::vector<int> seeds;
+    std::vector<CliRunner::RunResult> runs;
+    std::vector<Statistic> statistics;
+    int numTerminated = 0;
+    double elapsedMs = 0;
+  };
+
+  // Runs numReplicas replicas of the algorithm with the given signature and
+  // parameters (as for CliRunner::instantiate) on numThreads threads, where
+  // numThreads <= 0 uses one thread per core. Replica i runs with seed
+  // baseSeed + i; the algorithm's own seed parameter, if nonzero, is used as
+  // baseSeed, and otherwise a fresh one is drawn. Each replica is run as by
+  // CliRunner::run with the given budget and, if resultSink is not nullptr,
+  // reports its result there under its signature and parameters. Returns false
+  // and sets error on failure.
+  static bool run(const QString signature, const QStringList params,
+                  const int numReplicas, const int numThreads,
+                  const long long budget, Result& result, QString& error,
+                  ResultSink* resultSink = nullptr);
+
+  // Computes the statistics of the given values under the given name.
+  static Statistic summarize(const QString name, std::vector<double> values);
+
+  // Formats the result as a JSON string: the seeds, the number of replicas
+  // that terminated, and one entry per statistic.
+  static QString resultAsJSON(const QString signature, const Result& result);
+};
+
+#endif  // AMOEBOTSIM_CLI_REPLICARUNNER_H_
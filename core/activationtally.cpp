@@ -0,0 +1,34 @@
+/* Copyright (C) 2020 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+#include "core/activationtally.h"
+
+thread_local ActivationTally* ActivationTally::current = nullptr;
+
+ActivationTally::ActivationTally()
+  : stateDeltas{},
+    heldTokensDelta(0),
+    numFirstActivations(0) {}
+
+void ActivationTally::recordCount(Count* count, const unsigned int numEvents) {
+  // Algorithms record only a handful of distinct counts, so a linear search
+  // beats any map.
+  for (auto& delta : countDeltas) {
+    if (delta.first == count) {
+      delta.second += numEvents;
+      return;
+    }
+  }
+  countDeltas.emplace_back(count, numEvents);
+}
+
+void ActivationTally::clear() {
+  countDeltas.clear();
+  stateDeltas.fill(0);
+  heldTokensDelta = 0;
+  numFirstActivations = 0;
+  dormancyChanges.clear();
+  dirtyParticles.clear();
+  changes.clear();
+}
@@ -0,0 +1,55 @@
+/* Copyright (C) 2020 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+// Defines the per-thread bookkeeping of activations that run concurrently (see
+// core/parallelroundscheduler.h and core/asyncscheduler.h). While
+// ActivationTally::current is set on a thread, the shared counters an
+// activation would otherwise update in place (counts, the number of particles
+// per snapshot state, the number of held tokens, the set of active particles,
+// and the dirty particles) are accumulated in that tally instead, as are the
+// change events for the system's listeners, and the scheduler applies the
+// tallies once the concurrent activations are done (see
+// AmoebotSystem::mergeTally). On every other thread, current is nullptr and the
+// counters are updated directly.
+
+#ifndef AMOEBOTSIM_CORE_ACTIVATIONTALLY_H_
+#define AMOEBOTSIM_CORE_ACTIVATIONTALLY_H_
+
+#include <array>
+#include <utility>
+#include <vector>
+
+#include "core/changeevent.h"
+
+class AmoebotParticle;
+class Count;
+
+struct ActivationTally {
+  // Constructs an empty tally.
+  ActivationTally();
+
+  // The tally of the current thread, if any.
+  static thread_local ActivationTally* current;
+
+  // Adds the given number of events to the pending increment of the count.
+  void recordCount(Count* count, const unsigned int numEvents);
+
+  // Resets all pending changes to zero.
+  void clear();
+
+  // The pending increments of counts, the pending changes to the number of
+  // particles in each snapshot state, the pending change to the number of held
+  // tokens, the number of particles activated for the first time in the
+  // current round, the particles that fell asleep or were woken, the
+  // particles newly marked dirty, and the change events to deliver.
+  std::vector<std::pair<Count*, unsigned int>> countDeltas;
+  std::array<int, 256> stateDeltas;
+  int heldTokensDelta;
+  unsigned int numFirstActivations;
+  std::vector<AmoebotParticle*> dormancyChanges;
+  std::vector<AmoebotParticle*> dirtyParticles;
+  std::vector<ChangeEvent> changes;
+};
+
+#endif  // AMOEBOTSIM_CORE_ACTIVATIONTALLY_H_
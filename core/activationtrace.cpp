@@ -0,0 +1,314 @@
+/* Copyright (C) 2020 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+#include "core/activationtrace.h"
+
+#include <algorithm>
+#include <sstream>
+
+#include "core/amoebotparticle.h"
+#include "core/amoebotsystem.h"
+#include "core/checkpoint.h"
+
+namespace {
+
+// "AMBTRACE" as a little-endian 64-bit value.
+constexpr uint64_t kMagic = 0x4543415254424d41ull;
+constexpr uint32_t kVersion = 1;
+
+}  // namespace
+
+ActivationRecorder::ActivationRecorder(AmoebotSystem& system,
+                                       std::ostream& out,
+                                       const uint64_t keyframeInterval)
+  : system(&system),
+    out(out),
+    keyframeInterval(keyframeInterval),
+    _numActivations(0),
+    segmentActivations(0),
+    lastIndex(0) {
+  Q_ASSERT(system.activationRecorder == nullptr);
+
+  writeFixed(out, kMagic, 8);
+  writeFixed(out, kVersion, 4);
+  writeFixed(out, system.getSeed(), 8);
+  writeFixed(out, system.size(), 4);
+  beginSegment();
+  system.activationRecorder = this;
+}
+
+ActivationRecorder::~ActivationRecorder() {
+  finish();
+}
+
+void ActivationRecorder::finish() {
+  if (system == nullptr) {
+    return;
+  }
+
+  endSegment();
+  out.flush();
+  system->activationRecorder = nullptr;
+  system = nullptr;
+}
+
+uint64_t ActivationRecorder::numActivations() const {
+  return _numActivations;
+}
+
+bool ActivationRecorder::failed() const {
+  return !out;
+}
+
+void ActivationRecorder::record(const unsigned int index,
+                                const bool scheduled) {
+  const int64_t delta = static_cast<int64_t>(index) - lastIndex;
+  const uint64_t zigzag = (static_cast<uint64_t>(delta) << 1) ^
+                          static_cast<uint64_t>(delta >> 63);
+  appendVarint(records, (zigzag << 1) | (scheduled ? 0 : 1));
+  lastIndex = index;
+  ++_numActivations;
+  ++segmentActivations;
+
+  const bool keyframeDue = keyframeInterval > 0 &&
+                           _numActivations % keyframeInterval == 0 &&
+                           system->supportsCheckpoints();
+  if (keyframeDue || segmentActivations == kSegmentSize) {
+    endSegment();
+    beginSegment();
+  }
+}
+
+void ActivationRecorder::beginSegment() {
+  writeFixed(out, _numActivations, 8);
+
+  const bool keyframe =
+      system->supportsCheckpoints() &&
+      (_numActivations == 0 ||
+       (keyframeInterval > 0 && _numActivations % keyframeInterval == 0));
+  if (keyframe) {
+    std::ostringstream checkpoint(std::ios::binary);
+    CheckpointWriter writer(checkpoint);
+    system->writeCheckpoint(writer);
+    const std::string bytes = checkpoint.str();
+    writeFixed(out, bytes.size(), 8);
+    out.write(bytes.data(), bytes.size());
+  } else {
+    writeFixed(out, 0, 8);
+  }
+
+  segmentActivations = 0;
+  lastIndex = 0;
+  records.clear();
+}
+
+void ActivationRecorder::endSegment() {
+  writeFixed(out, segmentActivations, 8);
+  writeFixed(out, records.size(), 8);
+  out.write(records.data(), records.size());
+  out.flush();
+}
+
+ActivationReplayer::ActivationReplayer()
+  : seed(0),
+    numParticles(0),
+    lastSystem(nullptr),
+    position(0) {}
+
+bool ActivationReplayer::open(const QString filePath, QString& error) {
+  file.close();
+  file.clear();
+  segments.clear();
+  lastSystem = nullptr;
+  position = 0;
+
+  file.open(filePath.toStdString(), std::ios::binary);
+  if (!file) {
+    error = "cannot open " + filePath;
+    return false;
+  }
+  file.seekg(0, std::ios::end);
+  const std::streamoff fileSize = file.tellg();
+  file.seekg(0);
+
+  uint64_t magic = 0, version = 0, particles = 0;
+  if (!readFixed(file, magic, 8) || !readFixed(file, version, 4) ||
+      !readFixed(file, seed, 8) || !readFixed(file, particles, 4) ||
+      magic != kMagic || version != kVersion) {
+    error = filePath + ": not a trace, or written by another version";
+    return false;
+  }
+  numParticles = static_cast<uint32_t>(particles);
+
+  // Index the complete segments; an incomplete one can only be the last.
+  uint64_t numActivations = 0;
+  while (true) {
+    Segment segment;
+    if (!readFixed(file, segment.firstActivation, 8) ||
+        !readFixed(file, segment.keyframeSize, 8)) {
+      break;
+    }
+    segment.keyframeOffset = file.tellg();
+    if (segment.keyframeSize > static_cast<uint64_t>(
+                                   fileSize - segment.keyframeOffset)) {
+      break;
+    }
+    file.seekg(segment.keyframeSize, std::ios::cur);
+    if (!readFixed(file, segment.numActivations, 8) ||
+        !readFixed(file, segment.recordsSize, 8)) {
+      break;
+    }
+    segment.recordsOffset = file.tellg();
+    if (segment.recordsSize > static_cast<uint64_t>(
+                                  fileSize - segment.recordsOffset)) {
+      break;
+    }
+    file.seekg(segment.recordsSize, std::ios::cur);
+
+    if (segment.firstActivation != numActivations) {
+      error = filePath + ": corrupt trace";
+      segments.clear();
+      return false;
+    }
+    numActivations += segment.numActivations;
+    segments.push_back(segment);
+  }
+  file.clear();
+
+  if (segments.empty()) {
+    error = filePath + ": trace is truncated";
+    return false;
+  }
+
+  return true;
+}
+
+uint64_t ActivationReplayer::numActivations() const {
+  return segments.empty()
+             ? 0
+             : segments.back().firstActivation + segments.back().numActivations;
+}
+
+bool ActivationReplayer::seek(AmoebotSystem& system, const uint64_t activation,
+                              QString& error) {
+  if (segments.empty()) {
+    error = "no trace is open";
+    return false;
+  } else if (system.getSeed() != seed || system.size() != numParticles) {
+    error = "the trace was recorded with a different seed or system size";
+    return false;
+  } else if (activation > numActivations()) {
+    error = "the trace has only " + QString::number(numActivations()) +
+            " activations";
+    return false;
+  }
+
+  // Find the last keyframe at or before the activation, and continue from the
+  // previous position instead if that is closer.
+  const Segment* keyframe = nullptr;
+  for (const Segment& segment : segments) {
+    if (segment.firstActivation > activation) {
+      break;
+    } else if (segment.keyframeSize > 0) {
+      keyframe = &segment;
+    }
+  }
+  const bool continuing =
+      lastSystem == &system && position <= activation &&
+      (keyframe == nullptr || position >= keyframe->firstActivation);
+  if (!continuing) {
+    if (keyframe != nullptr) {
+      if (!restoreKeyframe(system, *keyframe, error)) {
+        lastSystem = nullptr;
+        return false;
+      }
+      position = keyframe->firstActivation;
+    } else if (lastSystem == &system) {
+      error = "the trace has no keyframe to go back to; instantiate the "
+              "system again";
+      return false;
+    } else {
+      position = 0;  // The system is fresh.
+    }
+  }
+  lastSystem = &system;
+
+  for (const Segment& segment : segments) {
+    const uint64_t end = segment.firstActivation + segment.numActivations;
+    if (position >= activation) {
+      break;
+    } else if (position < end) {
+      const uint64_t to = std::min(end, activation);
+      if (!replaySegment(system, segment, position - segment.firstActivation,
+                         to - segment.firstActivation, error)) {
+        lastSystem = nullptr;
+        return false;
+      }
+      position = to;
+    }
+  }
+
+  return true;
+}
+
+bool ActivationReplayer::restoreKeyframe(AmoebotSystem& system,
+                                         const Segment& segment,
+                                         QString& error) {
+  file.clear();
+  file.seekg(segment.keyframeOffset);
+  CheckpointReader in(file);
+  if (!system.readCheckpoint(in, error)) {
+    error = "keyframe at activation " +
+            QString::number(segment.firstActivation) + ": " + error;
+    return false;
+  }
+
+  return true;
+}
+
+bool ActivationReplayer::replaySegment(AmoebotSystem& system,
+                                       const Segment& segment,
+                                       const uint64_t from, const uint64_t to,
+                                       QString& error) {
+  std::string records(segment.recordsSize, '\0');
+  file.clear();
+  file.seekg(segment.recordsOffset);
+  file.read(&records[0], records.size());
+  if (static_cast<uint64_t>(file.gcount()) != records.size()) {
+    error = "cannot read the trace";
+    return false;
+  }
+
+  const unsigned char* p = reinterpret_cast<const unsigned char*>(
+      records.data());
+  const unsigned char* const end = p + records.size();
+  int64_t index = 0;
+  for (uint64_t i = 0; i < to; ++i) {
+    uint64_t value;
+    if (!readVarint(p, end, value)) {
+      error = "corrupt trace";
+      return false;
+    }
+    const uint64_t zigzag = value >> 1;
+    index += static_cast<int64_t>(zigzag >> 1) ^
+             -static_cast<int64_t>(zigzag & 1);
+    if (index < 0 || index >= static_cast<int64_t>(system.particles.size())) {
+      error = "corrupt trace";
+      return false;
+    } else if (i < from) {
+      continue;
+    }
+
+    AmoebotParticle* const particle = system.particles[index];
+    if (value & 1) {
+      system.activateDirectly(particle);
+    } else if (system.activateScheduled() != particle) {
+      error = "the replay diverged from the recorded run at activation " +
+              QString::number(segment.firstActivation + i);
+      return false;
+    }
+  }
+
+  return true;
+}
@@ -0,0 +1,166 @@
+/* Copyright (C) 2020 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+// Defines activation traces, which record the sequence of particles a system
+// activates so that a run can be reproduced exactly and revisited at any point.
+// An ActivationRecorder attached to a system logs every activation of
+// AmoebotSystem::activate and activateParticleAt, and an ActivationReplayer
+// brings a system instantiated with the same algorithm, parameters, and seed to
+// the state after any number of the recorded activations.
+//
+// A trace starts with the eight bytes "AMBTRACE", a 32-bit format version, the
+// system's 64-bit seed, and its 32-bit number of particles. It continues with
+// segments of at most kSegmentSize consecutive activations, each consisting of
+// the 64-bit number of activations before it, the 64-bit size of a keyframe
+// followed by the keyframe itself (see below), the 64-bit number of activations
+// in the segment, and the 64-bit size of its records followed by the records.
+// All fixed-width values are little-endian. Every activation is one record: a
+// varint (seven bits per byte, low bits first) of 2 * zigzag(i - j) + d, where
+// i is the activated particle's index in insertion order, j that of the
+// previous activation in the segment (0 for the first), and d is 1 if the
+// particle was activated directly by activateParticleAt.
+//
+// A keyframe is a checkpoint of the system at the start of its segment (see
+// AmoebotSystem::writeCheckpoint). The first segment has one, and a later one
+// has one every keyframeInterval activations, if the system supports
+// checkpoints; other keyframes are empty. Segments are written as they are
+// completed, so a run that crashes loses at most its last kSegmentSize
+// activations. To reach an activation, a replayer restores the last keyframe
+// before it, or starts from a freshly instantiated system if there is none, and
+// re-executes the recorded activations from there.
+//
+// Scheduled activations draw from the same random number generator as the
+// particles, so they are replayed through the system's scheduler, which keeps
+// the generator in step; their records serve to detect a replay that diverges
+// from the recorded run (e.g., when the algorithm has changed since). Direct
+// activations, such as those triggered in the GUI, are replayed from their
+// records. Activations by a ParallelRoundScheduler or an AsyncScheduler are
+// not recorded.
+
+#ifndef AMOEBOTSIM_CORE_ACTIVATIONTRACE_H_
+#define AMOEBOTSIM_CORE_ACTIVATIONTRACE_H_
+
+#include <cstdint>
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <QString>
+
+class AmoebotSystem;
+
+class ActivationRecorder {
+ public:
+  // The maximum number of activations per segment, which bounds the memory
+  // used to buffer records.
+  static constexpr uint64_t kSegmentSize = 1 << 20;
+
+  // Constructs a recorder that attaches itself to the given system and writes
+  // the trace of its activations from now on to the given stream, which must be
+  // opened in binary mode. Keyframes are stored every keyframeInterval
+  // activations (0 stores only the initial one). If the system does not support
+  // checkpoints, it must not have been activated yet, since replays of the
+  // trace start from a freshly instantiated system.
+  ActivationRecorder(AmoebotSystem& system, std::ostream& out,
+                     const uint64_t keyframeInterval = 0);
+  ActivationRecorder(const ActivationRecorder&) = delete;
+  ActivationRecorder& operator=(const ActivationRecorder&) = delete;
+
+  // Finishes the trace unless finish has been called.
+  ~ActivationRecorder();
+
+  // Writes the activations recorded since the last completed segment and
+  // detaches the recorder from its system. Further activations are not
+  // recorded.
+  void finish();
+
+  // Returns the number of activations recorded so far.
+  uint64_t numActivations() const;
+
+  // Returns true if the underlying stream reported an error.
+  bool failed() const;
+
+ private:
+  friend class AmoebotSystem;
+
+  // Records the activation of the particle with the given index in insertion
+  // order, which was chosen by the system's scheduler if scheduled is true and
+  // activated directly otherwise; called by the system once the activation is
+  // complete.
+  void record(const unsigned int index, const bool scheduled);
+
+  // Begin (respectively, end) a segment: beginSegment writes its first
+  // activation and keyframe, and endSegment its buffered records.
+  void beginSegment();
+  void endSegment();
+
+  AmoebotSystem* system;
+  std::ostream& out;
+  const uint64_t keyframeInterval;
+
+  // The number of activations recorded so far and in the current segment, the
+  // index of the particle activated last in the current segment, and the
+  // encoded records of the current segment.
+  uint64_t _numActivations;
+  uint64_t segmentActivations;
+  int64_t lastIndex;
+  std::string records;
+};
+
+class ActivationReplayer {
+ public:
+  ActivationReplayer();
+
+  // Opens the trace in the file at the given path and reads its segment
+  // layout. Returns false and describes the problem in error if the file is
+  // not a trace; a trace that ends in an incomplete segment is read up to it.
+  bool open(const QString filePath, QString& error);
+
+  // Returns the number of activations in the opened trace.
+  uint64_t numActivations() const;
+
+  // Brings the given system to the state after the first activation recorded
+  // activations of the opened trace. The system must have been instantiated
+  // with the same algorithm, parameters, and seed as the recorded one, and be
+  // either fresh or the one passed to the previous call, not activated since;
+  // in the latter case, a later activation is reached from where the previous
+  // call left off unless there is a keyframe in between. Returns false and
+  // describes the problem in error if the trace does not match the system, if
+  // there is no keyframe to go back to, or if the replay diverges from the
+  // recorded run, in which case the system must be discarded.
+  bool seek(AmoebotSystem& system, const uint64_t activation, QString& error);
+
+ private:
+  // The position of a segment in the file and its number of activations.
+  struct Segment {
+    uint64_t firstActivation;
+    std::streamoff keyframeOffset;
+    uint64_t keyframeSize;
+    uint64_t numActivations;
+    std::streamoff recordsOffset;
+    uint64_t recordsSize;
+  };
+
+  // Restores the keyframe of the given segment into the given system.
+  bool restoreKeyframe(AmoebotSystem& system, const Segment& segment,
+                       QString& error);
+
+  // Re-executes the activations of the given segment from the given index
+  // within it up to (but excluding) the given end index.
+  bool replaySegment(AmoebotSystem& system, const Segment& segment,
+                     const uint64_t from, const uint64_t to, QString& error);
+
+  std::ifstream file;
+  uint64_t seed;
+  uint32_t numParticles;
+  std::vector<Segment> segments;
+
+  // The system most recently passed to seek and the number of recorded
+  // activations it has executed.
+  const AmoebotSystem* lastSystem;
+  uint64_t position;
+};
+
+#endif  // AMOEBOTSIM_CORE_ACTIVATIONTRACE_H_
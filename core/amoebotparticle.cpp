@@ -7,6 +7,7 @@
 AmoebotParticle::AmoebotParticle(const Node& head, int globalTailDir,
                                  const int orientation, AmoebotSystem& system)
   : LocalParticle(head, globalTailDir, orientation),
+    RandomNumberGenerator(system.randomEngine),
     system(system) {}
 
 AmoebotParticle::~AmoebotParticle() {}
@@ -45,7 +46,9 @@ void AmoebotParticle::expand(int label) {
   const int globalExpansionDir = localToGlobalDir(label);
   head = head.nodeInDir(globalExpansionDir);
   globalTailDir = (globalExpansionDir + 3) % 6;
-  system.particleMap[head] = this;
+  system.lattice.setParticle(head, this);
+  refreshSnapshot();
+  reportChange(ChangeEvent::Type::NodeOccupied, head);
 
   system.registerMovement();
 }
@@ -66,12 +69,16 @@ void AmoebotParticle::push(int label) {
 
   head = handoverNode;
   globalTailDir = (globalExpansionDir + 3) % 6;
-  system.particleMap[handoverNode] = this;
+  system.lattice.setParticle(handoverNode, this);
 
   if (handoverNode == neighbor.head) {
     neighbor.head = neighbor.tail();
   }
   neighbor.globalTailDir = -1;
+  refreshSnapshot();
+  neighbor.refreshSnapshot();
+  neighbor.reportChange(ChangeEvent::Type::NodeVacated, handoverNode);
+  reportChange(ChangeEvent::Type::NodeOccupied, handoverNode);
 
   system.registerMovement(2);
   system.registerActivation(&neighbor);
@@ -87,9 +94,12 @@ void AmoebotParticle::contract(int label) {
 void AmoebotParticle::contractHead() {
   Q_ASSERT(isExpanded());
 
-  system.particleMap.erase(head);
+  const Node vacatedNode = head;
+  system.lattice.setParticle(head, nullptr);
   head = tail();
   globalTailDir = -1;
+  refreshSnapshot();
+  reportChange(ChangeEvent::Type::NodeVacated, vacatedNode);
 
   system.registerMovement();
 }
@@ -97,8 +107,11 @@ void AmoebotParticle::contractHead() {
 void AmoebotParticle::contractTail() {
   Q_ASSERT(isExpanded());
 
-  system.particleMap.erase(tail());
+  const Node vacatedNode = tail();
+  system.lattice.setParticle(vacatedNode, nullptr);
   globalTailDir = -1;
+  refreshSnapshot();
+  reportChange(ChangeEvent::Type::NodeVacated, vacatedNode);
 
   system.registerMovement();
 }
@@ -124,38 +137,102 @@ void AmoebotParticle::pull(int label) {
   globalTailDir = -1;
   neighbor.head = handoverNode;
   neighbor.globalTailDir = globalPullDir;
-  system.particleMap[handoverNode] = &neighbor;
+  system.lattice.setParticle(handoverNode, &neighbor);
+  refreshSnapshot();
+  neighbor.refreshSnapshot();
+  reportChange(ChangeEvent::Type::NodeVacated, handoverNode);
+  neighbor.reportChange(ChangeEvent::Type::NodeOccupied, handoverNode);
 
   system.registerMovement(2);
   system.registerActivation(&neighbor);
 }
 
-bool AmoebotParticle::hasNbrAtLabel(int label) const {
-  const Node neighboringNode = nbrNodeReachedViaLabel(label);
-  return system.particleMap.find(neighboringNode) != system.particleMap.end();
+void AmoebotParticle::setSnapshotState(unsigned char state) {
+  if (state == snapshotState) {
+    return;
+  }
+
+  if (isInSystem()) {
+    system.moveStateCount(snapshotState, state);
+    system._snapshot.state[snapshotIndex] = state;
+  }
+  snapshotState = state;
+  reportChange(ChangeEvent::Type::StateChanged, head);
 }
 
-bool AmoebotParticle::hasHeadAtLabel(int label) {
-  return hasNbrAtLabel(label) &&
-         (nbrAtLabel<Particle>(label).head == nbrNodeReachedViaLabel(label));
+void AmoebotParticle::sleep() {
+  if (dormant) {
+    return;
+  }
+
+  // This activation is the last one until the particle is woken, so it counts
+  // toward the current round right away.
+  const bool inSystem = isInSystem();
+  if (inSystem) {
+    system.countActivation(this);
+  }
+  dormant = true;
+  if (inSystem) {
+    system.updateActiveSet(this);
+  }
 }
 
-bool AmoebotParticle::hasTailAtLabel(int label) {
-  if (!hasNbrAtLabel(label)) {
-    return false;
+void AmoebotParticle::wake() {
+  if (!dormant) {
+    return;
   }
 
-  const auto& neighbor = nbrAtLabel<Particle>(label);
-  if (neighbor.isContracted()) {
-    return false;
+  dormant = false;
+  if (isInSystem()) {
+    system.updateActiveSet(this);
   }
+}
+
+void AmoebotParticle::writeState(CheckpointWriter& out) const {
+  Q_UNUSED(out);
+}
+
+void AmoebotParticle::readState(CheckpointReader& in) {
+  Q_UNUSED(in);
+}
+
+void AmoebotParticle::writeToken(CheckpointWriter& out,
+                                 const Token& token) const {
+  Q_UNUSED(out);
+  Q_UNUSED(token);
+  Q_ASSERT(false);
+}
+
+TokenPtr<AmoebotParticle::Token> AmoebotParticle::readToken(
+    CheckpointReader& in) {
+  in.fail();
+  return nullptr;
+}
+
+bool AmoebotParticle::isDormant() const {
+  return dormant;
+}
+
+bool AmoebotParticle::hasNbrAtLabel(int label) const {
+  const Node neighboringNode = nbrNodeReachedViaLabel(label);
+  return system.lattice.particleAt(neighboringNode) != nullptr;
+}
+
+bool AmoebotParticle::hasHeadAtLabel(int label) {
+  const Node neighboringNode = nbrNodeReachedViaLabel(label);
+  const AmoebotParticle* neighbor = system.lattice.particleAt(neighboringNode);
+  return neighbor != nullptr && neighbor->head == neighboringNode;
+}
 
-  return neighbor.tail() == nbrNodeReachedViaLabel(label);
+bool AmoebotParticle::hasTailAtLabel(int label) {
+  const Node neighboringNode = nbrNodeReachedViaLabel(label);
+  const AmoebotParticle* neighbor = system.lattice.particleAt(neighboringNode);
+  return neighbor != nullptr && neighbor->head != neighboringNode;
 }
 
 bool AmoebotParticle::hasObjectAtLabel(int label) const {
   const Node neighboringNode = nbrNodeReachedViaLabel(label);
-  return system.objectMap.find(neighboringNode) != system.objectMap.end();
+  return system.lattice.objectAt(neighboringNode) != nullptr;
 }
 
 bool AmoebotParticle::hasObjectNbr() const {
@@ -163,10 +240,14 @@ bool AmoebotParticle::hasObjectNbr() const {
 }
 
 int AmoebotParticle::labelOfFirstObjectNbr(int startLabel) const {
-  const int labelLimit = isContracted() ? 6 : 10;
-  for (int labelOffset = 0; labelOffset < labelLimit; labelOffset++) {
-    const int label = (startLabel + labelOffset) % labelLimit;
-    if (hasObjectAtLabel(label)) {
+  const Neighborhood nbhd = neighborhood();
+  if (nbhd.objects == 0) {
+    return -1;
+  }
+
+  for (int labelOffset = 0; labelOffset < nbhd.numLabels; labelOffset++) {
+    const int label = (startLabel + labelOffset) % nbhd.numLabels;
+    if (nbhd.hasObjectAtLabel(label)) {
       return label;
     }
   }
@@ -174,6 +255,73 @@ int AmoebotParticle::labelOfFirstObjectNbr(int startLabel) const {
   return -1;
 }
 
-void AmoebotParticle::putToken(std::shared_ptr<Token> token) {
-  tokens.push_back(token);
+AmoebotParticle::Neighborhood AmoebotParticle::neighborhood() const {
+  Neighborhood nbhd;
+  nbhd.numLabels = isContracted() ? 6 : 10;
+  for (int label = 0; label < nbhd.numLabels; label++) {
+    const Node neighboringNode = nbrNodeReachedViaLabel(label);
+    const LatticeIndex::Cell& cell = system.lattice.at(neighboringNode);
+    const unsigned int bit = 1u << label;
+    if (cell.particle != nullptr) {
+      nbhd.particles |= bit;
+      if (cell.particle->head == neighboringNode) {
+        nbhd.heads |= bit;
+      } else {
+        nbhd.tails |= bit;
+      }
+    }
+    if (cell.object != nullptr) {
+      nbhd.objects |= bit;
+    }
+  }
+
+  return nbhd;
+}
+
+void AmoebotParticle::putToken(TokenPtr<Token> token) {
+  tokens.put(std::move(token));
+  if (isInSystem()) {
+    system.addHeldTokens(1);
+  }
+  reportChange(ChangeEvent::Type::TokenPut, head);
+}
+
+void AmoebotParticle::reportChange(ChangeEvent::Type type, const Node& node) {
+  // Concurrent activations always report changes, since their particles
+  // falling asleep are only counted once the activations are done.
+  if (!isInSystem() || !system.observesChanges()) {
+    return;
+  }
+
+  system.markChanged(this);
+  if (type != ChangeEvent::Type::TokenPut) {
+    const int numLabels = isContracted() ? 6 : 10;
+    for (int label = 0; label < numLabels; ++label) {
+      AmoebotParticle* nbr =
+          system.lattice.particleAt(nbrNodeReachedViaLabel(label));
+      if (nbr != nullptr) {
+        system.markChanged(nbr);
+      }
+    }
+  }
+  if (type == ChangeEvent::Type::NodeVacated) {
+    for (int dir = 0; dir < 6; ++dir) {
+      AmoebotParticle* nbr = system.lattice.particleAt(node.nodeInDir(dir));
+      if (nbr != nullptr) {
+        system.markChanged(nbr);
+      }
+    }
+  }
+
+  system.notifyChange({type, node, this});
+}
+
+void AmoebotParticle::refreshSnapshot() {
+  if (snapshotIndex == -1) {
+    return;
+  }
+
+  system._snapshot.headX[snapshotIndex] = head.x;
+  system._snapshot.headY[snapshotIndex] = head.y;
+  system._snapshot.tailDir[snapshotIndex] = globalTailDir;
 }
@@ -13,14 +13,15 @@
 #ifndef AMOEBOTSIM_CORE_AMOEBOTPARTICLE_H_
 #define AMOEBOTSIM_CORE_AMOEBOTPARTICLE_H_
 
-#include <deque>
 #include <functional>
 #include <map>
-#include <memory>
 
 #include "core/amoebotsystem.h"
+#include "core/checkpoint.h"
 #include "core/localparticle.h"
 #include "core/node.h"
+#include "core/tokenmailbox.h"
+#include "core/tokenpool.h"
 #include "helper/randomnumbergenerator.h"
 
 class AmoebotParticle : public LocalParticle, public RandomNumberGenerator {
@@ -32,7 +33,7 @@ class AmoebotParticle : public LocalParticle, public RandomNumberGenerator {
                   AmoebotSystem& system);
 
   // Deletes the tokens this particle holds before destructing the particle.
-  // These deletions are handled by the shared_ptrs.
+  // These deletions are handled by the TokenPtrs.
   virtual ~AmoebotParticle();
 
   // Executes one particle activation. The '= 0' indicates that this is a pure
@@ -45,6 +46,9 @@ class AmoebotParticle : public LocalParticle, public RandomNumberGenerator {
   int headMarkGlobalDir() const final;
   int tailMarkGlobalDir() const final;
 
+  // Returns true if this particle is asleep (see sleep()).
+  bool isDormant() const;
+
  protected:
   // Returns the local directions from the head (respectively, tail) on which to
   // draw the direction markers. Intended to be overridden by particle
@@ -79,7 +83,8 @@ class AmoebotParticle : public LocalParticle, public RandomNumberGenerator {
 
   // Gets a reference to the neighboring particle incident to the specified port
   // label. Crashes if no such particle exists at this label; consider using
-  // hasNbrAtLabel() first if unsure.
+  // hasNbrAtLabel() first if unsure. The neighbor must be of the given type; in
+  // systems with a single particle type this is only checked in debug builds.
   template<class ParticleType>
   ParticleType& nbrAtLabel(int label) const;
 
@@ -94,6 +99,35 @@ class AmoebotParticle : public LocalParticle, public RandomNumberGenerator {
   bool hasObjectAtLabel(int label) const;
   bool hasObjectNbr() const;
 
+  // A snapshot of the occupancy of the nodes reached via each of this
+  // particle's port labels, where bit i of each mask corresponds to label i.
+  // particles (resp., objects) marks labels leading to a node occupied by a
+  // particle (resp., an object), and heads (resp., tails) marks the subset of
+  // particles whose head (resp., tail) occupies that node. numLabels is 6 if
+  // this particle was contracted when the snapshot was taken and 10 otherwise.
+  struct Neighborhood {
+    unsigned int particles = 0;
+    unsigned int heads = 0;
+    unsigned int tails = 0;
+    unsigned int objects = 0;
+    int numLabels = 6;
+
+    bool hasNbrAtLabel(int label) const;
+    bool hasHeadAtLabel(int label) const;
+    bool hasTailAtLabel(int label) const;
+    bool hasObjectAtLabel(int label) const;
+
+    // Returns the number of labels leading to a neighboring particle.
+    int numNbrs() const;
+  };
+
+  // Returns the occupancy of every label in this particle's neighborhood,
+  // collected with a single lattice lookup per label. Algorithms inspecting
+  // many labels in one activation should take this snapshot once instead of
+  // repeatedly calling hasNbrAtLabel() and its relatives. The snapshot is not
+  // updated by later movements of this particle or its neighbors.
+  Neighborhood neighborhood() const;
+
   // Function for returning the label of the first port incident to a
   // neighboring object, starting at the (optionally) specified label and
   // continuing counter-clockwise
@@ -107,24 +141,50 @@ class AmoebotParticle : public LocalParticle, public RandomNumberGenerator {
       std::function<bool(const ParticleType&)> propertyCheck,
       int startLabel = 0) const;
 
+  // Publishes an algorithm-defined state byte for this particle in its system's
+  // snapshot (see core/particlesnapshot.h), so measures can scan the states of
+  // all particles without visiting the particles and termination checks can
+  // ask AmoebotSystem::numParticlesInState in constant time. Algorithms that
+  // want this should call it whenever their state changes.
+  void setSnapshotState(unsigned char state);
+
+  // Functions for dormancy. A particle whose activations will do nothing until
+  // something around it changes can call sleep() to be skipped by its system's
+  // schedulers, which then draw only from the particles that are not dormant.
+  // It is woken again, i.e., scheduled as usual, by every change that affects
+  // it (see AmoebotSystem::setDirtyTracking): a particle moves onto, off, or
+  // within a node adjacent to it, a neighbor's snapshot state changes (see
+  // setSnapshotState), or a token is put into it. Particles that depend on
+  // their neighbors in other ways must be woken explicitly with wake().
+  void sleep();
+  void wake();
+
   /* TOKEN IMPLEMENTATION & FUNCTIONS */
 
   // A struct expressing the most basic version of a token. Particle subclasses
   // using tokens should write their token structs to inherit from this one.
-  struct Token { virtual ~Token(){ } };
+  // Tokens are referenced through TokenPtr handles (see core/tokenpool.h).
+  struct Token : public PooledToken { virtual ~Token(){ } };
+
+  // Constructs a token of the given type from the given arguments in the token
+  // pool of this particle's system; use this instead of allocating tokens
+  // individually.
+  template<class TokenType, class... Args>
+  TokenPtr<TokenType> makeToken(Args&&... args);
 
   // Functions for handling tokens. putToken adds the given token reference to
   // this particle's collection. peekAtToken returns a reference to the first
-  // token in this particle's collection which is of the specified type.
+  // (i.e., least recently put) token in this particle's collection which is of
+  // the specified type.
   // takeToken does the same thing as peekAtToken, but additionally removes the
   // returned reference from this particle's collection. Note that peekAtToken
   // and takeToken both fail when no token of the given type exists in the
   // collection; consider using hasToken() first if unsure.
-  void putToken(std::shared_ptr<Token> token);
+  void putToken(TokenPtr<Token> token);
   template<class TokenType>
-  std::shared_ptr<TokenType> peekAtToken() const;
+  TokenPtr<TokenType> peekAtToken() const;
   template<class TokenType>
-  std::shared_ptr<TokenType> takeToken();
+  TokenPtr<TokenType> takeToken();
 
   // Functions for basic token-related information. countTokens returns the
   // number of tokens of the specified type in this particle's collection.
@@ -139,33 +199,125 @@ class AmoebotParticle : public LocalParticle, public RandomNumberGenerator {
   // a custom property as input. This restricts the domain of each function to
   // the tokens of the specified type that also satisfy the input property.
   template<class TokenType>
-  std::shared_ptr<TokenType> peekAtToken(
-      std::function<bool(const std::shared_ptr<TokenType>)>
+  TokenPtr<TokenType> peekAtToken(
+      std::function<bool(const TokenPtr<TokenType>)>
       propertyCheck) const;
   template<class TokenType>
-  std::shared_ptr<TokenType> takeToken(
-      std::function<bool(const std::shared_ptr<TokenType>)> propertyCheck);
+  TokenPtr<TokenType> takeToken(
+      std::function<bool(const TokenPtr<TokenType>)> propertyCheck);
   template<class TokenType>
-  int countTokens(std::function<bool(const std::shared_ptr<TokenType>)>
+  int countTokens(std::function<bool(const TokenPtr<TokenType>)>
                   propertyCheck) const;
   template<class TokenType>
-  bool hasToken(std::function<bool(const std::shared_ptr<TokenType>)>
+  bool hasToken(std::function<bool(const TokenPtr<TokenType>)>
                 propertyCheck) const;
 
+  // Functions for checkpoints (see AmoebotSystem::writeCheckpoint), intended to
+  // be overridden by the particles of systems that support checkpoints.
+  // writeState (respectively, readState) writes (respectively, reads) this
+  // particle's algorithm-specific memory; the defaults do nothing. writeToken
+  // writes one of this particle's tokens, and readToken reads one back,
+  // constructing it with makeToken; particles holding tokens must override
+  // both.
+  virtual void writeState(CheckpointWriter& out) const;
+  virtual void readState(CheckpointReader& in);
+  virtual void writeToken(CheckpointWriter& out, const Token& token) const;
+  virtual TokenPtr<Token> readToken(CheckpointReader& in);
+
   AmoebotSystem& system;
 
  private:
-  std::deque<std::shared_ptr<Token>> tokens;
+  friend class AmoebotSystem;
+  friend class AsyncScheduler;
+
+  TokenMailbox<Token> tokens;
+
+  // The round in which this particle was last activated, as numbered by its
+  // system's activation epoch; used to detect the end of a round in O(1).
+  unsigned int activationEpoch = 0;
+
+  // Whether this particle is asleep, its index in its system's list of active
+  // particles (-1 if it is dormant or not yet inserted), and whether it is
+  // marked dirty (see AmoebotSystem::setDirtyTracking).
+  bool dormant = false;
+  int activeSlot = -1;
+  bool dirty = false;
+
+  // Reports a change of the given type at the given node to this particle's
+  // system, which wakes and marks dirty the particles it affects and notifies
+  // its listeners (see core/changeevent.h); called after every change to this
+  // particle's position, tokens, or snapshot state.
+  void reportChange(ChangeEvent::Type type, const Node& node);
+
+  // Writes this particle's current position into its system's snapshot; called
+  // after every movement.
+  void refreshSnapshot();
+
+  // Checks whether this particle is the one its system's snapshot entry
+  // describes, as opposed to not yet inserted or a copy of such a particle;
+  // only then do its state and token changes update the system's counters.
+  bool isInSystem() const;
+
+  // This particle's entry in its system's snapshot (-1 until inserted) and its
+  // algorithm-defined state byte.
+  int snapshotIndex = -1;
+  unsigned char snapshotState = 0;
+
+  // True if this particle lives in its system's particle arena (see
+  // AmoebotSystem::emplaceParticle) and must not be deleted individually.
+  bool inParticleArena = false;
 };
 
 template<class ParticleType>
 ParticleType& AmoebotParticle::nbrAtLabel(int label) const {
   Node nbrNode = nbrNodeReachedViaLabel(label);
-  auto it = system.particleMap.find(nbrNode);
-  Q_ASSERT(it != system.particleMap.end() &&
-           dynamic_cast<ParticleType*>(it->second) != nullptr);
+  AmoebotParticle* nbr = system.lattice.particleAt(nbrNode);
+  Q_ASSERT(nbr != nullptr && dynamic_cast<ParticleType*>(nbr) != nullptr);
+
+  // In a system whose particles all share one type, the neighbor has this
+  // particle's type, so (as checked above in debug builds) the downcast is
+  // static. Only mixed systems pay for a dynamic_cast.
+  if (system.uniformParticleType) {
+    return static_cast<ParticleType&>(*nbr);
+  }
+
+  return dynamic_cast<ParticleType&>(*nbr);
+}
+
+inline bool AmoebotParticle::Neighborhood::hasNbrAtLabel(int label) const {
+  Q_ASSERT(0 <= label && label < numLabels);
+
+  return (particles >> label) & 1u;
+}
+
+inline bool AmoebotParticle::Neighborhood::hasHeadAtLabel(int label) const {
+  Q_ASSERT(0 <= label && label < numLabels);
 
-  return dynamic_cast<ParticleType&>(*(it->second));
+  return (heads >> label) & 1u;
+}
+
+inline bool AmoebotParticle::Neighborhood::hasTailAtLabel(int label) const {
+  Q_ASSERT(0 <= label && label < numLabels);
+
+  return (tails >> label) & 1u;
+}
+
+inline bool AmoebotParticle::Neighborhood::hasObjectAtLabel(int label) const {
+  Q_ASSERT(0 <= label && label < numLabels);
+
+  return (objects >> label) & 1u;
+}
+
+inline int AmoebotParticle::Neighborhood::numNbrs() const {
+  int count = 0;
+  for (unsigned int mask = particles; mask != 0; mask &= mask - 1) {
+    count++;
+  }
+  return count;
+}
+
+inline bool AmoebotParticle::isInSystem() const {
+  return snapshotIndex != -1 && system._snapshot.particle[snapshotIndex] == this;
 }
 
 template<class ParticleType>
@@ -186,110 +338,73 @@ int AmoebotParticle::labelOfFirstNbrWithProperty(
   return -1;
 }
 
+template<class TokenType, class... Args>
+TokenPtr<TokenType> AmoebotParticle::makeToken(Args&&... args) {
+  return system.makeToken<TokenType>(std::forward<Args>(args)...);
+}
+
 template<class TokenType>
-std::shared_ptr<TokenType> AmoebotParticle::peekAtToken() const {
-  for (unsigned int i = 0; i < tokens.size(); i++) {
-    std::shared_ptr<TokenType> token =
-        std::dynamic_pointer_cast<TokenType>(tokens[i]);
-    if (token != nullptr) {
-      return token;
-    }
-  }
-  Q_ASSERT(false);
+TokenPtr<TokenType> AmoebotParticle::peekAtToken() const {
+  TokenPtr<TokenType> token =
+      tokens.find<TokenType>([](const TokenPtr<TokenType>) {
+        return true;
+      });
+  Q_ASSERT(token != nullptr);
+  return token;
 }
 
 template<class TokenType>
-std::shared_ptr<TokenType> AmoebotParticle::peekAtToken(
-    std::function<bool(const std::shared_ptr<TokenType>)> propertyCheck) const {
-  for (unsigned int i = 0; i < tokens.size(); i++) {
-    std::shared_ptr<TokenType> token =
-        std::dynamic_pointer_cast<TokenType>(tokens[i]);
-    if (token != nullptr && propertyCheck(token)) {
-      return token;
-    }
-  }
-  Q_ASSERT(false);
+TokenPtr<TokenType> AmoebotParticle::peekAtToken(
+    std::function<bool(const TokenPtr<TokenType>)> propertyCheck) const {
+  TokenPtr<TokenType> token = tokens.find<TokenType>(propertyCheck);
+  Q_ASSERT(token != nullptr);
+  return token;
 }
 
 template<class TokenType>
-std::shared_ptr<TokenType> AmoebotParticle::takeToken() {
-  for (unsigned int i = 0; i < tokens.size(); i++) {
-    std::shared_ptr<TokenType> token =
-        std::dynamic_pointer_cast<TokenType>(tokens[i]);
-    if (token != nullptr) {
-      std::swap(tokens[0], tokens[i]);
-      tokens.pop_front();
-      return token;
-    }
+TokenPtr<TokenType> AmoebotParticle::takeToken() {
+  TokenPtr<TokenType> token =
+      tokens.take<TokenType>([](const TokenPtr<TokenType>) {
+        return true;
+      });
+  Q_ASSERT(token != nullptr);
+  if (token != nullptr && isInSystem()) {
+    system.addHeldTokens(-1);
   }
-  Q_ASSERT(false);
+  return token;
 }
 
 template<class TokenType>
-std::shared_ptr<TokenType> AmoebotParticle::takeToken(
-    std::function<bool(const std::shared_ptr<TokenType>)> propertyCheck) {
-  for (unsigned int i = 0; i < tokens.size(); i++) {
-    std::shared_ptr<TokenType> token =
-        std::dynamic_pointer_cast<TokenType>(tokens[i]);
-    if (token != nullptr && propertyCheck(token)) {
-      std::swap(tokens[0], tokens[i]);
-      tokens.pop_front();
-      return token;
-    }
+TokenPtr<TokenType> AmoebotParticle::takeToken(
+    std::function<bool(const TokenPtr<TokenType>)> propertyCheck) {
+  TokenPtr<TokenType> token = tokens.take<TokenType>(propertyCheck);
+  Q_ASSERT(token != nullptr);
+  if (token != nullptr && isInSystem()) {
+    system.addHeldTokens(-1);
   }
-  Q_ASSERT(false);
+  return token;
 }
 
 template<class TokenType>
 int AmoebotParticle::countTokens() const {
-  int count = 0;
-  for (unsigned int i = 0; i < tokens.size(); i++) {
-    std::shared_ptr<TokenType> token =
-        std::dynamic_pointer_cast<TokenType>(tokens[i]);
-    if (token != nullptr) {
-      count++;
-    }
-  }
-  return count;
+  return tokens.count<TokenType>();
 }
 
 template<class TokenType>
 int AmoebotParticle::countTokens(
-    std::function<bool(const std::shared_ptr<TokenType>)> propertyCheck) const {
-  int count = 0;
-  for (unsigned int i = 0; i < tokens.size(); i++) {
-    std::shared_ptr<TokenType> token =
-        std::dynamic_pointer_cast<TokenType>(tokens[i]);
-    if (token != nullptr && propertyCheck(token)) {
-      count++;
-    }
-  }
-  return count;
+    std::function<bool(const TokenPtr<TokenType>)> propertyCheck) const {
+  return tokens.count<TokenType>(propertyCheck);
 }
 
 template<class TokenType>
 bool AmoebotParticle::hasToken() const {
-  for (unsigned int i = 0; i < tokens.size(); i++) {
-    std::shared_ptr<TokenType> token =
-        std::dynamic_pointer_cast<TokenType>(tokens[i]);
-    if (token != nullptr) {
-      return true;
-    }
-  }
-  return false;
+  return tokens.contains<TokenType>();
 }
 
 template<class TokenType>
 bool AmoebotParticle::hasToken(
-    std::function<bool(const std::shared_ptr<TokenType>)> propertyCheck) const {
-  for (unsigned int i = 0; i < tokens.size(); i++) {
-    std::shared_ptr<TokenType> token =
-        std::dynamic_pointer_cast<TokenType>(tokens[i]);
-    if (token != nullptr && propertyCheck(token)) {
-      return true;
-    }
-  }
-  return false;
+    std::function<bool(const TokenPtr<TokenType>)> propertyCheck) const {
+  return tokens.contains<TokenType>(propertyCheck);
 }
 
 #endif  // AMOEBOTSIM_CORE_AMOEBOTPARTICLE_H_
@@ -4,23 +4,78 @@
 
 #include "core/amoebotsystem.h"
 
+#include <algorithm>
+#include <limits>
+#include <set>
+#include <sstream>
+
 #include <QDateTime>
 #include <QtGlobal>
-#include <random>
 
+#include "core/activationtrace.h"
 #include "core/amoebotparticle.h"
+#include "core/metricsink.h"
+#include "core/resultsink.h"
+
+namespace {
+
+// Writes the given history as the fields of a metrics JSON object: "rounds",
+// the round of each stored value, if the history's policy drops values, and
+// "history", the stored values. Values are recorded every frequency rounds.
+template<class T>
+void writeHistoryJSON(QTextStream& out, const MetricHistory<T>& history,
+                      const unsigned int frequency) {
+  if (history.policy() == HistoryPolicy::Recent ||
+      history.policy() == HistoryPolicy::Decimated) {
+    const std::vector<std::size_t> indices = history.indices();
+    out << "\"rounds\" : [";
+    for (std::size_t i = 0; i < indices.size(); ++i) {
+      out << ((i > 0) ? ", " : "")
+          << static_cast<qulonglong>(indices[i]) * frequency;
+    }
+    out << "], ";
+  }
+
+  const std::vector<T> values = history.values();
+  out << "\"history\" : [";
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    out << ((i > 0) ? ", " : "") << values[i];
+  }
+  out << "]";
+}
+
+}  // namespace
 
-AmoebotSystem::AmoebotSystem() {
-  _counts.push_back(new Count("# Rounds"));
-  _counts.push_back(new Count("# Activations"));
-  _counts.push_back(new Count("# Moves"));
+AmoebotSystem::AmoebotSystem(const unsigned int seed)
+  : RandomNumberGenerator(randomEngine),
+    activationEpoch(1),
+    numActivatedThisEpoch(0),
+    numDormant(0),
+    numUndrawnDormant(0),
+    numCountedDormant(0),
+    particleType(nullptr),
+    uniformParticleType(true),
+    stateCounts{},
+    heldTokens(0),
+    randomEngine(seed),
+    permutationScheduler(randomEngine),
+    activationRecorder(nullptr),
+    resultSink(nullptr),
+    resultReported(false),
+    dirtyTracking(false) {
+  roundsCount = addCount("# Rounds");
+  activationsCount = addCount("# Activations");
+  movesCount = addCount("# Moves");
 }
 
 AmoebotSystem::~AmoebotSystem() {
   for (auto p : particles) {
-    delete p;
+    if (!p->inParticleArena) {
+      delete p;
+    }
   }
   particles.clear();
+  particleArena.clear();
 
   for (auto t : objects) {
     delete t;
@@ -37,38 +92,73 @@ AmoebotSystem::~AmoebotSystem() {
 }
 
 void AmoebotSystem::activate() {
+  AmoebotParticle* particle = activateScheduled();
+  if (activationRecorder != nullptr && particle != nullptr) {
+    activationRecorder->record(particle->snapshotIndex, true);
+  }
+}
+
+void AmoebotSystem::activateParticleAt(Node node) {
+  AmoebotParticle* particle = lattice.particleAt(node);
+  if (particle != nullptr) {
+    activateDirectly(particle);
+    if (activationRecorder != nullptr) {
+      activationRecorder->record(particle->snapshotIndex, false);
+    }
+  }
+}
+
+AmoebotParticle* AmoebotSystem::activateScheduled() {
+  // Dormant particles would do nothing if activated, so they are skipped (see
+  // AmoebotParticle::sleep).
+  if (activeParticles.empty()) {
+    return nullptr;
+  }
+
   if (!randomPermutationScheduler) {
     // default behaviour: activate random particle
-    int rand = randInt(0, particles.size());
-    particles.at(rand)->activate();
-    registerActivation(particles.at(rand));
+    drawDormantParticles();
+    AmoebotParticle* particle =
+        activeParticles[randInt(0, activeParticles.size())];
+    particle->activate();
+    registerActivation(particle);
+    return particle;
   }
   else {
-    // modified behavior: activate the next particle 
+    // modified behavior: activate the next particle
     // in a random permutation of the particles
-    if (permutationIndex == 0) {
-      rng.seed(time(0));
-      std::shuffle(std::begin(particles), std::end(particles), rng);
-    }
-    particles.at(permutationIndex)->activate();
-    registerActivation(particles.at(permutationIndex));
-    permutationIndex += 1;
-    double rndDouble = randDouble(0.0, 1.0);
-    if (rndDouble < randomReshuffleProb) {
-      std::shuffle(std::begin(particles), std::end(particles), rng);
+    // Permutations still run over all particles so that their cycles keep
+    // lining up with rounds; dormant particles are passed over, counting
+    // toward the round as if they had been activated.
+    AmoebotParticle* particle =
+        particles[permutationScheduler.next(particles.size())];
+    while (particle->dormant) {
+      countActivation(particle);
+      if (numActivatedThisEpoch >= particles.size()) {
+        completeRound();
+      }
+      particle = particles[permutationScheduler.next(particles.size())];
     }
-    if (permutationIndex >= particles.size()) {
-      permutationIndex = 0;
+    particle->activate();
+    registerActivation(particle);
+    if (randomReshuffleProb > 0.0 && randBool(randomReshuffleProb)) {
+      permutationScheduler.reshuffle();
     }
+    return particle;
   }
 }
 
-void AmoebotSystem::activateParticleAt(Node node) {
-  auto it = particleMap.find(node);
-  if (it != particleMap.end()) {
-    it->second->activate();
-    registerActivation(it->second);
-  }
+void AmoebotSystem::activateDirectly(AmoebotParticle* particle) {
+  particle->activate();
+  registerActivation(particle);
+}
+
+bool AmoebotSystem::supportsParallelRounds() const {
+  return false;
+}
+
+uint64_t AmoebotSystem::getSeed() const {
+  return randomEngine.getSeed();
 }
 
 unsigned int AmoebotSystem::size() const {
@@ -87,37 +177,255 @@ const std::deque<Object*>& AmoebotSystem::getObjects() const {
   return objects;
 }
 
+const ParticleSnapshot& AmoebotSystem::snapshot() const {
+  return _snapshot;
+}
+
+void AmoebotSystem::addChangeListener(ChangeListener* listener) {
+  changeListeners.push_back(listener);
+}
+
+void AmoebotSystem::removeChangeListener(ChangeListener* listener) {
+  changeListeners.erase(std::remove(changeListeners.begin(),
+                                    changeListeners.end(), listener),
+                        changeListeners.end());
+}
+
+void AmoebotSystem::setDirtyTracking(bool enabled) {
+  dirtyTracking = enabled;
+  if (!enabled) {
+    std::vector<AmoebotParticle*> dirty;
+    takeDirtyParticles(dirty);
+  }
+}
+
+void AmoebotSystem::takeDirtyParticles(std::vector<AmoebotParticle*>& dirty) {
+  dirty.clear();
+  dirty.swap(dirtyParticles);
+  for (AmoebotParticle* particle : dirty) {
+    particle->dirty = false;
+  }
+}
+
 void AmoebotSystem::insert(AmoebotParticle* particle) {
-  Q_ASSERT(particleMap.find(particle->head) == particleMap.end());
-  Q_ASSERT(objectMap.find(particle->head) == objectMap.end());
+  Q_ASSERT(lattice.particleAt(particle->head) == nullptr);
+  Q_ASSERT(lattice.objectAt(particle->head) == nullptr);
   Q_ASSERT(!particle->isExpanded() ||
-           particleMap.find(particle->tail()) == particleMap.end());
+           lattice.particleAt(particle->tail()) == nullptr);
+
+  const std::type_info& type = typeid(*particle);
+  if (particleType == nullptr) {
+    particleType = &type;
+  } else if (*particleType != type) {
+    uniformParticleType = false;
+  }
 
   particles.push_back(particle);
-  particleMap[particle->head] = particle;
+  if (particle->dormant) {
+    ++numDormant;
+    ++numUndrawnDormant;
+  } else {
+    particle->activeSlot = activeParticles.size();
+    activeParticles.push_back(particle);
+  }
+  particle->snapshotIndex = _snapshot.size();
+  _snapshot.particle.push_back(particle);
+  _snapshot.headX.push_back(particle->head.x);
+  _snapshot.headY.push_back(particle->head.y);
+  _snapshot.tailDir.push_back(particle->globalTailDir);
+  _snapshot.state.push_back(particle->snapshotState);
+  stateCounts[particle->snapshotState]++;
+  heldTokens += particle->tokens.size();
+  lattice.setParticle(particle->head, particle);
   if (particle->isExpanded()) {
-    particleMap[particle->tail()] = particle;
+    lattice.setParticle(particle->tail(), particle);
+  }
+
+  particle->reportChange(ChangeEvent::Type::NodeOccupied, particle->head);
+  if (particle->isExpanded()) {
+    particle->reportChange(ChangeEvent::Type::NodeOccupied, particle->tail());
+  }
+}
+
+void AmoebotSystem::reserveFor(
+    const std::vector<ConfigurationRecord>& records) {
+  if (records.empty()) {
+    return;
+  }
+
+  const std::size_t size = particles.size() + records.size();
+  particles.reserve(size);
+  activeParticles.reserve(size);
+  _snapshot.particle.reserve(size);
+  _snapshot.headX.reserve(size);
+  _snapshot.headY.reserve(size);
+  _snapshot.tailDir.reserve(size);
+  _snapshot.state.reserve(size);
+
+  // Grow the lattice index once to the configuration's bounding box (padded by
+  // one node for tails) instead of tile by tile.
+  int minX = records[0].x, maxX = records[0].x;
+  int minY = records[0].y, maxY = records[0].y;
+  for (const ConfigurationRecord& record : records) {
+    minX = std::min(minX, record.x);
+    maxX = std::max(maxX, record.x);
+    minY = std::min(minY, record.y);
+    maxY = std::max(maxY, record.y);
   }
+  lattice.reserve(Node(minX - 1, minY - 1));
+  lattice.reserve(Node(maxX + 1, maxY + 1));
 }
 
 void AmoebotSystem::insert(Object* object) {
-  Q_ASSERT(objectMap.find(object->_node) == objectMap.end());
-  Q_ASSERT(particleMap.find(object->_node) == particleMap.end());
+  Q_ASSERT(lattice.objectAt(object->_node) == nullptr);
+  Q_ASSERT(lattice.particleAt(object->_node) == nullptr);
 
   objects.push_back(object);
-  objectMap[object->_node] = object;
+  lattice.setObject(object->_node, object);
 }
 
 void AmoebotSystem::registerMovement(unsigned int numMoves) {
-  getCount("# Moves").record(numMoves);
+  count(movesCount).record(numMoves);
 }
 
 void AmoebotSystem::registerActivation(AmoebotParticle* particle) {
-  getCount("# Activations").record();
-  activatedParticles.insert(particle);
-  if (activatedParticles.size() == particles.size()) {
-    registerRound();
-    activatedParticles.clear();
+  count(activationsCount).record();
+  countActivation(particle);
+  if (ActivationTally::current == nullptr &&
+      numActivatedThisEpoch >= particles.size()) {
+    completeRound();
+  }
+}
+
+void AmoebotSystem::countActivation(AmoebotParticle* particle) {
+  if (particle->activationEpoch == activationEpoch) {
+    return;
+  }
+  if (particle->dormant) {
+    // Dormant particles are alike to the round detection, so this one stands
+    // in for any of those drawDormantParticles has not counted yet.
+    if (numUndrawnDormant == 0) {
+      return;
+    }
+    --numUndrawnDormant;
+    ++numCountedDormant;
+  }
+
+  particle->activationEpoch = activationEpoch;
+  ActivationTally* tally = ActivationTally::current;
+  if (tally != nullptr) {
+    // Concurrent activations leave completing the round to their scheduler.
+    tally->numFirstActivations++;
+  } else {
+    ++numActivatedThisEpoch;
+  }
+}
+
+void AmoebotSystem::completeRound() {
+  registerRound();
+  ++activationEpoch;
+  numActivatedThisEpoch = 0;
+  numUndrawnDormant = numDormant;
+  numCountedDormant = 0;
+}
+
+void AmoebotSystem::drawDormantParticles() {
+  // Among the draws of a scheduler choosing uniformly from all particles, the
+  // ones that matter for round detection are draws of active particles and
+  // first draws of dormant particles in the current round. The next such draw
+  // is the latter with probability u / (u + a) for u undrawn dormant and a
+  // active particles; all dormant particles are alike, so only u is tracked.
+  while (numUndrawnDormant > 0 &&
+         randInt(0, numUndrawnDormant + activeParticles.size()) <
+             static_cast<int>(numUndrawnDormant)) {
+    --numUndrawnDormant;
+    ++numActivatedThisEpoch;
+    if (numActivatedThisEpoch >= particles.size()) {
+      completeRound();
+    }
+  }
+}
+
+void AmoebotSystem::updateActiveSet(AmoebotParticle* particle) {
+  ActivationTally* tally = ActivationTally::current;
+  if (tally != nullptr) {
+    tally->dormancyChanges.push_back(particle);
+    return;
+  }
+
+  const bool counted = particle->activationEpoch == activationEpoch;
+  if (particle->dormant && particle->activeSlot != -1) {
+    // Swap the particle with the last active one and drop it.
+    AmoebotParticle* last = activeParticles.back();
+    activeParticles[particle->activeSlot] = last;
+    last->activeSlot = particle->activeSlot;
+    activeParticles.pop_back();
+    particle->activeSlot = -1;
+    ++numDormant;
+    ++(counted ? numCountedDormant : numUndrawnDormant);
+  } else if (!particle->dormant && particle->activeSlot == -1) {
+    // Of the d dormant particles whose activations do not count toward the
+    // current round, u are undrawn (see drawDormantParticles), so this one is
+    // with probability u / d; otherwise it was drawn and counts.
+    if (counted) {
+      --numCountedDormant;
+    } else if (randInt(0, numDormant - numCountedDormant) <
+               static_cast<int>(numUndrawnDormant)) {
+      --numUndrawnDormant;
+    } else {
+      particle->activationEpoch = activationEpoch;
+    }
+    particle->activeSlot = activeParticles.size();
+    activeParticles.push_back(particle);
+    --numDormant;
+  }
+}
+
+void AmoebotSystem::mergeTally(ActivationTally& tally) {
+  for (const auto& delta : tally.countDeltas) {
+    delta.first->_value += delta.second;
+  }
+  for (unsigned int state = 0; state < tally.stateDeltas.size(); ++state) {
+    stateCounts[state] += tally.stateDeltas[state];
+  }
+  heldTokens += tally.heldTokensDelta;
+  numActivatedThisEpoch += tally.numFirstActivations;
+  for (AmoebotParticle* particle : tally.dormancyChanges) {
+    updateActiveSet(particle);
+  }
+  dirtyParticles.insert(dirtyParticles.end(), tally.dirtyParticles.begin(),
+                        tally.dirtyParticles.end());
+  for (const ChangeEvent& event : tally.changes) {
+    notifyChange(event);
+  }
+  tally.clear();
+}
+
+void AmoebotSystem::markChanged(AmoebotParticle* particle) {
+  particle->wake();
+  if (dirtyTracking && !particle->dirty) {
+    particle->dirty = true;
+    ActivationTally* tally = ActivationTally::current;
+    if (tally != nullptr) {
+      tally->dirtyParticles.push_back(particle);
+    } else {
+      dirtyParticles.push_back(particle);
+    }
+  }
+}
+
+void AmoebotSystem::notifyChange(const ChangeEvent& event) {
+  if (changeListeners.empty()) {
+    return;
+  }
+
+  ActivationTally* tally = ActivationTally::current;
+  if (tally != nullptr) {
+    tally->changes.push_back(event);
+    return;
+  }
+  for (ChangeListener* listener : changeListeners) {
+    listener->changed(event);
   }
 }
 
@@ -125,12 +433,56 @@ void AmoebotSystem::registerRound() {
   for (const auto& c : _counts) {
     c->_history.push_back(c->_value);
   }
-  for (const auto& m : _measures) {
-    if (getCount("# Rounds")._value % m->_freq == 0) {
-      m->_history.push_back(m->calculate());
+  Count& rounds = count(roundsCount);
+  roundMeasureValues.assign(_measures.size(),
+                            std::numeric_limits<double>::quiet_NaN());
+  for (std::size_t i = 0; i < _measures.size(); ++i) {
+    Measure* m = _measures[i];
+    if (rounds._value % m->_freq == 0) {
+      roundMeasureValues[i] = m->calculate();
+      m->_history.push_back(roundMeasureValues[i]);
     }
   }
-  getCount("# Rounds").record();
+  for (MetricSink* sink : metricSinks) {
+    sink->writeRound(rounds._value, _counts, roundMeasureValues);
+  }
+  rounds.record();
+}
+
+void AmoebotSystem::addMetricSink(MetricSink* sink) {
+  sink->begin(_counts, _measures);
+  metricSinks.push_back(sink);
+}
+
+void AmoebotSystem::removeMetricSink(MetricSink* sink) {
+  metricSinks.erase(std::remove(metricSinks.begin(), metricSinks.end(), sink),
+                    metricSinks.end());
+}
+
+bool AmoebotSystem::reportsResults() const {
+  return false;
+}
+
+void AmoebotSystem::setResultSink(ResultSink* sink, const QString label) {
+  resultSink = sink;
+  resultLabel = label;
+}
+
+void AmoebotSystem::reportResult() {
+  if (resultSink == nullptr || resultReported) {
+    return;
+  }
+
+  ResultRow row;
+  row.label = resultLabel;
+  row.seed = getSeed();
+  row.numParticles = size();
+  row.rounds = count(roundsCount)._value;
+  row.activations = count(activationsCount)._value;
+  row.moves = count(movesCount)._value;
+  writeResult(row);
+  resultSink->report(row);
+  resultReported = true;
 }
 
 const std::vector<Count*>& AmoebotSystem::getCounts() const {
@@ -150,6 +502,31 @@ Count& AmoebotSystem::getCount(QString name) const {
   Q_ASSERT(false);  // Requested count does not exist.
 }
 
+void AmoebotSystem::setHistoryPolicy(const HistoryPolicy policy,
+                                     const std::size_t capacity) {
+  for (const auto& c : _counts) {
+    c->_history.setPolicy(policy, capacity);
+  }
+  for (const auto& m : _measures) {
+    m->_history.setPolicy(policy, capacity);
+  }
+}
+
+CountHandle AmoebotSystem::addCount(const QString name) {
+  _counts.push_back(new Count(name));
+  return CountHandle(_counts.size() - 1);
+}
+
+CountHandle AmoebotSystem::countHandle(QString name) const {
+  for (unsigned int i = 0; i < _counts.size(); ++i) {
+    if (QString::compare(_counts[i]->_name, name) == 0) {
+      return CountHandle(i);
+    }
+  }
+  Q_ASSERT(false);  // Requested count does not exist.
+  return CountHandle();
+}
+
 Measure& AmoebotSystem::getMeasure(QString name) const {
   for (const auto& m : _measures) {
     if (QString::compare(m->_name, name) == 0) {
@@ -160,42 +537,354 @@ Measure& AmoebotSystem::getMeasure(QString name) const {
 }
 
 
-const QString AmoebotSystem::metricsAsJSON() const {
-  QString json = "{\"title\" : \"AmoebotSim Metrics JSON\", ";
-  json += "\"datetime\" : \"" +
-          QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss") + "\", ";
-  json += "\"algorithm\" : \"???\", ";
-  json += "\"counts\" : [";
+// The part of a checkpoint owned by the system itself, as read and validated by
+// AmoebotSystem::stageCheckpoint.
+struct AmoebotSystem::StagedCheckpoint {
+  struct Particle {
+    Node head;
+    int globalTailDir;
+    unsigned char state;
+    unsigned int activationEpoch;
+    bool dormant;
+  };
+
+  explicit StagedCheckpoint(RandomEngine& engine)
+      : permutationScheduler(engine) {}
+
+  uint64_t seed;
+  std::array<uint64_t, 4> engineState;
+  bool randomPermutationScheduler;
+  double randomReshuffleProb;
+  PermutationScheduler permutationScheduler;
+  unsigned int activationEpoch;
+  unsigned int numActivatedThisEpoch;
+  unsigned int numDormant;
+  unsigned int numUndrawnDormant;
+  unsigned int numCountedDormant;
+  std::vector<unsigned int> countValues;
+  std::vector<MetricHistory<unsigned int>> countHistories;
+  std::vector<MetricHistory<double>> measureHistories;
+  std::vector<Particle> particles;
+  std::vector<unsigned int> activeIndices;
+};
+
+bool AmoebotSystem::supportsCheckpoints() const {
+  return false;
+}
+
+void AmoebotSystem::writeCheckpoint(CheckpointWriter& out) const {
+  Q_ASSERT(supportsCheckpoints());
+  Q_ASSERT(ActivationTally::current == nullptr);
+
+  out.writeString(typeid(*this).name());
+  out.writeUInt(particles.size());
+  out.writeUInt(objects.size());
+
+  // Scheduling and round detection.
+  out.writeUInt64(randomEngine.getSeed());
+  for (const uint64_t word : randomEngine.getState()) {
+    out.writeUInt64(word);
+  }
+  out.writeBool(randomPermutationScheduler);
+  out.writeDouble(randomReshuffleProb);
+  permutationScheduler.writeCheckpoint(out);
+  out.writeUInt(activationEpoch);
+  out.writeUInt(numActivatedThisEpoch);
+  out.writeUInt(numDormant);
+  out.writeUInt(numUndrawnDormant);
+  out.writeUInt(numCountedDormant);
+
+  // Metrics.
+  out.writeUInt(_counts.size());
   for (const auto& c : _counts) {
-    json += "{\"name\" : \"" + c->_name + "\", ";
-    json += "\"history\" : [";
-    for (auto val : c->_history) {
-      json += QString::number(val) += ", ";
+    out.writeQString(c->_name);
+    out.writeUInt(c->_value);
+    c->_history.writeCheckpoint(out);
+  }
+  out.writeUInt(_measures.size());
+  for (const auto& m : _measures) {
+    out.writeQString(m->_name);
+    m->_history.writeCheckpoint(out);
+  }
+
+  // Particles, in insertion order, followed by the active ones.
+  for (const AmoebotParticle* p : particles) {
+    out.writeInt(p->head.x);
+    out.writeInt(p->head.y);
+    out.writeInt(p->globalTailDir);
+    out.writeInt(p->orientation);
+    out.writeUInt(p->snapshotState);
+    out.writeUInt(p->activationEpoch);
+    out.writeBool(p->dormant);
+  }
+  for (const AmoebotParticle* p : activeParticles) {
+    out.writeUInt(p->snapshotIndex);
+  }
+
+  // The particles' memory and tokens and the algorithm state come last, since
+  // they are read by the particles and the algorithm directly.
+  for (const AmoebotParticle* p : particles) {
+    const auto tokens = p->tokens.inOrder();
+    out.writeUInt(tokens.size());
+    for (const auto& token : tokens) {
+      p->writeToken(out, *token);
     }
-    if (!c->_history.empty()) {
-      json.chop(2);  // Remove the last ", ".
+    p->writeState(out);
+  }
+  writeAlgorithmState(out);
+}
+
+bool AmoebotSystem::readCheckpoint(CheckpointReader& in, QString& error) {
+  Q_ASSERT(supportsCheckpoints());
+  Q_ASSERT(ActivationTally::current == nullptr);
+
+  if (in.failed()) {
+    error = "not a checkpoint, or written by another version";
+    return false;
+  }
+  if (in.readString() != typeid(*this).name()) {
+    error = "checkpoint of a different algorithm";
+    return false;
+  }
+  StagedCheckpoint staged(randomEngine);
+  if (!stageCheckpoint(in, staged)) {
+    error = "checkpoint is corrupt or does not match this system";
+    return false;
+  }
+
+  // The particles' memory and tokens and the algorithm state can only be read
+  // into the system itself, so the system is backed up in memory first and
+  // restored from the backup if reading them fails.
+  std::stringstream backup;
+  {
+    CheckpointWriter out(backup);
+    writeCheckpoint(out);
+  }
+  commitCheckpoint(staged);
+  if (readParticleData(in)) {
+    return true;
+  }
+
+  CheckpointReader backupIn(backup);
+  backupIn.readString();
+  StagedCheckpoint original(randomEngine);
+  const bool valid = stageCheckpoint(backupIn, original);
+  Q_ASSERT(valid);
+  Q_UNUSED(valid);
+  commitCheckpoint(original);
+  const bool restored = readParticleData(backupIn);
+  Q_ASSERT(restored);
+  Q_UNUSED(restored);
+  error = "checkpoint is corrupt or does not match this system";
+  return false;
+}
+
+bool AmoebotSystem::stageCheckpoint(CheckpointReader& in,
+                                    StagedCheckpoint& staged) const {
+  in.expectUInt(particles.size());
+  in.expectUInt(objects.size());
+
+  // Scheduling and round detection.
+  staged.seed = in.readUInt64();
+  for (uint64_t& word : staged.engineState) {
+    word = in.readUInt64();
+  }
+  staged.randomPermutationScheduler = in.readBool();
+  staged.randomReshuffleProb = in.readDouble();
+  staged.permutationScheduler.readCheckpoint(in);
+  staged.activationEpoch = in.readUInt();
+  staged.numActivatedThisEpoch = in.readUInt();
+  staged.numDormant = in.readUInt();
+  staged.numUndrawnDormant = in.readUInt();
+  staged.numCountedDormant = in.readUInt();
+
+  // Metrics, which the system's constructor has registered already.
+  in.expectUInt(_counts.size());
+  staged.countValues.resize(_counts.size());
+  staged.countHistories.resize(_counts.size());
+  for (std::size_t i = 0; i < _counts.size() && !in.failed(); ++i) {
+    if (in.readQString() != _counts[i]->_name) {
+      in.fail();
     }
-    json += "]}, ";
+    staged.countValues[i] = in.readUInt();
+    staged.countHistories[i].readCheckpoint(in);
   }
-  if (!_counts.empty()) {
-    json.chop(2);  // Remove the last ", ".
+  in.expectUInt(_measures.size());
+  staged.measureHistories.resize(_measures.size());
+  for (std::size_t i = 0; i < _measures.size() && !in.failed(); ++i) {
+    if (in.readQString() != _measures[i]->_name) {
+      in.fail();
+    }
+    staged.measureHistories[i].readCheckpoint(in);
   }
-  json += "], \"measures\" : [";
-  for (const auto& m : _measures) {
-    json += "{\"name\" : \"" + m->_name + "\", ";
-    json += "\"frequency\" : " + QString::number(m->_freq) + ", ";
-    json += "\"history\" : [";
-    for (auto val : m->_history) {
-      json += QString::number(val) += ", ";
+
+  // Particles. No two may occupy the same node, nor a node with an object.
+  staged.particles.resize(particles.size());
+  std::set<Node> occupied;
+  unsigned int dormantFound = 0;
+  for (std::size_t i = 0; i < particles.size() && !in.failed(); ++i) {
+    StagedCheckpoint::Particle& p = staged.particles[i];
+    p.head.x = in.readInt();
+    p.head.y = in.readInt();
+    p.globalTailDir = in.readInt();
+    if (p.globalTailDir < -1 || p.globalTailDir > 5 ||
+        in.readInt() != particles[i]->orientation) {
+      in.fail();
+      break;
+    }
+    const uint32_t state = in.readUInt();
+    if (state > 255) {
+      in.fail();
     }
-    if (!m->_history.empty()) {
-      json.chop(2);  // Remove the last ", ".
+    p.state = static_cast<unsigned char>(state);
+    p.activationEpoch = in.readUInt();
+    p.dormant = in.readBool();
+
+    std::vector<Node> nodes = {p.head};
+    if (p.globalTailDir != -1) {
+      nodes.push_back(p.head.nodeInDir(p.globalTailDir));
     }
-    json += "]}, ";
+    for (const Node& node : nodes) {
+      if (!occupied.insert(node).second || lattice.objectAt(node) != nullptr) {
+        in.fail();
+      }
+    }
+    dormantFound += p.dormant ? 1 : 0;
+  }
+  if (dormantFound != staged.numDormant ||
+      staged.numUndrawnDormant + staged.numCountedDormant > staged.numDormant) {
+    in.fail();
+  }
+
+  std::vector<bool> isActive(particles.size(), false);
+  for (unsigned int i = staged.numDormant;
+       i < particles.size() && !in.failed(); ++i) {
+    const uint32_t index = in.readUInt();
+    if (index >= particles.size() || staged.particles[index].dormant ||
+        isActive[index]) {
+      in.fail();
+      break;
+    }
+    isActive[index] = true;
+    staged.activeIndices.push_back(index);
+  }
+
+  return !in.failed();
+}
+
+void AmoebotSystem::commitCheckpoint(StagedCheckpoint& staged) {
+  // Scheduling and round detection.
+  randomEngine.setState(staged.seed, staged.engineState);
+  randomPermutationScheduler = staged.randomPermutationScheduler;
+  randomReshuffleProb = staged.randomReshuffleProb;
+  permutationScheduler = std::move(staged.permutationScheduler);
+  activationEpoch = staged.activationEpoch;
+  numActivatedThisEpoch = staged.numActivatedThisEpoch;
+  numDormant = staged.numDormant;
+  numUndrawnDormant = staged.numUndrawnDormant;
+  numCountedDormant = staged.numCountedDormant;
+
+  // Metrics.
+  for (std::size_t i = 0; i < _counts.size(); ++i) {
+    _counts[i]->_value = staged.countValues[i];
+    _counts[i]->_history = std::move(staged.countHistories[i]);
+  }
+  for (std::size_t i = 0; i < _measures.size(); ++i) {
+    _measures[i]->_history = std::move(staged.measureHistories[i]);
+  }
+
+  // Particles. All of them are lifted off the lattice first, since a particle
+  // may be restored onto a node another one occupies until it is restored.
+  // Their tokens are dropped until readParticleData restores them.
+  for (AmoebotParticle* p : particles) {
+    lattice.setParticle(p->head, nullptr);
+    if (p->isExpanded()) {
+      lattice.setParticle(p->tail(), nullptr);
+    }
+  }
+  stateCounts.fill(0);
+  heldTokens = 0;
+  for (std::size_t i = 0; i < particles.size(); ++i) {
+    AmoebotParticle* p = particles[i];
+    const StagedCheckpoint::Particle& record = staged.particles[i];
+    p->head = record.head;
+    p->globalTailDir = record.globalTailDir;
+    p->snapshotState = record.state;
+    p->activationEpoch = record.activationEpoch;
+    p->dormant = record.dormant;
+    p->activeSlot = -1;
+    p->dirty = false;
+    p->tokens = TokenMailbox<AmoebotParticle::Token>();
+    lattice.setParticle(p->head, p);
+    if (p->isExpanded()) {
+      lattice.setParticle(p->tail(), p);
+    }
+    p->refreshSnapshot();
+    _snapshot.state[p->snapshotIndex] = p->snapshotState;
+    stateCounts[p->snapshotState]++;
+  }
+
+  activeParticles.clear();
+  for (const unsigned int index : staged.activeIndices) {
+    particles[index]->activeSlot = activeParticles.size();
+    activeParticles.push_back(particles[index]);
+  }
+  dirtyParticles.clear();
+}
+
+bool AmoebotSystem::readParticleData(CheckpointReader& in) {
+  for (AmoebotParticle* p : particles) {
+    const uint32_t numTokens = in.readUInt();
+    for (uint32_t i = 0; i < numTokens && !in.failed(); ++i) {
+      auto token = p->readToken(in);
+      if (token == nullptr) {
+        in.fail();
+      } else {
+        p->tokens.put(std::move(token));
+      }
+    }
+    p->readState(in);
+    if (in.failed()) {
+      return false;
+    }
+    heldTokens += p->tokens.size();
+  }
+  readAlgorithmState(in);
+
+  return !in.failed();
+}
+
+void AmoebotSystem::writeAlgorithmState(CheckpointWriter& out) const {
+  Q_UNUSED(out);
+}
+
+void AmoebotSystem::readAlgorithmState(CheckpointReader& in) {
+  Q_UNUSED(in);
+}
+
+void AmoebotSystem::writeResult(ResultRow& row) const {
+  Q_UNUSED(row);
+}
+
+void AmoebotSystem::writeMetricsJSON(QTextStream& out) const {
+  out << "{\"title\" : \"AmoebotSim Metrics JSON\", ";
+  out << "\"datetime\" : \""
+      << QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss") << "\", ";
+  out << "\"algorithm\" : \"???\", ";
+  out << "\"counts\" : [";
+  for (std::size_t i = 0; i < _counts.size(); ++i) {
+    out << ((i > 0) ? ", " : "") << "{\"name\" : \"" << _counts[i]->_name
+        << "\", ";
+    writeHistoryJSON(out, _counts[i]->_history, 1);
+    out << "}";
   }
-  if (!_measures.empty()) {
-    json.chop(2);  // Remove the last ", ".
+  out << "], \"measures\" : [";
+  for (std::size_t i = 0; i < _measures.size(); ++i) {
+    out << ((i > 0) ? ", " : "") << "{\"name\" : \"" << _measures[i]->_name
+        << "\", ";
+    out << "\"frequency\" : " << _measures[i]->_freq << ", ";
+    writeHistoryJSON(out, _measures[i]->_history, _measures[i]->_freq);
+    out << "}";
   }
-  json += "]}";
-  return json;
+  out << "]}";
 }
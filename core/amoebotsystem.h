@@ -8,50 +8,85 @@
 #ifndef AMOEBOTSIM_CORE_AMOEBOTSYSTEM_H_
 #define AMOEBOTSIM_CORE_AMOEBOTSYSTEM_H_
 
+#include <array>
 #include <deque>
-#include <map>
-#include <set>
+#include <typeinfo>
 #include <vector>
-#include <random>
 
 #include <QString>
 
+#include "core/activationtally.h"
+#include "core/changeevent.h"
+#include "core/checkpoint.h"
+#include "core/configuration.h"
+#include "core/latticeindex.h"
 #include "core/metric.h"
 #include "core/object.h"
+#include "core/particlearena.h"
+#include "core/particlesnapshot.h"
+#include "core/permutationscheduler.h"
 #include "core/system.h"
+#include "core/tokenpool.h"
 #include "helper/randomnumbergenerator.h"
 
 // AmoebotParticle must be forward declared to avoid a cyclic dependency.
+class ActivationRecorder;
 class AmoebotParticle;
+class MetricSink;
+class ResultSink;
+struct ResultRow;
 
 class AmoebotSystem : public System, public RandomNumberGenerator {
+  friend class ActivationRecorder;
+  friend class ActivationReplayer;
   friend class AmoebotParticle;
+  friend class AsyncScheduler;
+  friend class ParallelRoundScheduler;
 
  public:
   // Constructs a new particle system with fresh round, activation, and movement
-  // counts.
-  AmoebotSystem();
+  // counts. All randomness of the system and its particles is drawn from a
+  // generator seeded with the given seed, so that runs with the same nonzero
+  // seed are reproducible; a seed of 0 picks a fresh seed.
+  explicit AmoebotSystem(const unsigned int seed = 0);
 
   // Deletes the particles, objects, and metrics in this system before
-  // destructing the system.
+  // destructing the system. Particles created by emplaceParticle are destroyed
+  // together with the arena holding them.
   virtual ~AmoebotSystem();
 
   // Functions for activating a particle in the system. activate activates a
-  // random particle in the system, while activateParticleAt activates the
-  // particle occupying the specified node if such a particle exists.
+  // random active particle in the system, skipping dormant ones (see
+  // AmoebotParticle::sleep), while activateParticleAt activates the particle
+  // occupying the specified node if such a particle exists. Both report the
+  // activation to the attached ActivationRecorder, if any (see
+  // core/activationtrace.h).
   void activate() final;
   void activateParticleAt(Node node) final;
 
-  // This variable can be set to true to change the functionality of the 
+  // This variable can be set to true to change the functionality of the
   // activate function. Instead of activating a random particle, it will
-  // activate the next particle in a random permutation of the particles.
+  // activate the next particle in a random permutation of the particles (see
+  // core/permutationscheduler.h).
   bool randomPermutationScheduler = false;
-  int permutationIndex = 0;
-  std::default_random_engine rng;
   // decimal number between 0 and 1. Change this value to make the permutation
-  // scheduler re-shuffle the permutation with this probability. 
+  // scheduler re-shuffle the rest of the permutation with this probability
+  // after each activation.
   double randomReshuffleProb = 0.0;
 
+  // Returns true if this system's particles may be activated concurrently by a
+  // ParallelRoundScheduler or an AsyncScheduler (see
+  // core/parallelroundscheduler.h and core/asyncscheduler.h). Systems should
+  // only override this to return true if an activation reads and writes
+  // nothing but the particles and nodes within distance 2 of the nodes the
+  // activated particle occupies, and uses no shared state other than the
+  // system's counts, random numbers, and tokens.
+  virtual bool supportsParallelRounds() const;
+
+  // Returns the seed this system's random number generator was seeded with.
+  // If the system was constructed with seed 0, this is the seed drawn instead.
+  uint64_t getSeed() const;
+
   // Returns the number of particles in the system.
   unsigned int size() const final;
 
@@ -64,18 +99,65 @@ class AmoebotSystem : public System, public RandomNumberGenerator {
   // Returns a reference to the object list.
   virtual const std::deque<Object*>& getObjects() const final;
 
+  // Returns the structure-of-arrays view of this system's particles. It is
+  // updated as particles are inserted and move, so it never needs refreshing.
+  const ParticleSnapshot& snapshot() const final;
+
+  // Functions for termination checks that run in constant time.
+  // numParticlesInState returns the number of particles whose snapshot state
+  // (see AmoebotParticle::setSnapshotState) is the given byte. numHeldTokens
+  // returns the number of tokens currently held by the particles. Both are
+  // updated as particles change state and pass tokens, so algorithms can decide
+  // termination without scanning their particles.
+  unsigned int numParticlesInState(unsigned char state) const;
+  unsigned int numHeldTokens() const;
+
+  // Functions for observing changes. addChangeListener registers a listener to
+  // be notified of every ChangeEvent in this system from now on, and
+  // removeChangeListener unregisters it. Listeners are not owned by the system.
+  void addChangeListener(ChangeListener* listener);
+  void removeChangeListener(ChangeListener* listener);
+
+  // Functions for dirty marking. While dirty tracking is enabled, every change
+  // marks the particles it affects as dirty: the particle that changed, its
+  // neighbors unless the change is a token put into it, and the neighbors of a
+  // node it vacated. Each particle is recorded once until takeDirtyParticles
+  // moves the dirty particles into the given vector and clears their marks, so
+  // marking takes constant time per change. Disabled by default.
+  void setDirtyTracking(bool enabled);
+  void takeDirtyParticles(std::vector<AmoebotParticle*>& dirty);
+
   // Inserts a particle or an object, respectively, into the system. A particle
   // can be contracted or expanded. Fails if the respective node(s) are already
   // occupied.
   void insert(AmoebotParticle* particle);
   void insert(Object* object);
 
+  // Constructs a particle of the given type from the given arguments in this
+  // system's particle arena and inserts it as above, returning its address.
+  // Particles are stored contiguously per type and freed in bulk along with
+  // the system, so this should be preferred over insert(new ...).
+  template<class ParticleType, class... Args>
+  ParticleType* emplaceParticle(Args&&... args);
+
+  // Inserts a particle of the given type for every record of the given
+  // configuration (see core/configuration.h), in order, as above. Each is
+  // constructed from its head, its tail direction, its orientation (drawn at
+  // random if the record leaves it unspecified), this system, and the given
+  // arguments. Memory for all of them is reserved up front.
+  template<class ParticleType, class... Args>
+  void emplaceParticles(const std::vector<ConfigurationRecord>& records,
+                        const Args&... args);
+
   // Functions for logging system progress. registerMovement logs the given
   // number of movements the system has made. registerActivation logs that the
   // given particle has been activated. When all particles have been activated
   // at least once, this resets its logging and triggers registerRound(), which
-  // commits all counts and measures to their histories and increments the
-  // number of completed asynchronous rounds by one.
+  // commits all counts and measures to their histories and to the attached
+  // metric sinks and increments the number of completed asynchronous rounds by
+  // one. Rounds are counted as if
+  // dormant particles were still drawn from (see drawDormantParticles), so
+  // their number is distributed as without dormancy.
   void registerMovement(unsigned int numMoves = 1);
   void registerActivation(AmoebotParticle* particle);
   void registerRound();
@@ -84,24 +166,306 @@ class AmoebotSystem : public System, public RandomNumberGenerator {
   // (resp., getMeasures) returns a reference to the count (resp., measure)
   // list. getCount (resp., getMeasure) returns a reference to the named count
   // (resp., measure). These functions crash if the requested count/measure is
-  // not found!
+  // not found! Since they compare names, they are meant for scripts and the
+  // GUI; algorithms recording counts during activations should use handles.
   const std::vector<Count*>& getCounts() const final;
   const std::vector<Measure*>& getMeasures() const final;
   Count& getCount(QString name) const final;
   Measure& getMeasure(QString name) const final;
 
-  // Formats the count and measure histories as a JSON string. The structure of
-  // this JSON string can be found in the Usage documentation.
-  const QString metricsAsJSON() const final;
+  // Sets how the histories of all counts and measures store their values (see
+  // HistoryPolicy in core/metric.h), e.g., to bound their memory in long runs;
+  // capacity is passed to MetricHistory::setPolicy. Must be called before the
+  // first round is registered. Restoring a checkpoint restores the policies it
+  // was written with.
+  void setHistoryPolicy(const HistoryPolicy policy,
+                        const std::size_t capacity = 0);
+
+  // Functions for handle-based count access. addCount registers a new count
+  // with the given name and returns a handle to it. countHandle returns a
+  // handle to the existing count with the given name (crashing if there is
+  // none) and is intended to be called once during setup. count resolves a
+  // handle to its count in constant time.
+  CountHandle addCount(const QString name);
+  CountHandle countHandle(QString name) const;
+  Count& count(CountHandle handle) const;
+
+  // Constructs a token of the given type from the given arguments in this
+  // system's token pool. Tokens created this way are recycled by the pool when
+  // their last TokenPtr is released.
+  template<class TokenType, class... Args>
+  TokenPtr<TokenType> makeToken(Args&&... args);
+
+  // Writes the count and measure histories as JSON to the given stream. The
+  // structure of this JSON can be found in the Usage documentation.
+  void writeMetricsJSON(QTextStream& out) const final;
+
+  // Functions for streaming metrics (see core/metricsink.h). addMetricSink
+  // writes the header of the given sink for this system's counts and measures,
+  // which must all be registered by then, and has every round committed from
+  // now on written to it; removeMetricSink detaches it again. Sinks are not
+  // owned by the system and are not part of a checkpoint.
+  void addMetricSink(MetricSink* sink);
+  void removeMetricSink(MetricSink* sink);
+
+  // Functions for reporting results (see core/resultsink.h). setResultSink has
+  // the result of this system's run reported to the given sink under the given
+  // label, e.g., the algorithm's signature and parameters. reportResult fills
+  // in the result with writeResult and reports it, unless there is no sink or
+  // it has been reported already. Sinks are not owned by the system.
+  // reportsResults returns true if writeResult reports an outcome specific to
+  // the algorithm, i.e., if the results of interactive runs are worth keeping;
+  // the GUI only attaches its sink to such systems. The default returns false.
+  void setResultSink(ResultSink* sink, const QString label);
+  void reportResult() final;
+  virtual bool reportsResults() const;
+
+  // Functions for checkpoints (see core/checkpoint.h). writeCheckpoint writes
+  // everything needed to continue this system's run exactly where it stands:
+  // the particles' positions, memory, and tokens, the state of the random
+  // number generator and the permutation scheduler, the round detection and
+  // dormancy state, and the metric histories. readCheckpoint restores such a
+  // checkpoint into a system constructed with the same algorithm, parameters,
+  // and seed; it returns false with a description in error if the checkpoint
+  // is unreadable or does not match, in which case the system is left as it
+  // was. Change listeners and dirty marks are not part of a checkpoint.
+  // Only systems whose supportsCheckpoints returns true, i.e., whose particles
+  // and system override the checkpoint hooks below and in AmoebotParticle, may
+  // be checkpointed.
+  virtual bool supportsCheckpoints() const;
+  void writeCheckpoint(CheckpointWriter& out) const;
+  bool readCheckpoint(CheckpointReader& in, QString& error);
 
  protected:
   std::vector<AmoebotParticle*> particles;
-  std::map<Node, AmoebotParticle*> particleMap;
-  std::set<AmoebotParticle*> activatedParticles;
   std::deque<Object*> objects;
-  std::map<Node, Object*> objectMap;
+
+  // Round detection state. Each particle is stamped with the current epoch the
+  // first time it is activated in a round, and numActivatedThisEpoch counts the
+  // distinct particles stamped so far; the epoch advances with every round.
+  unsigned int activationEpoch;
+  unsigned int numActivatedThisEpoch;
+
+  // The particles that are not dormant, in no particular order, the number of
+  // dormant particles, the number of those that have not been drawn in the
+  // current round (see drawDormantParticles), and the number of those stamped
+  // with the current activation epoch. Each active particle knows its index in
+  // activeParticles, so both sleeping and waking take constant time.
+  std::vector<AmoebotParticle*> activeParticles;
+  unsigned int numDormant;
+  unsigned int numUndrawnDormant;
+  unsigned int numCountedDormant;
+
+  // The dynamic type of the first particle inserted into this system, and
+  // whether every particle inserted since has had the same type. Particles use
+  // this to skip RTTI when accessing their neighbors.
+  const std::type_info* particleType;
+  bool uniformParticleType;
+
+  // Column-wise copies of the particles' positions and states, indexed by
+  // insertion order; maintained by insert() and the AmoebotParticle movements.
+  ParticleSnapshot _snapshot;
+
+  // The number of particles in each snapshot state and the number of tokens
+  // held by particles; maintained by insert() and the AmoebotParticle state and
+  // token functions.
+  std::array<unsigned int, 256> stateCounts;
+  unsigned int heldTokens;
+
+  // Maps occupied nodes to the particles and objects occupying them.
+  LatticeIndex lattice;
   std::vector<Count*> _counts;
   std::vector<Measure*> _measures;
+
+  // The attached metric sinks, and the values of the measures calculated in
+  // the round being committed (NaN for the others), which are passed to them.
+  std::vector<MetricSink*> metricSinks;
+  std::vector<double> roundMeasureValues;
+
+  // Handles to the counts every AmoebotSystem maintains.
+  CountHandle roundsCount;
+  CountHandle activationsCount;
+  CountHandle movesCount;
+
+  // Write (respectively, read) any algorithm-specific state of this system
+  // beyond its particles' memory (see AmoebotParticle::writeState); called
+  // after all particles have been written (respectively, restored). The
+  // defaults do nothing.
+  virtual void writeAlgorithmState(CheckpointWriter& out) const;
+  virtual void readAlgorithmState(CheckpointReader& in);
+
+  // Fills in the algorithm-specific fields of the given result, whose other
+  // fields already hold this system's label, seed, size, and counts; called by
+  // reportResult. The default does nothing.
+  virtual void writeResult(ResultRow& row) const;
+
+ private:
+  // The generator all randomness of this system and its particles is drawn
+  // from, through the RandomNumberGenerator interface.
+  RandomEngine randomEngine;
+
+  // Orders the activations if randomPermutationScheduler is set.
+  PermutationScheduler permutationScheduler;
+
+  // Owns the particles created by emplaceParticle.
+  ParticleArena particleArena;
+
+  // The recorder of this system's activations, or nullptr; set by the
+  // ActivationRecorder itself.
+  ActivationRecorder* activationRecorder;
+
+  // The sink results are reported to, or nullptr, the label they are reported
+  // under, and whether the result of this run has been reported.
+  ResultSink* resultSink;
+  QString resultLabel;
+  bool resultReported;
+
+  // The implementations of activate and activateParticleAt, without
+  // recording, which replays use as well. activateScheduled activates the
+  // next particle chosen by the scheduler and returns it, or nullptr if all
+  // particles are dormant; activateDirectly activates the given particle.
+  AmoebotParticle* activateScheduled();
+  void activateDirectly(AmoebotParticle* particle);
+
+  // The steps of readCheckpoint. stageCheckpoint reads the part of a
+  // checkpoint owned by the system itself (everything but the particles' memory
+  // and tokens and the algorithm state) into the given staging area and
+  // validates it without changing the system. commitCheckpoint applies a
+  // staged checkpoint, and readParticleData then has the particles and the
+  // algorithm read their own state, which cannot be staged; it returns false if
+  // that fails, leaving the system to be restored from a backup.
+  struct StagedCheckpoint;
+  bool stageCheckpoint(CheckpointReader& in, StagedCheckpoint& staged) const;
+  void commitCheckpoint(StagedCheckpoint& staged);
+  bool readParticleData(CheckpointReader& in);
+
+  // Reserves memory for inserting the particles of the given configuration,
+  // so that emplaceParticles grows no container more than once.
+  void reserveFor(const std::vector<ConfigurationRecord>& records);
+
+  // Apply a particle's move from one snapshot state to another (respectively,
+  // a change in the number of held tokens) to the counters above, or to the
+  // current thread's ActivationTally during concurrent activations.
+  void moveStateCount(unsigned char from, unsigned char to);
+  void addHeldTokens(int delta);
+
+  // Applies the changes accumulated in the given tally of concurrent
+  // activations to the counts and counters above, delivers its change events,
+  // and clears it. Particles
+  // activated for the first time in the current round are added to
+  // numActivatedThisEpoch; completing the round is left to the caller.
+  void mergeTally(ActivationTally& tally);
+
+  // Functions for round detection. countActivation stamps the given particle
+  // as activated in the current round unless it already is; a dormant particle
+  // is only stamped if some dormant particle is still undrawn. completeRound
+  // registers the round and begins the next one. drawDormantParticles
+  // simulates the draws of dormant particles that a scheduler drawing
+  // uniformly from all particles would make before its next draw of an active
+  // one, counting each dormant particle drawn for the first time in the
+  // current round as activated; it is called before every such activation.
+  // The permutation scheduler instead passes over dormant particles in its
+  // cycles, counting them with countActivation.
+  void countActivation(AmoebotParticle* particle);
+  void completeRound();
+  void drawDormantParticles();
+
+  // Adds the given particle to or removes it from activeParticles according to
+  // whether it is dormant. During concurrent activations, the change is
+  // recorded in the current thread's ActivationTally and applied by mergeTally.
+  void updateActiveSet(AmoebotParticle* particle);
+
+  // Functions for reporting changes (see AmoebotParticle::reportChange).
+  // observesChanges returns false if nothing needs to hear about changes, i.e.,
+  // there are no dormant particles to wake, no dirty tracking, no listeners,
+  // and no concurrent activations whose particles might fall asleep.
+  // markChanged wakes the given particle and marks it dirty. notifyChange
+  // delivers the event to the listeners. During concurrent activations, marks
+  // and events are recorded in the current thread's ActivationTally and
+  // applied by mergeTally.
+  bool observesChanges() const;
+  void markChanged(AmoebotParticle* particle);
+  void notifyChange(const ChangeEvent& event);
+
+  // The registered listeners, whether dirty tracking is enabled, and the
+  // particles marked dirty since the last call to takeDirtyParticles.
+  std::vector<ChangeListener*> changeListeners;
+  bool dirtyTracking;
+  std::vector<AmoebotParticle*> dirtyParticles;
+
+  // Owns the memory of this system's tokens. Members are destroyed only after
+  // the destructor body, which deletes the particles (and thus returns their
+  // tokens) first, so no token outlives the pool.
+  TokenPool tokenPool;
 };
 
+inline unsigned int AmoebotSystem::numParticlesInState(
+    unsigned char state) const {
+  return stateCounts[state];
+}
+
+inline unsigned int AmoebotSystem::numHeldTokens() const {
+  return heldTokens;
+}
+
+inline bool AmoebotSystem::observesChanges() const {
+  return numDormant > 0 || dirtyTracking || !changeListeners.empty() ||
+         ActivationTally::current != nullptr;
+}
+
+inline void AmoebotSystem::moveStateCount(unsigned char from,
+                                          unsigned char to) {
+  ActivationTally* tally = ActivationTally::current;
+  if (tally != nullptr) {
+    tally->stateDeltas[from]--;
+    tally->stateDeltas[to]++;
+  } else {
+    stateCounts[from]--;
+    stateCounts[to]++;
+  }
+}
+
+inline void AmoebotSystem::addHeldTokens(int delta) {
+  ActivationTally* tally = ActivationTally::current;
+  if (tally != nullptr) {
+    tally->heldTokensDelta += delta;
+  } else {
+    heldTokens += delta;
+  }
+}
+
+inline Count& AmoebotSystem::count(CountHandle handle) const {
+  Q_ASSERT(0 <= handle._index && handle._index < (int)_counts.size());
+
+  return *_counts[handle._index];
+}
+
+template<class ParticleType, class... Args>
+ParticleType* AmoebotSystem::emplaceParticle(Args&&... args) {
+  ParticleType* particle =
+      particleArena.emplace<ParticleType>(std::forward<Args>(args)...);
+  AmoebotParticle* base = particle;
+  base->inParticleArena = true;
+  insert(base);
+
+  return particle;
+}
+
+template<class ParticleType, class... Args>
+void AmoebotSystem::emplaceParticles(
+    const std::vector<ConfigurationRecord>& records, const Args&... args) {
+  reserveFor(records);
+  for (const ConfigurationRecord& record : records) {
+    const int orientation =
+        (record.orientation != -1) ? record.orientation : randDir();
+    emplaceParticle<ParticleType>(Node(record.x, record.y), record.tailDir,
+                                  orientation, *this, args...);
+  }
+}
+
+template<class TokenType, class... Args>
+TokenPtr<TokenType> AmoebotSystem::makeToken(Args&&... args) {
+  return tokenPool.make<TokenType>(std::forward<Args>(args)...);
+}
+
 #endif  // AMOEBOTSIM_CORE_AMOEBOTSYSTEM_H_
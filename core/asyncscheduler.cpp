@@ -0,0 +1,333 @@
+/* Copyright (C) 2020 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+#include "core/asyncscheduler.h"
+
+#include <algorithm>
+
+#include <QtGlobal>
+
+#include "core/amoebotparticle.h"
+
+AsyncScheduler::Worker::Worker(const unsigned int index)
+  : index(index),
+    queueBegin(0),
+    queueEnd(0),
+    numActivated(0) {}
+
+AsyncScheduler::AsyncScheduler(AmoebotSystem& system, unsigned int numThreads)
+  : system(system),
+    locks(new std::mutex[kNumLocks]),
+    numPositions(0),
+    batchNumber(0),
+    numBusyHelpers(0),
+    stopping(false),
+    batchActivations(0),
+    outOfReserve(false) {
+  Q_ASSERT(system.supportsParallelRounds());
+
+  if (numThreads == 0) {
+    numThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  for (unsigned int i = 0; i < numThreads; ++i) {
+    workers.emplace_back(new Worker(i));
+  }
+  for (unsigned int i = 1; i < numThreads; ++i) {
+    Worker& worker = *workers[i];
+    worker.thread = std::thread([this, &worker]() { workerLoop(worker); });
+  }
+}
+
+AsyncScheduler::~AsyncScheduler() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  batchStarted.notify_all();
+  for (auto& worker : workers) {
+    if (worker->thread.joinable()) {
+      worker->thread.join();
+    }
+  }
+}
+
+unsigned int AsyncScheduler::numThreads() const {
+  return workers.size();
+}
+
+void AsyncScheduler::run(unsigned int numActivations) {
+  const std::vector<AmoebotParticle*>& particles = system.particles;
+  if (system.activeParticles.empty() || numActivations == 0) {
+    return;
+  }
+
+  // The system may have been activated sequentially (or had particles
+  // inserted) since the last call, so positions are refreshed every time.
+  if (numPositions != particles.size()) {
+    numPositions = particles.size();
+    positions.reset(new std::atomic<uint64_t>[numPositions]);
+  }
+  for (unsigned int i = 0; i < numPositions; ++i) {
+    positions[i].store(pack(particles[i]->head), std::memory_order_relaxed);
+  }
+
+  // Give every worker its own stream, non-overlapping with the others.
+  const uint64_t seed = system.randomEngine();
+  for (unsigned int i = 0; i < workers.size(); ++i) {
+    RandomEngine& engine = workers[i]->engine;
+    engine.seed(seed != 0 ? seed : 1);
+    for (unsigned int j = 0; j < i; ++j) {
+      engine.jump();
+    }
+  }
+
+  system.tokenPool.setConcurrent(true);
+  unsigned int numLeft = numActivations;
+  while (numLeft > 0) {
+    // Deal the chunks out evenly. A batch ends early when some activation would
+    // grow the lattice index, which is then grown while no thread is running.
+    reserveLattice();
+    outOfReserve = false;
+    batchActivations = numLeft;
+    const unsigned int numChunks = (numLeft + kChunkSize - 1) / kChunkSize;
+    for (unsigned int i = 0; i < workers.size(); ++i) {
+      Worker& worker = *workers[i];
+      worker.queueBegin = numChunks * i / workers.size();
+      worker.queueEnd = numChunks * (i + 1) / workers.size();
+      worker.numActivated = 0;
+    }
+
+    const bool useHelpers = workers.size() > 1 && numChunks > 1;
+    if (useHelpers) {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        numBusyHelpers = workers.size() - 1;
+        ++batchNumber;
+      }
+      batchStarted.notify_all();
+    }
+
+    work(*workers[0]);
+
+    if (useHelpers) {
+      std::unique_lock<std::mutex> lock(mutex);
+      batchFinished.wait(lock, [this]() { return numBusyHelpers == 0; });
+    }
+
+    for (auto& worker : workers) {
+      numLeft -= worker->numActivated;
+    }
+  }
+  system.tokenPool.setConcurrent(false);
+
+  for (auto& worker : workers) {
+    system.mergeTally(worker->tally);
+  }
+  if (system.numActivatedThisEpoch >= particles.size()) {
+    system.completeRound();
+  }
+
+  // Account for the dormant particles a sequential scheduler would have drawn
+  // along the way.
+  if (!system.activeParticles.empty()) {
+    for (unsigned int i = 0; i < numActivations; ++i) {
+      system.drawDormantParticles();
+    }
+  }
+}
+
+AsyncScheduler::LockSet AsyncScheduler::locksAround(const Node& node) {
+  // Hash the coordinates of every region overlapped by the neighborhood. It
+  // spans fewer nodes than a region in each dimension, so at most two regions
+  // per dimension.
+  const int reach = kLockRadius + 1;
+  LockSet set;
+  set.size = 0;
+  for (int rx = (node.x - reach) >> kLockRegionBits;
+       rx <= (node.x + reach) >> kLockRegionBits; ++rx) {
+    for (int ry = (node.y - reach) >> kLockRegionBits;
+         ry <= (node.y + reach) >> kLockRegionBits; ++ry) {
+      const uint32_t hash = static_cast<uint32_t>(rx) * 0x9E3779B1u ^
+                            static_cast<uint32_t>(ry) * 0x85EBCA77u;
+      set.indices[set.size++] = (hash >> 20) & (kNumLocks - 1);
+    }
+  }
+
+  // Lock in increasing order, taking mutexes shared by two regions only once.
+  std::sort(set.indices.begin(), set.indices.begin() + set.size);
+  set.size = std::unique(set.indices.begin(), set.indices.begin() + set.size) -
+             set.indices.begin();
+
+  return set;
+}
+
+uint64_t AsyncScheduler::pack(const Node& node) {
+  return (static_cast<uint64_t>(static_cast<uint32_t>(node.x)) << 32) |
+         static_cast<uint32_t>(node.y);
+}
+
+Node AsyncScheduler::unpack(const uint64_t word) {
+  return Node(static_cast<int32_t>(word >> 32),
+              static_cast<int32_t>(word & 0xFFFFFFFFu));
+}
+
+void AsyncScheduler::reserveLattice() {
+  // A box of 2 * kReserveMargin + 1 nodes overlaps at most two tiles per
+  // dimension, so reserving its corners reserves all of it.
+  for (const AmoebotParticle* particle : system.particles) {
+    const Node head = particle->head;
+    for (const int dx : {-kReserveMargin, kReserveMargin}) {
+      for (const int dy : {-kReserveMargin, kReserveMargin}) {
+        system.lattice.reserve(Node(head.x + dx, head.y + dy));
+      }
+    }
+  }
+}
+
+void AsyncScheduler::work(Worker& worker) {
+  ActivationTally::current = &worker.tally;
+  RandomNumberGenerator::threadEngine = &worker.engine;
+
+  unsigned int chunk;
+  while (!outOfReserve && takeChunk(worker, chunk)) {
+    const unsigned int end = std::min((chunk + 1) * kChunkSize,
+                                      batchActivations);
+    for (unsigned int i = chunk * kChunkSize; i < end; ++i) {
+      if (!activateRandom(worker)) {
+        outOfReserve = true;
+        break;
+      }
+      ++worker.numActivated;
+    }
+  }
+
+  RandomNumberGenerator::threadEngine = nullptr;
+  ActivationTally::current = nullptr;
+}
+
+bool AsyncScheduler::takeChunk(Worker& worker, unsigned int& chunk) {
+  {
+    std::lock_guard<std::mutex> lock(worker.queueMutex);
+    if (worker.queueBegin < worker.queueEnd) {
+      chunk = worker.queueBegin++;
+      return true;
+    }
+  }
+
+  // Steal the back half of the first nonempty queue after this worker's own.
+  for (unsigned int k = 1; k < workers.size(); ++k) {
+    Worker& victim = *workers[(worker.index + k) % workers.size()];
+    unsigned int begin, end;
+    {
+      std::lock_guard<std::mutex> lock(victim.queueMutex);
+      const unsigned int numLeft = victim.queueEnd - victim.queueBegin;
+      if (numLeft == 0) {
+        continue;
+      }
+      end = victim.queueEnd;
+      begin = end - (numLeft + 1) / 2;
+      victim.queueEnd = begin;
+    }
+
+    std::lock_guard<std::mutex> lock(worker.queueMutex);
+    chunk = begin;
+    worker.queueBegin = begin + 1;
+    worker.queueEnd = end;
+    return true;
+  }
+
+  return false;
+}
+
+bool AsyncScheduler::activateRandom(Worker& worker) {
+  // The active set only changes once all activations of a run() are done, so
+  // it can be read here without locks.
+  const std::vector<AmoebotParticle*>& active = system.activeParticles;
+  AmoebotParticle* const particle = active[worker.engine.nextBelow(
+      active.size())];
+  const unsigned int index = particle->snapshotIndex;
+
+  while (true) {
+    // Lock the neighborhood of where the particle was last seen. If it still
+    // occupies that node, any activation that could move it needs one of the
+    // locks held, so it stays put until they are released; otherwise it moved
+    // in the meantime and its position has been updated, so try again.
+    const Node node = unpack(positions[index].load(std::memory_order_relaxed));
+    const int reach = kLockRadius + 1;
+    for (const int dx : {-reach, reach}) {
+      for (const int dy : {-reach, reach}) {
+        if (!system.lattice.covers(Node(node.x + dx, node.y + dy))) {
+          return false;
+        }
+      }
+    }
+
+    const LockSet lockSet = locksAround(node);
+    for (unsigned int i = 0; i < lockSet.size; ++i) {
+      locks[lockSet.indices[i]].lock();
+    }
+
+    // A particle that fell asleep since the run began is skipped, since its
+    // activation would do nothing.
+    const bool found = system.lattice.particleAt(node) == particle;
+    if (found && !particle->dormant) {
+      const Node head = particle->head;
+      const int tailDir = particle->globalTailDir;
+      particle->activate();
+      system.registerActivation(particle);
+
+      // A particle only moves others by handovers, which also move itself.
+      // Update the positions of the particle and of its neighbors, among which
+      // is any handover partner.
+      if (particle->head != head || particle->globalTailDir != tailDir) {
+        const Node nodes[] = {particle->head, particle->isExpanded()
+                                                  ? particle->tail()
+                                                  : particle->head};
+        for (const Node& own : nodes) {
+          for (int dir = 0; dir < 6; ++dir) {
+            const AmoebotParticle* nbr =
+                system.lattice.particleAt(own.nodeInDir(dir));
+            if (nbr != nullptr) {
+              positions[nbr->snapshotIndex].store(pack(nbr->head),
+                                                  std::memory_order_relaxed);
+            }
+          }
+        }
+        positions[index].store(pack(particle->head), std::memory_order_relaxed);
+      }
+    }
+
+    for (unsigned int i = lockSet.size; i-- > 0;) {
+      locks[lockSet.indices[i]].unlock();
+    }
+    if (found) {
+      return true;
+    }
+  }
+}
+
+void AsyncScheduler::workerLoop(Worker& worker) {
+  unsigned long long lastBatch = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      batchStarted.wait(lock, [this, lastBatch]() {
+        return stopping || batchNumber != lastBatch;
+      });
+      if (stopping) {
+        return;
+      }
+      lastBatch = batchNumber;
+    }
+
+    work(worker);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (--numBusyHelpers == 0) {
+        batchFinished.notify_one();
+      }
+    }
+  }
+}
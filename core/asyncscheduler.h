@@ -0,0 +1,152 @@
+/* Copyright (C) 2020 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+// Defines a scheduler that runs the asynchronous activations of a system on
+// several threads at once. Each thread repeatedly picks a uniformly random
+// particle, locks every node the particle's activation could touch, and
+// activates it, so each activation is atomic with respect to its neighborhood
+// just as in the amoebot model's asynchronous semantics. The lattice is split
+// into square lock regions of kLockRegionSize x kLockRegionSize nodes, each
+// guarded by one of a fixed table of mutexes; an activation locks the mutexes
+// of the (at most four) regions its neighborhood overlaps in increasing index
+// order, so no two threads can deadlock. The activations of a run() call are
+// split into chunks dealt out evenly to the threads, and a thread that runs out
+// of chunks steals half of another thread's remaining ones.
+//
+// Only systems that support parallel rounds (see
+// AmoebotSystem::supportsParallelRounds) may be run this way. Unlike parallel
+// rounds, runs are not reproducible: which activations win a lock depends on
+// the operating system's thread scheduling.
+
+#ifndef AMOEBOTSIM_CORE_ASYNCSCHEDULER_H_
+#define AMOEBOTSIM_CORE_ASYNCSCHEDULER_H_
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "core/activationtally.h"
+#include "core/amoebotsystem.h"
+#include "core/node.h"
+#include "helper/randomnumbergenerator.h"
+
+class AsyncScheduler {
+ public:
+  // The radius around a particle's head that its activation may touch: nodes
+  // within distance 3 and the particles occupying them, each of which spans at
+  // most one further node (see ParallelRoundScheduler::kColorPeriod). The
+  // locked neighborhood extends one node further to cover an expanded
+  // particle's tail regardless of which of its nodes the lock is taken for.
+  static constexpr int kLockRadius = 4;
+
+  // Constructs a scheduler for the given system, which must support parallel
+  // rounds, using numThreads threads including the calling one (0 uses one
+  // thread per core).
+  explicit AsyncScheduler(AmoebotSystem& system, unsigned int numThreads = 0);
+  AsyncScheduler(const AsyncScheduler&) = delete;
+  AsyncScheduler& operator=(const AsyncScheduler&) = delete;
+
+  // Stops and joins the worker threads.
+  ~AsyncScheduler();
+
+  // Returns the number of threads activating particles.
+  unsigned int numThreads() const;
+
+  // Executes numActivations activations of uniformly random active (i.e., not
+  // dormant) particles concurrently and registers them with the system,
+  // including the rounds they complete. Rounds are detected once all
+  // activations have finished, so a round completed partway through is only
+  // registered at the end of the call. Must be called from the thread that
+  // constructed the scheduler.
+  void run(unsigned int numActivations);
+
+ private:
+  // The side length of a lock region and the number of mutexes guarding them.
+  // Regions are mapped to mutexes by hashing, so distant regions may share one.
+  static constexpr int kLockRegionBits = 4;
+  static constexpr int kLockRegionSize = 1 << kLockRegionBits;
+  static constexpr unsigned int kNumLocks = 1 << 12;
+
+  // The number of activations per chunk of work.
+  static constexpr unsigned int kChunkSize = 64;
+
+  // The lattice index is grown to cover this many nodes around every particle
+  // before the threads start, so that activations never reallocate it.
+  static constexpr int kReserveMargin = 16;
+
+  // A thread activating particles, with its position in workers, its own random
+  // engine, the tally of its activations, and its queue of chunks
+  // [queueBegin, queueEnd).
+  struct Worker {
+    explicit Worker(const unsigned int index);
+
+    const unsigned int index;
+    std::thread thread;
+    RandomEngine engine;
+    ActivationTally tally;
+    std::mutex queueMutex;
+    unsigned int queueBegin, queueEnd;
+    unsigned int numActivated;
+  };
+
+  // The indices of the mutexes locked for one activation, in locking order.
+  struct LockSet {
+    std::array<unsigned int, 4> indices;
+    unsigned int size;
+  };
+
+  // Returns the mutexes guarding the neighborhood of the given node.
+  static LockSet locksAround(const Node& node);
+
+  // Packs a node into one word and back, for the positions array.
+  static uint64_t pack(const Node& node);
+  static Node unpack(const uint64_t word);
+
+  // Grows the lattice index by kReserveMargin around every particle.
+  void reserveLattice();
+
+  // Runs chunks until none are left or an activation would leave the reserved
+  // part of the lattice, recording into the given worker's tally.
+  void work(Worker& worker);
+
+  // Takes the next chunk from the given worker's queue, stealing from the other
+  // workers when it is empty. Returns false if no chunks are left.
+  bool takeChunk(Worker& worker, unsigned int& chunk);
+
+  // Activates one random particle. Returns false without activating anything
+  // if its neighborhood is not covered by the lattice index.
+  bool activateRandom(Worker& worker);
+
+  // The loop of the helper threads, which run work() once per batch.
+  void workerLoop(Worker& worker);
+
+  AmoebotSystem& system;
+  std::vector<std::unique_ptr<Worker>> workers;  // workers[0] is the caller.
+  std::unique_ptr<std::mutex[]> locks;
+
+  // The head of every particle, indexed like the system's particle list. A
+  // thread reads a particle's entry without holding any locks to find out which
+  // ones to take, so entries are updated whenever a particle moves and are
+  // checked against the lattice once the locks are held.
+  std::unique_ptr<std::atomic<uint64_t>[]> positions;
+  unsigned int numPositions;
+
+  // The current batch of chunks, published to the helper threads under mutex.
+  // A batch ends early if outOfReserve is set.
+  std::mutex mutex;
+  std::condition_variable batchStarted;
+  std::condition_variable batchFinished;
+  unsigned long long batchNumber;
+  unsigned int numBusyHelpers;
+  bool stopping;
+  unsigned int batchActivations;
+  std::atomic<bool> outOfReserve;
+};
+
+#endif  // AMOEBOTSIM_CORE_ASYNCSCHEDULER_H_
@@ -0,0 +1,47 @@
+/* Copyright (C) 2020 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+// Defines the fine-grained changes an AmoebotSystem reports as its particles
+// move, receive tokens, and change state, and the interface for observing them
+// (see AmoebotSystem::addChangeListener). Together with the system's dirty
+// marking (see AmoebotSystem::setDirtyTracking), these let schedulers,
+// incremental measures, and renderers do work proportional to what changed
+// instead of to the size of the system.
+
+#ifndef AMOEBOTSIM_CORE_CHANGEEVENT_H_
+#define AMOEBOTSIM_CORE_CHANGEEVENT_H_
+
+#include "core/node.h"
+
+class AmoebotParticle;
+
+struct ChangeEvent {
+  // The kinds of changes. A particle occupies a node when it is inserted,
+  // expands into it, or takes it over in a handover, and vacates a node when it
+  // contracts out of it or hands it over. For the other kinds, node is the
+  // particle's head.
+  enum class Type {
+    NodeOccupied,
+    NodeVacated,
+    TokenPut,
+    StateChanged
+  };
+
+  Type type;
+  Node node;
+  AmoebotParticle* particle;
+};
+
+class ChangeListener {
+ public:
+  virtual ~ChangeListener() = default;
+
+  // Called once the change described by the given event has been made. During
+  // concurrent activations, events are collected and delivered on the
+  // scheduling thread once the activations are done, so listeners never run
+  // concurrently.
+  virtual void changed(const ChangeEvent& event) = 0;
+};
+
+#endif  // AMOEBOTSIM_CORE_CHANGEEVENT_H_
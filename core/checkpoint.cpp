@@ -0,0 +1,285 @@
+/* Copyright (C) 2020 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+#include "core/checkpoint.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include "core/amoebotsystem.h"
+
+namespace {
+
+// "AMBCKPT" followed by a zero byte.
+constexpr uint64_t kMagic = 0x0054504b43424d41ull;
+
+}  // namespace
+
+CheckpointWriter::CheckpointWriter(std::ostream& out)
+  : out(out) {
+  writeUInt64(kMagic);
+  writeUInt(kVersion);
+}
+
+void CheckpointWriter::writeBool(const bool value) {
+  const unsigned char byte = value ? 1 : 0;
+  writeBytes(&byte, 1);
+}
+
+void CheckpointWriter::writeInt(const int32_t value) {
+  writeUInt(static_cast<uint32_t>(value));
+}
+
+void CheckpointWriter::writeUInt(const uint32_t value) {
+  unsigned char bytes[4];
+  encodeFixed(bytes, value, 4);
+  writeBytes(bytes, 4);
+}
+
+void CheckpointWriter::writeUInt64(const uint64_t value) {
+  unsigned char bytes[8];
+  encodeFixed(bytes, value, 8);
+  writeBytes(bytes, 8);
+}
+
+void CheckpointWriter::writeDouble(const double value) {
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  writeUInt64(bits);
+}
+
+void CheckpointWriter::writeString(const std::string& value) {
+  writeUInt(value.size());
+  writeBytes(reinterpret_cast<const unsigned char*>(value.data()),
+             value.size());
+}
+
+void CheckpointWriter::writeQString(const QString& value) {
+  writeString(value.toStdString());
+}
+
+bool CheckpointWriter::failed() const {
+  return !out;
+}
+
+void CheckpointWriter::writeBytes(const unsigned char* bytes,
+                                  const std::size_t size) {
+  out.write(reinterpret_cast<const char*>(bytes), size);
+}
+
+CheckpointReader::CheckpointReader(std::istream& in)
+  : in(in),
+    _failed(false) {
+  if (readUInt64() != kMagic || readUInt() != CheckpointWriter::kVersion) {
+    fail();
+  }
+}
+
+bool CheckpointReader::readBool() {
+  unsigned char byte = 0;
+  readBytes(&byte, 1);
+  return byte != 0;
+}
+
+int32_t CheckpointReader::readInt() {
+  return static_cast<int32_t>(readUInt());
+}
+
+uint32_t CheckpointReader::readUInt() {
+  unsigned char bytes[4];
+  if (!readBytes(bytes, 4)) {
+    return 0;
+  }
+
+  return static_cast<uint32_t>(decodeFixed(bytes, 4));
+}
+
+uint64_t CheckpointReader::readUInt64() {
+  unsigned char bytes[8];
+  if (!readBytes(bytes, 8)) {
+    return 0;
+  }
+
+  return decodeFixed(bytes, 8);
+}
+
+double CheckpointReader::readDouble() {
+  const uint64_t bits = readUInt64();
+  double value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+std::string CheckpointReader::readString() {
+  const uint32_t size = readUInt();
+  std::string value;
+  if (failed()) {
+    return value;
+  }
+
+  // Read in bounded pieces, so that a corrupt length fails at the end of the
+  // stream instead of allocating all of it up front.
+  char buffer[4096];
+  uint32_t left = size;
+  while (left > 0) {
+    const uint32_t piece = std::min<uint32_t>(left, sizeof(buffer));
+    if (!readBytes(reinterpret_cast<unsigned char*>(buffer), piece)) {
+      return std::string();
+    }
+    value.append(buffer, piece);
+    left -= piece;
+  }
+
+  return value;
+}
+
+QString CheckpointReader::readQString() {
+  return QString::fromStdString(readString());
+}
+
+void CheckpointReader::expectUInt(const uint32_t expected) {
+  if (readUInt() != expected) {
+    fail();
+  }
+}
+
+void CheckpointReader::fail() {
+  _failed = true;
+}
+
+bool CheckpointReader::failed() const {
+  return _failed;
+}
+
+bool CheckpointReader::readBytes(unsigned char* bytes, const std::size_t size) {
+  if (_failed) {
+    std::memset(bytes, 0, size);
+    return false;
+  }
+
+  in.read(reinterpret_cast<char*>(bytes), size);
+  if (static_cast<std::size_t>(in.gcount()) != size) {
+    std::memset(bytes, 0, size);
+    fail();
+    return false;
+  }
+
+  return true;
+}
+
+bool saveCheckpoint(const AmoebotSystem& system, const QString filePath,
+                    QString& error) {
+  if (!system.supportsCheckpoints()) {
+    error = "this algorithm does not support checkpoints";
+    return false;
+  }
+
+  const std::string path = filePath.toStdString();
+  const std::string tempPath = path + ".tmp";
+  std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+  if (!file) {
+    error = "cannot open " + QString::fromStdString(tempPath) + " for writing";
+    return false;
+  }
+  CheckpointWriter out(file);
+  system.writeCheckpoint(out);
+  file.close();
+  if (out.failed()) {
+    error = "cannot write " + QString::fromStdString(tempPath);
+    std::remove(tempPath.c_str());
+    return false;
+  }
+
+  if (std::rename(tempPath.c_str(), path.c_str()) != 0) {
+    // Not every platform replaces an existing file when renaming.
+    std::remove(path.c_str());
+    if (std::rename(tempPath.c_str(), path.c_str()) != 0) {
+      error = "cannot replace " + filePath;
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool loadCheckpoint(AmoebotSystem& system, const QString filePath,
+                    QString& error) {
+  if (!system.supportsCheckpoints()) {
+    error = "this algorithm does not support checkpoints";
+    return false;
+  }
+
+  std::ifstream file(filePath.toStdString(), std::ios::binary);
+  if (!file) {
+    error = "cannot open " + filePath;
+    return false;
+  }
+  CheckpointReader in(file);
+  if (!system.readCheckpoint(in, error)) {
+    error = filePath + ": " + error;
+    return false;
+  }
+
+  return true;
+}
+
+void encodeFixed(unsigned char* bytes, const uint64_t value, const int size) {
+  for (int i = 0; i < size; ++i) {
+    bytes[i] = static_cast<unsigned char>(value >> (8 * i));
+  }
+}
+
+uint64_t decodeFixed(const unsigned char* bytes, const int size) {
+  uint64_t value = 0;
+  for (int i = 0; i < size; ++i) {
+    value |= static_cast<uint64_t>(bytes[i]) << (8 * i);
+  }
+  return value;
+}
+
+void appendFixed(std::string& bytes, const uint64_t value, const int size) {
+  unsigned char encoded[8];
+  encodeFixed(encoded, value, size);
+  bytes.append(reinterpret_cast<const char*>(encoded), size);
+}
+
+void writeFixed(std::ostream& out, const uint64_t value, const int size) {
+  unsigned char encoded[8];
+  encodeFixed(encoded, value, size);
+  out.write(reinterpret_cast<const char*>(encoded), size);
+}
+
+bool readFixed(std::istream& in, uint64_t& value, const int size) {
+  unsigned char bytes[8];
+  in.read(reinterpret_cast<char*>(bytes), size);
+  if (in.gcount() != size) {
+    return false;
+  }
+
+  value = decodeFixed(bytes, size);
+  return true;
+}
+
+void appendVarint(std::string& bytes, uint64_t value) {
+  while (value >= 0x80) {
+    bytes.push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  bytes.push_back(static_cast<char>(value));
+}
+
+bool readVarint(const unsigned char*& p, const unsigned char* end,
+                uint64_t& value) {
+  value = 0;
+  for (int shift = 0; p != end && shift < 64; shift += 7) {
+    const unsigned char byte = *p++;
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
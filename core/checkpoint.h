@@ -0,0 +1,154 @@
+/* Copyright (C) 2020 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+// Defines the binary stream format of checkpoints (see
+// AmoebotSystem::writeCheckpoint). A checkpoint starts with a magic number and
+// a format version, followed by fixed-width little-endian values and
+// length-prefixed strings and arrays in the order they were written; there is
+// no index, so a checkpoint is written and read in one sequential pass. Readers
+// check the magic number and version when constructed, and any failure (a
+// short read, a wrong header, or a value that does not match what the reader
+// expects) is sticky: once failed() is set, every further read returns zero.
+
+#ifndef AMOEBOTSIM_CORE_CHECKPOINT_H_
+#define AMOEBOTSIM_CORE_CHECKPOINT_H_
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <QString>
+
+class AmoebotSystem;
+
+class CheckpointWriter {
+ public:
+  // The version of the format written. Bump it whenever the layout written by
+  // the core or by any algorithm changes.
+  static constexpr uint32_t kVersion = 3;
+
+  // Constructs a writer appending to the given stream, which must be opened in
+  // binary mode, and writes the header.
+  explicit CheckpointWriter(std::ostream& out);
+
+  // Functions for writing values.
+  void writeBool(const bool value);
+  void writeInt(const int32_t value);
+  void writeUInt(const uint32_t value);
+  void writeUInt64(const uint64_t value);
+  void writeDouble(const double value);
+  void writeString(const std::string& value);
+  void writeQString(const QString& value);
+
+  // Writes the length of the given array followed by its elements, each with
+  // the given member function (e.g., &CheckpointWriter::writeInt).
+  template<class T, class Write>
+  void writeArray(const std::vector<T>& values, const Write write);
+
+  // Returns true if the underlying stream reported an error.
+  bool failed() const;
+
+ private:
+  void writeBytes(const unsigned char* bytes, const std::size_t size);
+
+  std::ostream& out;
+};
+
+class CheckpointReader {
+ public:
+  // Constructs a reader consuming the given stream, which must be opened in
+  // binary mode, and checks the header.
+  explicit CheckpointReader(std::istream& in);
+
+  // Functions for reading values written by the matching write functions.
+  bool readBool();
+  int32_t readInt();
+  uint32_t readUInt();
+  uint64_t readUInt64();
+  double readDouble();
+  std::string readString();
+  QString readQString();
+
+  // Reads an array written by writeArray, each element with the given member
+  // function (e.g., &CheckpointReader::readInt). Fails if the stored length
+  // exceeds maxSize, which guards against allocating for a corrupt length.
+  template<class T, class Read>
+  std::vector<T> readArray(const Read read,
+                           const uint32_t maxSize = UINT32_MAX);
+
+  // Reads a value and fails if it differs from the expected one; used to check
+  // that a checkpoint matches the system it is restored into.
+  void expectUInt(const uint32_t expected);
+
+  // Marks the checkpoint as unreadable.
+  void fail();
+
+  // Returns true if reading failed at any point.
+  bool failed() const;
+
+ private:
+  bool readBytes(unsigned char* bytes, const std::size_t size);
+
+  std::istream& in;
+  bool _failed;
+};
+
+// Write (respectively, restore) a checkpoint of the given system to
+// (respectively, from) the file at the given path; see
+// AmoebotSystem::writeCheckpoint. saveCheckpoint writes to a temporary file
+// first and replaces the given file only once the checkpoint is complete, so
+// that a crash while writing leaves the previous checkpoint intact. Both return
+// false and describe the problem in error on failure.
+bool saveCheckpoint(const AmoebotSystem& system, const QString filePath,
+                    QString& error);
+bool loadCheckpoint(AmoebotSystem& system, const QString filePath,
+                    QString& error);
+
+// Functions for the fixed-width little-endian and varint encodings shared by
+// the binary formats of the core (checkpoints, traces, metric streams, result
+// tables, and configurations). A fixed-width value consists of the low size
+// bytes (at most eight) of a value, low byte first: encodeFixed (respectively,
+// decodeFixed) stores (respectively, loads) one in memory, appendFixed and
+// writeFixed append one to a string or stream, and readFixed reads one from a
+// stream, returning false on a short read. A varint consists of seven bits per
+// byte, low bits first, with the high bit set on all but the last byte:
+// appendVarint appends one to a string, and readVarint reads one from the bytes
+// from p to end, advancing p, and returns false if they end before it does.
+void encodeFixed(unsigned char* bytes, const uint64_t value, const int size);
+uint64_t decodeFixed(const unsigned char* bytes, const int size);
+void appendFixed(std::string& bytes, const uint64_t value, const int size);
+void writeFixed(std::ostream& out, const uint64_t value, const int size);
+bool readFixed(std::istream& in, uint64_t& value, const int size);
+void appendVarint(std::string& bytes, uint64_t value);
+bool readVarint(const unsigned char*& p, const unsigned char* end,
+                uint64_t& value);
+
+template<class T, class Write>
+void CheckpointWriter::writeArray(const std::vector<T>& values,
+                                  const Write write) {
+  writeUInt(values.size());
+  for (const T& value : values) {
+    (this->*write)(value);
+  }
+}
+
+template<class T, class Read>
+std::vector<T> CheckpointReader::readArray(const Read read,
+                                           const uint32_t maxSize) {
+  const uint32_t size = readUInt();
+  if (size > maxSize) {
+    fail();
+  }
+
+  std::vector<T> values;
+  for (uint32_t i = 0; i < size && !failed(); ++i) {
+    values.push_back(static_cast<T>((this->*read)()));
+  }
+
+  return values;
+}
+
+#endif  // AMOEBOTSIM_CORE_CHECKPOINT_H_
@@ -0,0 +1,204 @@
+/* Copyright (C) 2020 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+#include "core/configuration.h"
+
+#include <climits>
+#include <cstdint>
+#include <cstring>
+
+#include <QByteArray>
+#include <QFile>
+
+#include "core/checkpoint.h"
+
+namespace {
+
+const char kMagic[8] = {'A', 'M', 'B', 'S', 'H', 'A', 'P', 'E'};
+constexpr uint32_t kVersion = 1;
+constexpr qint64 kHeaderSize = 8 + 4 + 8;
+constexpr qint64 kRecordSize = 4 + 4 + 1 + 1;
+
+bool isValidDir(const int dir) {
+  return -1 <= dir && dir < 6;
+}
+
+bool parseBinary(const uchar* data, const qint64 size,
+                 std::vector<ConfigurationRecord>& records, QString& error) {
+  if (size < kHeaderSize ||
+      static_cast<uint32_t>(decodeFixed(data + 8, 4)) != kVersion) {
+    error = "unsupported configuration format version";
+    return false;
+  }
+  const uint64_t numRecords = decodeFixed(data + 12, 8);
+  if (numRecords != static_cast<uint64_t>(size - kHeaderSize) / kRecordSize ||
+      (size - kHeaderSize) % kRecordSize != 0) {
+    error = "configuration is truncated";
+    return false;
+  }
+
+  records.resize(numRecords);
+  const uchar* record = data + kHeaderSize;
+  for (uint64_t i = 0; i < numRecords; ++i) {
+    ConfigurationRecord& r = records[i];
+    r.x = static_cast<int32_t>(decodeFixed(record, 4));
+    r.y = static_cast<int32_t>(decodeFixed(record + 4, 4));
+    r.orientation = static_cast<int8_t>(record[8]);
+    r.tailDir = static_cast<int8_t>(record[9]);
+    if (!isValidDir(r.orientation) || !isValidDir(r.tailDir)) {
+      error = "invalid orientation or tail direction in record " +
+              QString::number(i);
+      return false;
+    }
+    record += kRecordSize;
+  }
+
+  return true;
+}
+
+void skipBlanks(const char*& p, const char* end) {
+  while (p != end && (*p == ' ' || *p == '\t' || *p == '\r')) {
+    ++p;
+  }
+}
+
+bool parseInt(const char*& p, const char* end, int& value) {
+  bool negative = false;
+  if (p != end && (*p == '-' || *p == '+')) {
+    negative = (*p == '-');
+    ++p;
+  }
+
+  const char* digits = p;
+  const long long limit = negative ? -static_cast<long long>(INT_MIN) : INT_MAX;
+  long long magnitude = 0;
+  while (p != end && '0' <= *p && *p <= '9') {
+    magnitude = 10 * magnitude + (*p - '0');
+    if (magnitude > limit) {
+      return false;
+    }
+    ++p;
+  }
+
+  value = static_cast<int>(negative ? -magnitude : magnitude);
+  return p != digits;
+}
+
+bool parseText(const char* data, const qint64 size,
+               std::vector<ConfigurationRecord>& records, QString& error) {
+  const char* const end = data + size;
+  const char* p = data;
+  for (int line = 1; p != end; ++line) {
+    const char* lineEnd =
+        static_cast<const char*>(std::memchr(p, '\n', end - p));
+    if (lineEnd == nullptr) {
+      lineEnd = end;
+    }
+
+    // Parse up to four comma-separated integers, skipping blank lines.
+    int values[4];
+    int numValues = 0;
+    bool valid = true;
+    skipBlanks(p, lineEnd);
+    while (p != lineEnd && valid) {
+      valid = numValues < 4 && parseInt(p, lineEnd, values[numValues++]);
+      skipBlanks(p, lineEnd);
+      if (valid && p != lineEnd) {
+        valid = (*p == ',');
+        ++p;
+        skipBlanks(p, lineEnd);
+        valid = valid && p != lineEnd;
+      }
+    }
+
+    if (numValues != 0) {
+      if (!valid || (numValues != 2 && numValues != 4) ||
+          (numValues == 4 && (!isValidDir(values[2]) ||
+                              !isValidDir(values[3])))) {
+        error = "line " + QString::number(line) +
+                ": expected x,y or x,y,orientation,tailDir";
+        return false;
+      }
+      records.push_back({values[0], values[1],
+                         (numValues == 4) ? values[2] : -1,
+                         (numValues == 4) ? values[3] : -1});
+    }
+
+    p = (lineEnd == end) ? end : lineEnd + 1;
+  }
+
+  return true;
+}
+
+}  // namespace
+
+QString inputConfigurationPath(const QString name) {
+  const QString path = "../AmoebotSim/data/input/" + name;
+  return QFile::exists(path + ".bin") ? path + ".bin" : path + ".txt";
+}
+
+bool readConfiguration(const QString filePath,
+                       std::vector<ConfigurationRecord>& records,
+                       QString& error) {
+  records.clear();
+  QFile file(filePath);
+  if (!file.open(QIODevice::ReadOnly)) {
+    error = "cannot open " + filePath;
+    return false;
+  }
+
+  // Map the file if possible; files that cannot be mapped (e.g., pipes) are
+  // read into memory instead.
+  const qint64 size = file.size();
+  const uchar* data = (size > 0) ? file.map(0, size) : nullptr;
+  QByteArray contents;
+  if (data == nullptr) {
+    contents = file.readAll();
+    data = reinterpret_cast<const uchar*>(contents.constData());
+  }
+  const qint64 dataSize = contents.isNull() ? size : contents.size();
+
+  bool parsed;
+  if (dataSize >= 8 && std::memcmp(data, kMagic, 8) == 0) {
+    parsed = parseBinary(data, dataSize, records, error);
+  } else {
+    parsed = parseText(reinterpret_cast<const char*>(data), dataSize, records,
+                       error);
+  }
+  if (!parsed) {
+    error = filePath + ": " + error;
+    records.clear();
+  }
+
+  return parsed;
+}
+
+bool writeConfiguration(const QString filePath,
+                        const std::vector<ConfigurationRecord>& records,
+                        QString& error) {
+  QByteArray bytes(kHeaderSize + kRecordSize * records.size(), '\0');
+  uchar* data = reinterpret_cast<uchar*>(bytes.data());
+  std::memcpy(data, kMagic, 8);
+  encodeFixed(data + 8, kVersion, 4);
+  encodeFixed(data + 12, records.size(), 8);
+
+  uchar* record = data + kHeaderSize;
+  for (const ConfigurationRecord& r : records) {
+    Q_ASSERT(isValidDir(r.orientation) && isValidDir(r.tailDir));
+    encodeFixed(record, static_cast<uint32_t>(r.x), 4);
+    encodeFixed(record + 4, static_cast<uint32_t>(r.y), 4);
+    record[8] = static_cast<uchar>(static_cast<int8_t>(r.orientation));
+    record[9] = static_cast<uchar>(static_cast<int8_t>(r.tailDir));
+    record += kRecordSize;
+  }
+
+  QFile file(filePath);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) ||
+      file.write(bytes) != bytes.size()) {
+    error = "cannot write " + filePath;
+    return false;
+  }
+
+  return true;
+}
@@ -0,0 +1,54 @@
+/* Copyright (C) 2020 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+// Defines the files holding particle configurations, i.e., the initial shapes
+// that algorithms can be instantiated on (see AmoebotSystem::emplaceParticles)
+// and that Simulator::saveSystem writes. A configuration is a list of
+// particles, each given by its head node, its orientation, and its global tail
+// direction.
+//
+// The binary format starts with the eight bytes "AMBSHAPE", a 32-bit format
+// version, and the 64-bit number of particles, followed by one packed 10-byte
+// record per particle: x and y as 32-bit integers, then orientation and tail
+// direction as 8-bit integers, all little-endian. Files in this format are
+// memory-mapped and decoded without intermediate copies. Any other file is
+// parsed as text with one particle per line, either as "x,y" or as
+// "x,y,orientation,tailDir".
+
+#ifndef AMOEBOTSIM_CORE_CONFIGURATION_H_
+#define AMOEBOTSIM_CORE_CONFIGURATION_H_
+
+#include <vector>
+
+#include <QString>
+
+// A particle of a configuration. An orientation of -1 leaves the orientation
+// unspecified, in which case a random one is drawn; a tail direction of -1
+// means the particle is contracted.
+struct ConfigurationRecord {
+  int x;
+  int y;
+  int orientation;
+  int tailDir;
+};
+
+// Returns the path of the input configuration with the given name, which is
+// <name>.bin in the data/input directory if such a file exists and <name>.txt
+// otherwise.
+QString inputConfigurationPath(const QString name);
+
+// Reads the configuration in the given file, in either format, into records.
+// Returns false and describes the problem in error if the file cannot be read
+// or is malformed.
+bool readConfiguration(const QString filePath,
+                       std::vector<ConfigurationRecord>& records,
+                       QString& error);
+
+// Writes the given configuration to the given file in the binary format.
+// Returns false and describes the problem in error on failure.
+bool writeConfiguration(const QString filePath,
+                        const std::vector<ConfigurationRecord>& records,
+                        QString& error);
+
+#endif  // AMOEBOTSIM_CORE_CONFIGURATION_H_
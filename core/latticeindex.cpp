@@ -0,0 +1,93 @@
+/* Copyright (C) 2020 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+#include "core/latticeindex.h"
+
+#include <algorithm>
+
+#include <QtGlobal>
+
+const LatticeIndex::Cell LatticeIndex::emptyCell;
+
+LatticeIndex::LatticeIndex()
+  : dirX(0),
+    dirY(0),
+    dirWidth(0),
+    dirHeight(0) {}
+
+void LatticeIndex::clear() {
+  tiles.clear();
+  dirX = dirY = 0;
+  dirWidth = dirHeight = 0;
+}
+
+void LatticeIndex::reserve(const Node& node) {
+  if (findCell(node) == nullptr) {
+    cellForWrite(node);
+  }
+}
+
+LatticeIndex::Cell& LatticeIndex::cellForWrite(const Node& node) {
+  const int tileX = node.x >> kTileBits;
+  const int tileY = node.y >> kTileBits;
+  if (tileX < dirX || tileX >= dirX + dirWidth ||
+      tileY < dirY || tileY >= dirY + dirHeight) {
+    growToInclude(tileX, tileY);
+  }
+
+  auto& tile = tiles[(tileY - dirY) * dirWidth + (tileX - dirX)];
+  if (tile == nullptr) {
+    tile.reset(new Cell[kTileSize * kTileSize]);
+  }
+
+  Cell* cell = findCell(node);
+  Q_ASSERT(cell != nullptr);
+
+  return *cell;
+}
+
+void LatticeIndex::growToInclude(int tileX, int tileY) {
+  if (dirWidth == 0) {
+    // First allocation: a small directory centered on the requested tile.
+    dirX = tileX - 1;
+    dirY = tileY - 1;
+    dirWidth = dirHeight = 3;
+    tiles.resize(dirWidth * dirHeight);
+    return;
+  }
+
+  // Extend the directory toward the requested tile by at least its current
+  // extent so that a system drifting in one direction only triggers a
+  // logarithmic number of reallocations.
+  int newX = dirX, newY = dirY;
+  int newWidth = dirWidth, newHeight = dirHeight;
+  if (tileX < dirX) {
+    newX = std::min(tileX, dirX - dirWidth);
+    newWidth += dirX - newX;
+  } else if (tileX >= dirX + dirWidth) {
+    newWidth = std::max(tileX - dirX + 1, 2 * dirWidth);
+  }
+  if (tileY < dirY) {
+    newY = std::min(tileY, dirY - dirHeight);
+    newHeight += dirY - newY;
+  } else if (tileY >= dirY + dirHeight) {
+    newHeight = std::max(tileY - dirY + 1, 2 * dirHeight);
+  }
+
+  std::vector<std::unique_ptr<Cell[]>> newTiles(newWidth * newHeight);
+  for (int row = 0; row < dirHeight; ++row) {
+    for (int col = 0; col < dirWidth; ++col) {
+      const int newRow = row + dirY - newY;
+      const int newCol = col + dirX - newX;
+      newTiles[newRow * newWidth + newCol] =
+          std::move(tiles[row * dirWidth + col]);
+    }
+  }
+
+  tiles = std::move(newTiles);
+  dirX = newX;
+  dirY = newY;
+  dirWidth = newWidth;
+  dirHeight = newHeight;
+}
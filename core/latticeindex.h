@@ -0,0 +1,149 @@
+/* Copyright (C) 2020 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+// Defines a dense occupancy index over the triangular lattice which maps nodes
+// to the particle and/or object occupying them. The lattice is partitioned into
+// square tiles of kTileSize x kTileSize nodes that are allocated lazily the
+// first time one of their nodes is occupied; a tile directory covering the
+// bounding box of all allocated tiles grows as particles move outward. Lookups
+// are thus two array accesses instead of a walk down a balanced tree.
+
+#ifndef AMOEBOTSIM_CORE_LATTICEINDEX_H_
+#define AMOEBOTSIM_CORE_LATTICEINDEX_H_
+
+#include <memory>
+#include <vector>
+
+#include "core/node.h"
+
+// AmoebotParticle and Object are only stored by pointer, so forward declaring
+// them avoids a cyclic dependency with amoebotsystem.h.
+class AmoebotParticle;
+class Object;
+
+class LatticeIndex {
+ public:
+  // The contents of a single lattice node. Either pointer is nullptr if the
+  // node is not occupied by a particle (respectively, an object).
+  struct Cell {
+    AmoebotParticle* particle = nullptr;
+    Object* object = nullptr;
+  };
+
+  // Constructs an empty index; no memory is allocated until the first node is
+  // occupied.
+  LatticeIndex();
+
+  // Returns the contents of the given node. Nodes outside the indexed region
+  // are reported as unoccupied.
+  const Cell& at(const Node& node) const;
+
+  // Convenience accessors for the individual fields of at(node).
+  AmoebotParticle* particleAt(const Node& node) const;
+  Object* objectAt(const Node& node) const;
+
+  // Functions for updating the contents of a node. Passing nullptr marks the
+  // node as no longer occupied by a particle (respectively, an object). Setting
+  // a non-null pointer outside the indexed region grows the index to cover it.
+  void setParticle(const Node& node, AmoebotParticle* particle);
+  void setObject(const Node& node, Object* object);
+
+  // Returns true if the given node is covered by the index, i.e., setting it
+  // would not allocate.
+  bool covers(const Node& node) const;
+
+  // Grows the index to cover the given node without changing its contents.
+  // Setting nodes that are already covered never reallocates, so threads may
+  // then set distinct covered nodes concurrently.
+  void reserve(const Node& node);
+
+  // Releases all tiles, leaving the index empty.
+  void clear();
+
+ private:
+  static constexpr int kTileBits = 5;
+  static constexpr int kTileSize = 1 << kTileBits;
+  static constexpr int kTileMask = kTileSize - 1;
+
+  // Returns a pointer to the cell of the given node, or nullptr if its tile has
+  // not been allocated. cellForWrite additionally grows the directory and
+  // allocates the tile if necessary.
+  Cell* findCell(const Node& node) const;
+  Cell& cellForWrite(const Node& node);
+
+  // Grows the tile directory so that it covers tile (tileX, tileY), at least
+  // doubling the extent in the direction(s) of growth.
+  void growToInclude(int tileX, int tileY);
+
+  // The tile directory is a row-major dirWidth x dirHeight grid of tiles whose
+  // lower-left tile has tile coordinates (dirX, dirY). Unallocated tiles are
+  // nullptr.
+  int dirX, dirY;
+  int dirWidth, dirHeight;
+  std::vector<std::unique_ptr<Cell[]>> tiles;
+
+  static const Cell emptyCell;
+};
+
+inline LatticeIndex::Cell* LatticeIndex::findCell(const Node& node) const {
+  // Arithmetic right shifts floor negative coordinates onto the correct tile,
+  // and masking yields the (non-negative) offset of the node within it.
+  const unsigned int col = static_cast<unsigned int>((node.x >> kTileBits) -
+                                                     dirX);
+  const unsigned int row = static_cast<unsigned int>((node.y >> kTileBits) -
+                                                     dirY);
+  if (col >= static_cast<unsigned int>(dirWidth) ||
+      row >= static_cast<unsigned int>(dirHeight)) {
+    return nullptr;
+  }
+
+  Cell* tile = tiles[row * dirWidth + col].get();
+  if (tile == nullptr) {
+    return nullptr;
+  }
+
+  return &tile[((node.y & kTileMask) << kTileBits) | (node.x & kTileMask)];
+}
+
+inline const LatticeIndex::Cell& LatticeIndex::at(const Node& node) const {
+  const Cell* cell = findCell(node);
+  return (cell != nullptr) ? *cell : emptyCell;
+}
+
+inline AmoebotParticle* LatticeIndex::particleAt(const Node& node) const {
+  return at(node).particle;
+}
+
+inline Object* LatticeIndex::objectAt(const Node& node) const {
+  return at(node).object;
+}
+
+inline bool LatticeIndex::covers(const Node& node) const {
+  return findCell(node) != nullptr;
+}
+
+inline void LatticeIndex::setParticle(const Node& node,
+                                      AmoebotParticle* particle) {
+  if (particle == nullptr) {
+    Cell* cell = findCell(node);
+    if (cell != nullptr) {
+      cell->particle = nullptr;
+    }
+  } else {
+    cellForWrite(node).particle = particle;
+  }
+}
+
+inline void LatticeIndex::setObject(const Node& node, Object* object) {
+  if (object == nullptr) {
+    Cell* cell = findCell(node);
+    if (cell != nullptr) {
+      cell->object = nullptr;
+    }
+  } else {
+    cellForWrite(node).object = object;
+  }
+}
+
+#endif  // AMOEBOTSIM_CORE_LATTICEINDEX_H_
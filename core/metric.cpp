@@ -4,14 +4,293 @@
 
 #include "core/metric.h"
 
+#include <algorithm>
+#include <cstring>
+
+#include "core/activationtally.h"
 #include "core/amoebotsystem.h"
+#include "core/checkpoint.h"
+
+namespace {
+
+// Functions for the Compressed policy. A count is encoded as the zigzag
+// encoding of its difference to the previous value, and a measure as the XOR
+// of its bits with those of the previous value, bit-reversed so that values
+// with short mantissas (such as integers) differ in the low bits. Either is
+// then written as a varint (see core/checkpoint.h).
+uint64_t encodeDelta(const unsigned int value, const unsigned int previous) {
+  const int64_t delta =
+      static_cast<int64_t>(value) - static_cast<int64_t>(previous);
+  return (static_cast<uint64_t>(delta) << 1) ^
+         static_cast<uint64_t>(delta >> 63);
+}
+
+unsigned int decodeDelta(const uint64_t code, const unsigned int previous) {
+  const int64_t delta = static_cast<int64_t>(code >> 1) ^
+                        -static_cast<int64_t>(code & 1);
+  return static_cast<unsigned int>(previous + delta);
+}
+
+uint64_t reverseBits(uint64_t bits) {
+  uint64_t reversed = 0;
+  for (int i = 0; i < 64; ++i) {
+    reversed = (reversed << 1) | (bits & 1);
+    bits >>= 1;
+  }
+  return reversed;
+}
+
+uint64_t toBits(const double value) {
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+uint64_t encodeDelta(const double value, const double previous) {
+  return reverseBits(toBits(value) ^ toBits(previous));
+}
+
+double decodeDelta(const uint64_t code, const double previous) {
+  const uint64_t bits = reverseBits(code) ^ toBits(previous);
+  double value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+// Decodes the values of the Compressed policy, stopping at malformed bytes.
+template<class T>
+std::vector<T> decodeValues(const std::string& encoded) {
+  std::vector<T> values;
+  const unsigned char* p =
+      reinterpret_cast<const unsigned char*>(encoded.data());
+  const unsigned char* const end = p + encoded.size();
+  T value = T();
+  uint64_t code;
+  while (p != end && readVarint(p, end, code)) {
+    value = decodeDelta(code, value);
+    values.push_back(value);
+  }
+  return values;
+}
+
+// Functions for checkpointing values of either type.
+void writeValue(CheckpointWriter& out, const unsigned int value) {
+  out.writeUInt(value);
+}
+
+void writeValue(CheckpointWriter& out, const double value) {
+  out.writeDouble(value);
+}
+
+void readValue(CheckpointReader& in, unsigned int& value) {
+  value = in.readUInt();
+}
+
+void readValue(CheckpointReader& in, double& value) {
+  value = in.readDouble();
+}
+
+}  // namespace
+
+template<class T>
+MetricHistory<T>::MetricHistory()
+  : _policy(HistoryPolicy::Full),
+    _capacity(0),
+    _size(0),
+    last(),
+    stride(1) {}
+
+template<class T>
+void MetricHistory<T>::setPolicy(const HistoryPolicy policy,
+                                 const std::size_t capacity) {
+  Q_ASSERT(empty());
+  Q_ASSERT(capacity >= 2 || policy == HistoryPolicy::Full ||
+           policy == HistoryPolicy::Compressed);
+
+  _policy = policy;
+  _capacity = capacity;
+}
+
+template<class T>
+HistoryPolicy MetricHistory<T>::policy() const {
+  return _policy;
+}
+
+template<class T>
+std::size_t MetricHistory<T>::capacity() const {
+  return _capacity;
+}
+
+template<class T>
+void MetricHistory<T>::push_back(const T value) {
+  switch (_policy) {
+    case HistoryPolicy::Full:
+      stored.push_back(value);
+      break;
+    case HistoryPolicy::Recent:
+      if (stored.size() < _capacity) {
+        stored.push_back(value);
+      } else {
+        stored[_size % _capacity] = value;
+      }
+      break;
+    case HistoryPolicy::Decimated:
+      if (_size % stride == 0) {
+        stored.push_back(value);
+        if (stored.size() == _capacity) {
+          for (std::size_t i = 1; 2 * i < stored.size(); ++i) {
+            stored[i] = stored[2 * i];
+          }
+          stored.resize((stored.size() + 1) / 2);
+          stride *= 2;
+        }
+      }
+      break;
+    case HistoryPolicy::Compressed:
+      appendVarint(encoded, encodeDelta(value, last));
+      break;
+  }
+  last = value;
+  ++_size;
+}
+
+template<class T>
+std::size_t MetricHistory<T>::size() const {
+  return _size;
+}
+
+template<class T>
+bool MetricHistory<T>::empty() const {
+  return _size == 0;
+}
+
+template<class T>
+T MetricHistory<T>::back() const {
+  Q_ASSERT(!empty());
+
+  return last;
+}
+
+template<class T>
+std::vector<T> MetricHistory<T>::values() const {
+  if (_policy == HistoryPolicy::Compressed) {
+    return decodeValues<T>(encoded);
+  } else if (_policy == HistoryPolicy::Recent && _size > _capacity) {
+    std::vector<T> ordered(stored.size());
+    std::rotate_copy(stored.begin(), stored.begin() + _size % _capacity,
+                     stored.end(), ordered.begin());
+    return ordered;
+  } else {
+    return stored;
+  }
+}
+
+template<class T>
+std::vector<std::size_t> MetricHistory<T>::indices() const {
+  const std::size_t numStored =
+      (_policy == HistoryPolicy::Compressed) ? _size : stored.size();
+  const std::size_t first =
+      (_policy == HistoryPolicy::Recent) ? _size - numStored : 0;
+  const std::size_t step =
+      (_policy == HistoryPolicy::Decimated) ? stride : 1;
+
+  std::vector<std::size_t> positions(numStored);
+  for (std::size_t i = 0; i < numStored; ++i) {
+    positions[i] = first + i * step;
+  }
+  return positions;
+}
+
+template<class T>
+bool MetricHistory<T>::isComplete() const {
+  switch (_policy) {
+    case HistoryPolicy::Recent:
+      return _size <= _capacity;
+    case HistoryPolicy::Decimated:
+      return stride == 1;
+    default:
+      return true;
+  }
+}
+
+template<class T>
+void MetricHistory<T>::writeCheckpoint(CheckpointWriter& out) const {
+  out.writeUInt(static_cast<uint32_t>(_policy));
+  out.writeUInt64(_capacity);
+  out.writeUInt64(_size);
+  writeValue(out, last);
+  out.writeUInt64(stride);
+  out.writeUInt(stored.size());
+  for (const T value : stored) {
+    writeValue(out, value);
+  }
+  out.writeString(encoded);
+}
+
+template<class T>
+void MetricHistory<T>::readCheckpoint(CheckpointReader& in) {
+  _policy = static_cast<HistoryPolicy>(in.readUInt());
+  _capacity = in.readUInt64();
+  _size = in.readUInt64();
+  readValue(in, last);
+  stride = in.readUInt64();
+  const uint32_t numStored = in.readUInt();
+  stored.clear();
+  for (uint32_t i = 0; i < numStored && !in.failed(); ++i) {
+    T value;
+    readValue(in, value);
+    stored.push_back(value);
+  }
+  encoded = in.readString();
+
+  // Check that the stored values are consistent with the policy.
+  bool consistent = false;
+  switch (_policy) {
+    case HistoryPolicy::Full:
+      consistent = stored.size() == _size;
+      break;
+    case HistoryPolicy::Recent:
+      consistent = _capacity >= 2 &&
+                   stored.size() == std::min<uint64_t>(_size, _capacity);
+      break;
+    case HistoryPolicy::Decimated:
+      consistent = _capacity >= 2 && stride >= 1 &&
+                   stored.size() == (_size + stride - 1) / stride &&
+                   stored.size() < _capacity;
+      break;
+    case HistoryPolicy::Compressed:
+      consistent = stored.empty() &&
+                   decodeValues<T>(encoded).size() == _size;
+      break;
+  }
+  if (!consistent) {
+    in.fail();
+  }
+}
+
+template class MetricHistory<unsigned int>;
+template class MetricHistory<double>;
 
 Count::Count(const QString name)
   : _name(name),
     _value(0) {}
 
 void Count::record(const unsigned int numEvents) {
-  _value += numEvents;
+  if (ActivationTally::current != nullptr) {
+    ActivationTally::current->recordCount(this, numEvents);
+  } else {
+    _value += numEvents;
+  }
+}
+
+CountHandle::CountHandle()
+  : _index(-1) {}
+
+CountHandle::CountHandle(const int index)
+  : _index(index) {}
+
+bool CountHandle::isValid() const {
+  return _index >= 0;
 }
 
 Measure::Measure(const QString name, const unsigned int freq)
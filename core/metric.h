@@ -8,19 +8,98 @@
 #ifndef AMOEBOTSIM_CORE_METRIC_H_
 #define AMOEBOTSIM_CORE_METRIC_H_
 
+#include <cstddef>
+#include <cstdint>
 #include <deque>
 #include <map>
+#include <string>
 #include <vector>
 
 #include <QString>
 
+#include "core/checkpoint.h"
+
+// The ways a MetricHistory can store its values. Full keeps every value.
+// Recent keeps only the last capacity values, in a ring buffer. Decimated keeps
+// at most capacity values spread evenly over the whole history: it keeps every
+// stride-th value, starting with stride 1, and whenever it holds capacity
+// values, it drops every other one and doubles the stride. Compressed keeps
+// every value as a varint encoding its difference to the previous value and
+// decodes them on access, which for slowly changing metrics takes one or two
+// bytes per value.
+enum class HistoryPolicy {
+  Full,
+  Recent,
+  Decimated,
+  Compressed
+};
+
+// The values a count or measure has taken over time, stored according to a
+// HistoryPolicy. Instantiated for unsigned int (counts) and double (measures).
+template<class T>
+class MetricHistory {
+ public:
+  // Constructs an empty history that keeps every value.
+  MetricHistory();
+
+  // Sets how this history stores its values. capacity bounds the number of
+  // values kept by the Recent and Decimated policies and must be at least 2
+  // for them. The history must be empty.
+  void setPolicy(const HistoryPolicy policy, const std::size_t capacity = 0);
+  HistoryPolicy policy() const;
+  std::size_t capacity() const;
+
+  // Records the given value as the next one.
+  void push_back(const T value);
+
+  // Returns the number of values recorded so far, including those that are no
+  // longer stored, and whether there are none, respectively.
+  std::size_t size() const;
+  bool empty() const;
+
+  // Returns the value recorded last, which is always available. The history
+  // must not be empty.
+  T back() const;
+
+  // Returns the stored values, decoded and in the order they were recorded,
+  // and their positions among all values recorded, respectively. Unless
+  // isComplete returns true, some values have been dropped.
+  std::vector<T> values() const;
+  std::vector<std::size_t> indices() const;
+  bool isComplete() const;
+
+  // Write (respectively, restore) this history, including its policy, to
+  // (respectively, from) a checkpoint (see core/checkpoint.h).
+  void writeCheckpoint(CheckpointWriter& out) const;
+  void readCheckpoint(CheckpointReader& in);
+
+ private:
+  HistoryPolicy _policy;
+  std::size_t _capacity;
+
+  // The number of values recorded and the value recorded last.
+  uint64_t _size;
+  T last;
+
+  // The values stored by the Full, Recent, and Decimated policies. The Recent
+  // policy writes its ring buffer at _size % _capacity once it is full; the
+  // Decimated policy stores the values whose positions are multiples of
+  // stride.
+  std::vector<T> stored;
+  uint64_t stride;
+
+  // The encoded values of the Compressed policy.
+  std::string encoded;
+};
+
 class Count {
  public:
   // Constructs a new count initialized to zero.
   Count(const QString name);
 
   // Increments the value of this count by the number of events being recorded,
-  // whose default is 1.
+  // whose default is 1. During concurrent activations, the increment is
+  // deferred to the thread's ActivationTally (see core/activationtally.h).
   void record(const unsigned int numEvents = 1);
 
   // Member variables. The count's name should be human-readable, as it is used
@@ -28,7 +107,28 @@ class Count {
   // incremented. History records the count values over time, once per round.
   const QString _name;
   unsigned int _value;
-  std::vector<int> _history;
+  MetricHistory<unsigned int> _history;
+};
+
+// A cheap, copyable reference to a count registered with an AmoebotSystem.
+// Handles are created by AmoebotSystem::addCount (or looked up once by name via
+// AmoebotSystem::countHandle) and resolved by AmoebotSystem::count with a
+// single index into the system's count list, so that counts recorded on every
+// activation avoid the string comparisons performed by getCount.
+class CountHandle {
+ public:
+  // Constructs an invalid handle that does not refer to any count.
+  CountHandle();
+
+  // Returns true if this handle refers to a registered count.
+  bool isValid() const;
+
+ private:
+  friend class AmoebotSystem;
+
+  explicit CountHandle(const int index);
+
+  int _index;
 };
 
 class Measure {
@@ -46,10 +146,10 @@ class Measure {
   // Member variables. The measure's name should be human-readable, as it is
   // used to represent this measure in the GUI. Frequency determines how often
   // the measure is calculated in terms of # of rounds. History records the
-  // measure values over time, once per round.
+  // measure values over time, once per calculation.
   const QString _name;
   const unsigned int _freq;
-  std::vector<double> _history;
+  MetricHistory<double> _history;
 };
 
 #endif  // AMOEBOTSIM_CORE_METRIC_H_
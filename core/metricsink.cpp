@@ -0,0 +1,282 @@
+/* Copyright (C) 2020 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+#include "core/metricsink.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include <QByteArray>
+
+#include "core/checkpoint.h"
+
+namespace {
+
+// "AMBMETRC" as a little-endian 64-bit value.
+constexpr uint64_t kMagic = 0x435254454d424d41ull;
+
+void writeName(std::ostream& out, const QString& name) {
+  const std::string utf8 = name.toStdString();
+  writeFixed(out, utf8.size(), 4);
+  out.write(utf8.data(), utf8.size());
+}
+
+// Appends the given number as it appears in the metrics JSON (see
+// AmoebotSystem::writeMetricsJSON), i.e., with six significant digits and a
+// decimal point regardless of the C locale, which QCoreApplication sets from
+// the environment.
+void appendNumber(std::string& buffer, const double value) {
+  const QByteArray digits = QByteArray::number(value, 'g', 6);
+  buffer.append(digits.constData(), digits.size());
+}
+
+void appendNumber(std::string& buffer, const unsigned int value) {
+  char digits[16];
+  const int length = std::snprintf(digits, sizeof(digits), "%u", value);
+  buffer.append(digits, length);
+}
+
+// Appends the given name as a JSON (respectively, CSV) string.
+void appendJsonString(std::string& buffer, const QString& name) {
+  buffer += '"';
+  for (const char c : name.toStdString()) {
+    if (c == '"' || c == '\\') {
+      buffer += '\\';
+    }
+    buffer += c;
+  }
+  buffer += '"';
+}
+
+void appendCsvString(std::string& buffer, const QString& name) {
+  buffer += '"';
+  for (const char c : name.toStdString()) {
+    if (c == '"') {
+      buffer += '"';
+    }
+    buffer += c;
+  }
+  buffer += '"';
+}
+
+}  // namespace
+
+MetricSink::MetricSink(std::ostream& out, const unsigned int flushEvery)
+  : out(out),
+    flushEvery(std::max(flushEvery, 1u)),
+    numBuffered(0) {}
+
+MetricSink::~MetricSink() {}
+
+void MetricSink::begin(const std::vector<Count*>& counts,
+                       const std::vector<Measure*>& measures) {
+  writeHeader(out, counts, measures);
+}
+
+void MetricSink::writeRound(const unsigned int round,
+                            const std::vector<Count*>& counts,
+                            const std::vector<double>& measureValues) {
+  appendRow(round, counts, measureValues);
+  if (++numBuffered >= flushEvery) {
+    writeBuffer(out);
+    numBuffered = 0;
+  }
+}
+
+void MetricSink::flush() {
+  if (numBuffered > 0) {
+    writeBuffer(out);
+    numBuffered = 0;
+  }
+  out.flush();
+}
+
+bool MetricSink::failed() const {
+  return !out;
+}
+
+JsonLinesMetricSink::JsonLinesMetricSink(std::ostream& out,
+                                         const unsigned int flushEvery)
+  : MetricSink(out, flushEvery) {}
+
+JsonLinesMetricSink::~JsonLinesMetricSink() {
+  flush();
+}
+
+void JsonLinesMetricSink::writeHeader(std::ostream& out,
+                                      const std::vector<Count*>& counts,
+                                      const std::vector<Measure*>& measures) {
+  std::string header = "{\"counts\" : [";
+  for (std::size_t i = 0; i < counts.size(); ++i) {
+    header += (i > 0) ? ", " : "";
+    appendJsonString(header, counts[i]->_name);
+  }
+  header += "], \"measures\" : [";
+  for (std::size_t i = 0; i < measures.size(); ++i) {
+    header += (i > 0) ? ", {\"name\" : " : "{\"name\" : ";
+    appendJsonString(header, measures[i]->_name);
+    header += ", \"frequency\" : ";
+    appendNumber(header, measures[i]->_freq);
+    header += '}';
+  }
+  header += "]}\n";
+  out.write(header.data(), header.size());
+}
+
+void JsonLinesMetricSink::appendRow(const unsigned int round,
+                                    const std::vector<Count*>& counts,
+                                    const std::vector<double>& measureValues) {
+  buffer += "{\"round\" : ";
+  appendNumber(buffer, round);
+  buffer += ", \"counts\" : [";
+  for (std::size_t i = 0; i < counts.size(); ++i) {
+    buffer += (i > 0) ? ", " : "";
+    appendNumber(buffer, counts[i]->_value);
+  }
+  buffer += "], \"measures\" : [";
+  for (std::size_t i = 0; i < measureValues.size(); ++i) {
+    buffer += (i > 0) ? ", " : "";
+    if (std::isnan(measureValues[i])) {
+      buffer += "null";
+    } else {
+      appendNumber(buffer, measureValues[i]);
+    }
+  }
+  buffer += "]}\n";
+}
+
+void JsonLinesMetricSink::writeBuffer(std::ostream& out) {
+  out.write(buffer.data(), buffer.size());
+  buffer.clear();
+}
+
+CsvMetricSink::CsvMetricSink(std::ostream& out, const unsigned int flushEvery)
+  : MetricSink(out, flushEvery) {}
+
+CsvMetricSink::~CsvMetricSink() {
+  flush();
+}
+
+void CsvMetricSink::writeHeader(std::ostream& out,
+                                const std::vector<Count*>& counts,
+                                const std::vector<Measure*>& measures) {
+  std::string header = "round";
+  for (const auto& c : counts) {
+    header += ',';
+    appendCsvString(header, c->_name);
+  }
+  for (const auto& m : measures) {
+    header += ',';
+    appendCsvString(header, m->_name);
+  }
+  header += '\n';
+  out.write(header.data(), header.size());
+}
+
+void CsvMetricSink::appendRow(const unsigned int round,
+                              const std::vector<Count*>& counts,
+                              const std::vector<double>& measureValues) {
+  appendNumber(buffer, round);
+  for (const auto& c : counts) {
+    buffer += ',';
+    appendNumber(buffer, c->_value);
+  }
+  for (const double value : measureValues) {
+    buffer += ',';
+    if (!std::isnan(value)) {
+      appendNumber(buffer, value);
+    }
+  }
+  buffer += '\n';
+}
+
+void CsvMetricSink::writeBuffer(std::ostream& out) {
+  out.write(buffer.data(), buffer.size());
+  buffer.clear();
+}
+
+BinaryMetricSink::BinaryMetricSink(std::ostream& out,
+                                   const unsigned int flushEvery)
+  : MetricSink(out, flushEvery) {}
+
+BinaryMetricSink::~BinaryMetricSink() {
+  flush();
+}
+
+void BinaryMetricSink::writeHeader(std::ostream& out,
+                                   const std::vector<Count*>& counts,
+                                   const std::vector<Measure*>& measures) {
+  writeFixed(out, kMagic, 8);
+  writeFixed(out, kVersion, 4);
+  writeFixed(out, counts.size(), 4);
+  writeFixed(out, measures.size(), 4);
+  for (const auto& c : counts) {
+    writeName(out, c->_name);
+  }
+  for (const auto& m : measures) {
+    writeName(out, m->_name);
+    writeFixed(out, m->_freq, 4);
+  }
+
+  countColumns.assign(counts.size(), std::vector<uint32_t>());
+  measureColumns.assign(measures.size(), std::vector<double>());
+}
+
+void BinaryMetricSink::appendRow(const unsigned int round,
+                                 const std::vector<Count*>& counts,
+                                 const std::vector<double>& measureValues) {
+  Q_ASSERT(counts.size() == countColumns.size() &&
+           measureValues.size() == measureColumns.size());
+
+  rounds.push_back(round);
+  for (std::size_t i = 0; i < counts.size(); ++i) {
+    countColumns[i].push_back(counts[i]->_value);
+  }
+  for (std::size_t i = 0; i < measureValues.size(); ++i) {
+    measureColumns[i].push_back(measureValues[i]);
+  }
+}
+
+void BinaryMetricSink::writeBuffer(std::ostream& out) {
+  std::string block;
+  block.reserve(4 + rounds.size() * (4 + 4 * countColumns.size() +
+                                     8 * measureColumns.size()));
+  appendFixed(block, rounds.size(), 4);
+  for (const uint32_t round : rounds) {
+    appendFixed(block, round, 4);
+  }
+  for (auto& column : countColumns) {
+    for (const uint32_t value : column) {
+      appendFixed(block, value, 4);
+    }
+    column.clear();
+  }
+  for (auto& column : measureColumns) {
+    for (const double value : column) {
+      uint64_t bits;
+      std::memcpy(&bits, &value, sizeof(bits));
+      appendFixed(block, bits, 8);
+    }
+    column.clear();
+  }
+  rounds.clear();
+  out.write(block.data(), block.size());
+}
+
+std::unique_ptr<MetricSink> makeMetricSink(const QString format,
+                                           std::ostream& out,
+                                           const unsigned int flushEvery) {
+  if (format == "jsonl") {
+    return std::unique_ptr<MetricSink>(
+        new JsonLinesMetricSink(out, flushEvery));
+  } else if (format == "csv") {
+    return std::unique_ptr<MetricSink>(new CsvMetricSink(out, flushEvery));
+  } else if (format == "bin") {
+    return std::unique_ptr<MetricSink>(new BinaryMetricSink(out, flushEvery));
+  } else {
+    return nullptr;
+  }
+}
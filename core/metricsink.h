@@ -0,0 +1,152 @@
+/* Copyright (C) 2020 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+// Defines metric sinks, which stream a system's counts and measures to a file
+// as AmoebotSystem::registerRound commits them, instead of assembling the
+// complete histories at the end of a run (see AmoebotSystem::writeMetricsJSON).
+// A sink attached with AmoebotSystem::addMetricSink first writes a header
+// naming the system's counts and measures and then one row per round: the
+// round number, the value of every count, and the value of every measure
+// calculated in that round. Rows are buffered and written to the stream every
+// flushEvery rounds, so a sink's memory is bounded by that many rows no matter
+// how long the run is.
+//
+// Three formats are available:
+// - JSON Lines: the header is {"counts" : [<names>], "measures" : [{"name" :
+//   <name>, "frequency" : <frequency>}, ...]} and each row is {"round" : <r>,
+//   "counts" : [<values>], "measures" : [<values>]}, one object per line, with
+//   null for measures not calculated in the round.
+// - CSV: the header is round,<count names>,<measure names>, and each row lists
+//   the values in the same order, leaving measures not calculated in the round
+//   empty.
+// - Binary: the eight bytes "AMBMETRC", a 32-bit format version, the 32-bit
+//   numbers of counts and measures, each count's name, and each measure's name
+//   and 32-bit frequency, where names are UTF-8 strings prefixed by their
+//   32-bit length. It continues with one block per flush, consisting of the
+//   32-bit number of rows in the block, their 32-bit round numbers, and then
+//   one column per count of 32-bit values and one column per measure of 64-bit
+//   IEEE 754 values, with NaN for measures not calculated in a round. All
+//   values are little-endian.
+
+#ifndef AMOEBOTSIM_CORE_METRICSINK_H_
+#define AMOEBOTSIM_CORE_METRICSINK_H_
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <QString>
+
+#include "core/metric.h"
+
+class MetricSink {
+ public:
+  // Constructs a sink writing to the given stream, which must be opened in
+  // binary mode, and buffering up to flushEvery rows (at least 1).
+  MetricSink(std::ostream& out, const unsigned int flushEvery);
+  MetricSink(const MetricSink&) = delete;
+  MetricSink& operator=(const MetricSink&) = delete;
+
+  // Subclasses write the rows still buffered when they are destructed.
+  virtual ~MetricSink();
+
+  // Writes the header for the given counts and measures; called by
+  // AmoebotSystem::addMetricSink.
+  void begin(const std::vector<Count*>& counts,
+             const std::vector<Measure*>& measures);
+
+  // Buffers the row of the given round, given the counts and the values of the
+  // measures (NaN for those not calculated in the round), and writes the
+  // buffered rows if there are flushEvery of them; called by
+  // AmoebotSystem::registerRound.
+  void writeRound(const unsigned int round, const std::vector<Count*>& counts,
+                  const std::vector<double>& measureValues);
+
+  // Writes the buffered rows and flushes the stream.
+  void flush();
+
+  // Returns true if the underlying stream reported an error.
+  bool failed() const;
+
+ protected:
+  // Write the header to the stream, append a row to the buffer of the sink,
+  // and write (and clear) the buffer, respectively.
+  virtual void writeHeader(std::ostream& out,
+                           const std::vector<Count*>& counts,
+                           const std::vector<Measure*>& measures) = 0;
+  virtual void appendRow(const unsigned int round,
+                         const std::vector<Count*>& counts,
+                         const std::vector<double>& measureValues) = 0;
+  virtual void writeBuffer(std::ostream& out) = 0;
+
+ private:
+  std::ostream& out;
+  const unsigned int flushEvery;
+  unsigned int numBuffered;
+};
+
+class JsonLinesMetricSink : public MetricSink {
+ public:
+  JsonLinesMetricSink(std::ostream& out, const unsigned int flushEvery);
+  ~JsonLinesMetricSink() override;
+
+ protected:
+  void writeHeader(std::ostream& out, const std::vector<Count*>& counts,
+                   const std::vector<Measure*>& measures) override;
+  void appendRow(const unsigned int round, const std::vector<Count*>& counts,
+                 const std::vector<double>& measureValues) override;
+  void writeBuffer(std::ostream& out) override;
+
+ private:
+  std::string buffer;
+};
+
+class CsvMetricSink : public MetricSink {
+ public:
+  CsvMetricSink(std::ostream& out, const unsigned int flushEvery);
+  ~CsvMetricSink() override;
+
+ protected:
+  void writeHeader(std::ostream& out, const std::vector<Count*>& counts,
+                   const std::vector<Measure*>& measures) override;
+  void appendRow(const unsigned int round, const std::vector<Count*>& counts,
+                 const std::vector<double>& measureValues) override;
+  void writeBuffer(std::ostream& out) override;
+
+ private:
+  std::string buffer;
+};
+
+class BinaryMetricSink : public MetricSink {
+ public:
+  // The version of the format written.
+  static constexpr uint32_t kVersion = 1;
+
+  BinaryMetricSink(std::ostream& out, const unsigned int flushEvery);
+  ~BinaryMetricSink() override;
+
+ protected:
+  void writeHeader(std::ostream& out, const std::vector<Count*>& counts,
+                   const std::vector<Measure*>& measures) override;
+  void appendRow(const unsigned int round, const std::vector<Count*>& counts,
+                 const std::vector<double>& measureValues) override;
+  void writeBuffer(std::ostream& out) override;
+
+ private:
+  // The buffered rows, column by column.
+  std::vector<uint32_t> rounds;
+  std::vector<std::vector<uint32_t>> countColumns;
+  std::vector<std::vector<double>> measureColumns;
+};
+
+// Constructs a sink of the format with the given name ("jsonl", "csv", or
+// "bin") writing to the given stream, or returns nullptr if there is no such
+// format.
+std::unique_ptr<MetricSink> makeMetricSink(const QString format,
+                                           std::ostream& out,
+                                           const unsigned int flushEvery);
+
+#endif  // AMOEBOTSIM_CORE_METRICSINK_H_
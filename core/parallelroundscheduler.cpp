@@ -0,0 +1,204 @@
+/* Copyright (C) 2020 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+#include "core/parallelroundscheduler.h"
+
+#include <algorithm>
+
+#include <QtGlobal>
+
+#include "core/amoebotparticle.h"
+#include "helper/randomnumbergenerator.h"
+
+ParallelRoundScheduler::ParallelRoundScheduler(AmoebotSystem& system,
+                                               unsigned int numThreads)
+  : system(system),
+    colorClasses(kColorPeriod * kColorPeriod),
+    roundSeed(0),
+    phaseNumber(0),
+    numBusyHelpers(0),
+    stopping(false),
+    phaseColor(-1),
+    nextBatch(0) {
+  Q_ASSERT(system.supportsParallelRounds());
+
+  if (numThreads == 0) {
+    numThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  for (unsigned int i = 0; i < numThreads; ++i) {
+    workers.emplace_back(new Worker());
+  }
+  for (unsigned int i = 1; i < numThreads; ++i) {
+    Worker& worker = *workers[i];
+    worker.thread = std::thread([this, &worker]() { workerLoop(worker); });
+  }
+}
+
+ParallelRoundScheduler::~ParallelRoundScheduler() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  phaseStarted.notify_all();
+  for (auto& worker : workers) {
+    if (worker->thread.joinable()) {
+      worker->thread.join();
+    }
+  }
+}
+
+unsigned int ParallelRoundScheduler::numThreads() const {
+  return workers.size();
+}
+
+void ParallelRoundScheduler::runRound() {
+  const std::vector<AmoebotParticle*>& particles = system.particles;
+  if (particles.empty()) {
+    return;
+  }
+
+  // Sort the particles by color, and make sure the lattice index covers every
+  // node within distance 2 of a head: a particle only ever moves onto nodes
+  // adjacent to the ones it occupies, so the index will not grow (and thus
+  // reallocate) while phases are running.
+  for (auto& colorClass : colorClasses) {
+    colorClass.clear();
+  }
+  for (unsigned int i = 0; i < particles.size(); ++i) {
+    if (particles[i]->isDormant()) {
+      // Its activation would do nothing (see AmoebotParticle::sleep).
+      continue;
+    }
+    const Node head = particles[i]->head;
+    for (const int dx : {-2, 2}) {
+      for (const int dy : {-2, 2}) {
+        system.lattice.reserve(Node(head.x + dx, head.y + dy));
+      }
+    }
+    colorClasses[colorOf(head)].push_back(i);
+  }
+
+  roundSeed = system.randomEngine();
+  system.tokenPool.setConcurrent(true);
+  for (int color = 0; color < kColorPeriod * kColorPeriod; ++color) {
+    if (!colorClasses[color].empty()) {
+      runPhase(color, colorClasses[color]);
+    }
+  }
+  system.tokenPool.setConcurrent(false);
+
+  // Particles moved to another color by a neighbor's handover before their
+  // phase are activated one after another, drawing from the system's engine.
+  std::sort(deferred.begin(), deferred.end());
+  ActivationTally::current = &workers[0]->tally;
+  for (const unsigned int i : deferred) {
+    particles[i]->activate();
+    system.count(system.activationsCount).record();
+  }
+  ActivationTally::current = nullptr;
+  deferred.clear();
+
+  for (auto& worker : workers) {
+    system.mergeTally(worker->tally);
+  }
+
+  // Every particle was activated exactly once, so this round is complete.
+  system.completeRound();
+}
+
+int ParallelRoundScheduler::colorOf(const Node& node) {
+  const int x = ((node.x % kColorPeriod) + kColorPeriod) % kColorPeriod;
+  const int y = ((node.y % kColorPeriod) + kColorPeriod) % kColorPeriod;
+
+  return x * kColorPeriod + y;
+}
+
+void ParallelRoundScheduler::runPhase(const int color,
+                                      const std::vector<unsigned int>& members) {
+  // Filter the members before any of them is activated; once activations run,
+  // a particle outside the phase color may be moved by one of them.
+  phaseMembers.clear();
+  for (const unsigned int i : members) {
+    if (colorOf(system.particles[i]->head) == color) {
+      phaseMembers.push_back(i);
+    } else {
+      deferred.push_back(i);
+    }
+  }
+
+  phaseColor = color;
+  nextBatch = 0;
+  const bool useHelpers = workers.size() > 1 &&
+                          phaseMembers.size() > kBatchSize;
+  if (useHelpers) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      numBusyHelpers = workers.size() - 1;
+      ++phaseNumber;
+    }
+    phaseStarted.notify_all();
+  }
+
+  activateBatches(*workers[0]);
+
+  if (useHelpers) {
+    std::unique_lock<std::mutex> lock(mutex);
+    phaseFinished.wait(lock, [this]() { return numBusyHelpers == 0; });
+  }
+}
+
+void ParallelRoundScheduler::activateBatches(Worker& worker) {
+  const std::vector<AmoebotParticle*>& particles = system.particles;
+  const unsigned int numMembers = phaseMembers.size();
+
+  ActivationTally::current = &worker.tally;
+  while (true) {
+    const unsigned int batch = nextBatch.fetch_add(1);
+    const unsigned int begin = batch * kBatchSize;
+    if (begin >= numMembers) {
+      break;
+    }
+
+    // Seed the batch's engine from the round, phase, and batch alone, so the
+    // random numbers each activation draws do not depend on which thread
+    // executes it. A seed of 0 would draw a fresh one instead.
+    uint64_t seed = roundSeed ^ (static_cast<uint64_t>(phaseColor + 1) << 32) ^
+                    batch;
+    RandomEngine engine(seed != 0 ? seed : 1);
+    RandomNumberGenerator::threadEngine = &engine;
+
+    const unsigned int end = std::min(begin + kBatchSize, numMembers);
+    for (unsigned int i = begin; i < end; ++i) {
+      particles[phaseMembers[i]]->activate();
+      system.count(system.activationsCount).record();
+    }
+  }
+  RandomNumberGenerator::threadEngine = nullptr;
+  ActivationTally::current = nullptr;
+}
+
+void ParallelRoundScheduler::workerLoop(Worker& worker) {
+  unsigned long long lastPhase = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      phaseStarted.wait(lock, [this, lastPhase]() {
+        return stopping || phaseNumber != lastPhase;
+      });
+      if (stopping) {
+        return;
+      }
+      lastPhase = phaseNumber;
+    }
+
+    activateBatches(worker);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (--numBusyHelpers == 0) {
+        phaseFinished.notify_one();
+      }
+    }
+  }
+}
@@ -0,0 +1,113 @@
+/* Copyright (C) 2020 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+// Defines a scheduler that executes a system in rounds, activating every
+// particle exactly once per round and running non-interfering activations in
+// parallel. The lattice is colored by node coordinates modulo kColorPeriod, so
+// distinct nodes of the same color are at least kColorPeriod apart. A round
+// runs one phase per color, in order; each phase activates the particles whose
+// heads have that color in parallel. For systems that support parallel rounds
+// (see AmoebotSystem::supportsParallelRounds), activations within distance 2
+// of their particle cannot interfere at that spacing, so every round is
+// equivalent to a sequential round in some order and the run is a legitimate
+// fair-scheduler execution. Particles moved out of their phase's color by a
+// neighbor's handover are activated sequentially at the end of the round.
+//
+// Every batch of activations draws from its own engine seeded from the
+// system's, so runs are reproducible independently of the number of threads.
+
+#ifndef AMOEBOTSIM_CORE_PARALLELROUNDSCHEDULER_H_
+#define AMOEBOTSIM_CORE_PARALLELROUNDSCHEDULER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "core/activationtally.h"
+#include "core/amoebotsystem.h"
+#include "core/node.h"
+
+class ParallelRoundScheduler {
+ public:
+  // The period of the lattice coloring, which yields kColorPeriod^2 colors.
+  // An activation touches nodes within distance 3 of the particle's head (2 of
+  // an expanded particle's tail) and the particles occupying them, each of
+  // which spans at most one further node, so two activations can only
+  // interfere if their heads are at most 7 apart.
+  static constexpr int kColorPeriod = 8;
+
+  // Constructs a scheduler for the given system, which must support parallel
+  // rounds, using numThreads threads including the calling one (0 uses one
+  // thread per core).
+  explicit ParallelRoundScheduler(AmoebotSystem& system,
+                                  unsigned int numThreads = 0);
+  ParallelRoundScheduler(const ParallelRoundScheduler&) = delete;
+  ParallelRoundScheduler& operator=(const ParallelRoundScheduler&) = delete;
+
+  // Stops and joins the worker threads.
+  ~ParallelRoundScheduler();
+
+  // Returns the number of threads activating particles.
+  unsigned int numThreads() const;
+
+  // Executes one round, activating every particle of the system exactly once,
+  // and registers it with the system. Must be called from the thread that
+  // constructed the scheduler.
+  void runRound();
+
+ private:
+  // Activations of a phase are handed out in batches of this many particles,
+  // each with its own random engine.
+  static constexpr unsigned int kBatchSize = 256;
+
+  // A thread activating particles, with the tally of its activations.
+  struct Worker {
+    std::thread thread;
+    ActivationTally tally;
+  };
+
+  // Returns the color of the given node.
+  static int colorOf(const Node& node);
+
+  // Runs the phase of the given color, activating those of the given particles
+  // (indices into the system's particle list) whose heads still have that
+  // color and deferring the others to the end of the round.
+  void runPhase(const int color, const std::vector<unsigned int>& members);
+
+  // Activates batches of the current phase until none are left, recording
+  // into the given worker's tally.
+  void activateBatches(Worker& worker);
+
+  // The loop of the helper threads, which run activateBatches once per phase.
+  void workerLoop(Worker& worker);
+
+  AmoebotSystem& system;
+  std::vector<std::unique_ptr<Worker>> workers;  // workers[0] is the caller.
+
+  // The particles whose heads had each color at the start of the round, the
+  // particles to activate in the current phase, and the particles deferred to
+  // the end of the round.
+  std::vector<std::vector<unsigned int>> colorClasses;
+  std::vector<unsigned int> phaseMembers;
+  std::vector<unsigned int> deferred;
+
+  // The seed of the current round's engines.
+  uint64_t roundSeed;
+
+  // The current phase, published to the helper threads under mutex.
+  std::mutex mutex;
+  std::condition_variable phaseStarted;
+  std::condition_variable phaseFinished;
+  unsigned long long phaseNumber;
+  unsigned int numBusyHelpers;
+  bool stopping;
+  int phaseColor;
+  std::atomic<unsigned int> nextBatch;
+};
+
+#endif  // AMOEBOTSIM_CORE_PARALLELROUNDSCHEDULER_H_
@@ -0,0 +1,13 @@
+/* Copyright (C) 2020 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+#include "core/particlearena.h"
+
+ParticleArena::~ParticleArena() {
+  clear();
+}
+
+void ParticleArena::clear() {
+  storages.clear();
+}
@@ -0,0 +1,129 @@
+/* Copyright (C) 2020 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+// Defines the storage backing AmoebotSystem::emplaceParticle. Particles are
+// constructed in place in chunks of contiguous memory, with a separate series
+// of chunks per particle type, so that the particles of a system lie next to
+// each other in memory in insertion order. Chunks are never moved or resized,
+// so particle addresses are stable for the lifetime of the arena. Tearing the
+// arena down runs the destructors in one linear sweep per type (without
+// virtual dispatch) and then frees whole chunks instead of individual
+// particles.
+
+#ifndef AMOEBOTSIM_CORE_PARTICLEARENA_H_
+#define AMOEBOTSIM_CORE_PARTICLEARENA_H_
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+class ParticleArena {
+ public:
+  ParticleArena() = default;
+  ParticleArena(const ParticleArena&) = delete;
+  ParticleArena& operator=(const ParticleArena&) = delete;
+
+  // Destroys all particles in the arena.
+  ~ParticleArena();
+
+  // Constructs a particle of the given type from the given arguments in the
+  // arena and returns its (stable) address. The arena retains ownership.
+  template<class ParticleType, class... Args>
+  ParticleType* emplace(Args&&... args);
+
+  // Destroys all particles in the arena and releases its memory.
+  void clear();
+
+ private:
+  class Storage {
+   public:
+    virtual ~Storage() {}
+  };
+
+  // Contiguous storage for the particles of a single type, in chunks of
+  // roughly kChunkBytes bytes.
+  template<class ParticleType>
+  class TypedStorage : public Storage {
+   public:
+    ~TypedStorage();
+
+    template<class... Args>
+    ParticleType* emplace(Args&&... args);
+
+   private:
+    static constexpr std::size_t kChunkBytes = 64 * 1024;
+    static constexpr std::size_t kPerChunk =
+        sizeof(ParticleType) < kChunkBytes
+            ? kChunkBytes / sizeof(ParticleType) : 1;
+
+    using Slot = typename std::aligned_storage<sizeof(ParticleType),
+                                               alignof(ParticleType)>::type;
+
+    std::vector<std::unique_ptr<Slot[]>> chunks;
+    std::size_t numInLastChunk = kPerChunk;
+  };
+
+  template<class ParticleType>
+  TypedStorage<ParticleType>& storageFor();
+
+  // Storage per particle type, in order of first use. Systems rarely hold more
+  // than one or two particle types, so a linear search suffices.
+  std::vector<std::pair<const std::type_info*, std::unique_ptr<Storage>>>
+      storages;
+};
+
+template<class ParticleType, class... Args>
+ParticleType* ParticleArena::emplace(Args&&... args) {
+  return storageFor<ParticleType>().emplace(std::forward<Args>(args)...);
+}
+
+template<class ParticleType>
+ParticleArena::TypedStorage<ParticleType>& ParticleArena::storageFor() {
+  const std::type_info& type = typeid(ParticleType);
+  for (auto& storage : storages) {
+    if (*storage.first == type) {
+      return static_cast<TypedStorage<ParticleType>&>(*storage.second);
+    }
+  }
+
+  storages.emplace_back(&type, std::unique_ptr<Storage>(
+                                   new TypedStorage<ParticleType>()));
+  return static_cast<TypedStorage<ParticleType>&>(*storages.back().second);
+}
+
+template<class ParticleType>
+ParticleArena::TypedStorage<ParticleType>::~TypedStorage() {
+  for (std::size_t c = 0; c < chunks.size(); c++) {
+    const std::size_t numInChunk =
+        (c + 1 == chunks.size()) ? numInLastChunk : kPerChunk;
+    for (std::size_t i = 0; i < numInChunk; i++) {
+      // Every slot holds exactly a ParticleType, so the qualified call is safe
+      // and skips the virtual dispatch.
+      ParticleType* particle = reinterpret_cast<ParticleType*>(&chunks[c][i]);
+      particle->ParticleType::~ParticleType();
+    }
+  }
+}
+
+template<class ParticleType>
+template<class... Args>
+ParticleType* ParticleArena::TypedStorage<ParticleType>::emplace(
+    Args&&... args) {
+  if (numInLastChunk == kPerChunk) {
+    chunks.emplace_back(new Slot[kPerChunk]);
+    numInLastChunk = 0;
+  }
+
+  ParticleType* particle = new (&chunks.back()[numInLastChunk])
+      ParticleType(std::forward<Args>(args)...);
+  numInLastChunk++;
+
+  return particle;
+}
+
+#endif  // AMOEBOTSIM_CORE_PARTICLEARENA_H_
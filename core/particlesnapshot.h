@@ -0,0 +1,50 @@
+/* Copyright (C) 2020 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+// Defines a structure-of-arrays view of the particles of a system, intended
+// for consumers that scan every particle (measures, termination checks,
+// rendering, saving). Entry i of every array describes the i-th particle that
+// was inserted into the system; this order is unaffected by schedulers that
+// reorder the system's own particle list. The owning system keeps the arrays
+// up to date as particles move, so reading them is always current.
+
+#ifndef AMOEBOTSIM_CORE_PARTICLESNAPSHOT_H_
+#define AMOEBOTSIM_CORE_PARTICLESNAPSHOT_H_
+
+#include <vector>
+
+#include "core/node.h"
+#include "core/particle.h"
+
+struct ParticleSnapshot {
+  // Returns the number of particles described by the snapshot.
+  unsigned int size() const;
+
+  // Returns the head node of the i-th particle.
+  Node headAt(unsigned int i) const;
+
+  // The particle described by each entry, for consumers that need more than
+  // the columns below (e.g., colors).
+  std::vector<const Particle*> particle;
+
+  // The head node coordinates and global tail direction (-1 if contracted) of
+  // each particle.
+  std::vector<int> headX;
+  std::vector<int> headY;
+  std::vector<signed char> tailDir;
+
+  // An algorithm-defined state byte for each particle; see
+  // AmoebotParticle::setSnapshotState. Zero unless the algorithm sets it.
+  std::vector<unsigned char> state;
+};
+
+inline unsigned int ParticleSnapshot::size() const {
+  return particle.size();
+}
+
+inline Node ParticleSnapshot::headAt(unsigned int i) const {
+  return Node(headX[i], headY[i]);
+}
+
+#endif  // AMOEBOTSIM_CORE_PARTICLESNAPSHOT_H_
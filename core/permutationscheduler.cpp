@@ -0,0 +1,64 @@
+/* Copyright (C) 2020 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+#include "core/permutationscheduler.h"
+
+#include <numeric>
+#include <utility>
+
+#include <QtGlobal>
+
+PermutationScheduler::PermutationScheduler(RandomEngine& engine)
+  : RandomNumberGenerator(engine),
+    numDrawn(0),
+    cycleLeft(0) {}
+
+unsigned int PermutationScheduler::next(const unsigned int numParticles) {
+  Q_ASSERT(numParticles > 0);
+
+  if (order.size() != numParticles) {
+    order.resize(numParticles);
+    std::iota(order.begin(), order.end(), 0);
+    cycleLeft = 0;
+  }
+  if (cycleLeft == 0) {
+    numDrawn = 0;
+    cycleLeft = numParticles;
+  }
+
+  // One step of Fisher-Yates: fix the next position by swapping in a uniformly
+  // random candidate. Since numDrawn + cycleLeft <= numParticles, a candidate
+  // always remains.
+  const int pick = randInt(numDrawn, numParticles);
+  std::swap(order[numDrawn], order[pick]);
+  cycleLeft--;
+
+  return order[numDrawn++];
+}
+
+void PermutationScheduler::reshuffle() {
+  // Every entry of order is a candidate again; which permutation order holds
+  // does not matter for the uniformity of the positions drawn from it.
+  numDrawn = 0;
+}
+
+void PermutationScheduler::writeCheckpoint(CheckpointWriter& out) const {
+  out.writeArray(order, &CheckpointWriter::writeUInt);
+  out.writeUInt(numDrawn);
+  out.writeUInt(cycleLeft);
+}
+
+void PermutationScheduler::readCheckpoint(CheckpointReader& in) {
+  order = in.readArray<unsigned int>(&CheckpointReader::readUInt);
+  numDrawn = in.readUInt();
+  cycleLeft = in.readUInt();
+  if (numDrawn + cycleLeft > order.size()) {
+    in.fail();
+  }
+  for (const unsigned int index : order) {
+    if (index >= order.size()) {
+      in.fail();
+    }
+  }
+}
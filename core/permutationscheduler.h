@@ -0,0 +1,51 @@
+/* Copyright (C) 2020 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+// Defines the random permutation scheduler, which activates particles in
+// cycles that each activate every particle exactly once in a uniformly random
+// order. The permutation is kept as a separate array of particle indices and
+// generated lazily by an incremental Fisher-Yates shuffle, one position per
+// activation, so scheduling costs O(1) per activation and the system's own
+// particle list is never reordered.
+
+#ifndef AMOEBOTSIM_CORE_PERMUTATIONSCHEDULER_H_
+#define AMOEBOTSIM_CORE_PERMUTATIONSCHEDULER_H_
+
+#include <vector>
+
+#include "core/checkpoint.h"
+#include "helper/randomnumbergenerator.h"
+
+class PermutationScheduler : public RandomNumberGenerator {
+ public:
+  // Constructs a scheduler drawing its permutations from the given engine,
+  // which must outlive it.
+  explicit PermutationScheduler(RandomEngine& engine);
+
+  // Returns the index of the next particle to activate out of numParticles
+  // particles. If numParticles differs from the previous call, the current
+  // cycle is abandoned and a new one over all particles begins.
+  unsigned int next(const unsigned int numParticles);
+
+  // Redraws the remainder of the current cycle: its remaining activations are
+  // again drawn without replacement from all particles, as if the whole
+  // permutation had been reshuffled at this point.
+  void reshuffle();
+
+  // Writes (respectively, reads) the current cycle, so that a restored
+  // scheduler continues it exactly.
+  void writeCheckpoint(CheckpointWriter& out) const;
+  void readCheckpoint(CheckpointReader& in);
+
+ private:
+  // The permutation of particle indices. Its first numDrawn entries are the
+  // positions fixed so far; the rest are the candidates for the next one.
+  std::vector<unsigned int> order;
+  unsigned int numDrawn;
+
+  // The number of activations remaining in the current cycle.
+  unsigned int cycleLeft;
+};
+
+#endif  // AMOEBOTSIM_CORE_PERMUTATIONSCHEDULER_H_
@@ -0,0 +1,187 @@
+/* Copyright (C) 2020 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+#include "core/resultsink.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "core/checkpoint.h"
+
+namespace {
+
+// "AMBRESLT" as a little-endian 64-bit value.
+constexpr uint64_t kMagic = 0x544c534552424d41ull;
+
+void appendString(std::string& bytes, const QString& value) {
+  const std::string utf8 = value.toStdString();
+  appendFixed(bytes, utf8.size(), 4);
+  bytes += utf8;
+}
+
+void appendCsvString(std::string& buffer, const QString& value) {
+  buffer += '"';
+  for (const char c : value.toStdString()) {
+    if (c == '"') {
+      buffer += '"';
+    }
+    buffer += c;
+  }
+  buffer += '"';
+}
+
+}  // namespace
+
+ResultSink::ResultSink(const QString filePath, const unsigned int batchSize)
+  : filePath(filePath.toStdString()),
+    batchSize(std::max(batchSize, 1u)),
+    numBuffered(0),
+    _failed(false) {}
+
+ResultSink::~ResultSink() {}
+
+void ResultSink::report(const ResultRow& row) {
+  std::lock_guard<std::mutex> lock(mutex);
+  appendRow(row);
+  if (++numBuffered >= batchSize) {
+    writeBuffered();
+  }
+}
+
+void ResultSink::flush() {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (numBuffered > 0) {
+    writeBuffered();
+  }
+  if (out.is_open()) {
+    out.flush();
+    _failed = _failed || !out;
+  }
+}
+
+bool ResultSink::failed() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return _failed;
+}
+
+void ResultSink::writeBuffered() {
+  if (!out.is_open() && !_failed) {
+    out.open(filePath, std::ios::binary | std::ios::app);
+    out.seekp(0, std::ios::end);
+    if (out && out.tellp() == 0) {
+      writeHeader(out);
+    }
+  }
+  writeBuffer(out);
+  numBuffered = 0;
+  _failed = !out;
+}
+
+CsvResultSink::CsvResultSink(const QString filePath,
+                             const unsigned int batchSize)
+  : ResultSink(filePath, batchSize) {}
+
+CsvResultSink::~CsvResultSink() {
+  flush();
+}
+
+void CsvResultSink::writeHeader(std::ostream& out) {
+  out << "label,input,seed,particles,rounds,activations,moves,leader_x,"
+         "leader_y\n";
+}
+
+void CsvResultSink::appendRow(const ResultRow& row) {
+  appendCsvString(buffer, row.label);
+  buffer += ',';
+  appendCsvString(buffer, row.input);
+  char fields[128];
+  int length = std::snprintf(fields, sizeof(fields), ",%llu,%u,%u,%u,%u,",
+                             static_cast<unsigned long long>(row.seed),
+                             row.numParticles, row.rounds, row.activations,
+                             row.moves);
+  buffer.append(fields, length);
+  if (row.hasLeader) {
+    length = std::snprintf(fields, sizeof(fields), "%d,%d", row.leaderX,
+                           row.leaderY);
+    buffer.append(fields, length);
+  } else {
+    buffer += ',';
+  }
+  buffer += '\n';
+}
+
+void CsvResultSink::writeBuffer(std::ostream& out) {
+  out.write(buffer.data(), buffer.size());
+  buffer.clear();
+}
+
+BinaryResultSink::BinaryResultSink(const QString filePath,
+                                   const unsigned int batchSize)
+  : ResultSink(filePath, batchSize) {}
+
+BinaryResultSink::~BinaryResultSink() {
+  flush();
+}
+
+void BinaryResultSink::writeHeader(std::ostream& out) {
+  std::string header;
+  appendFixed(header, kMagic, 8);
+  appendFixed(header, kVersion, 4);
+  out.write(header.data(), header.size());
+}
+
+void BinaryResultSink::appendRow(const ResultRow& row) {
+  rows.push_back(row);
+}
+
+void BinaryResultSink::writeBuffer(std::ostream& out) {
+  std::string block;
+  appendFixed(block, rows.size(), 4);
+  for (const ResultRow& row : rows) {
+    appendString(block, row.label);
+  }
+  for (const ResultRow& row : rows) {
+    appendString(block, row.input);
+  }
+  for (const ResultRow& row : rows) {
+    appendFixed(block, row.seed, 8);
+  }
+  for (const ResultRow& row : rows) {
+    appendFixed(block, row.numParticles, 4);
+  }
+  for (const ResultRow& row : rows) {
+    appendFixed(block, row.rounds, 4);
+  }
+  for (const ResultRow& row : rows) {
+    appendFixed(block, row.activations, 4);
+  }
+  for (const ResultRow& row : rows) {
+    appendFixed(block, row.moves, 4);
+  }
+  for (const ResultRow& row : rows) {
+    appendFixed(block, row.hasLeader ? 1 : 0, 1);
+  }
+  for (const ResultRow& row : rows) {
+    appendFixed(block, static_cast<uint32_t>(row.leaderX), 4);
+  }
+  for (const ResultRow& row : rows) {
+    appendFixed(block, static_cast<uint32_t>(row.leaderY), 4);
+  }
+  rows.clear();
+  out.write(block.data(), block.size());
+}
+
+std::unique_ptr<ResultSink> makeResultSink(const QString format,
+                                           const QString filePath,
+                                           const unsigned int batchSize) {
+  if (format == "csv") {
+    return std::unique_ptr<ResultSink>(
+        new CsvResultSink(filePath, batchSize));
+  } else if (format == "bin") {
+    return std::unique_ptr<ResultSink>(
+        new BinaryResultSink(filePath, batchSize));
+  } else {
+    return nullptr;
+  }
+}
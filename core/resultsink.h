@@ -0,0 +1,134 @@
+/* Copyright (C) 2020 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+// Defines result sinks, which collect one row per terminated run into a single
+// results table. A system attached to a sink with AmoebotSystem::setResultSink
+// reports its row exactly once, when the runner driving it first sees it
+// terminate (see AmoebotSystem::reportResult), so termination checks stay free
+// of I/O. Any number of systems, also on different threads, may report to the
+// same sink. Rows are buffered and appended to the sink's file in batches of
+// batchSize rows, and the file is only opened when the first batch is
+// written; a header is written if the file is empty, so the table can be
+// extended by later runs.
+//
+// The columns are those of ResultRow. In CSV, the header names them and each
+// row lists its values in the same order, leaving the leader's coordinates
+// empty if there is none. The binary format starts with the eight bytes
+// "AMBRESLT" and a 32-bit format version, followed by one block per batch,
+// consisting of the 32-bit number of rows in the block and then one column per
+// field: labels and inputs as UTF-8 strings prefixed by their 32-bit length,
+// the seed as a 64-bit value, the size and the counts as 32-bit values, whether
+// there is a leader as one byte, and the leader's coordinates as 32-bit
+// integers. All values are little-endian.
+
+#ifndef AMOEBOTSIM_CORE_RESULTSINK_H_
+#define AMOEBOTSIM_CORE_RESULTSINK_H_
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <QString>
+
+// The result of a terminated run: the label it was reported under, the name of
+// the input configuration the system was loaded from (if any), the system's
+// seed and number of particles, the numbers of rounds, activations, and moves
+// it took, and, for leader election algorithms, the position of the leader it
+// elected (if any).
+struct ResultRow {
+  QString label;
+  QString input;
+  uint64_t seed = 0;
+  unsigned int numParticles = 0;
+  unsigned int rounds = 0;
+  unsigned int activations = 0;
+  unsigned int moves = 0;
+  bool hasLeader = false;
+  int leaderX = 0;
+  int leaderY = 0;
+};
+
+class ResultSink {
+ public:
+  // Constructs a sink appending to the file at the given path and buffering up
+  // to batchSize rows (at least 1).
+  ResultSink(const QString filePath, const unsigned int batchSize);
+  ResultSink(const ResultSink&) = delete;
+  ResultSink& operator=(const ResultSink&) = delete;
+
+  // Subclasses write the rows still buffered when they are destructed.
+  virtual ~ResultSink();
+
+  // Buffers the given row and appends the buffered rows to the file if there
+  // are batchSize of them. Thread-safe.
+  void report(const ResultRow& row);
+
+  // Appends the buffered rows to the file and flushes it. Thread-safe.
+  void flush();
+
+  // Returns true if the file could not be opened or written.
+  bool failed() const;
+
+ protected:
+  // Write the header to the empty file, append a row to the buffer of the
+  // sink, and write (and clear) the buffer, respectively.
+  virtual void writeHeader(std::ostream& out) = 0;
+  virtual void appendRow(const ResultRow& row) = 0;
+  virtual void writeBuffer(std::ostream& out) = 0;
+
+ private:
+  // Opens the file unless it is open and writes the buffered rows; the caller
+  // must hold mutex.
+  void writeBuffered();
+
+  const std::string filePath;
+  const unsigned int batchSize;
+  unsigned int numBuffered;
+  std::ofstream out;
+  bool _failed;
+  mutable std::mutex mutex;
+};
+
+class CsvResultSink : public ResultSink {
+ public:
+  CsvResultSink(const QString filePath, const unsigned int batchSize);
+  ~CsvResultSink() override;
+
+ protected:
+  void writeHeader(std::ostream& out) override;
+  void appendRow(const ResultRow& row) override;
+  void writeBuffer(std::ostream& out) override;
+
+ private:
+  std::string buffer;
+};
+
+class BinaryResultSink : public ResultSink {
+ public:
+  // The version of the format written.
+  static constexpr uint32_t kVersion = 1;
+
+  BinaryResultSink(const QString filePath, const unsigned int batchSize);
+  ~BinaryResultSink() override;
+
+ protected:
+  void writeHeader(std::ostream& out) override;
+  void appendRow(const ResultRow& row) override;
+  void writeBuffer(std::ostream& out) override;
+
+ private:
+  std::vector<ResultRow> rows;
+};
+
+// Constructs a sink of the format with the given name ("csv" or "bin")
+// appending to the file at the given path, or returns nullptr if there is no
+// such format.
+std::unique_ptr<ResultSink> makeResultSink(const QString format,
+                                           const QString filePath,
+                                           const unsigned int batchSize);
+
+#endif  // AMOEBOTSIM_CORE_RESULTSINK_H_
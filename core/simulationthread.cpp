@@ -0,0 +1,78 @@
+/* Copyright (C) 2020 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+#include "core/simulationthread.h"
+
+#include <QElapsedTimer>
+#include <QMutexLocker>
+
+SimulationThread::SimulationThread(std::shared_ptr<System> system,
+                                   const int sliceMs)
+  : system(system),
+    sliceNs(static_cast<qint64>(sliceMs) * 1000000),
+    stopRequested(false),
+    activations(0) {}
+
+SimulationThread::~SimulationThread() {
+  requestStop();
+  wait();
+}
+
+void SimulationThread::requestStop() {
+  stopRequested = true;
+}
+
+long long SimulationThread::numActivations() const {
+  return activations;
+}
+
+void SimulationThread::run() {
+  QElapsedTimer timer;
+  bool terminated = false;
+  while (!stopRequested && !terminated) {
+    // Let waiting readers take the mutex before starting the next batch.
+    while (system->numWaiting > 0 && !stopRequested) {
+      QThread::yieldCurrentThread();
+    }
+
+    QMutexLocker locker(&system->mutex);
+    timer.start();
+    // Dormant particles are skipped, so activations are read off the system's
+    // count rather than the number of calls to activate.
+    const Count& count = system->getCount("# Activations");
+    long long batch = 0;
+    bool dormant = false;
+    while (!stopRequested) {
+      if (system->hasTerminated()) {
+        system->reportResult();
+        terminated = true;
+        break;
+      }
+      const unsigned int before = count._value;
+      system->activate();
+      if (count._value == before) {
+        dormant = true;
+        break;
+      }
+      batch++;
+      if (batch % kActivationsPerClockCheck == 0 &&
+          timer.nsecsElapsed() >= sliceNs) {
+        break;
+      }
+    }
+    activations += batch;
+    locker.unlock();
+
+    // All particles are dormant, so nothing happens until the user changes the
+    // system (e.g., by activating a particle directly); wait instead of
+    // spinning on the mutex.
+    if (dormant && !stopRequested) {
+      QThread::usleep(sliceNs / 1000);
+    }
+  }
+
+  if (terminated) {
+    emit systemTerminated();
+  }
+}
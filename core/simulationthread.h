@@ -0,0 +1,63 @@
+/* Copyright (C) 2020 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+// Defines the thread on which the Simulator runs a system at full speed.
+// Instead of one activation per event loop iteration, the thread executes
+// activations in batches that each hold the system's mutex for about one time
+// slice. Between batches it releases the mutex and, if a SystemLocker (e.g.,
+// the renderer) is waiting, lets it in first, so that others always observe
+// the system as of the end of a batch while the GUI stays responsive. While
+// all particles are dormant, it waits one time slice between attempts.
+
+#ifndef AMOEBOTSIM_CORE_SIMULATIONTHREAD_H_
+#define AMOEBOTSIM_CORE_SIMULATIONTHREAD_H_
+
+#include <atomic>
+#include <memory>
+
+#include <QThread>
+
+#include "core/system.h"
+
+class SimulationThread : public QThread {
+  Q_OBJECT
+
+ public:
+  // The default batch length, chosen to leave a renderer targeting 60 frames
+  // per second (16.7 ms per frame) with plenty of time to draw.
+  static constexpr int kDefaultSliceMs = 8;
+
+  // Constructs a thread that activates the given system in batches of about
+  // sliceMs milliseconds once started.
+  explicit SimulationThread(std::shared_ptr<System> system,
+                            const int sliceMs = kDefaultSliceMs);
+
+  // Stops the thread and waits for it to finish before destructing it.
+  virtual ~SimulationThread();
+
+  // Asks the thread to stop after the current activation. Thread-safe.
+  void requestStop();
+
+  // Returns the number of particles activated so far. Thread-safe.
+  long long numActivations() const;
+
+ signals:
+  // Emitted from this thread when the system has terminated, after which the
+  // thread finishes.
+  void systemTerminated();
+
+ protected:
+  void run() override;
+
+ private:
+  // The clock is read once per this many activations.
+  static constexpr int kActivationsPerClockCheck = 16;
+
+  std::shared_ptr<System> system;
+  const qint64 sliceNs;
+  std::atomic<bool> stopRequested;
+  std::atomic<long long> activations;
+};
+
+#endif  // AMOEBOTSIM_CORE_SIMULATIONTHREAD_H_
@@ -8,31 +8,40 @@
 #include <QDateTime>
 #include <QDir>
 #include <QFile>
-#include <QMutexLocker>
 #include <QTextStream>
 #include <QtGlobal>
 
-#include <string>
-#include <fstream>
-#include "core/particle.h"
-#include <QTextStream>
-
+#include "core/amoebotsystem.h"
+#include "core/checkpoint.h"
+#include "core/configuration.h"
+#include "core/localparticle.h"
 #include "core/metric.h"
+#include "core/resultsink.h"
 
-Simulator::Simulator() {
+Simulator::Simulator()
+  : resultSink(makeResultSink("csv", "../AmoebotSim/data/output/results.csv",
+                              1)) {
   stepTimer.setInterval(100);
   connect(&stepTimer, &QTimer::timeout, this, &Simulator::step);
 }
 
 Simulator::~Simulator() {
-  stepTimer.stop();
+  halt();
+  auto amoebotSystem = std::dynamic_pointer_cast<AmoebotSystem>(system);
+  if (amoebotSystem != nullptr) {
+    amoebotSystem->setResultSink(nullptr, "");
+  }
 }
 
 void Simulator::setSystem(std::shared_ptr<System> _system) {
-  stepTimer.stop();
+  halt();
   emit stopped();
 
   system = _system;
+  auto amoebotSystem = std::dynamic_pointer_cast<AmoebotSystem>(system);
+  if (amoebotSystem != nullptr && amoebotSystem->reportsResults()) {
+    amoebotSystem->setResultSink(resultSink.get(), "gui");
+  }
   emit systemChanged(system);
 }
 
@@ -40,20 +49,25 @@ void Simulator::saveSystem() {
   QTextStream out(stdout);
   out << "Saving system..." << endl;
 
-  std::string path = "../AmoebotSim/data/input/save.txt";
-  std::ofstream file;
-  file.open(path);
-
-  int index = 0;
-  while (index < system->size()) {
-    const Particle& p = system->at(index);
-    file << std::to_string(p.head.x) << "," << std::to_string(p.head.y) << "\n";
-    index += 1;
+  std::vector<ConfigurationRecord> records;
+  {
+    SystemLocker locker(*system);
+    const ParticleSnapshot& snapshot = system->snapshot();
+    records.reserve(snapshot.size());
+    for (unsigned int i = 0; i < snapshot.size(); ++i) {
+      auto p = dynamic_cast<const LocalParticle*>(snapshot.particle[i]);
+      records.push_back({snapshot.headX[i], snapshot.headY[i],
+                         p ? p->orientation : -1, snapshot.tailDir[i]});
+    }
   }
 
-  file.close();
-  
-  out << "System saved to: " << QString::fromStdString(path) << endl;
+  const QString path = "../AmoebotSim/data/input/save.bin";
+  QString error;
+  if (writeConfiguration(path, records, error)) {
+    out << "System saved to: " << path << endl;
+  } else {
+    out << "Could not save system: " << error << endl;
+  }
 }
 
 std::shared_ptr<System> Simulator::getSystem() const {
@@ -61,53 +75,68 @@ std::shared_ptr<System> Simulator::getSystem() const {
 }
 
 void Simulator::start() {
-  stepTimer.start();
+  resume();
   emit started();
 }
 
 void Simulator::stop() {
-  stepTimer.stop();
+  halt();
   emit stopped();
 }
 
 void Simulator::step() {
-  QMutexLocker locker(&system->mutex);
-  system->activate();
+  bool terminated = false;
+  {
+    SystemLocker locker(*system);
+    system->activate();
+    terminated = system->hasTerminated();
+    if (terminated) {
+      system->reportResult();
+    }
+  }
 
-  if (system->hasTerminated()) {
+  // Stopping waits for the simulation thread, which may be waiting for the
+  // system's mutex, so the lock must be released first.
+  if (terminated) {
     stop();
   }
 }
 
 void Simulator::stepForParticleAt(Node node) {
-  QMutexLocker locker(&system->mutex);
+  SystemLocker locker(*system);
   system->activateParticleAt(node);
 }
 
 void Simulator::setStepDuration(int ms) {
+  const bool running = isRunning();
+  halt();
   stepTimer.setInterval(ms);
+  if (running) {
+    resume();
+  }
   emit stepDurationChanged(ms);
 }
 
 void Simulator::runUntilTermination() {
-  QMutexLocker locker(&system->mutex);
+  SystemLocker locker(*system);
   while (!system->hasTerminated()) {
     system->activate();
   }
+  system->reportResult();
 }
 
 int Simulator::numParticles() const {
-  QMutexLocker locker(&system->mutex);
+  SystemLocker locker(*system);
   return system->size();
 }
 
 int Simulator::numObjects() const {
-  QMutexLocker locker(&system->mutex);
+  SystemLocker locker(*system);
   return system->numObjects();
 }
 
 QVariant Simulator::metrics() const {
-  QMutexLocker locker(&system->mutex);
+  SystemLocker locker(*system);
   QList<QVariant> metricsData;
   for (const auto& c : system->getCounts()) {
     metricsData.push_back(QVariant({c->_name, c->_value}));
@@ -123,7 +152,7 @@ QVariant Simulator::metrics() const {
 }
 
 void Simulator::exportMetrics() {
-  QMutexLocker locker(&system->mutex);
+  SystemLocker locker(*system);
   QDir metricsDir(QCoreApplication::applicationDirPath());
   #ifdef Q_OS_MACOS
     metricsDir.cd("../../..");  // Escape the macOS application bundle.
@@ -138,11 +167,73 @@ void Simulator::exportMetrics() {
     return;
   }
   QTextStream outStream(&outFile);
-  outStream << system->metricsAsJSON();
+  system->writeMetricsJSON(outStream);
   outFile.close();
 }
 
+bool Simulator::saveCheckpoint(const QString filePath, QString& error) {
+  SystemLocker locker(*system);
+  auto amoebotSystem = std::dynamic_pointer_cast<AmoebotSystem>(system);
+  if (amoebotSystem == nullptr) {
+    error = "this algorithm does not support checkpoints";
+    return false;
+  }
+
+  return ::saveCheckpoint(*amoebotSystem, filePath, error);
+}
+
+bool Simulator::loadCheckpoint(const QString filePath, QString& error) {
+  halt();
+  emit stopped();
+
+  auto amoebotSystem = std::dynamic_pointer_cast<AmoebotSystem>(system);
+  if (amoebotSystem == nullptr) {
+    error = "this algorithm does not support checkpoints";
+    return false;
+  }
+  bool restored = false;
+  {
+    // The visualization reads the system from the GUI thread while it is
+    // restored.
+    SystemLocker locker(*system);
+    restored = ::loadCheckpoint(*amoebotSystem, filePath, error);
+  }
+  emit systemChanged(system);
+
+  return restored;
+}
+
 void Simulator::saveScreenshotSetup(const QString filePath) {
   emit systemChanged(system);
   emit saveScreenshot(filePath);
 }
+
+void Simulator::resume() {
+  if (system == nullptr) {
+    return;
+  } else if (stepTimer.interval() > 0) {
+    stepTimer.start();
+    return;
+  }
+
+  simThread.reset(new SimulationThread(system));
+  SimulationThread* thread = simThread.get();
+  connect(thread, &SimulationThread::systemTerminated, this,
+          [this, thread]() {
+            // Ignore threads that have been replaced in the meantime.
+            if (simThread.get() == thread) {
+              stop();
+            }
+          });
+  simThread->start();
+}
+
+void Simulator::halt() {
+  stepTimer.stop();
+  simThread.reset();  // Stops the thread and waits for it to finish.
+}
+
+bool Simulator::isRunning() const {
+  return stepTimer.isActive() ||
+         (simThread != nullptr && simThread->isRunning());
+}
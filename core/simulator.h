@@ -11,8 +11,11 @@
 #include <QTimer>
 #include <QVariant>
 
+#include "core/simulationthread.h"
 #include "core/system.h"
 
+class ResultSink;
+
 class Simulator : public QObject {
   Q_OBJECT
 
@@ -36,8 +39,10 @@ class Simulator : public QObject {
   // Responds to control flow signals from the GUI and scripts. Start, stop, and
   // step are self-explanatory. stepForParticleAt executes one activation for
   // the specific particle at the given node. setStepDuration updates the delay
-  // in milliseconds between particle activations. runUntilTermination activates
-  // particles repeatedly until the hasTerminated condition is satisfied.
+  // in milliseconds between particle activations; with a delay of 0, a started
+  // simulation runs in batches on a SimulationThread instead of the event loop.
+  // runUntilTermination activates particles repeatedly until the hasTerminated
+  // condition is satisfied.
   void start();
   void stop();
   void step();
@@ -59,9 +64,31 @@ class Simulator : public QObject {
   // takes a screenshot of the result.
   void saveScreenshotSetup(const QString filePath);
 
+  // Responds to GUI and script requests for checkpoints. saveCheckpoint writes
+  // a binary checkpoint of the current system to the given file, and
+  // loadCheckpoint restores one into the current system, which must be an
+  // instance of the same algorithm with the same parameters and seed (see
+  // AmoebotSystem::writeCheckpoint). Both return false and describe the
+  // problem in error on failure; a system whose restore failed should be
+  // reinstantiated.
+  bool saveCheckpoint(const QString filePath, QString& error);
+  bool loadCheckpoint(const QString filePath, QString& error);
+
  protected:
+  // Starts (resp., stops) running the system on the step timer or, if the step
+  // duration is 0, on the simulation thread, without emitting any signals.
+  void resume();
+  void halt();
+  bool isRunning() const;
+
   QTimer stepTimer;
+  std::unique_ptr<SimulationThread> simThread;
   std::shared_ptr<System> system;
+
+  // The results table terminated systems report to if they report results of
+  // their own (see AmoebotSystem::reportsResults), replacing the output files
+  // leader election algorithms used to write.
+  std::unique_ptr<ResultSink> resultSink;
 };
 
 #endif  // AMOEBOTSIM_CORE_SIMULATOR_H_
@@ -34,6 +34,61 @@ SystemIterator System::end() const {
   return SystemIterator(this, size());
 }
 
+const QString System::metricsAsJSON() const {
+  QString json;
+  QTextStream out(&json);
+  writeMetricsJSON(out);
+  out.flush();
+  return json;
+}
+
 bool System::hasTerminated() const {
   return false;
 }
+
+void System::reportResult() {}
+
+bool System::isConnected(const ParticleSnapshot& snapshot) {
+  std::set<Node> occupiedNodes;
+  for (unsigned int i = 0; i < snapshot.size(); ++i) {
+    const Node head = snapshot.headAt(i);
+    occupiedNodes.insert(head);
+    if (snapshot.tailDir[i] != -1) {
+      occupiedNodes.insert(head.nodeInDir(snapshot.tailDir[i]));
+    }
+  }
+
+  return nodesConnected(std::move(occupiedNodes));
+}
+
+bool System::nodesConnected(std::set<Node> occupiedNodes) {
+  std::deque<Node> queue;
+  queue.push_back(*occupiedNodes.begin());
+  occupiedNodes.clear(); // remove the first node already
+
+  while (!queue.empty()) {
+    Node n = queue.front();
+    queue.pop_front();
+    for (int dir = 0; dir < 6; ++dir) {
+      Node neighbor = n.nodeInDir(dir);
+      auto nondeIt = occupiedNodes.find(neighbor);
+      if (nondeIt != occupiedNodes.end()) {
+        queue.push_back(neighbor);
+        occupiedNodes.erase(nondeIt);
+      }
+    }
+  }
+
+  return occupiedNodes.empty();
+}
+
+SystemLocker::SystemLocker(System& system)
+  : system(system) {
+  system.numWaiting++;
+  system.mutex.lock();
+  system.numWaiting--;
+}
+
+SystemLocker::~SystemLocker() {
+  system.mutex.unlock();
+}
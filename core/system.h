@@ -8,16 +8,20 @@
 #ifndef AMOEBOTSIM_CORE_SYSTEM_H_
 #define AMOEBOTSIM_CORE_SYSTEM_H_
 
+#include <atomic>
 #include <deque>
 #include <set>
+#include <utility>
 
 #include <QMutex>
 #include <QString>
+#include <QTextStream>
 
 #include "core/metric.h"
 #include "core/node.h"
 #include "core/object.h"
 #include "core/particle.h"
+#include "core/particlesnapshot.h"
 
 // System is forward declared to avoid a cyclic dependency with SystemIterator.
 class System;
@@ -62,6 +66,10 @@ class System {
   // Returns a reference to the object list.
   virtual const std::deque<Object*>& getObjects() const = 0;
 
+  // Returns a structure-of-arrays view of the particles in the system; see
+  // particlesnapshot.h. Must be overridden by any system subclasses.
+  virtual const ParticleSnapshot& snapshot() const = 0;
+
   // STL-like begin and end functions for particle-accessing iterators.
   SystemIterator begin() const;
   SystemIterator end() const;
@@ -72,17 +80,53 @@ class System {
   virtual const std::vector<Measure*>& getMeasures() const = 0;
   virtual Count& getCount(QString name) const = 0;
   virtual Measure& getMeasure(QString name) const = 0;
-  virtual const QString metricsAsJSON() const = 0;
+
+  // Writes the count and measure histories as JSON to the given stream, and
+  // returns that JSON as a string, respectively. The structure of the JSON can
+  // be found in the Usage documentation. Streaming avoids holding the complete
+  // document in memory, e.g., when exporting the metrics of a long run.
+  virtual void writeMetricsJSON(QTextStream& out) const = 0;
+  const QString metricsAsJSON() const;
 
   virtual bool hasTerminated() const;
 
+  // Reports the result of this system's run, e.g., to a results table (see
+  // AmoebotSystem::setResultSink); called by the runners once hasTerminated
+  // returns true, so that hasTerminated itself has no side effects. Reports at
+  // most once per run. The default does nothing.
+  virtual void reportResult();
+
  protected:
-  // Checks whether the particle system forms one connected component.
+  // Checks whether the particle system forms one connected component. The
+  // snapshot version avoids touching the particles themselves.
   template<class ParticleContainer>
   static bool isConnected(const ParticleContainer& particles);
+  static bool isConnected(const ParticleSnapshot& snapshot);
+
+ private:
+  // Checks whether the given set of nodes forms one connected component.
+  static bool nodesConnected(std::set<Node> occupiedNodes);
 
  public:
+  // Guards the system against concurrent access, e.g., by the renderer while
+  // the simulator activates particles. Threads other than the simulation
+  // thread should lock it through a SystemLocker. numWaiting counts the
+  // SystemLockers currently waiting for the mutex; a SimulationThread hands the
+  // mutex over to them between its batches of activations.
   QMutex mutex;
+  std::atomic<int> numWaiting{0};
+};
+
+// Locks the mutex of the given system for the lifetime of the locker, like a
+// QMutexLocker, but announces the wait so that a SimulationThread running
+// batches of activations does not starve this thread.
+class SystemLocker {
+ public:
+  explicit SystemLocker(System& system);
+  ~SystemLocker();
+
+ private:
+  System& system;
 };
 
 template<class ParticleContainer>
@@ -95,24 +139,7 @@ bool System::isConnected(const ParticleContainer& particles) {
     }
   }
 
-  std::deque<Node> queue;
-  queue.push_back(*occupiedNodes.begin());
-  occupiedNodes.clear(); // remove the first node already
-
-  while (!queue.empty()) {
-    Node n = queue.front();
-    queue.pop_front();
-    for (int dir = 0; dir < 6; ++dir) {
-      Node neighbor = n.nodeInDir(dir);
-      auto nondeIt = occupiedNodes.find(neighbor);
-      if (nondeIt != occupiedNodes.end()) {
-        queue.push_back(neighbor);
-        occupiedNodes.erase(nondeIt);
-      }
-    }
-  }
-
-  return occupiedNodes.empty();
+  return nodesConnected(std::move(occupiedNodes));
 }
 
 #endif  // AMOEBOTSIM_CORE_SYSTEM_H_
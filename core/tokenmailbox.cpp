@@ -0,0 +1,24 @@
+/* Copyright (C) 2020 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+#include "core/tokenmailbox.h"
+
+#include <typeindex>
+#include <unordered_map>
+
+#include <QMutex>
+#include <QMutexLocker>
+
+int TokenTypeRegistry::idOf(const std::type_info& type) {
+  static QMutex mutex;
+  static std::unordered_map<std::type_index, int> ids;
+
+  QMutexLocker locker(&mutex);
+  auto it = ids.find(std::type_index(type));
+  if (it == ids.end()) {
+    it = ids.emplace(std::type_index(type), static_cast<int>(ids.size())).first;
+  }
+
+  return it->second;
+}
@@ -0,0 +1,300 @@
+/* Copyright (C) 2020 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+// Defines the container in which an AmoebotParticle stores its tokens. Tokens
+// are bucketed by their dynamic type, so that looking for tokens of a given
+// type only visits the buckets of that type (and of types derived from it)
+// instead of casting every held token. Whether a bucket's type is derived from
+// a queried type is determined once per pair of types and cached globally,
+// after which queries do not use RTTI. Tokens are kept in arrival order: the
+// "first" token of a type is always the one that was put earliest.
+
+#ifndef AMOEBOTSIM_CORE_TOKENMAILBOX_H_
+#define AMOEBOTSIM_CORE_TOKENMAILBOX_H_
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <typeinfo>
+#include <vector>
+
+#include <QtGlobal>
+
+#include "core/tokenpool.h"
+
+// Assigns dense integer ids to token types, used to index the type relation
+// caches of TokenMailbox.
+class TokenTypeRegistry {
+ public:
+  // The number of token types whose relations are cached. Types registered
+  // beyond this limit still work, but are related with a dynamic_cast on every
+  // query instead.
+  static constexpr int kMaxCachedTypes = 256;
+
+  // Returns the id of the given type, registering it on first use. Thread-safe.
+  static int idOf(const std::type_info& type);
+
+  // Returns the id of the given static type. The lookup happens once per type.
+  template<class TokenType>
+  static int idOf();
+};
+
+template<class TokenType>
+int TokenTypeRegistry::idOf() {
+  static const int id = idOf(typeid(TokenType));
+  return id;
+}
+
+template<class TokenBase>
+class TokenMailbox {
+ public:
+  // Adds the given token to the back of its type's bucket.
+  void put(TokenPtr<TokenBase> token);
+
+  // Functions for querying tokens of the specified type (including tokens of
+  // types derived from it) that satisfy the given property. find returns the
+  // earliest such token or nullptr if there is none; take does the same but
+  // also removes the returned token. count returns the number of such tokens,
+  // and contains checks whether there is at least one.
+  template<class TokenType, class Property>
+  TokenPtr<TokenType> find(const Property& propertyCheck) const;
+  template<class TokenType, class Property>
+  TokenPtr<TokenType> take(const Property& propertyCheck);
+  template<class TokenType, class Property>
+  int count(const Property& propertyCheck) const;
+  template<class TokenType, class Property>
+  bool contains(const Property& propertyCheck) const;
+
+  // Versions of count and contains without a property; these never touch the
+  // tokens themselves.
+  template<class TokenType>
+  int count() const;
+  template<class TokenType>
+  bool contains() const;
+
+  // Returns the total number of tokens held.
+  int size() const;
+
+  // Returns all tokens held, in the order they were put.
+  std::vector<TokenPtr<TokenBase>> inOrder() const;
+
+ private:
+  struct Entry {
+    unsigned long long seq;
+    TokenPtr<TokenBase> token;
+  };
+
+  struct Bucket {
+    const std::type_info* type;
+    int typeId;
+    std::vector<Entry> entries;  // Ordered by seq.
+  };
+
+  // Returns true if the tokens in the given nonempty bucket are of the
+  // specified type or of a type derived from it.
+  template<class TokenType>
+  static bool holds(const Bucket& bucket);
+
+  // Returns the position of the earliest entry over all buckets that holds the
+  // specified type and satisfies the given property, with bucket == -1 if no
+  // such entry exists.
+  struct Position {
+    int bucket = -1;
+    int entry = -1;
+  };
+  template<class TokenType, class Property>
+  Position locate(const Property& propertyCheck) const;
+
+  std::vector<Bucket> buckets;
+  unsigned long long nextSeq = 0;
+  int numTokens = 0;
+};
+
+template<class TokenBase>
+void TokenMailbox<TokenBase>::put(TokenPtr<TokenBase> token) {
+  Q_ASSERT(token != nullptr);
+
+  const std::type_info& type = typeid(*token);
+  Bucket* target = nullptr;
+  for (auto& bucket : buckets) {
+    if (*bucket.type == type) {
+      target = &bucket;
+      break;
+    }
+  }
+  if (target == nullptr) {
+    buckets.push_back(Bucket{&type, TokenTypeRegistry::idOf(type), {}});
+    target = &buckets.back();
+  }
+
+  target->entries.push_back(Entry{nextSeq++, std::move(token)});
+  numTokens++;
+}
+
+template<class TokenBase>
+template<class TokenType>
+bool TokenMailbox<TokenBase>::holds(const Bucket& bucket) {
+  const int queryId = TokenTypeRegistry::idOf<TokenType>();
+  if (bucket.typeId == queryId) {
+    return true;
+  }
+
+  auto isDerived = [&bucket]() {
+    return dynamic_cast<const TokenType*>(bucket.entries.front().token.get())
+        != nullptr;
+  };
+  if (bucket.typeId >= TokenTypeRegistry::kMaxCachedTypes) {
+    return isDerived();
+  }
+
+  // Per queried type: 0 if the relation to a stored type is still unknown, 1 if
+  // the stored type is unrelated, and 2 if it is derived. Static storage is
+  // zero-initialized, so every relation starts out unknown.
+  static std::array<std::atomic<unsigned char>,
+                    TokenTypeRegistry::kMaxCachedTypes> relation;
+  auto& cached = relation[bucket.typeId];
+  unsigned char related = cached.load(std::memory_order_relaxed);
+  if (related == 0) {
+    related = isDerived() ? 2 : 1;
+    cached.store(related, std::memory_order_relaxed);
+  }
+
+  return related == 2;
+}
+
+template<class TokenBase>
+template<class TokenType, class Property>
+typename TokenMailbox<TokenBase>::Position
+TokenMailbox<TokenBase>::locate(const Property& propertyCheck) const {
+  Position best;
+  unsigned long long bestSeq = 0;
+  for (unsigned int b = 0; b < buckets.size(); b++) {
+    const Bucket& bucket = buckets[b];
+    if (bucket.entries.empty() || !holds<TokenType>(bucket)) {
+      continue;
+    }
+    for (unsigned int e = 0; e < bucket.entries.size(); e++) {
+      const Entry& entry = bucket.entries[e];
+      if (best.bucket != -1 && entry.seq > bestSeq) {
+        break;  // Later entries of this bucket cannot be earlier than best.
+      }
+      if (propertyCheck(staticTokenCast<TokenType>(entry.token))) {
+        best.bucket = b;
+        best.entry = e;
+        bestSeq = entry.seq;
+        break;
+      }
+    }
+  }
+
+  return best;
+}
+
+template<class TokenBase>
+template<class TokenType, class Property>
+TokenPtr<TokenType> TokenMailbox<TokenBase>::find(
+    const Property& propertyCheck) const {
+  const Position pos = locate<TokenType>(propertyCheck);
+  if (pos.bucket == -1) {
+    return nullptr;
+  }
+
+  return staticTokenCast<TokenType>(
+      buckets[pos.bucket].entries[pos.entry].token);
+}
+
+template<class TokenBase>
+template<class TokenType, class Property>
+TokenPtr<TokenType> TokenMailbox<TokenBase>::take(
+    const Property& propertyCheck) {
+  const Position pos = locate<TokenType>(propertyCheck);
+  if (pos.bucket == -1) {
+    return nullptr;
+  }
+
+  auto& entries = buckets[pos.bucket].entries;
+  TokenPtr<TokenType> token =
+      staticTokenCast<TokenType>(entries[pos.entry].token);
+  entries.erase(entries.begin() + pos.entry);
+  numTokens--;
+
+  return token;
+}
+
+template<class TokenBase>
+template<class TokenType, class Property>
+int TokenMailbox<TokenBase>::count(const Property& propertyCheck) const {
+  int result = 0;
+  for (const auto& bucket : buckets) {
+    if (bucket.entries.empty() || !holds<TokenType>(bucket)) {
+      continue;
+    }
+    for (const auto& entry : bucket.entries) {
+      if (propertyCheck(staticTokenCast<TokenType>(entry.token))) {
+        result++;
+      }
+    }
+  }
+
+  return result;
+}
+
+template<class TokenBase>
+template<class TokenType, class Property>
+bool TokenMailbox<TokenBase>::contains(const Property& propertyCheck) const {
+  return locate<TokenType>(propertyCheck).bucket != -1;
+}
+
+template<class TokenBase>
+template<class TokenType>
+int TokenMailbox<TokenBase>::count() const {
+  int result = 0;
+  for (const auto& bucket : buckets) {
+    if (!bucket.entries.empty() && holds<TokenType>(bucket)) {
+      result += bucket.entries.size();
+    }
+  }
+
+  return result;
+}
+
+template<class TokenBase>
+template<class TokenType>
+bool TokenMailbox<TokenBase>::contains() const {
+  if (numTokens == 0) {
+    return false;
+  }
+  for (const auto& bucket : buckets) {
+    if (!bucket.entries.empty() && holds<TokenType>(bucket)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+template<class TokenBase>
+int TokenMailbox<TokenBase>::size() const {
+  return numTokens;
+}
+
+template<class TokenBase>
+std::vector<TokenPtr<TokenBase>> TokenMailbox<TokenBase>::inOrder() const {
+  std::vector<const Entry*> entries;
+  for (const auto& bucket : buckets) {
+    for (const Entry& entry : bucket.entries) {
+      entries.push_back(&entry);
+    }
+  }
+  std::sort(entries.begin(), entries.end(),
+            [](const Entry* a, const Entry* b) { return a->seq < b->seq; });
+
+  std::vector<TokenPtr<TokenBase>> tokens;
+  for (const Entry* entry : entries) {
+    tokens.push_back(entry->token);
+  }
+  return tokens;
+}
+
+#endif  // AMOEBOTSIM_CORE_TOKENMAILBOX_H_
@@ -0,0 +1,61 @@
+/* Copyright (C) 2020 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+#include "core/tokenpool.h"
+
+TokenPool::TokenPool()
+  : chunkPos(nullptr),
+    chunkLeft(0),
+    concurrent(false) {}
+
+TokenPool::~TokenPool() {
+  for (char* chunk : chunks) {
+    ::operator delete(chunk);
+  }
+}
+
+void TokenPool::setConcurrent(const bool concurrent) {
+  this->concurrent = concurrent;
+}
+
+void* TokenPool::allocate(unsigned int sizeClass) {
+  std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+  if (concurrent) {
+    lock.lock();
+  }
+
+  if (sizeClass >= freeLists.size()) {
+    freeLists.resize(sizeClass + 1, nullptr);
+  }
+
+  FreeBlock* block = freeLists[sizeClass];
+  if (block != nullptr) {
+    freeLists[sizeClass] = block->next;
+    return block;
+  }
+
+  return allocateFromChunk(sizeClass * kGranularity);
+}
+
+void* TokenPool::allocateFromChunk(std::size_t size) {
+  if (size > kChunkSize / 4) {
+    // Large tokens get a chunk of their own so they do not waste the current
+    // chunk's remainder.
+    char* chunk = static_cast<char*>(::operator new(size));
+    chunks.push_back(chunk);
+    return chunk;
+  }
+
+  if (size > chunkLeft) {
+    chunkPos = static_cast<char*>(::operator new(kChunkSize));
+    chunkLeft = kChunkSize;
+    chunks.push_back(chunkPos);
+  }
+
+  void* block = chunkPos;
+  chunkPos += size;
+  chunkLeft -= size;
+
+  return block;
+}
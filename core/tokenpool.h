@@ -0,0 +1,298 @@
+/* Copyright (C) 2020 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+// Defines the allocation scheme for particle tokens. Tokens are owned through
+// TokenPtr, an intrusive reference-counted handle whose count lives in the
+// token itself and is not atomic: tokens are only ever touched by the particle
+// being activated, so the thread-safety of shared_ptr buys nothing here.
+// Tokens created via TokenPool::make (or AmoebotSystem/AmoebotParticle's
+// makeToken) are carved out of chunks owned by the pool and recycled through
+// per-size free lists when their last handle is dropped, so passing tokens
+// around does not hit the global allocator once the pool is warm.
+//
+// A pool is not thread-safe unless it is in concurrent mode (see
+// setConcurrent), and must outlive every token it creates. Tokens allocated
+// with plain new may also be wrapped in a TokenPtr; they are deleted normally.
+// Handles themselves are never thread-safe; a token must only be touched by
+// one thread at a time.
+
+#ifndef AMOEBOTSIM_CORE_TOKENPOOL_H_
+#define AMOEBOTSIM_CORE_TOKENPOOL_H_
+
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+class TokenPool;
+
+// The base of all pooled tokens, holding the bookkeeping used by TokenPtr and
+// TokenPool. Copying a token does not copy its bookkeeping.
+class PooledToken {
+ public:
+  PooledToken() = default;
+  PooledToken(const PooledToken&) {}
+  PooledToken& operator=(const PooledToken&) { return *this; }
+  virtual ~PooledToken() {}
+
+ private:
+  template<class TokenType>
+  friend class TokenPtr;
+  friend class TokenPool;
+
+  unsigned int refCount = 0;
+  unsigned int sizeClass = 0;
+  TokenPool* pool = nullptr;
+};
+
+template<class TokenType>
+class TokenPtr {
+ public:
+  // Constructs an empty handle, or a handle taking (shared) ownership of the
+  // given token.
+  TokenPtr() : ptr(nullptr) {}
+  TokenPtr(std::nullptr_t) : ptr(nullptr) {}
+  explicit TokenPtr(TokenType* token);
+
+  // Copying and moving handles, including conversions from handles to derived
+  // token types.
+  TokenPtr(const TokenPtr& other);
+  TokenPtr(TokenPtr&& other) noexcept;
+  template<class OtherType>
+  TokenPtr(const TokenPtr<OtherType>& other);
+  template<class OtherType>
+  TokenPtr(TokenPtr<OtherType>&& other) noexcept;
+  TokenPtr& operator=(TokenPtr other) noexcept;
+
+  // Releases this handle's reference, destroying the token if it was the last.
+  ~TokenPtr();
+
+  TokenType* get() const { return ptr; }
+  TokenType& operator*() const { return *ptr; }
+  TokenType* operator->() const { return ptr; }
+  explicit operator bool() const { return ptr != nullptr; }
+
+ private:
+  template<class OtherType>
+  friend class TokenPtr;
+
+  void retain();
+  void release();
+
+  TokenType* ptr;
+};
+
+// Cast functions for handles, analogous to std::static_pointer_cast and
+// std::dynamic_pointer_cast for shared_ptr.
+template<class TokenType, class OtherType>
+TokenPtr<TokenType> staticTokenCast(const TokenPtr<OtherType>& token);
+template<class TokenType, class OtherType>
+TokenPtr<TokenType> dynamicTokenCast(const TokenPtr<OtherType>& token);
+
+template<class TokenType, class OtherType>
+bool operator==(const TokenPtr<TokenType>& a, const TokenPtr<OtherType>& b);
+template<class TokenType, class OtherType>
+bool operator!=(const TokenPtr<TokenType>& a, const TokenPtr<OtherType>& b);
+template<class TokenType>
+bool operator==(const TokenPtr<TokenType>& a, std::nullptr_t);
+template<class TokenType>
+bool operator!=(const TokenPtr<TokenType>& a, std::nullptr_t);
+template<class TokenType>
+bool operator==(std::nullptr_t, const TokenPtr<TokenType>& b);
+template<class TokenType>
+bool operator!=(std::nullptr_t, const TokenPtr<TokenType>& b);
+
+class TokenPool {
+ public:
+  TokenPool();
+  TokenPool(const TokenPool&) = delete;
+  TokenPool& operator=(const TokenPool&) = delete;
+
+  // Frees all memory held by the pool. Every token created by this pool must
+  // have been destroyed already.
+  ~TokenPool();
+
+  // Constructs a token of the given type from the given arguments in memory
+  // owned by this pool and returns the first handle to it.
+  template<class TokenType, class... Args>
+  TokenPtr<TokenType> make(Args&&... args);
+
+  // Destroys a token whose last handle was released, returning its memory to
+  // the pool it came from (or to the global allocator if it was not pooled).
+  static void dispose(PooledToken* token);
+
+  // Enables or disables concurrent mode, in which tokens may be made and
+  // disposed of from several threads at once at the cost of taking a lock for
+  // each. Must not be called while tokens are being made or disposed of.
+  void setConcurrent(const bool concurrent);
+
+ private:
+  // Token sizes are rounded up to multiples of kGranularity bytes; tokens of
+  // the same rounded size share a free list. New blocks are cut from chunks of
+  // kChunkSize bytes, or from a dedicated chunk for unusually large tokens.
+  static constexpr std::size_t kGranularity = alignof(std::max_align_t);
+  static constexpr std::size_t kChunkSize = 64 * 1024;
+
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  void* allocate(unsigned int sizeClass);
+  void* allocateFromChunk(std::size_t size);
+
+  std::vector<FreeBlock*> freeLists;
+  std::vector<char*> chunks;
+  char* chunkPos;
+  std::size_t chunkLeft;
+
+  // Guards the above in concurrent mode.
+  bool concurrent;
+  std::mutex mutex;
+};
+
+template<class TokenType>
+TokenPtr<TokenType>::TokenPtr(TokenType* token)
+  : ptr(token) {
+  retain();
+}
+
+template<class TokenType>
+TokenPtr<TokenType>::TokenPtr(const TokenPtr& other)
+  : ptr(other.ptr) {
+  retain();
+}
+
+template<class TokenType>
+TokenPtr<TokenType>::TokenPtr(TokenPtr&& other) noexcept
+  : ptr(other.ptr) {
+  other.ptr = nullptr;
+}
+
+template<class TokenType>
+template<class OtherType>
+TokenPtr<TokenType>::TokenPtr(const TokenPtr<OtherType>& other)
+  : ptr(other.ptr) {
+  retain();
+}
+
+template<class TokenType>
+template<class OtherType>
+TokenPtr<TokenType>::TokenPtr(TokenPtr<OtherType>&& other) noexcept
+  : ptr(other.ptr) {
+  other.ptr = nullptr;
+}
+
+template<class TokenType>
+TokenPtr<TokenType>& TokenPtr<TokenType>::operator=(TokenPtr other) noexcept {
+  std::swap(ptr, other.ptr);
+  return *this;
+}
+
+template<class TokenType>
+TokenPtr<TokenType>::~TokenPtr() {
+  release();
+}
+
+template<class TokenType>
+void TokenPtr<TokenType>::retain() {
+  if (ptr != nullptr) {
+    static_cast<PooledToken*>(ptr)->refCount++;
+  }
+}
+
+template<class TokenType>
+void TokenPtr<TokenType>::release() {
+  if (ptr != nullptr) {
+    PooledToken* token = ptr;
+    if (--token->refCount == 0) {
+      TokenPool::dispose(token);
+    }
+    ptr = nullptr;
+  }
+}
+
+template<class TokenType, class OtherType>
+TokenPtr<TokenType> staticTokenCast(const TokenPtr<OtherType>& token) {
+  return TokenPtr<TokenType>(static_cast<TokenType*>(token.get()));
+}
+
+template<class TokenType, class OtherType>
+TokenPtr<TokenType> dynamicTokenCast(const TokenPtr<OtherType>& token) {
+  return TokenPtr<TokenType>(dynamic_cast<TokenType*>(token.get()));
+}
+
+template<class TokenType, class OtherType>
+bool operator==(const TokenPtr<TokenType>& a, const TokenPtr<OtherType>& b) {
+  return a.get() == b.get();
+}
+
+template<class TokenType, class OtherType>
+bool operator!=(const TokenPtr<TokenType>& a, const TokenPtr<OtherType>& b) {
+  return a.get() != b.get();
+}
+
+template<class TokenType>
+bool operator==(const TokenPtr<TokenType>& a, std::nullptr_t) {
+  return a.get() == nullptr;
+}
+
+template<class TokenType>
+bool operator!=(const TokenPtr<TokenType>& a, std::nullptr_t) {
+  return a.get() != nullptr;
+}
+
+template<class TokenType>
+bool operator==(std::nullptr_t, const TokenPtr<TokenType>& b) {
+  return b.get() == nullptr;
+}
+
+template<class TokenType>
+bool operator!=(std::nullptr_t, const TokenPtr<TokenType>& b) {
+  return b.get() != nullptr;
+}
+
+template<class TokenType, class... Args>
+TokenPtr<TokenType> TokenPool::make(Args&&... args) {
+  static_assert(std::is_base_of<PooledToken, TokenType>::value,
+                "pooled tokens must derive from PooledToken");
+  static_assert(alignof(TokenType) <= kGranularity,
+                "over-aligned tokens cannot be pooled");
+
+  const unsigned int sizeClass =
+      (sizeof(TokenType) + kGranularity - 1) / kGranularity;
+  TokenType* token =
+      new (allocate(sizeClass)) TokenType(std::forward<Args>(args)...);
+
+  PooledToken* base = token;
+  base->pool = this;
+  base->sizeClass = sizeClass;
+
+  return TokenPtr<TokenType>(token);
+}
+
+inline void TokenPool::dispose(PooledToken* token) {
+  TokenPool* pool = token->pool;
+  if (pool == nullptr) {
+    delete token;
+    return;
+  }
+
+  // The block starts at the most derived object, which need not coincide with
+  // its PooledToken base.
+  const unsigned int sizeClass = token->sizeClass;
+  void* block = dynamic_cast<void*>(token);
+  token->~PooledToken();
+
+  std::unique_lock<std::mutex> lock(pool->mutex, std::defer_lock);
+  if (pool->concurrent) {
+    lock.lock();
+  }
+  FreeBlock* freeBlock = static_cast<FreeBlock*>(block);
+  freeBlock->next = pool->freeLists[sizeClass];
+  pool->freeLists[sizeClass] = freeBlock;
+}
+
+#endif  // AMOEBOTSIM_CORE_TOKENPOOL_H_
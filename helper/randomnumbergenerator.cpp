@@ -4,4 +4,72 @@
 
 #include "helper/randomnumbergenerator.h"
 
-std::mt19937 RandomNumberGenerator::rng;
+#include <chrono>
+#include <climits>
+#include <random>
+
+thread_local RandomEngine* RandomNumberGenerator::threadEngine = nullptr;
+
+RandomEngine::RandomEngine(const uint64_t seed) {
+  this->seed(seed);
+}
+
+void RandomEngine::seed(uint64_t seed) {
+  if (seed == 0) {
+    std::random_device device;
+    const uint64_t entropy = (static_cast<uint64_t>(device()) << 32) ^ device();
+    const uint64_t time = std::chrono::high_resolution_clock::now()
+                              .time_since_epoch().count();
+    // Fresh seeds are positive ints, which every way of instantiating a system
+    // accepts, so runs can be recreated from the seed they report.
+    seed = (entropy ^ time) % INT_MAX + 1;
+  }
+  _seed = seed;
+
+  // Expand the seed into the full state with splitmix64, as recommended by the
+  // authors of xoshiro; this never yields the all-zero state.
+  uint64_t x = seed;
+  for (auto& word : state) {
+    uint64_t z = (x += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    word = z ^ (z >> 31);
+  }
+}
+
+uint64_t RandomEngine::getSeed() const {
+  return _seed;
+}
+
+void RandomEngine::jump() {
+  static const uint64_t kJump[] = {0x180ec6d33cfd0aba, 0xd5a61266f0c9392c,
+                                   0xa9582618e03fc9aa, 0x39abdc4529b1661c};
+
+  uint64_t jumped[4] = {0, 0, 0, 0};
+  for (const uint64_t word : kJump) {
+    for (int bit = 0; bit < 64; ++bit) {
+      if (word & (uint64_t(1) << bit)) {
+        for (int i = 0; i < 4; ++i) {
+          jumped[i] ^= state[i];
+        }
+      }
+      (*this)();
+    }
+  }
+
+  for (int i = 0; i < 4; ++i) {
+    state[i] = jumped[i];
+  }
+}
+
+std::array<uint64_t, 4> RandomEngine::getState() const {
+  return {state[0], state[1], state[2], state[3]};
+}
+
+void RandomEngine::setState(const uint64_t seed,
+                            const std::array<uint64_t, 4>& state) {
+  _seed = seed;
+  for (int i = 0; i < 4; ++i) {
+    this->state[i] = state[i];
+  }
+}
@@ -2,83 +2,181 @@
  * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
  * notice can be found at the top of main/main.cpp. */
 
+// Defines the random number generation used by systems and particles. Every
+// AmoebotSystem owns a RandomEngine (xoshiro256++) seeded when the system is
+// constructed; the system and its particles draw from that engine through the
+// RandomNumberGenerator interface. Runs with the same seed are therefore
+// reproducible, and separate systems share no generator state.
+
 #ifndef AMOEBOTSIM_HELPER_RANDOMNUMBERGENERATOR_H_
 #define AMOEBOTSIM_HELPER_RANDOMNUMBERGENERATOR_H_
 
-#include <algorithm>
-#include <chrono>
-#include <random>
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+
+#include <QtGlobal>
+
+class RandomEngine {
+ public:
+  using result_type = uint64_t;
+
+  // Constructs an engine seeded with the given seed; see seed().
+  explicit RandomEngine(const uint64_t seed = 0);
+
+  // Resets the engine to the stream determined by the given seed. A seed of 0
+  // draws a fresh seed in [1, INT_MAX] from the system's entropy source
+  // instead; getSeed() returns the seed actually used, so such runs can still
+  // be reproduced by passing it as the seed parameter.
+  void seed(uint64_t seed);
+  uint64_t getSeed() const;
+
+  // Returns the next 64 random bits. Together with min() and max(), this makes
+  // the engine usable with the standard library's random facilities.
+  result_type operator()();
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() { return UINT64_MAX; }
+
+  // Returns a uniformly random integer in [0, bound), for 0 < bound, using
+  // Lemire's multiply-and-shift method (which almost never needs a division).
+  uint32_t nextBelow(const uint32_t bound);
+
+  // Returns a uniformly random double (resp., float) in [0, 1).
+  double nextDouble();
+  float nextFloat();
+
+  // Advances the engine by 2^128 steps. Engines copied from one another and
+  // jumped different numbers of times produce non-overlapping streams, e.g.
+  // for use by different threads.
+  void jump();
+
+  // Functions for checkpoints. getState returns the engine's position in its
+  // stream, and setState resets the engine to the given seed and a position
+  // returned by getState, so that it continues exactly where it left off.
+  std::array<uint64_t, 4> getState() const;
+  void setState(const uint64_t seed, const std::array<uint64_t, 4>& state);
+
+ private:
+  uint64_t _seed;
+  uint64_t state[4];
+};
+
+class RandomNumberGenerator {
+ public:
+  // Constructs a generator drawing from the given engine, which must outlive
+  // it.
+  explicit RandomNumberGenerator(RandomEngine& engine);
+
+  // While non-null, every generator draws from this engine instead of its own
+  // when used on the current thread. The parallel round scheduler uses this to
+  // give each batch of concurrent activations a private, reproducible stream.
+  static thread_local RandomEngine* threadEngine;
 
-class RandomNumberGenerator
-{
-public:
-    RandomNumberGenerator();
+ protected:
+  int randInt(const int from, const int toNotIncluding) const;
+  int randDir() const;
+  float randFloat(const float from, const float toNotIncluding) const;
+  double randDouble(const double from, const double toNotIncluding) const;
+  bool randBool(const double trueProb = 0.5) const;
 
-protected:
-    static int randInt(const int from, const int toNotIncluding);
-    static int randDir();
-    static float randFloat(const float from, const float toNotIncluding);
-    static double randDouble(const double from, const double toNotIncluding);
-    static bool randBool(const double trueProb = 0.5);
+  template <class Iterator>
+  void shuffle(Iterator first, Iterator last) const;
 
-    template <class Iterator>
-    void shuffle(Iterator firxt, Iterator last);
+ private:
+  // Returns the engine to draw from: threadEngine if set, else engine.
+  RandomEngine& source() const;
 
-private:
-    static std::mt19937 rng;
+  RandomEngine* engine;
 };
 
-inline RandomNumberGenerator::RandomNumberGenerator()
-{
-    static bool initialized = false;
-    if(!initialized) {
-        uint32_t seed;
-        std::random_device device;
-        if(device.entropy() == 0) {
-            auto duration = std::chrono::high_resolution_clock::now() - std::chrono::high_resolution_clock::time_point::min();
-            seed = duration.count();
-        } else {
-            std::uniform_int_distribution<uint32_t> dist(std::numeric_limits<uint32_t>::min(),
-                                                         std::numeric_limits<uint32_t>::max());
-            seed = dist(device);
-        }
-        rng.seed(seed);
-        initialized = true;
+inline RandomEngine::result_type RandomEngine::operator()() {
+  const auto rotl = [](const uint64_t x, const int k) {
+    return (x << k) | (x >> (64 - k));
+  };
+
+  const uint64_t result = rotl(state[0] + state[3], 23) + state[0];
+  const uint64_t t = state[1] << 17;
+  state[2] ^= state[0];
+  state[3] ^= state[1];
+  state[1] ^= state[2];
+  state[0] ^= state[3];
+  state[2] ^= t;
+  state[3] = rotl(state[3], 45);
+
+  return result;
+}
+
+inline uint32_t RandomEngine::nextBelow(const uint32_t bound) {
+  Q_ASSERT(bound > 0);
+
+  uint64_t product = ((*this)() >> 32) * bound;
+  uint32_t low = static_cast<uint32_t>(product);
+  if (low < bound) {
+    const uint32_t threshold = (0u - bound) % bound;
+    while (low < threshold) {
+      product = ((*this)() >> 32) * bound;
+      low = static_cast<uint32_t>(product);
     }
+  }
+
+  return static_cast<uint32_t>(product >> 32);
+}
+
+inline double RandomEngine::nextDouble() {
+  return ((*this)() >> 11) / 9007199254740992.0;
+}
+
+inline float RandomEngine::nextFloat() {
+  return ((*this)() >> 40) / 16777216.0f;
 }
 
-inline int RandomNumberGenerator::randInt(const int from, const int toNotIncluding)
-{
-    std::uniform_int_distribution<int> dist(from, toNotIncluding - 1);
-    return dist(rng);
+inline RandomNumberGenerator::RandomNumberGenerator(RandomEngine& engine)
+  : engine(&engine) {}
+
+inline RandomEngine& RandomNumberGenerator::source() const {
+  RandomEngine* const local = threadEngine;
+  return (local != nullptr) ? *local : *engine;
+}
+
+inline int RandomNumberGenerator::randInt(const int from,
+                                          const int toNotIncluding) const {
+  Q_ASSERT(from < toNotIncluding);
+
+  const uint32_t range = static_cast<uint32_t>(toNotIncluding) -
+                         static_cast<uint32_t>(from);
+  return static_cast<int>(static_cast<uint32_t>(from) +
+                          source().nextBelow(range));
 }
 
-inline int RandomNumberGenerator::randDir()
-{
-    return randInt(0, 6);
+inline int RandomNumberGenerator::randDir() const {
+  return static_cast<int>(source().nextBelow(6));
 }
 
-inline float RandomNumberGenerator::randFloat(const float from, const float toNotIncluding)
-{
-    std::uniform_real_distribution<float> dist(from, toNotIncluding);
-    return dist(rng);
+inline float RandomNumberGenerator::randFloat(
+    const float from, const float toNotIncluding) const {
+  return from + (toNotIncluding - from) * source().nextFloat();
 }
 
-inline double RandomNumberGenerator::randDouble(const double from, const double toNotIncluding)
-{
-    std::uniform_real_distribution<double> dist(from, toNotIncluding);
-    return dist(rng);
+inline double RandomNumberGenerator::randDouble(
+    const double from, const double toNotIncluding) const {
+  return from + (toNotIncluding - from) * source().nextDouble();
 }
 
-inline bool RandomNumberGenerator::randBool(const double trueProb)
-{
-    return (randFloat(0, 1) < trueProb);
+inline bool RandomNumberGenerator::randBool(const double trueProb) const {
+  return source().nextDouble() < trueProb;
 }
 
 template <class Iterator>
-void RandomNumberGenerator::shuffle(Iterator first, Iterator last)
-{
-    std::shuffle(first, last, rng);
+void RandomNumberGenerator::shuffle(Iterator first, Iterator last) const {
+  // Fisher-Yates, drawing indices with the engine's bounded sampling.
+  RandomEngine& random = source();
+  const auto n = std::distance(first, last);
+  for (auto i = n - 1; i > 0; --i) {
+    const auto j = random.nextBelow(static_cast<uint32_t>(i + 1));
+    using std::swap;
+    swap(first[i], first[j]);
+  }
 }
 
 #endif  // AMOEBOTSIM_HELPER_RANDOMNUMBERGENERATOR_H_
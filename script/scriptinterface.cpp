@@ -11,6 +11,21 @@
 #include "alg/shapeformation.h"
 #include "core/node.h"
 
+namespace {
+
+// Returns the values stored in the given history, decoded and in the order
+// they were recorded, as a list scripts can index.
+template<class T>
+QVariantList historyAsList(const MetricHistory<T>& history) {
+  QVariantList list;
+  for (const T value : history.values()) {
+    list.append(value);
+  }
+  return list;
+}
+
+}  // namespace
+
 ScriptInterface::ScriptInterface(ScriptEngine &engine, Simulator& sim,
                                  VisItem *vis)
   : engine(engine),
@@ -71,15 +86,36 @@ void ScriptInterface::exportMetrics() {
   log("Metrics exported to application directory.");
 }
 
+void ScriptInterface::saveCheckpoint(const QString filePath) {
+  QString error;
+  if (sim.saveCheckpoint(filePath, error)) {
+    log("Checkpoint saved to " + filePath + ".");
+  } else {
+    log(error, true);
+  }
+}
+
+void ScriptInterface::loadCheckpoint(const QString filePath) {
+  QString error;
+  if (sim.loadCheckpoint(filePath, error)) {
+    log("Checkpoint loaded from " + filePath + ".");
+  } else {
+    log(error, true);
+  }
+}
+
 QVariant ScriptInterface::getMetric(QString name, bool history) {
-  for (const auto& c : sim.getSystem()->getCounts()) {
+  std::shared_ptr<System> system = sim.getSystem();
+  SystemLocker locker(*system);
+  for (const auto& c : system->getCounts()) {
     if (c->_name == name) {
-      return history ? QVariant::fromValue(c->_history) : c->_value;
+      return history ? QVariant(historyAsList(c->_history)) : c->_value;
     }
   }
-  for (const auto& m : sim.getSystem()->getMeasures()) {
+  for (const auto& m : system->getMeasures()) {
     if (m->_name == name) {
-      return history ? QVariant::fromValue(m->_history) : m->_history.back();
+      return history ? QVariant(historyAsList(m->_history))
+                     : m->_history.back();
     }
   }
   log("no metrics with given name exist", true);
@@ -121,8 +157,16 @@ void ScriptInterface::filmSimulation(QString filePath, const int stepLimit) {
     temp = temp % 10;
   }
 
+  // The simulator locks the system while stepping, so termination is checked
+  // under a lock of its own.
+  std::shared_ptr<System> system = sim.getSystem();
+  auto hasTerminated = [&system]() {
+    SystemLocker locker(*system);
+    return system->hasTerminated();
+  };
+
   int i = 0;
-  while(!sim.getSystem()->hasTerminated() && i < stepLimit) {
+  while(!hasTerminated() && i < stepLimit) {
     emit vis->beforeRendering();  // Updates GUI #rounds and #movements labels.
     saveScreenshot(filePath + pad(i,fnameLen) + QString(".png"));
     step();
@@ -43,12 +43,21 @@ class ScriptInterface : public QObject {
   // exportMetrics writes the metrics to JSON. See simulator.h for further
   // discussion. getMetric returns either the current value (history = false)
   // or the historical data (history = true) of the metric with parameter-
-  // defined name.
+  // defined name. The historical data is decoded from the metric's history
+  // storage and holds only the values it keeps (see HistoryPolicy in
+  // core/metric.h).
   int getNumParticles();
   int getNumObjects();
   void exportMetrics();
   QVariant getMetric(QString name, bool history = false);
 
+  // Checkpoint commands. saveCheckpoint writes a binary checkpoint of the
+  // current algorithm instance to the given file, and loadCheckpoint restores
+  // one into it; see simulator.h for further discussion. Failures are logged
+  // as errors.
+  void saveCheckpoint(const QString filePath);
+  void loadCheckpoint(const QString filePath);
+
   // Visualization commands. focusOn centers the window at the given (x,y) node.
   // setZoom sets the zoom level of the window. saveScreenshot saves the current
   // window as a .png in the specified location; if no filepath is provided, a
@@ -64,66 +64,91 @@ void Algorithm::addParameter(QString parameter, QString defaultValue) {
 DiscoDemoAlg::DiscoDemoAlg() : Algorithm("Demo: Disco", "discodemo") {
   addParameter("# Particles", "30");
   addParameter("Counter Max", "5");
+  addParameter("Seed", "0");
 };
 
-void DiscoDemoAlg::instantiate(const int numParticles, const int counterMax) {
+void DiscoDemoAlg::instantiate(const int numParticles, const int counterMax,
+                               const int seed) {
   if (numParticles <= 0) {
     emit log("# particles must be > 0", true);
   } else if (counterMax <= 0) {
     emit log("counterMax must be > 0", true);
+  } else if (seed < 0) {
+    emit log("seed must be >= 0", true);
   } else {
-    emit setSystem(std::make_shared<DiscoDemoSystem>(numParticles));
+    // Counter Max is only validated; the system keeps its default of 5.
+    emit setSystem(std::make_shared<DiscoDemoSystem>(numParticles, 5, seed));
   }
 }
 
 MetricsDemoAlg::MetricsDemoAlg() : Algorithm("Demo: Metrics", "metricsdemo") {
   addParameter("# Particles", "30");
   addParameter("Counter Max", "5");
+  addParameter("Seed", "0");
 };
 
-void MetricsDemoAlg::instantiate(const int numParticles, const int counterMax) {
+void MetricsDemoAlg::instantiate(const int numParticles, const int counterMax,
+                                 const int seed) {
   if (numParticles <= 0) {
     emit log("# particles must be > 0", true);
   } else if (counterMax <= 0) {
     emit log("counterMax must be > 0", true);
+  } else if (seed < 0) {
+    emit log("seed must be >= 0", true);
   } else {
-    emit setSystem(std::make_shared<MetricsDemoSystem>(numParticles));
+    // Counter Max is only validated; the system keeps its default of 5.
+    emit setSystem(std::make_shared<MetricsDemoSystem>(numParticles, 5, seed));
   }
 }
 
 BallroomDemoAlg::BallroomDemoAlg() : Algorithm("Demo: Ballroom", "ballroomdemo") {
   addParameter("# Particles", "30");
+  addParameter("Seed", "0");
 }
 
-void BallroomDemoAlg::instantiate(const int numParticles) {
-  emit setSystem(std::make_shared<BallroomDemoSystem>(numParticles));
+void BallroomDemoAlg::instantiate(const int numParticles, const int seed) {
+  if (seed < 0) {
+    emit log("seed must be >= 0", true);
+  } else {
+    emit setSystem(std::make_shared<BallroomDemoSystem>(numParticles, seed));
+  }
 }
 
 TokenDemoAlg::TokenDemoAlg() : Algorithm("Demo: Token Passing", "tokendemo") {
   addParameter("# Particles", "48");
   addParameter("Token Lifetime", "100");
+  addParameter("Seed", "0");
 }
 
-void TokenDemoAlg::instantiate(const int numParticles, const int lifetime) {
+void TokenDemoAlg::instantiate(const int numParticles, const int lifetime,
+                               const int seed) {
   if (numParticles <= 6) {
     emit log("# particles must be > 6", true);
   } else if (lifetime <= 0) {
     emit log("token lifetime must be > 0", true);
+  } else if (seed < 0) {
+    emit log("seed must be >= 0", true);
   } else {
-    emit setSystem(std::make_shared<TokenDemoSystem>(numParticles, lifetime));
+    emit setSystem(std::make_shared<TokenDemoSystem>(numParticles, lifetime,
+                                                     seed));
   }
 }
 
 CompressionAlg::CompressionAlg() : Algorithm("Compression", "compression") {
   addParameter("# Particles", "100");
   addParameter("Lambda", "4.0");
+  addParameter("Seed", "0");
 }
 
-void CompressionAlg::instantiate(const int numParticles, const double lambda) {
+void CompressionAlg::instantiate(const int numParticles, const double lambda,
+                                 const int seed) {
   if (numParticles <= 0) {
     emit log("# particles must be > 0", true);
+  } else if (seed < 0) {
+    emit log("seed must be >= 0", true);
   } else {
-    emit setSystem(std::make_shared<CompressionSystem>(numParticles, lambda));
+    emit setSystem(std::make_shared<CompressionSystem>(numParticles, lambda,
+                                                       seed));
   }
 }
 
@@ -135,6 +160,7 @@ EnergyShapeAlg::EnergyShapeAlg()
   addParameter("Capacity", "10.0");
   addParameter("Demand", "5.0");
   addParameter("Transfer Rate", "1.0");
+  addParameter("Seed", "0");
 }
 
 void EnergyShapeAlg::instantiate(const int numParticles,
@@ -142,7 +168,8 @@ void EnergyShapeAlg::instantiate(const int numParticles,
                                  const double holeProb,
                                  const double capacity,
                                  const double demand,
-                                 const double transferRate) {
+                                 const double transferRate,
+                                 const int seed) {
   if (numParticles <= 0) {
     emit log("# particles must be > 0", true);
   } else if (numEnergyRoots <= 0 || numEnergyRoots > numParticles) {
@@ -155,10 +182,12 @@ void EnergyShapeAlg::instantiate(const int numParticles,
     emit log("demand must be in (0, capacity]", true);
   } else if (transferRate <= 0) {
     emit log("transferRate must be > 0", true);
+  } else if (seed < 0) {
+    emit log("seed must be >= 0", true);
   } else {
     emit setSystem(std::make_shared<EnergyShapeSystem>(
                      numParticles, numEnergyRoots, holeProb, capacity, demand,
-                     transferRate));
+                     transferRate, seed));
   }
 }
 
@@ -170,6 +199,7 @@ EnergySharingAlg::EnergySharingAlg()
   addParameter("Capacity", "10.0");
   addParameter("Demand", "5.0");
   addParameter("Transfer Rate", "1.0");
+  addParameter("Seed", "0");
 }
 
 void EnergySharingAlg::instantiate(int numParticles,
@@ -177,7 +207,8 @@ void EnergySharingAlg::instantiate(int numParticles,
                                    const int usage,
                                    const double capacity,
                                    const double demand,
-                                   const double transferRate) {
+                                   const double transferRate,
+                                   const int seed) {
   if (numParticles <= 0) {
     emit log("# particles must be > 0", true);
   } else if (numEnergyRoots <= 0 || numEnergyRoots > numParticles) {
@@ -190,10 +221,12 @@ void EnergySharingAlg::instantiate(int numParticles,
     emit log("demand must be in (0, capacity]", true);
   } else if (transferRate <= 0) {
     emit log("transferRate must be > 0", true);
+  } else if (seed < 0) {
+    emit log("seed must be >= 0", true);
   } else {
     emit setSystem(std::make_shared<EnergySharingSystem>(
                      numParticles, numEnergyRoots, usage, capacity, demand,
-                     transferRate));
+                     transferRate, seed));
   }
 }
 
@@ -201,17 +234,21 @@ InfObjCoatingAlg::InfObjCoatingAlg() :
   Algorithm("Infinite Object Coating", "infobjcoating") {
   addParameter("# Particles", "100");
   addParameter("Hole Prob.", "0.2");
+  addParameter("Seed", "0");
 }
 
 void InfObjCoatingAlg::instantiate(const int numParticles,
-                                   const double holeProb) {
+                                   const double holeProb,
+                                   const int seed) {
   if (numParticles <= 0) {
     emit log("# particles must be > 0", true);
   } else if (holeProb < 0 || holeProb > 1) {
     emit log("holeProb in [0,1] required", true);
+  } else if (seed < 0) {
+    emit log("seed must be >= 0", true);
   } else {
     emit setSystem(std::make_shared<InfObjCoatingSystem>(numParticles,
-                                                         holeProb));
+                                                         holeProb, seed));
   }
 }
 
@@ -220,19 +257,24 @@ LeaderElectionAlg::LeaderElectionAlg() :
   addParameter("# Particles", "100");
   addParameter("Hole Prob.", "0.2");
   addParameter("File name", "");
+  addParameter("Seed", "0");
 }
 
 void LeaderElectionAlg::instantiate(const int numParticles,
                                     const double holeProb, 
-                                    const QString fileName) {
+                                    const QString fileName,
+                                    const int seed) {
   if (numParticles <= 0 && fileName.size() == 0) {
     emit log("# particles must be > 0 or file name must be given", true);
   } else if (holeProb < 0 || holeProb > 1) {
     emit log("holeProb in [0,1] required", true);
+  } else if (seed < 0) {
+    emit log("seed must be >= 0", true);
   } else {
     emit setSystem(std::make_shared<LeaderElectionSystem>(numParticles,
                                                           holeProb, 
-                                                          fileName));
+                                                          fileName,
+                                                          seed));
   }
 }
 
@@ -244,14 +286,18 @@ LeaderElectionErosionAlg::LeaderElectionErosionAlg() :
   Algorithm("Leader Election by Erosion", "leaderelection_erosion") {
   addParameter("# Particles", "100");
   addParameter("File name", "");
+  addParameter("Seed", "0");
 }
 
-void LeaderElectionErosionAlg::instantiate(const int numParticles, const QString fileName) {
+void LeaderElectionErosionAlg::instantiate(const int numParticles, const QString fileName, const int seed) {
   if (numParticles <= 0 && fileName.size() == 0) {
     emit log("# particles must be > 0 or file name must be given", true);
   }
+  else if (seed < 0) {
+    emit log("seed must be >= 0", true);
+  }
   else {
-    emit setSystem(std::make_shared<LeaderElectionErosionSystem>(numParticles, fileName));
+    emit setSystem(std::make_shared<LeaderElectionErosionSystem>(numParticles, fileName, seed));
   }
 }
 
@@ -263,14 +309,18 @@ LeaderElectionStationaryDeterministicAlg::LeaderElectionStationaryDeterministicA
   Algorithm("Stationary Deterministic Leader Election", "leaderelection_stationary_deterministic") {
   addParameter("# Particles", "100");
   addParameter("File name", "");
+  addParameter("Seed", "0");
 }
 
-void LeaderElectionStationaryDeterministicAlg::instantiate(const int numParticles, const QString fileName) {
+void LeaderElectionStationaryDeterministicAlg::instantiate(const int numParticles, const QString fileName, const int seed) {
   if (numParticles <= 0 && fileName.size() == 0) {
     emit log("# particles must be > 0 or file name must be given", true);
   }
+  else if (seed < 0) {
+    emit log("seed must be >= 0", true);
+  }
   else {
-    emit setSystem(std::make_shared<LeaderElectionStationaryDeterministicSystem>(numParticles, fileName));
+    emit setSystem(std::make_shared<LeaderElectionStationaryDeterministicSystem>(numParticles, fileName, seed));
   }
 }
 
@@ -282,14 +332,18 @@ LeaderElectionDeterministicAlg::LeaderElectionDeterministicAlg() :
   Algorithm("Deterministic Leader Election", "leaderelection_deterministic") {
   addParameter("# Particles", "100");
   addParameter("File name", "");
+  addParameter("Seed", "0");
 }
 
-void LeaderElectionDeterministicAlg::instantiate(const int numParticles, const QString fileName) {
+void LeaderElectionDeterministicAlg::instantiate(const int numParticles, const QString fileName, const int seed) {
   if (numParticles <= 0 && fileName.size() == 0) {
     emit log("# particles must be > 0 or file name must be given", true);
   }
+  else if (seed < 0) {
+    emit log("seed must be >= 0", true);
+  }
   else {
-    emit setSystem(std::make_shared<LeaderElectionDeterministicSystem>(numParticles, fileName));
+    emit setSystem(std::make_shared<LeaderElectionDeterministicSystem>(numParticles, fileName, seed));
   }
 }
 
@@ -301,14 +355,18 @@ LeaderElectionSContractionAlg::LeaderElectionSContractionAlg() :
   Algorithm("Leader Election by S-Contraction", "leaderelection_scontraction") {
   addParameter("# Particles", "100");
   addParameter("File name", "");
+  addParameter("Seed", "0");
 }
 
-void LeaderElectionSContractionAlg::instantiate(const int numParticles, const QString fileName) {
+void LeaderElectionSContractionAlg::instantiate(const int numParticles, const QString fileName, const int seed) {
   if (numParticles <= 0 && fileName.size() == 0) {
     emit log("# particles must be > 0 or file name must be given", true);
   }
+  else if (seed < 0) {
+    emit log("seed must be >= 0", true);
+  }
   else {
-    emit setSystem(std::make_shared<LeaderElectionSContractionSystem>(numParticles, fileName));
+    emit setSystem(std::make_shared<LeaderElectionSContractionSystem>(numParticles, fileName, seed));
   }
 }
 
@@ -321,10 +379,12 @@ ShapeFormationAlg::ShapeFormationAlg() :
   addParameter("# Particles", "200");
   addParameter("Hole Prob.", "0.2");
   addParameter("Shape", "h");
+  addParameter("Seed", "0");
 }
 
 void ShapeFormationAlg::instantiate(const int numParticles,
-                                    const double holeProb, const QString mode) {
+                                    const double holeProb, const QString mode,
+                                    const int seed) {
   std::set<QString> set = ShapeFormationSystem::getAcceptedModes();
   if (numParticles <= 0) {
     emit log("# particles must be > 0", true);
@@ -337,9 +397,12 @@ void ShapeFormationAlg::instantiate(const int numParticles,
       else accepted = *it;
     }
     emit log("only accepted modes are: " + accepted, true);
+  } else if (seed < 0) {
+    emit log("seed must be >= 0", true);
   } else {
     emit setSystem(std::make_shared<ShapeFormationSystem>(numParticles,
-                                                          holeProb, mode));
+                                                          holeProb, mode,
+                                                          seed));
   }
 }
 
@@ -384,6 +447,19 @@ Algorithm* AlgorithmList::getAlg(QString algName) const {
   return algo;
 }
 
+Algorithm* AlgorithmList::getAlgBySignature(QString signature) const {
+  Algorithm* algo = nullptr;
+
+  for (auto alg : _algorithms) {
+    if (alg->getSignature().compare(signature) == 0) {
+      algo = alg;
+      break;
+    }
+  }
+
+  return algo;
+}
+
 QStringList AlgorithmList::getAlgNames() const {
   QStringList names;
   for (auto alg : _algorithms) {
@@ -58,7 +58,8 @@ class DiscoDemoAlg : public Algorithm {
   DiscoDemoAlg();
 
  public slots:
-  void instantiate(const int numParticles = 30, const int counterMax = 5);
+  void instantiate(const int numParticles = 30, const int counterMax = 5,
+                   const int seed = 0);
 };
 
 // Demo: Metrics.
@@ -69,7 +70,8 @@ class MetricsDemoAlg : public Algorithm {
   MetricsDemoAlg();
 
  public slots:
-  void instantiate(const int numParticles = 30, const int counterMax = 5);
+  void instantiate(const int numParticles = 30, const int counterMax = 5,
+                   const int seed = 0);
 };
 
 // Demo: Ballroom, a tutorial in coordination.
@@ -80,7 +82,7 @@ class BallroomDemoAlg : public Algorithm {
   BallroomDemoAlg();
 
  public slots:
-  void instantiate(const int numParticles = 30);
+  void instantiate(const int numParticles = 30, const int seed = 0);
 };
 
 // Demo: Token Passing.
@@ -91,7 +93,8 @@ class TokenDemoAlg : public Algorithm {
   TokenDemoAlg();
 
  public slots:
-  void instantiate(const int numParticles = 48, const int lifetime = 100);
+  void instantiate(const int numParticles = 48, const int lifetime = 100,
+                   const int seed = 0);
 };
 
 // Compression.
@@ -102,7 +105,8 @@ class CompressionAlg : public Algorithm {
   CompressionAlg();
 
  public slots:
-  void instantiate(const int numParticles = 100, const double lambda = 4.0);
+  void instantiate(const int numParticles = 100, const double lambda = 4.0,
+                   const int seed = 0);
 };
 
 // Energy Distribution + Hexagon Formation.
@@ -115,7 +119,8 @@ class EnergyShapeAlg : public Algorithm {
  public slots:
   void instantiate(const int numParticles = 200, const int numEnergyRoots = 1,
                    const double holeProb = 0.2, const double capacity = 10,
-                   const double demand = 5, const double transferRate = 1);
+                   const double demand = 5, const double transferRate = 1,
+                   const int seed = 0);
 };
 
 // Energy Distribution/Sharing.
@@ -128,7 +133,8 @@ class EnergySharingAlg : public Algorithm {
  public slots:
   void instantiate(int numParticles = 91, const int numEnergyRoots = 1,
                    const int usage = 0, const double capacity = 10,
-                   const double demand = 5, const double transferRate = 1);
+                   const double demand = 5, const double transferRate = 1,
+                   const int seed = 0);
 };
 
 // Infinite Object Coating.
@@ -139,7 +145,8 @@ class InfObjCoatingAlg : public Algorithm {
   InfObjCoatingAlg();
 
  public slots:
-  void instantiate(const int numParticles = 100, const double holeProb = 0.2);
+  void instantiate(const int numParticles = 100, const double holeProb = 0.2,
+                   const int seed = 0);
 };
 
 // Leader Election.
@@ -150,7 +157,7 @@ class LeaderElectionAlg : public Algorithm {
   LeaderElectionAlg();
 
  public slots:
-  void instantiate(const int numParticles = 100, const double holeProb = 0.2, const QString fileName = "");
+  void instantiate(const int numParticles = 100, const double holeProb = 0.2, const QString fileName = "", const int seed = 0);
   void save();
 };
 
@@ -162,7 +169,7 @@ public:
   LeaderElectionErosionAlg();
 
 public slots:
-  void instantiate(const int numParticles = 100, const QString fileName = "");
+  void instantiate(const int numParticles = 100, const QString fileName = "", const int seed = 0);
   void save();
 };
 
@@ -174,7 +181,7 @@ public:
   LeaderElectionStationaryDeterministicAlg();
 
 public slots:
-  void instantiate(const int numParticles = 100, const QString fileName = "");
+  void instantiate(const int numParticles = 100, const QString fileName = "", const int seed = 0);
   void save();
 };
 
@@ -186,7 +193,7 @@ public:
   LeaderElectionDeterministicAlg();
 
 public slots:
-  void instantiate(const int numParticles = 100, const QString fileName = "");
+  void instantiate(const int numParticles = 100, const QString fileName = "", const int seed = 0);
   void save();
 };
 
@@ -198,7 +205,7 @@ public:
   LeaderElectionSContractionAlg();
 
 public slots:
-  void instantiate(const int numParticles = 100, const QString fileName = "");
+  void instantiate(const int numParticles = 100, const QString fileName = "", const int seed = 0);
   void save();
 };
 
@@ -211,7 +218,7 @@ class ShapeFormationAlg : public Algorithm {
 
  public slots:
   void instantiate(const int numParticles = 200, const double holeProb = 0.2,
-                   const QString mode = "h");
+                   const QString mode = "h", const int seed = 0);
 };
 
 class AlgorithmList {
@@ -226,8 +233,11 @@ class AlgorithmList {
   // Returns a list of all the algorithms in this list.
   std::vector<Algorithm*> getAlgs();
 
-  // Returns the algorithm object of the given algorithm.
+  // Returns the algorithm object of the given algorithm, identified by its name
+  // or its signature, respectively. Returns nullptr if there is no such
+  // algorithm.
   Algorithm* getAlg(QString algName) const;
+  Algorithm* getAlgBySignature(QString signature) const;
 
   // Returns a list of all the algorithm's names in this list.
   QStringList getAlgNames() const;
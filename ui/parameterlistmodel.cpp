@@ -76,50 +76,52 @@ void ParameterListModel::createSystem(QString algName) {
 
   if (signature == "discodemo") {
     dynamic_cast<DiscoDemoAlg*>(alg)->
-        instantiate(params[0].toInt(), params[1].toInt());
+        instantiate(params[0].toInt(), params[1].toInt(), params[2].toInt());
   } else if (signature == "metricsdemo") {
     dynamic_cast<MetricsDemoAlg*>(alg)->
-        instantiate(params[0].toInt(), params[1].toInt());
+        instantiate(params[0].toInt(), params[1].toInt(), params[2].toInt());
   } else if (signature == "ballroomdemo") {
     dynamic_cast<BallroomDemoAlg*>(alg)->
-        instantiate(params[0].toInt());
+        instantiate(params[0].toInt(), params[1].toInt());
   } else if (signature == "tokendemo") {
     dynamic_cast<TokenDemoAlg*>(alg)->
-        instantiate(params[0].toInt(), params[1].toInt());
+        instantiate(params[0].toInt(), params[1].toInt(), params[2].toInt());
   } else if (signature == "compression") {
     dynamic_cast<CompressionAlg*>(alg)->
-        instantiate(params[0].toInt(), params[1].toDouble());
+        instantiate(params[0].toInt(), params[1].toDouble(), params[2].toInt());
   } else if (signature == "energyshape") {
     dynamic_cast<EnergyShapeAlg*>(alg)->
         instantiate(params[0].toInt(), params[1].toInt(), params[2].toDouble(),
                     params[3].toDouble(), params[4].toDouble(),
-                    params[5].toDouble());
+                    params[5].toDouble(), params[6].toInt());
   } else if (signature == "energysharing") {
     dynamic_cast<EnergySharingAlg*>(alg)->
         instantiate(params[0].toInt(), params[1].toInt(), params[2].toInt(),
                     params[3].toDouble(), params[4].toDouble(),
-                    params[5].toDouble());
+                    params[5].toDouble(), params[6].toInt());
   } else if (signature == "infobjcoating") {
     dynamic_cast<InfObjCoatingAlg*>(alg)->
-        instantiate(params[0].toInt(), params[1].toDouble());
+        instantiate(params[0].toInt(), params[1].toDouble(), params[2].toInt());
   } else if (signature == "leaderelection") {
     dynamic_cast<LeaderElectionAlg*>(alg)->
-        instantiate(params[0].toInt(), params[1].toDouble(), params[2]);
+        instantiate(params[0].toInt(), params[1].toDouble(), params[2],
+                    params[3].toInt());
   } else if (signature == "shapeformation") {
     dynamic_cast<ShapeFormationAlg*>(alg)->
-        instantiate(params[0].toInt(), params[1].toDouble(), params[2]);
+        instantiate(params[0].toInt(), params[1].toDouble(), params[2],
+                    params[3].toInt());
   } else if (signature == "leaderelection_erosion") {
       dynamic_cast<LeaderElectionErosionAlg*>(alg)->
-          instantiate(params[0].toInt(), params[1]);
+          instantiate(params[0].toInt(), params[1], params[2].toInt());
   } else if (signature == "leaderelection_stationary_deterministic") {
       dynamic_cast<LeaderElectionStationaryDeterministicAlg*>(alg)->
-          instantiate(params[0].toInt(), params[1]);
+          instantiate(params[0].toInt(), params[1], params[2].toInt());
   } else if (signature == "leaderelection_deterministic") {
       dynamic_cast<LeaderElectionDeterministicAlg*>(alg)->
-          instantiate(params[0].toInt(), params[1]);
+          instantiate(params[0].toInt(), params[1], params[2].toInt());
   } else if (signature == "leaderelection_scontraction") {
       dynamic_cast<LeaderElectionSContractionAlg*>(alg)->
-          instantiate(params[0].toInt(), params[1]);
+          instantiate(params[0].toInt(), params[1], params[2].toInt());
   } else {
     Q_ASSERT(false);  // An unrecognized signature has been entered.
   }
@@ -7,7 +7,6 @@
 #include <cmath>
 
 #include <QImage>
-#include <QMutexLocker>
 #include <QOpenGLFunctions_2_0>
 #include <QQuickWindow>
 #include <QRgb>
@@ -33,8 +32,11 @@ void VisItem::systemChanged(std::shared_ptr<System> _system) {
 }
 
 void VisItem::focusOnCenterOfMass() {
-  QMutexLocker locker(&system->mutex);
-  if (system == nullptr || system->size() == 0) {
+  if (system == nullptr) {
+    return;
+  }
+  SystemLocker locker(*system);
+  if (system->size() == 0) {
     return;
   }
 
@@ -109,7 +111,7 @@ void VisItem::paint() {
   drawGrid();
 
   if (system != nullptr) {
-    QMutexLocker locker(&system->mutex);
+    SystemLocker locker(*system);
 
     drawParticles();
 
@@ -166,26 +168,27 @@ void VisItem::drawParticles() {
   particleTex->bind();
   glfn->glBegin(GL_QUADS);
 
-  // Draw particle marks, then particles, then borders, then border points.
-  for (const Particle& p : *system) {
-    if (view.includes(nodeToWorldCoord(p.head))) {
-      drawMarks(p);
+  // Find the particles in view with one linear scan over the head positions.
+  const ParticleSnapshot& snapshot = system->snapshot();
+  visibleParticles.clear();
+  for (unsigned int i = 0; i < snapshot.size(); ++i) {
+    if (view.includes(nodeToWorldCoord(snapshot.headAt(i)))) {
+      visibleParticles.push_back(snapshot.particle[i]);
     }
   }
-  for (const Particle& p : *system) {
-    if (view.includes(nodeToWorldCoord(p.head))) {
-      drawParticle(p);
-    }
+
+  // Draw particle marks, then particles, then borders, then border points.
+  for (const Particle* p : visibleParticles) {
+    drawMarks(*p);
   }
-  for (const Particle& p : *system) {
-    if (view.includes(nodeToWorldCoord(p.head))) {
-      drawBorders(p);
-    }
+  for (const Particle* p : visibleParticles) {
+    drawParticle(*p);
   }
-  for (const Particle& p : *system) {
-    if (view.includes(nodeToWorldCoord(p.head))) {
-      drawBorderPoints(p);
-    }
+  for (const Particle* p : visibleParticles) {
+    drawBorders(*p);
+  }
+  for (const Particle* p : visibleParticles) {
+    drawBorderPoints(*p);
   }
 
   glfn->glEnd();
@@ -330,10 +333,13 @@ void VisItem::mousePressEvent(QMouseEvent* e) {
       translating = false;
       auto clickedNode = worldCoordToNode(windowCoordToWorldCoord(e->localPos()));
       QString text = "";
-      for (const auto& p : *system) {
-        if (p.head == clickedNode || (p.isExpanded() && p.tail() == clickedNode)) {
-          text = p.inspectionText();
-          break;
+      {
+        SystemLocker locker(*system);
+        for (const auto& p : *system) {
+          if (p.head == clickedNode || (p.isExpanded() && p.tail() == clickedNode)) {
+            text = p.inspectionText();
+            break;
+          }
         }
       }
       while (text.endsWith('\n')) {
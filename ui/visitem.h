@@ -6,6 +6,7 @@
 #define AMOEBOTSIM_UI_VISITEM_H_
 
 #include <memory>
+#include <vector>
 
 #include <QMouseEvent>
 #include <QOpenGLTexture>
@@ -77,6 +78,10 @@ class VisItem : public GLItem {
   bool translating;
 
   std::shared_ptr<System> system;
+
+  // The particles drawn in the current frame; kept as a member to reuse its
+  // memory across frames.
+  std::vector<const Particle*> visibleParticles;
 };
 
 #endif  // AMOEBOTSIM_UI_VISITEM_H_